@@ -4,11 +4,35 @@
 // ============================================================================
 
 #include <GL/glut.h>
+#include <GL/glext.h>
+#if defined(FREEGLUT)
+#include <GL/freeglut_ext.h>   // glutGetProcAddress (shader path)
+#endif
 #include <cmath>
 #include <cstdlib>
 #include <cstdio>
 #include <vector>
+#include <deque>
+#include <queue>
 #include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>            // _BitScanForward (scene timers)
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -18,58 +42,172 @@
 const int WIDTH  = 1400;
 const int HEIGHT = 800;
 
-// Animation states
-float sunAngle        = 0.0f;   // now used as full day-night cycle 0..2PI
-float cloudOffset     = 0.0f;
-float boatPosition    = 0.0f;
-float birdOffset      = 0.0f;
-float windmillAngle   = 0.0f;
-float carPosition     = 0.0f;
-float busPosition     = -300.0f;
-bool  isDay           = true;
-bool  animationPaused = false;
-
-// Extra animation states
-float swingAngle      = 0.0f;
-bool  swingForward    = true;
-float planePosition   = 0.0f;
-bool  isRaining       = false;
-float rainOffset      = 0.0f;
-float speedFactor     = 1.0f;
-
-// ENHANCED ELEMENTS
-float trainPosition   = WIDTH + 400.0f;  // Start from right side
-float personPosition  = 0.0f;
-float riverWave       = 0.0f;
-float fishPosition    = -300.0f;         // fish starts 300px left
-float smokeOffset     = 0.0f;
-float dayNightBlend   = 1.0f;
-float sunGlow         = 0.0f;
-float windIntensity   = 1.0f;
-float windUser = 1.0f;   // user wind multiplier (W/S changes this)
-int trainBogieCount = 5; 
-
-
-// NEW: extra animations
-float balloonPosition = 0.0f;    // hot air balloon
-float trafficTimer    = 0.0f;    // for traffic light cycle
-int   trafficState    = 0;       // 0=red,1=yellow,2=green
-bool  festivalMode    = false;   // festival lights at night
-float kitePosition    = 0.0f;    // kite in the sky
-
-// TOGGLE FLAGS (for viva/demo)
-bool showBirds        = true;
-bool showPlane        = true;
-bool showTrain        = true;
-bool showLights       = true;   // controls glow, poles always visible
-bool showPerson       = true;
-
-
-
-bool useScaleT   = false;
-bool useRotateT  = false;
-bool useReflectT = false;
-bool useShearT   = false;
+// ============================================================================
+// SCENE STATE
+// Every animation + toggle variable lives in ONE plain struct, so reset,
+// snapshots (K/O keys) and warm starts are just struct copies.
+// The old global names below are references into it, so drawing code is
+// unchanged.
+// NOTE: keep it padding-free (4-byte fields first, bools last) - it is
+// written to disk byte for byte. Bump SNAPSHOT_VERSION when it changes.
+// ============================================================================
+
+struct SceneState {
+    // Animation states
+    float    sunAngle;          // full day-night cycle 0..2PI (not wrapped)
+    float    cloudOffset;
+    float    boatPosition;
+    float    birdOffset;
+    float    windmillAngle;
+    float    carPosition;
+    float    busPosition;
+
+    // Extra animation states
+    float    swingAngle;
+    float    planePosition;
+    float    rainOffset;
+    float    speedFactor;
+
+    // ENHANCED ELEMENTS
+    float    trainPosition;
+    float    personPosition;
+    float    riverWave;
+    float    fishPosition;
+    float    smokeOffset;
+    float    dayNightBlend;
+    float    sunGlow;
+    float    windIntensity;
+    float    windUser;          // user wind multiplier (W/S changes this)
+
+    // NEW: extra animations
+    float    balloonPosition;   // hot air balloon
+    float    trafficTimer;      // for traffic light cycle
+    float    kitePosition;      // kite in the sky
+
+    int32_t  trainBogieCount;
+    int32_t  trafficState;      // 0=red,1=yellow,2=green
+    uint32_t tick;              // simulated ticks since start
+    uint32_t pedRand;           // crowd LCG (seeded by initCrowd)
+    uint32_t herdRand;          // herd LCG (seeded by initHerd)
+
+    bool     isDay;
+    bool     animationPaused;
+    bool     swingForward;
+    bool     isRaining;
+    bool     festivalMode;      // festival lights at night
+
+    // TOGGLE FLAGS (for viva/demo)
+    bool     showBirds;
+    bool     showPlane;
+    bool     showTrain;
+    bool     showLights;        // controls glow, poles always visible
+    bool     showPerson;
+
+    bool     useScaleT;
+    bool     useRotateT;
+    bool     useReflectT;
+    bool     useShearT;
+
+    uint8_t  reserved[2];       // explicit padding (always 0)
+};
+
+static_assert(sizeof(SceneState) == 28 * 4 + 16, "SceneState must stay padding-free");
+
+// Initial values (also what E resets to)
+int startCoaches = 5;    // train length at start-up and after E (--coaches N)
+
+SceneState sceneDefaults() {
+    SceneState s;
+    std::memset(&s, 0, sizeof(s));
+
+    s.busPosition     = -300.0f;
+    s.speedFactor     = 1.0f;
+    s.trainPosition   = WIDTH + 400.0f;  // Start from right side
+    s.fishPosition    = -300.0f;         // fish starts 300px left
+    s.dayNightBlend   = 1.0f;
+    s.windIntensity   = 1.0f;
+    s.windUser        = 1.0f;
+    s.trainBogieCount = startCoaches;
+    s.trafficState    = 0;
+
+    s.isDay           = true;
+    s.swingForward    = true;
+
+    s.showBirds       = true;
+    s.showPlane       = true;
+    s.showTrain       = true;
+    s.showLights      = true;
+    s.showPerson      = true;
+    return s;
+}
+
+SceneState scene = sceneDefaults();
+
+float& sunAngle        = scene.sunAngle;
+float& cloudOffset     = scene.cloudOffset;
+float& boatPosition    = scene.boatPosition;
+float& birdOffset      = scene.birdOffset;
+float& windmillAngle   = scene.windmillAngle;
+float& carPosition     = scene.carPosition;
+float& busPosition     = scene.busPosition;
+bool&  isDay           = scene.isDay;
+bool&  animationPaused = scene.animationPaused;
+
+float& swingAngle      = scene.swingAngle;
+bool&  swingForward    = scene.swingForward;
+float& planePosition   = scene.planePosition;
+bool&  isRaining       = scene.isRaining;
+float& rainOffset      = scene.rainOffset;
+float& speedFactor     = scene.speedFactor;
+
+float& trainPosition   = scene.trainPosition;
+float& personPosition  = scene.personPosition;
+float& riverWave       = scene.riverWave;
+float& fishPosition    = scene.fishPosition;
+float& smokeOffset     = scene.smokeOffset;
+float& dayNightBlend   = scene.dayNightBlend;
+float& sunGlow         = scene.sunGlow;
+float& windIntensity   = scene.windIntensity;
+float& windUser        = scene.windUser;
+int&   trainBogieCount = scene.trainBogieCount;
+
+float& balloonPosition = scene.balloonPosition;
+float& trafficTimer    = scene.trafficTimer;
+int&   trafficState    = scene.trafficState;
+bool&  festivalMode    = scene.festivalMode;
+float& kitePosition    = scene.kitePosition;
+
+bool&  showBirds       = scene.showBirds;
+bool&  showPlane       = scene.showPlane;
+bool&  showTrain       = scene.showTrain;
+bool&  showLights      = scene.showLights;
+bool&  showPerson      = scene.showPerson;
+
+bool&  useScaleT       = scene.useScaleT;
+bool&  useRotateT      = scene.useRotateT;
+bool&  useReflectT     = scene.useReflectT;
+bool&  useShearT       = scene.useShearT;
+
+// Input log state (not part of the scene state)
+uint32_t inputTick  = 0;       // update() calls so far, paused or not
+bool     replayMode = false;   // headless --replay run
+
+// Settings (not part of the scene state)
+// window size in pixels (reshape): mouse mapping, river detail
+int winW = WIDTH;
+int winH = HEIGHT;
+
+bool useShaders   = true;    // U: GLSL sky + river when available (--fixed-function)
+bool shadersReady = false;   // initShaders() found GL 3.3 and linked both programs
+bool bloomEnabled = true;    // J: bloom post-process (--no-bloom)
+int  bloomDivisor = 4;       // bloom works at 1/2 or 1/4 of the window (--bloom-scale)
+bool benchGL      = false;   // --bench-gl: time both paths in the window, then exit
+bool shadowStencil = false;  // window has a stencil buffer: shadow + reflection passes
+
+int fishCount = 24;                          // size of the fish school (--fish N)
+int crowdCount = 40;                         // walkers on the footpath (--crowd N)
+int herdCount  = 8;                          // cows in the field (--cows N)
+const char* snapshotPath = "village.snap";   // K saves, O loads (--snapshot PATH)
 
 
 
@@ -83,6 +221,16 @@ void initRendering();
 void drawCircle(float cx, float cy, float r, int segments = 40);
 void drawEllipse(float cx, float cy, float rx, float ry, int segments = 40);
 void drawShadowEllipse(float cx, float cy, float rx, float ry, float alpha);
+void addShadow(float cx, float cy, float rx, float ry, float alpha);
+void drawShadowNow(float cx, float cy, float rx, float ry, float alpha);
+void beginShadowMask();
+void surfaceMask(int mask);
+void setShadowLight(float arc, float strength);
+void drawShadowPass();
+void addMirror(float x0, float x1, float y0, float y1, float squash, float alpha);
+void drawReflections();
+const unsigned char* mapLastFrame(int w, int h);   // bloom read-back (PBOs)
+void unmapLastFrame();
 
 
 // --- ALGORITHM DRAWING (for teacher requirement) ---
@@ -91,11 +239,28 @@ void drawLineBresenham(int x1, int y1, int x2, int y2);
 void drawCircleMidpoint(int cx, int cy, int r);
 
 
+// Time-of-day color table + material palette
+void bakeTimeOfDay();
+void updateTimeOfDay();
+void registerMaterials();
+void resolveMaterials();
+
 // Background elements
 void drawSky();
+void initShaders();
+bool shaderPathActive();
+void drawSkyShader();
+void drawRiverShader();
+void drawStarsShader();
+static inline float fastSin(float x);
 void drawSunMoon();
 void drawClouds();
+void initClouds(int count);
+void startCloudBake(int workers);
+void finishCloudBake();
+void uploadCloudAtlas();
 void drawDistantHills();
+void buildHills(int octaves);
 void drawStars();
 
 // Terrain and landscape
@@ -113,24 +278,44 @@ void drawCottage(float x, float y);
 
 // Vegetation
 void drawTree(float x, float y, int type = 0);
+void drawTreeShape(float x, float y, int type, float wind);
+void bakeTreeAtlas();
+void initForest(int count);
+void drawForest();
 void drawBush(float x, float y, float size);
 
 // Vehicles
 void drawTrain(float x, float y);
+void buildCoachMeshes();
+void initCoachShader();
+float trainWrapX(int coaches);
 void drawBus(float x, float y);
 void drawCar(float x, float y);
 void drawBoat(float x, float y);
-void drawBoatWaterReflection(float boatX, float boatY);
 void drawAirplane();
 void drawFish();
 
+// Fish school simulation
+void initFishSchool(int count);
+void updateFishSchool(float speed);
+
+// Pedestrian crowd
+void initCrowd(int count);
+void updateCrowd(float speed);
+void initCrowdShader();
+
+// Cow herd
+void initHerd(int count);
+void updateHerd(float speed);
+void initHerdShader();
+
 // Animated objects
 void drawMovingTrain();
 void drawMovingBus();
 void drawMovingCar();
 void drawMovingBoat();
 void drawBirds();
-void drawWalkingPerson();
+void drawCrowd();
 
 // Structures
 void drawWindmill(float x, float y);
@@ -141,7 +326,7 @@ void drawSwing(float x, float y);        // kept – used as seesaw angle source
 void drawDockAndFisherman();            // river ghat + fishing man
 void drawFieldAndCow();                 // crop field + cows (+ fence)
 void drawBusStop();                     // bus stop + waiting person
-void drawTrafficLight();                // animated traffic light
+void drawTrafficLight();                // animated traffic lights (one per signal)
 void drawHotAirBalloon();               // sky balloon
 void drawFireflies();                   // night fireflies
 void drawFestivalLights();              // decorative lights
@@ -151,20 +336,59 @@ void drawKite();                        // kite in sky
 // void drawWelcomeSign();                 // "WELCOME TO VILLAGE" board
 void drawWell(float x, float y);        // small well near house
 
-// Cow helper
-void drawSingleCow(float cx, float cy, float scale, bool faceRight);
+// Cow herd (instanced)
+void drawHerd();
+
+// Signal controller (--signals N)
+void initRoadSignals(int count);
 
 // Weather effects
 void drawRain();
 
 // Scene composition
+void cullScene();
 void drawVillageScene();
 
+// Snapshots (K / O keys, --load-snapshot)
+bool saveSnapshot(const char* path);
+bool loadSnapshot(const char* path);
+void saveReplaySnapshot();               // K / O while replaying (in memory)
+bool loadReplaySnapshot();
+
+// Benchmarks (--bench)
+static double nowMs();
+void runBenchmarks();
+void runGLBenchmarks();
+
+// Simulation tick + input (shared by the live loop and --replay)
+void stepScene(bool live = true);
+void handleKey(unsigned char key);
+void handleMouse(int button, int state, int x, int y);
+void handleMotion(int x, int y);
+
+// Analytic time seek (--seek, scrubbing)
+SceneState stateAt(const SceneState& base, uint64_t ticks);
+uint64_t   parseTicks(const char* text);
+
+// Timeline checkpoints + HUD scrub bar
+void resetTimeline();
+void recordCheckpoint();
+void recordInputCheckpoint();
+void seekTimeline(uint32_t target);
+void drawTimelineBar();
+
+// Input recording / replay (--record, --replay)
+void recordInput(char kind, uint8_t code, uint8_t state, int x, int y);
+void recordTickHash();
+void closeRecording();
+int  runReplay(const char* path);
+
 // Callbacks
 void display();
 void update(int value);
 void keyboard(unsigned char key, int x, int y);
 void mouse(int button, int state, int x, int y);
+void motion(int x, int y);
 void reshape(int w, int h);
 
 // ============================================================================
@@ -177,6 +401,10 @@ void initRendering() {
     glEnable(GL_LINE_SMOOTH);
     glHint(GL_POINT_SMOOTH_HINT, GL_NICEST);
     glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+
+    GLint stencilBits = 0;
+    glGetIntegerv(GL_STENCIL_BITS, &stencilBits);
+    shadowStencil = stencilBits > 0;
 }
 
 // ============================================================================
@@ -453,3766 +681,9654 @@ static inline Vec2 applyAllTransforms(Vec2 p,
 
 
 // ============================================================================
-// SKY AND BACKGROUND WITH SMOOTH TRANSITIONS
+// TIME OF DAY (baked color curves)
+// Every sky / terrain / water / foliage color has four keyframes: dawn
+// (sunrise, phase 0), noon, dusk (sunset, phase PI) and night. Noon and
+// night hold for a quarter of the cycle each, the edges are smoothstepped.
+// All of it is baked at start-up into a 1024-row table indexed by the
+// sunAngle phase, so a frame does one row fetch instead of per-draw lerps.
 // ============================================================================
 
-void drawSky() {
-    if (isDay && dayNightBlend < 1.0f) dayNightBlend += 0.02f;
-    if (!isDay && dayNightBlend > 0.0f) dayNightBlend -= 0.02f;
-
-    float dayFactor   = dayNightBlend;
-    float nightFactor = 1.0f - dayFactor;
-
-    // Day colors
-    float dayTopR = 0.5f, dayTopG = 0.7f, dayTopB = 1.0f;
-    float dayBotR = 0.7f, dayBotG = 0.85f, dayBotB = 1.0f;
-
-    // Night colors
-    float nightTopR = 0.05f, nightTopG = 0.05f, nightTopB = 0.2f;
-    float nightBotR = 0.1f,  nightBotG = 0.1f,  nightBotB = 0.3f;
-
-    glBegin(GL_QUADS);
-    glColor3f(dayTopR * dayFactor + nightTopR * nightFactor,
-              dayTopG * dayFactor + nightTopG * nightFactor,
-              dayTopB * dayFactor + nightTopB * nightFactor);
-    glVertex2f(0, HEIGHT);
-    glVertex2f(WIDTH, HEIGHT);
-
-    glColor3f(dayBotR * dayFactor + nightBotR * nightFactor,
-              dayBotG * dayFactor + nightBotG * nightFactor,
-              dayBotB * dayFactor + nightBotB * nightFactor);
-    glVertex2f(WIDTH, HEIGHT * 0.6f);
-    glVertex2f(0, HEIGHT * 0.6f);
-    glEnd();
-}
-
-void drawStars() {
-    if (isDay || dayNightBlend > 0.3f) return;
+const int TOD_LUT_SIZE = 1024;
 
-    glPointSize(1.5f);
-    glBegin(GL_POINTS);
-    for (int i = 0; i < 100; i++) {
-        float x = (i * 37) % WIDTH;
-        float y = HEIGHT * 0.7f + (i * 53) % (int)(HEIGHT * 0.3f);
-        if (i % 3 == 0) glColor3f(1.0f, 1.0f, 1.0f);
-        else if (i % 3 == 1) glColor3f(0.9f, 0.9f, 1.0f);
-        else glColor3f(1.0f, 0.9f, 0.9f);
-        glVertex2f(x, y);
-    }
-    glEnd();
-}
+// middle of the noon / night holds (the D and N keys jump here)
+const float TOD_NOON_PHASE     = 0.5f * (float)M_PI;
+const float TOD_MIDNIGHT_PHASE = 1.5f * (float)M_PI;
 
-// NEW: sun & moon move from horizon (bottom of sky) up and again down
-// ======================= REPLACE THIS FUNCTION =======================
-void drawSunMoon() {
-    const float PI = 3.1415926f;
+enum TodMaterial {
+    TOD_SKY_TOP, TOD_SKY_BOTTOM,
+    TOD_GROUND_LOW, TOD_GROUND_HIGH,
+    TOD_ROAD_NEAR, TOD_ROAD_FAR, TOD_ROAD_LINE,
+    TOD_WATER,
+    TOD_SUNLIGHT,         // light on lit materials (was a 0.55..1.0 grey)
+    TOD_COUNT
+};
 
-    float t = std::fmod(sunAngle, 2.0f * PI);
-    if (t < 0.0f) t += 2.0f * PI;
+struct TodColor { float r, g, b; };
+
+struct TodKeys { TodColor dawn, noon, dusk, night; };
+
+// noon / night are the old day / night constants
+const TodKeys TOD_KEYS[TOD_COUNT] = {
+    // dawn                  noon                  dusk                  night
+    {{0.95f, 0.58f, 0.48f}, {0.50f, 0.70f, 1.00f}, {0.52f, 0.30f, 0.48f}, {0.05f, 0.05f, 0.20f}}, // sky top
+    {{1.00f, 0.76f, 0.52f}, {0.70f, 0.85f, 1.00f}, {0.98f, 0.55f, 0.30f}, {0.10f, 0.10f, 0.30f}}, // sky bottom
+    {{0.22f, 0.44f, 0.22f}, {0.25f, 0.55f, 0.25f}, {0.20f, 0.36f, 0.18f}, {0.07f, 0.18f, 0.07f}}, // ground low
+    {{0.36f, 0.56f, 0.32f}, {0.35f, 0.65f, 0.35f}, {0.32f, 0.46f, 0.26f}, {0.12f, 0.25f, 0.12f}}, // ground high
+    {{0.24f, 0.22f, 0.22f}, {0.25f, 0.25f, 0.25f}, {0.22f, 0.19f, 0.18f}, {0.10f, 0.10f, 0.10f}}, // road near
+    {{0.34f, 0.31f, 0.30f}, {0.35f, 0.35f, 0.35f}, {0.31f, 0.27f, 0.25f}, {0.18f, 0.18f, 0.18f}}, // road far
+    {{0.86f, 0.80f, 0.74f}, {0.90f, 0.90f, 0.90f}, {0.82f, 0.72f, 0.62f}, {0.60f, 0.60f, 0.60f}}, // road line
+    {{0.30f, 0.38f, 0.66f}, {0.18f, 0.42f, 0.85f}, {0.30f, 0.28f, 0.55f}, {0.08f, 0.20f, 0.45f}}, // water
+    {{1.00f, 0.84f, 0.72f}, {1.00f, 1.00f, 1.00f}, {1.00f, 0.76f, 0.62f}, {0.55f, 0.55f, 0.55f}}, // sunlight
+};
 
-    float horizonY  = 460.0f;
-    float sunAmp    = 130.0f;
-    float moonAmp   = 100.0f;
+TodColor todTable[TOD_LUT_SIZE][TOD_COUNT];
+const TodColor* todNow = todTable[0];     // this frame's row (updateTimeOfDay)
 
-    // ✅ enable blending so glColor4f alpha actually works (glow, rays)
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+void bakeTimeOfDay() {
+    // keyframe times as a fraction of the cycle (0 = sunrise, 0.5 = sunset)
+    const float at[7] = {0.0f, 0.125f, 0.375f, 0.5f, 0.625f, 0.875f, 1.0f};
 
-    if (t < PI) {
-        // ---------------------- SUN (DAY) ----------------------------------
-        float local = t;
-        float phase = local / PI;
+    for (int m = 0; m < TOD_COUNT; m++) {
+        const TodKeys& k = TOD_KEYS[m];
+        const TodColor key[7] = {k.dawn, k.noon, k.noon, k.dusk, k.night, k.night, k.dawn};
 
-        float x = WIDTH * 0.15f + (WIDTH * 0.70f) * phase;
-        float y = horizonY + std::sin(local) * sunAmp;
+        for (int i = 0; i < TOD_LUT_SIZE; i++) {
+            float u = (i + 0.5f) / TOD_LUT_SIZE;
+            int   s = 0;
+            while (s < 5 && u >= at[s + 1]) s++;
 
-        sunGlow = 0.3f + 0.2f * std::sin(local * 3.0f);
+            float f = (u - at[s]) / (at[s + 1] - at[s]);
+            f = f * f * (3.0f - 2.0f * f);
 
-        // glow layers
-        for (int i = 3; i > 0; --i) {
-            float alpha = 0.10f * i;
-            glColor4f(1.0f, 1.0f, 0.5f, alpha);
-            drawCircle(x, y, 30.0f + i * 10.0f);
+            TodColor& c = todTable[i][m];
+            c.r = key[s].r + (key[s + 1].r - key[s].r) * f;
+            c.g = key[s].g + (key[s + 1].g - key[s].g) * f;
+            c.b = key[s].b + (key[s + 1].b - key[s].b) * f;
         }
+    }
+}
 
-        // main sun
-        glColor4f(1.0f, 1.0f, 0.0f, 1.0f);
-        drawCircle(x, y, 30.0f);
-
-        // rays
-        glColor4f(1.0f, 1.0f, 0.5f, 0.55f);
-        glLineWidth(2.5f + sunGlow);
-        for (int i = 0; i < 16; i++) {
-            float ang = 2.0f * PI * i / 16.0f + local * 0.5f;
-            float x1 = x + std::cos(ang) * 40.0f;
-            float y1 = y + std::sin(ang) * 40.0f;
-            float x2 = x + std::cos(ang) * 60.0f;
-            float y2 = y + std::sin(ang) * 60.0f;
+// once per frame, before drawing
+void updateTimeOfDay() {
+    // the table is a power of two long, so the phase wrap is just a mask
+    const double ROWS_PER_RAD = TOD_LUT_SIZE / (2.0 * 3.14159265358979);
+    long long row = (long long)std::floor(sunAngle * ROWS_PER_RAD);
+    todNow = todTable[row & (TOD_LUT_SIZE - 1)];
+}
 
-            glBegin(GL_LINES);
-            glVertex2f(x1, y1);
-            glVertex2f(x2, y2);
-            glEnd();
-        }
-    } else {
-        // ---------------------- MOON (NIGHT) -------------------------------
-        float local = t - PI;
-        float phase = local / PI;
+static inline void todColor(int material) {
+    glColor3fv(&todNow[material].r);
+}
 
-        float x = WIDTH * 0.15f + (WIDTH * 0.70f) * phase;
-        float y = horizonY + std::sin(local) * moonAmp + 10.0f;
+// ============================================================================
+// MATERIALS (named surface colors, resolved once per frame)
+// Each material is a base RGBA plus the time-of-day light it is lit by.
+// resolveMaterials() multiplies them out once per frame into a packed RGBA8
+// palette; draw code just picks an index (matColor), so a batch can keep a
+// 1-byte material id per vertex instead of float colors.
+// ============================================================================
 
-        float bright = 0.8f + 0.2f * std::sin(local * 0.8f);
+enum Material {
+    // trees
+    MAT_BARK, MAT_BARK_SHADOW, MAT_BARK_LINE, MAT_BRANCH,
+    MAT_LEAF_DARK, MAT_LEAF_DARK_SIDE, MAT_LEAF_DARK_FRUIT,
+    MAT_LEAF_LIGHT, MAT_LEAF_LIGHT_SIDE, MAT_LEAF_LIGHT_FRUIT,
+    MAT_PINE_TIP,                         // 4 layers each (bottom -> top)
+    MAT_PINE_LEFT  = MAT_PINE_TIP  + 4,
+    MAT_PINE_RIGHT = MAT_PINE_LEFT + 4,
+    MAT_PALM_BARK  = MAT_PINE_RIGHT + 4,
+    MAT_PALM_BARK_ALT, MAT_PALM_SHADOW, MAT_COCONUT,
+    MAT_PALM_LEAF, MAT_PALM_LEAF_SHINE, MAT_PALM_RIB,
+    MAT_FRUIT,
+
+    // rail track
+    MAT_BALLAST_LOW, MAT_BALLAST_HIGH,
+    MAT_STONE,                            // 3 shades
+    MAT_SLEEPER = MAT_STONE + 3,
+    MAT_SLEEPER_SHADOW, MAT_RAIL_SHADOW, MAT_RAIL, MAT_RAIL_SHINE, MAT_RAIL_PLATE,
+
+    // houses and roofs (unlit: they keep their literal colors at night)
+    MAT_HOUSE_OUTLINE, MAT_WINDOW_FRAME, MAT_CHIMNEY, MAT_DOOR_STEP, MAT_DOOR_KNOB,
+    MAT_MODERN_WALL, MAT_MODERN_ROOF, MAT_MODERN_WINDOW, MAT_MODERN_DOOR,
+    MAT_TRAD_WALL, MAT_TRAD_ROOF, MAT_TRAD_WINDOW, MAT_TRAD_DOOR,
+    MAT_FARM_WALL, MAT_FARM_ROOF, MAT_FARM_VERANDA, MAT_FARM_WINDOW,
+    MAT_COTTAGE_WALL, MAT_COTTAGE_ROOF, MAT_COTTAGE_DOOR, MAT_COTTAGE_WINDOW,
+
+    // props (unlit too)
+    MAT_MILL_TOWER, MAT_MILL_CAP, MAT_MILL_SAIL,
+    MAT_LAMP_POST, MAT_LAMP_HEAD, MAT_LAMP_OFF, MAT_POLE,
+    MAT_PLATFORM, MAT_SHELTER_PILLAR, MAT_SHELTER_PANEL, MAT_SHELTER_ROOF, MAT_BENCH,
+    MAT_WELL_STONE, MAT_WELL_RIM, MAT_WELL_WATER, MAT_WELL_WOOD,
+
+    MAT_COUNT
+};
 
-        glColor4f(0.9f * bright, 0.9f * bright, 0.9f * bright, 1.0f);
-        drawCircle(x, y, 28.0f);
+static_assert(MAT_COUNT <= 256, "material ids must fit in one byte");
 
-        glColor4f(0.7f * bright, 0.7f * bright, 0.7f * bright, 1.0f);
-        drawCircle(x - 10.0f, y + 10.0f, 6.0f);
-        drawCircle(x + 12.0f, y -  8.0f, 5.0f);
-        drawCircle(x +  8.0f, y + 12.0f, 4.0f);
+struct MaterialDef {
+    float r, g, b, a;
+    int   light;       // TodMaterial multiplier, or -1 = unlit
+};
 
-        // moon glow
-        glColor4f(0.9f, 0.9f, 1.0f, 0.20f);
-        drawCircle(x, y, 35.0f);
-    }
+MaterialDef materials[MAT_COUNT];
+uint32_t    materialPalette[MAT_COUNT];   // RGBA8, bytes in r,g,b,a order
 
-    glDisable(GL_BLEND);
+static void defineMaterial(int id, float r, float g, float b, float a = 1.0f,
+                           int light = TOD_SUNLIGHT) {
+    MaterialDef& m = materials[id];
+    m.r = r; m.g = g; m.b = b; m.a = a;
+    m.light = light;
 }
 
+void registerMaterials() {
+    defineMaterial(MAT_BARK,             0.40f, 0.25f, 0.12f);
+    defineMaterial(MAT_BARK_SHADOW,      0.26f, 0.16f, 0.08f);
+    defineMaterial(MAT_BARK_LINE,        0.18f, 0.12f, 0.06f);
+    defineMaterial(MAT_BRANCH,           0.28f, 0.17f, 0.08f);
 
-void drawClouds() {
-    
-    float speed = 0.5f * windIntensity;
+    // leaf clusters: base color, side clusters and the fruit tree are a bit off
+    defineMaterial(MAT_LEAF_DARK,        0.08f,          0.40f,          0.10f);
+    defineMaterial(MAT_LEAF_DARK_SIDE,   0.08f * 1.05f,  0.40f * 1.05f,  0.10f * 1.05f);
+    defineMaterial(MAT_LEAF_DARK_FRUIT,  0.08f * 1.02f,  0.40f * 1.02f,  0.10f * 1.02f);
+    defineMaterial(MAT_LEAF_LIGHT,       0.18f,          0.62f,          0.18f);
+    defineMaterial(MAT_LEAF_LIGHT_SIDE,  0.18f * 0.98f,  0.62f * 0.98f,  0.18f * 0.98f);
+    defineMaterial(MAT_LEAF_LIGHT_FRUIT, 0.18f * 1.05f,  0.62f * 1.05f,  0.18f * 1.05f);
 
-    for (int layer = 0; layer < 3; layer++) {
-        float layerSpeed = speed * (layer + 1) * 0.5f;
-        float layerY = 500.0f + layer * 40.0f;
-        float layerAlpha = 0.7f - layer * 0.2f;
+    for (int i = 0; i < 4; i++) {
+        float dark = 0.18f - i * 0.01f;
+        float mid  = 0.45f - i * 0.02f;
+        defineMaterial(MAT_PINE_TIP   + i, 0.06f, mid,         0.08f);
+        defineMaterial(MAT_PINE_LEFT  + i, 0.05f, dark,        0.07f);
+        defineMaterial(MAT_PINE_RIGHT + i, 0.08f, mid + 0.08f, 0.10f);
+    }
 
-        glColor4f(1.0f, 1.0f, 1.0f, layerAlpha);
+    defineMaterial(MAT_PALM_BARK,        0.42f, 0.26f, 0.13f);
+    defineMaterial(MAT_PALM_BARK_ALT,    0.36f, 0.26f, 0.13f);
+    defineMaterial(MAT_PALM_SHADOW,      0.25f, 0.16f, 0.08f);
+    defineMaterial(MAT_COCONUT,          0.28f, 0.20f, 0.10f);
+    defineMaterial(MAT_PALM_LEAF,        0.08f, 0.45f, 0.12f);
+    defineMaterial(MAT_PALM_LEAF_SHINE,  0.30f, 0.85f, 0.30f, 0.35f);
+    defineMaterial(MAT_PALM_RIB,         0.05f, 0.30f, 0.08f);
+    defineMaterial(MAT_FRUIT,            1.00f, 0.50f, 0.05f);
+
+    defineMaterial(MAT_BALLAST_LOW,      0.20f, 0.18f, 0.16f);
+    defineMaterial(MAT_BALLAST_HIGH,     0.28f, 0.25f, 0.22f);
+    for (int i = 0; i < 3; i++) {
+        float c = 0.35f + 0.15f * (i * 0.25f);
+        defineMaterial(MAT_STONE + i, c, c, c);
+    }
+    defineMaterial(MAT_SLEEPER,          0.36f, 0.25f, 0.14f);
+    defineMaterial(MAT_SLEEPER_SHADOW,   0.22f, 0.15f, 0.08f);
+    defineMaterial(MAT_RAIL_SHADOW,      0.10f, 0.10f, 0.10f);
+    defineMaterial(MAT_RAIL,             0.55f, 0.55f, 0.58f);
+    defineMaterial(MAT_RAIL_SHINE,       0.85f, 0.85f, 0.88f);
+    defineMaterial(MAT_RAIL_PLATE,       0.25f, 0.25f, 0.28f);
+
+    const int UNLIT = -1;
+    defineMaterial(MAT_HOUSE_OUTLINE,    0.15f, 0.15f, 0.15f, 1.0f, UNLIT);
+    defineMaterial(MAT_WINDOW_FRAME,     0.25f, 0.25f, 0.25f, 1.0f, UNLIT);
+    defineMaterial(MAT_CHIMNEY,          0.40f, 0.40f, 0.40f, 1.0f, UNLIT);
+    defineMaterial(MAT_DOOR_STEP,        0.55f, 0.55f, 0.55f, 1.0f, UNLIT);
+    defineMaterial(MAT_DOOR_KNOB,        0.95f, 0.90f, 0.20f, 1.0f, UNLIT);
+    defineMaterial(MAT_MODERN_WALL,      0.25f, 0.55f, 0.85f, 1.0f, UNLIT);
+    defineMaterial(MAT_MODERN_ROOF,      0.88f, 0.88f, 0.88f, 1.0f, UNLIT);
+    defineMaterial(MAT_MODERN_WINDOW,    0.75f, 0.90f, 1.00f, 1.0f, UNLIT);
+    defineMaterial(MAT_MODERN_DOOR,      0.85f, 0.70f, 0.50f, 1.0f, UNLIT);
+    defineMaterial(MAT_TRAD_WALL,        0.92f, 0.74f, 0.52f, 1.0f, UNLIT);
+    defineMaterial(MAT_TRAD_ROOF,        0.55f, 0.25f, 0.18f, 1.0f, UNLIT);
+    defineMaterial(MAT_TRAD_WINDOW,      0.88f, 0.95f, 1.00f, 1.0f, UNLIT);
+    defineMaterial(MAT_TRAD_DOOR,        0.45f, 0.28f, 0.18f, 1.0f, UNLIT);
+    defineMaterial(MAT_FARM_WALL,        0.85f, 0.62f, 0.40f, 1.0f, UNLIT);
+    defineMaterial(MAT_FARM_ROOF,        0.70f, 0.18f, 0.12f, 1.0f, UNLIT);
+    defineMaterial(MAT_FARM_VERANDA,     0.60f, 0.40f, 0.22f, 1.0f, UNLIT);
+    defineMaterial(MAT_FARM_WINDOW,      0.80f, 0.93f, 1.00f, 1.0f, UNLIT);
+    defineMaterial(MAT_COTTAGE_WALL,     0.70f, 0.80f, 0.60f, 1.0f, UNLIT);
+    defineMaterial(MAT_COTTAGE_ROOF,     0.80f, 0.60f, 0.30f, 1.0f, UNLIT);
+    defineMaterial(MAT_COTTAGE_DOOR,     0.50f, 0.40f, 0.30f, 1.0f, UNLIT);
+    defineMaterial(MAT_COTTAGE_WINDOW,   0.90f, 0.95f, 1.00f, 1.0f, UNLIT);
+
+    defineMaterial(MAT_MILL_TOWER,       0.50f, 0.30f, 0.20f, 1.0f, UNLIT);
+    defineMaterial(MAT_MILL_CAP,         0.60f, 0.40f, 0.30f, 1.0f, UNLIT);
+    defineMaterial(MAT_MILL_SAIL,        0.90f, 0.90f, 0.80f, 1.0f, UNLIT);
+    defineMaterial(MAT_LAMP_POST,        0.25f, 0.25f, 0.25f, 1.0f, UNLIT);
+    defineMaterial(MAT_LAMP_HEAD,        0.35f, 0.35f, 0.35f, 1.0f, UNLIT);
+    defineMaterial(MAT_LAMP_OFF,         0.90f, 0.90f, 0.70f, 1.0f, UNLIT);
+    defineMaterial(MAT_POLE,             0.35f, 0.35f, 0.35f, 1.0f, UNLIT);
+    defineMaterial(MAT_PLATFORM,         0.70f, 0.70f, 0.70f, 1.0f, UNLIT);
+    defineMaterial(MAT_SHELTER_PILLAR,   0.18f, 0.18f, 0.18f, 1.0f, UNLIT);
+    defineMaterial(MAT_SHELTER_PANEL,    0.85f, 0.90f, 0.95f, 0.55f, UNLIT);
+    defineMaterial(MAT_SHELTER_ROOF,     0.95f, 0.75f, 0.15f, 1.0f, UNLIT);
+    defineMaterial(MAT_BENCH,            0.35f, 0.22f, 0.10f, 1.0f, UNLIT);
+    defineMaterial(MAT_WELL_STONE,       0.60f, 0.60f, 0.60f, 1.0f, UNLIT);
+    defineMaterial(MAT_WELL_RIM,         0.40f, 0.40f, 0.40f, 1.0f, UNLIT);
+    defineMaterial(MAT_WELL_WATER,       0.20f, 0.20f, 0.20f, 1.0f, UNLIT);
+    defineMaterial(MAT_WELL_WOOD,        0.35f, 0.25f, 0.15f, 1.0f, UNLIT);
+}
 
-        float cloud1X = 150.0f + cloudOffset * layerSpeed;
-        drawCircle(cloud1X, layerY, 25.0f);
-        drawCircle(cloud1X + 22.0f, layerY + 12.0f, 22.0f);
-        drawCircle(cloud1X + 45.0f, layerY, 25.0f);
-        drawCircle(cloud1X + 22.0f, layerY - 10.0f, 20.0f);
+static inline uint8_t toByte(float v) {
+    if (v <= 0.0f) return 0;
+    if (v >= 1.0f) return 255;
+    return (uint8_t)(v * 255.0f + 0.5f);
+}
 
-        // ✅ changed direction: now moves SAME way (right)
-        float cloud2X = 600.0f + cloudOffset * layerSpeed * 0.8f;
-        drawCircle(cloud2X, layerY + 20.0f, 30.0f);
-        drawCircle(cloud2X + 28.0f, layerY + 30.0f, 25.0f);
-        drawCircle(cloud2X + 55.0f, layerY + 20.0f, 28.0f);
+// once per frame, after updateTimeOfDay()
+void resolveMaterials() {
+    for (int i = 0; i < MAT_COUNT; i++) {
+        const MaterialDef& m = materials[i];
+        TodColor l = {1.0f, 1.0f, 1.0f};
+        if (m.light >= 0) l = todNow[m.light];
 
-        float cloud3X = 1000.0f + cloudOffset * layerSpeed * 0.6f;
-        drawCircle(cloud3X, layerY - 10.0f, 20.0f);
-        drawCircle(cloud3X + 20.0f, layerY, 18.0f);
-        drawCircle(cloud3X + 38.0f, layerY - 10.0f, 22.0f);
+        uint8_t px[4] = { toByte(m.r * l.r), toByte(m.g * l.g), toByte(m.b * l.b), toByte(m.a) };
+        std::memcpy(&materialPalette[i], px, 4);
     }
 }
 
+static inline void matColor(int id) {
+    glColor4ubv((const GLubyte*)&materialPalette[id]);
+}
 
 // ============================================================================
-// TERRAIN WITH REALISTIC LAYOUT
+// LIGHT PASS (night emitters gathered per frame, one low-res light buffer)
+// Street lamps, festival bulbs, fireflies, headlights and lit windows call
+// addLight() while the scene draws instead of stacking translucent circles.
+// After the scene, compositeLights() deposits every light bilinearly into a
+// 1/8 resolution RGB grid per size class, box-blurs each class twice
+// (separable running sums, so the blur cost does not depend on the radius
+// or the light count), packs the sum into one texture and lays it over the
+// scene twice: multiplied (dst * (1 + L), lit surfaces) and added
+// (dst + L * LIGHT_GLOW, the halo). Per-light cost is one deposit.
 // ============================================================================
 
-// void drawDistantHills() {
-//     glColor3f(0.08f, 0.35f, 0.08f);
-
-//     glBegin(GL_POLYGON);
-//     glVertex2f(0, 450);
-//     for (int x = 0; x <= WIDTH; x += 100) {
-//         float height = 450.0f + 80.0f * std::sin(x * 0.01f);
-//         glVertex2f(x, height);
-//     }
-//     glVertex2f(WIDTH, 450);
-//     glVertex2f(WIDTH, 400);
-//     glVertex2f(0, 400);
-//     glEnd();
+enum LightSize { LIGHT_SMALL, LIGHT_MEDIUM, LIGHT_LARGE, LIGHT_SIZES };
 
-//     glColor3f(0.12f, 0.45f, 0.12f);
-//     glBegin(GL_POLYGON);
-//     glVertex2f(0, 420);
-//     for (int x = 0; x <= WIDTH; x += 80) {
-//         float height = 420.0f + 60.0f * std::sin(x * 0.015f);
-//         glVertex2f(x, height);
-//     }
-//     glVertex2f(WIDTH, 420);
-//     glVertex2f(WIDTH, 380);
-//     glVertex2f(0, 380);
-//     glEnd();
-// }
+const int   LIGHT_CELL   = 8;                        // scene units per grid cell
+const int   LIGHT_GRID_W = WIDTH / LIGHT_CELL;       // 175
+const int   LIGHT_GRID_H = HEIGHT / LIGHT_CELL;      // 100
+const int   LIGHT_TEX_W  = 256;                      // power of two for old GL
+const int   LIGHT_TEX_H  = 128;
+const int   LIGHT_BLUR[LIGHT_SIZES] = {0, 1, 3};     // box radius (cells), applied twice
+const float LIGHT_GLOW   = 0.35f;
 
-void drawDistantHills() {
+struct PointLight {
+    float x, y;
+    float r, g, b;      // color * intensity
+    int   size;         // LightSize
+};
 
-    auto drawHillLayer = [&](float baseY, float bottomY,
-                             float amp1, float f1,
-                             float amp2, float f2,
-                             float step,
-                             float r, float g, float b)
-    {
-        glColor3f(r, g, b);
-        glBegin(GL_POLYGON);
+std::vector<PointLight>    frameLights;              // this frame's emitters
+std::vector<float>         lightGrid[LIGHT_SIZES];   // RGB per cell
+std::vector<unsigned char> lightTexels;              // RGBA8, LIGHT_TEX_W wide
+GLuint lightTexture = 0;
 
-        glVertex2f(0, bottomY);
-        glVertex2f(0, baseY);
+void addLight(float x, float y, int size, float r, float g, float b, float intensity) {
+    if (intensity <= 0.0f) return;
+    PointLight l = {x, y, r * intensity, g * intensity, b * intensity, size};
+    frameLights.push_back(l);
+}
 
-        for (float x = 0; x <= WIDTH; x += step) {
-            // mix 2 sine waves -> irregular, more natural
-            float h = baseY
-                    + amp1 * std::sin(x * f1)
-                    + amp2 * std::sin(x * f2 + 1.7f);
-            glVertex2f(x, h);
+// one box pass over a W x H RGB grid: rows into tmp (running sum per
+// channel), then columns back into g (one running sum per column, row order)
+static void boxBlurGrid(float* g, float* tmp, int W, int H, int radius) {
+    const float inv = 1.0f / (2 * radius + 1);
+    const int   row = W * 3;
+
+    for (int y = 0; y < H; y++) {
+        const float* in  = &g[y * row];
+        float*       out = &tmp[y * row];
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f;
+        for (int x = 0; x < std::min(radius, W); x++) { s0 += in[x * 3]; s1 += in[x * 3 + 1]; s2 += in[x * 3 + 2]; }
+        for (int x = 0; x < W; x++) {
+            if (x + radius < W) {
+                const float* a = &in[(x + radius) * 3];
+                s0 += a[0]; s1 += a[1]; s2 += a[2];
+            }
+            if (x - radius - 1 >= 0) {
+                const float* d = &in[(x - radius - 1) * 3];
+                s0 -= d[0]; s1 -= d[1]; s2 -= d[2];
+            }
+            out[x * 3] = s0 * inv; out[x * 3 + 1] = s1 * inv; out[x * 3 + 2] = s2 * inv;
         }
+    }
 
-        glVertex2f(WIDTH, baseY);
-        glVertex2f(WIDTH, bottomY);
+    std::vector<float> sum(row, 0.0f);
+    for (int y = 0; y < std::min(radius, H); y++)
+        for (int i = 0; i < row; i++) sum[i] += tmp[y * row + i];
+    for (int y = 0; y < H; y++) {
+        if (y + radius < H) {
+            const float* a = &tmp[(y + radius) * row];
+            for (int i = 0; i < row; i++) sum[i] += a[i];
+        }
+        if (y - radius - 1 >= 0) {
+            const float* d = &tmp[(y - radius - 1) * row];
+            for (int i = 0; i < row; i++) sum[i] -= d[i];
+        }
+        float* out = &g[y * row];
+        for (int i = 0; i < row; i++) out[i] = sum[i] * inv;
+    }
+}
 
-        glEnd();
-    };
+// grid only (no GL): deposit + blur + pack into lightTexels
+void accumulateLights() {
+    const int W = LIGHT_GRID_W, H = LIGHT_GRID_H;
+    bool used[LIGHT_SIZES] = {false, false, false};
+    for (size_t i = 0; i < frameLights.size(); i++) used[frameLights[i].size] = true;
+    for (int s = 0; s < LIGHT_SIZES; s++)
+        if (used[s]) lightGrid[s].assign((size_t)W * H * 3, 0.0f);
+
+    for (size_t i = 0; i < frameLights.size(); i++) {
+        const PointLight& l = frameLights[i];
+        float gx = l.x / LIGHT_CELL - 0.5f, gy = l.y / LIGHT_CELL - 0.5f;
+        int   ix = (int)std::floor(gx),     iy = (int)std::floor(gy);
+        if (ix < -1 || iy < -1 || ix >= W || iy >= H) continue;
+
+        // the blur spreads a deposit over (2r+1)^2 cells: scale so the peak is the color
+        float peak = (float)((2 * LIGHT_BLUR[l.size] + 1) * (2 * LIGHT_BLUR[l.size] + 1));
+        float fx = gx - ix, fy = gy - iy;
+        const float w[4]  = {(1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy};
+        const int   cx[4] = {ix, ix + 1, ix, ix + 1};
+        const int   cy[4] = {iy, iy, iy + 1, iy + 1};
+        float* grid = lightGrid[l.size].data();
+        for (int k = 0; k < 4; k++) {
+            if (cx[k] < 0 || cy[k] < 0 || cx[k] >= W || cy[k] >= H) continue;
+            float* cell = &grid[(cy[k] * W + cx[k]) * 3];
+            cell[0] += l.r * w[k] * peak;
+            cell[1] += l.g * w[k] * peak;
+            cell[2] += l.b * w[k] * peak;
+        }
+    }
 
-    // ---------------- FAR layer (light, smooth) ----------------
-    drawHillLayer(
-        465.0f, 400.0f,
-        35.0f, 0.0065f,
-        18.0f, 0.0140f,
-        25.0f,
-        0.10f, 0.38f, 0.10f
-    );
-
-    // ---------------- MID layer ----------------
-    drawHillLayer(
-        445.0f, 380.0f,
-        45.0f, 0.0080f,
-        22.0f, 0.0180f,
-        22.0f,
-        0.08f, 0.34f, 0.08f
-    );
-
-    // ---------------- NEAR layer (darker, more detail) ----------------
-    drawHillLayer(
-        425.0f, 360.0f,
-        55.0f, 0.0100f,
-        28.0f, 0.0240f,
-        18.0f,
-        0.06f, 0.28f, 0.06f
-    );
-
-    // ---------------- VERY NEAR strip (small bumps, foreground feel) ----------------
-    drawHillLayer(
-        405.0f, 350.0f,
-        28.0f, 0.0180f,
-        14.0f, 0.0450f,
-        14.0f,
-        0.05f, 0.22f, 0.05f
-    );
+    static std::vector<float> tmp;
+    tmp.resize((size_t)W * H * 3);
+    for (int s = 0; s < LIGHT_SIZES; s++) {
+        if (!used[s] || LIGHT_BLUR[s] == 0) continue;
+        for (int pass = 0; pass < 2; pass++)
+            boxBlurGrid(lightGrid[s].data(), tmp.data(), W, H, LIGHT_BLUR[s]);
+    }
 
-    // ✅ Optional: light mist line to soften horizon (looks very realistic)
-    if (!isDay) return; // keep mist mainly daytime (you can remove this line)
+    lightTexels.resize((size_t)LIGHT_TEX_W * H * 4);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            float rgb[3] = {0.0f, 0.0f, 0.0f};
+            for (int s = 0; s < LIGHT_SIZES; s++) {
+                if (!used[s]) continue;
+                const float* cell = &lightGrid[s][(y * W + x) * 3];
+                rgb[0] += cell[0]; rgb[1] += cell[1]; rgb[2] += cell[2];
+            }
+            unsigned char* out = &lightTexels[(y * LIGHT_TEX_W + x) * 4];
+            for (int c = 0; c < 3; c++) out[c] = (unsigned char)(255.0f * std::min(1.0f, rgb[c]));
+            out[3] = 255;
+        }
+    }
+}
 
+// after the scene, before the HUD
+void compositeLights() {
+    if (frameLights.empty()) return;
+    accumulateLights();
+    frameLights.clear();
+
+    if (!lightTexture) {
+        glGenTextures(1, &lightTexture);
+        glBindTexture(GL_TEXTURE_2D, lightTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, LIGHT_TEX_W, LIGHT_TEX_H, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    glBindTexture(GL_TEXTURE_2D, lightTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, LIGHT_TEX_W, LIGHT_GRID_H,
+                    GL_RGBA, GL_UNSIGNED_BYTE, lightTexels.data());
+
+    const float u1 = (float)LIGHT_GRID_W / LIGHT_TEX_W;
+    const float v1 = (float)LIGHT_GRID_H / LIGHT_TEX_H;
+    glEnable(GL_TEXTURE_2D);
     glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(0.9f, 0.95f, 1.0f, 0.08f);
-    glBegin(GL_QUADS);
-        glVertex2f(0, 455);
-        glVertex2f(WIDTH, 455);
-        glVertex2f(WIDTH, 395);
-        glVertex2f(0, 395);
-    glEnd();
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 0) { glBlendFunc(GL_DST_COLOR, GL_ONE); glColor4f(1.0f, 1.0f, 1.0f, 1.0f); }
+        else           { glBlendFunc(GL_ONE, GL_ONE);       glColor4f(LIGHT_GLOW, LIGHT_GLOW, LIGHT_GLOW, 1.0f); }
+        glBegin(GL_QUADS);
+            glTexCoord2f(0.0f, 0.0f); glVertex2f(0, 0);
+            glTexCoord2f(u1, 0.0f);   glVertex2f(WIDTH, 0);
+            glTexCoord2f(u1, v1);     glVertex2f(WIDTH, HEIGHT);
+            glTexCoord2f(0.0f, v1);   glVertex2f(0, HEIGHT);
+        glEnd();
+    }
     glDisable(GL_BLEND);
+    glDisable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+// ============================================================================
+// BLOOM (post-process: threshold, separable blur at 1/2 or 1/4 size, add)
+// After the scene (and the light pass) the frame is read back (through two
+// pixel-pack buffers when GL 3.3 is up, so the frame read is the previous
+// one and nothing stalls; plain glReadPixels otherwise), averaged
+// down by bloomDivisor with a soft luminance threshold (lower at night, so
+// the moon and lamps glow but the daytime sky does not), blurred with three
+// separable running-sum box passes (about a Gaussian, cost independent of
+// the radius) and added back over the scene as one texture. One RGBA pixel
+// is one SSE register (px4); without SSE2 the same code runs on 4 floats.
+// Replaces the old hand-drawn halo stacks around the sun and moon.
+// ============================================================================
+
+const float BLOOM_STRENGTH = 0.8f;
+const float BLOOM_RADIUS   = 16.0f;   // box radius in window pixels (x3 passes)
 
-void drawGround() {
-    float f = dayNightBlend;
+struct BloomBuffers {
+    int w, h;                          // blur size (window / bloomDivisor)
+    int texW, texH;                    // power-of-two texture holding it
+    std::vector<unsigned char> frame;  // read-back, window size
+    std::vector<float>         a, b;   // RGBA float, w x h
+    std::vector<unsigned char> out;    // RGBA8, w x h
+};
 
-    float dayLowR = 0.25f, dayLowG = 0.55f, dayLowB = 0.25f;
-    float dayHighR = 0.35f, dayHighG = 0.65f, dayHighB = 0.35f;
+BloomBuffers bloom = {};
+GLuint bloomTexture = 0;
+
+#if defined(__SSE2__)
+typedef __m128 px4;
+static inline px4  pxLoad(const float* p)        { return _mm_loadu_ps(p); }
+static inline void pxStore(float* p, px4 v)      { _mm_storeu_ps(p, v); }
+static inline px4  pxZero()                      { return _mm_setzero_ps(); }
+static inline px4  pxAdd(px4 a, px4 b)           { return _mm_add_ps(a, b); }
+static inline px4  pxSub(px4 a, px4 b)           { return _mm_sub_ps(a, b); }
+static inline px4  pxScale(px4 a, float s)       { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+#else
+struct px4 { float v[4]; };
+static inline px4  pxLoad(const float* p)        { px4 r; memcpy(r.v, p, sizeof(r.v)); return r; }
+static inline void pxStore(float* p, px4 v)      { memcpy(p, v.v, sizeof(v.v)); }
+static inline px4  pxZero()                      { px4 r = {{0, 0, 0, 0}}; return r; }
+static inline px4  pxAdd(px4 a, px4 b)           { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+static inline px4  pxSub(px4 a, px4 b)           { for (int i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+static inline px4  pxScale(px4 a, float s)       { for (int i = 0; i < 4; i++) a.v[i] *= s; return a; }
+#endif
 
-    float nightLowR = 0.07f, nightLowG = 0.18f, nightLowB = 0.07f;
-    float nightHighR = 0.12f, nightHighG = 0.25f, nightHighB = 0.12f;
+// frame (fw x fh RGBA8) -> dst (w x h RGBA float): box average + soft threshold.
+// The div source rows are summed into 16-bit lanes first (16 bytes at a time).
+void bloomDownsample(const unsigned char* frame, int fw, int fh, int div,
+                     float threshold, float* dst, int w, int h) {
+    static std::vector<uint16_t> rowSum;
+    rowSum.resize((size_t)fw * 4);
+    const int   rowBytes = fw * 4;
+    const float inv = 1.0f / (255.0f * div * div);
+
+    for (int y = 0; y < h; y++) {
+        std::fill(rowSum.begin(), rowSum.end(), 0);
+        uint16_t* acc = rowSum.data();
+        for (int sy = y * div; sy < std::min((y + 1) * div, fh); sy++) {
+            const unsigned char* src = &frame[(size_t)sy * rowBytes];
+            int i = 0;
+#if defined(__SSE2__)
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 16 <= rowBytes; i += 16) {
+                __m128i p  = _mm_loadu_si128((const __m128i*)&src[i]);
+                __m128i lo = _mm_loadu_si128((const __m128i*)&acc[i]);
+                __m128i hi = _mm_loadu_si128((const __m128i*)&acc[i + 8]);
+                _mm_storeu_si128((__m128i*)&acc[i],     _mm_add_epi16(lo, _mm_unpacklo_epi8(p, zero)));
+                _mm_storeu_si128((__m128i*)&acc[i + 8], _mm_add_epi16(hi, _mm_unpackhi_epi8(p, zero)));
+            }
+#endif
+            for (; i < rowBytes; i++) acc[i] += src[i];
+        }
 
-    float lowR  = dayLowR  * f + nightLowR  * (1.0f - f);
-    float lowG  = dayLowG  * f + nightLowG  * (1.0f - f);
-    float lowB  = dayLowB  * f + nightLowB  * (1.0f - f);
-    float highR = dayHighR * f + nightHighR * (1.0f - f);
-    float highG = dayHighG * f + nightHighG * (1.0f - f);
-    float highB = dayHighB * f + nightHighB * (1.0f - f);
+        for (int x = 0; x < w; x++) {
+            const uint16_t* p = &acc[x * div * 4];
+            int sum[3] = {0, 0, 0};
+            for (int sx = 0; sx < div; sx++, p += 4) {
+                sum[0] += p[0]; sum[1] += p[1]; sum[2] += p[2];
+            }
+            float r = sum[0] * inv, g = sum[1] * inv, b = sum[2] * inv;
+            float lum = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+            float k = std::min(1.0f, std::max(0.0f, (lum - threshold) / (1.0f - threshold)));
 
-    glBegin(GL_QUADS);
-    glColor3f(lowR, lowG, lowB);
-    glVertex2f(0, 0);
-    glVertex2f(WIDTH, 0);
-    glColor3f(highR, highG, highB);
-    glVertex2f(WIDTH, 380);
-    glVertex2f(0, 380);
-    glEnd();
+            float* out = &dst[(y * w + x) * 4];
+            out[0] = r * k; out[1] = g * k; out[2] = b * k; out[3] = 1.0f;
+        }
+    }
 }
 
-void drawFootpath() {
-    glBegin(GL_QUADS);
-    glColor3f(0.7f, 0.6f, 0.4f);
-    glVertex2f(0, 190);
-    glVertex2f(WIDTH, 190);
-    glVertex2f(WIDTH, 210);
-    glVertex2f(0, 210);
-    glEnd();
+// one separable box pass: rows src -> tmp, columns tmp -> src
+static void bloomBoxPass(float* src, float* tmp, int w, int h, int radius) {
+    const float inv = 1.0f / (2 * radius + 1);
+    const int   r   = std::min(radius, w - 1);
+
+    for (int y = 0; y < h; y++) {
+        const float* in  = &src[y * w * 4];
+        float*       out = &tmp[y * w * 4];
+        px4 sum = pxZero();
+        int x = 0;
+        for (int i = 0; i < r; i++) sum = pxAdd(sum, pxLoad(&in[i * 4]));
+        for (; x <= r && x < w; x++) {                               // left edge
+            if (x + r < w) sum = pxAdd(sum, pxLoad(&in[(x + r) * 4]));
+            pxStore(&out[x * 4], pxScale(sum, inv));
+        }
+        for (; x + r < w; x++) {                                     // middle
+            sum = pxSub(pxAdd(sum, pxLoad(&in[(x + r) * 4])), pxLoad(&in[(x - r - 1) * 4]));
+            pxStore(&out[x * 4], pxScale(sum, inv));
+        }
+        for (; x < w; x++) {                                         // right edge
+            sum = pxSub(sum, pxLoad(&in[(x - r - 1) * 4]));
+            pxStore(&out[x * 4], pxScale(sum, inv));
+        }
+    }
 
-    glColor3f(0.6f, 0.5f, 0.3f);
-    glLineWidth(1.0f);
-    glBegin(GL_LINES);
-    for (float x = 0; x < WIDTH; x += 40) {
-        glVertex2f(x, 200);
-        glVertex2f(x + 20, 200);
+    // columns in row order: one running sum per column
+    static std::vector<float> colSum;
+    colSum.assign((size_t)w * 4, 0.0f);
+    float* cs = colSum.data();
+    for (int y = 0; y < std::min(radius, h); y++)
+        for (int x = 0; x < w; x++) pxStore(&cs[x * 4], pxAdd(pxLoad(&cs[x * 4]), pxLoad(&tmp[(y * w + x) * 4])));
+    static std::vector<float> zeroRow;
+    zeroRow.assign((size_t)w * 4, 0.0f);
+    for (int y = 0; y < h; y++) {
+        const float* add = y + radius < h      ? &tmp[(y + radius) * w * 4]     : zeroRow.data();
+        const float* sub = y - radius - 1 >= 0 ? &tmp[(y - radius - 1) * w * 4] : zeroRow.data();
+        float* out = &src[y * w * 4];
+        for (int x = 0; x < w; x++) {
+            px4 s = pxSub(pxAdd(pxLoad(&cs[x * 4]), pxLoad(&add[x * 4])), pxLoad(&sub[x * 4]));
+            pxStore(&cs[x * 4], s);
+            pxStore(&out[x * 4], pxScale(s, inv));
+        }
     }
-    glEnd();
 }
 
-void drawRoad() {
-    float f = dayNightBlend;
-    float dayR1 = 0.25f, dayG1 = 0.25f, dayB1 = 0.25f;
-    float dayR2 = 0.35f, dayG2 = 0.35f, dayB2 = 0.35f;
+// float RGBA (0..1) -> RGBA8
+static void bloomPack(const float* src, unsigned char* dst, int n) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 s255 = _mm_set1_ps(255.0f);
+    for (; i + 4 <= n; i += 4) {
+        __m128i p0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&src[i * 4]),      s255));
+        __m128i p1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&src[i * 4 + 4]),  s255));
+        __m128i p2 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&src[i * 4 + 8]),  s255));
+        __m128i p3 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&src[i * 4 + 12]), s255));
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+        _mm_storeu_si128((__m128i*)&dst[i * 4], packed);
+    }
+#endif
+    for (; i < n; i++)
+        for (int c = 0; c < 4; c++)
+            dst[i * 4 + c] = (unsigned char)(255.0f * std::min(1.0f, std::max(0.0f, src[i * 4 + c])) + 0.5f);
+}
 
-    float nightR1 = 0.10f, nightG1 = 0.10f, nightB1 = 0.10f;
-    float nightR2 = 0.18f, nightG2 = 0.18f, nightB2 = 0.18f;
+// CPU part (no GL): frame (fw x fh RGBA8) -> blurred RGBA8 in bloom.out
+void bloomProcess(const unsigned char* frame, int fw, int fh, int div, float threshold) {
+    bloom.w = std::max(1, fw / div);
+    bloom.h = std::max(1, fh / div);
+    size_t n = (size_t)bloom.w * bloom.h;
+    bloom.a.resize(n * 4);
+    bloom.b.resize(n * 4);
+    bloom.out.resize(n * 4);
+
+    bloomDownsample(frame, fw, fh, div, threshold, bloom.a.data(), bloom.w, bloom.h);
+    int radius = std::max(1, (int)(BLOOM_RADIUS / div + 0.5f));
+    for (int pass = 0; pass < 3; pass++)
+        bloomBoxPass(bloom.a.data(), bloom.b.data(), bloom.w, bloom.h, radius);
+    bloomPack(bloom.a.data(), bloom.out.data(), (int)n);
+}
 
-    float r1 = dayR1 * f + nightR1 * (1.0f - f);
-    float g1 = dayG1 * f + nightG1 * (1.0f - f);
-    float b1 = dayB1 * f + nightB1 * (1.0f - f);
+// after the scene, before the HUD
+void applyBloom() {
+    if (!bloomEnabled) return;
+
+    int fw = winW, fh = winH;
+    const unsigned char* frame = mapLastFrame(fw, fh);
+    if (!frame) {   // no PBOs, or none filled at this size yet
+        bloom.frame.resize((size_t)fw * fh * 4);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, fw, fh, GL_RGBA, GL_UNSIGNED_BYTE, bloom.frame.data());
+        frame = bloom.frame.data();
+    }
 
-    float r2 = dayR2 * f + nightR2 * (1.0f - f);
-    float g2 = dayG2 * f + nightG2 * (1.0f - f);
-    float b2 = dayB2 * f + nightB2 * (1.0f - f);
+    // night: lower threshold so the moon and lamp cores bloom
+    bloomProcess(frame, fw, fh, bloomDivisor, 0.6f + 0.3f * dayNightBlend);
+    unmapLastFrame();
+
+    int texW = 1, texH = 1;
+    while (texW < bloom.w) texW <<= 1;
+    while (texH < bloom.h) texH <<= 1;
+    if (!bloomTexture || texW != bloom.texW || texH != bloom.texH) {
+        if (!bloomTexture) glGenTextures(1, &bloomTexture);
+        glBindTexture(GL_TEXTURE_2D, bloomTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texW, texH, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        bloom.texW = texW;
+        bloom.texH = texH;
+    }
+    glBindTexture(GL_TEXTURE_2D, bloomTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, bloom.w, bloom.h, GL_RGBA, GL_UNSIGNED_BYTE, bloom.out.data());
 
+    const float u1 = (float)bloom.w / texW, v1 = (float)bloom.h / texH;
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glColor4f(BLOOM_STRENGTH, BLOOM_STRENGTH, BLOOM_STRENGTH, 1.0f);
     glBegin(GL_QUADS);
-    glColor3f(r1, g1, b1);
-    glVertex2f(0, 210);
-    glVertex2f(WIDTH, 210);
-    glColor3f(r2, g2, b2);
-    glVertex2f(WIDTH, 280);
-    glVertex2f(0, 280);
-    glEnd();
-
-    float lineBright = 0.9f * f + 0.6f * (1.0f - f);
-    glColor3f(lineBright, lineBright, lineBright);
-    glLineWidth(3.0f);
-    glBegin(GL_LINES);
-    for (float x = 0; x < WIDTH; x += 60) {
-        float y = 245;
-        glVertex2f(x, y);
-        glVertex2f(x + 30, y);
-    }
+        glTexCoord2f(0.0f, 0.0f); glVertex2f(0, 0);
+        glTexCoord2f(u1, 0.0f);   glVertex2f(WIDTH, 0);
+        glTexCoord2f(u1, v1);     glVertex2f(WIDTH, HEIGHT);
+        glTexCoord2f(0.0f, v1);   glVertex2f(0, HEIGHT);
     glEnd();
+    glDisable(GL_BLEND);
+    glDisable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void drawRiver() {
-    float topY    = 180.0f;
-    float bottomY = 120.0f;
-    float midY    = (topY + bottomY) * 0.5f;
+// ============================================================================
+// VIEWPORT CULLING
+// cullScene() runs first in every frame. It gives each drawable that can
+// be off screen a conservative box (its drawing, plus the farthest its
+// ground shadow slides and its light halo spreads) and tests it against
+// cullView, before any geometry is built. The moving objects get a flag,
+// the train a coach range, the agent groups, clouds and sprite trees a
+// list of the members on view; props are tested where they are placed.
+// cullView is the world rectangle on screen, so a panning camera only has
+// to move it. Tested / culled counts per kind are kept per frame (HUD).
+// ============================================================================
 
-    float waveIntensity = 3.0f + 2.0f * std::sin(riverWave * 0.05f);
+enum CullKind { CULL_VEHICLE, CULL_SKY, CULL_PROP, CULL_TREE, CULL_FISH, CULL_WALKER, CULL_COW, CULL_KINDS };
+const char* const CULL_NAMES[CULL_KINDS] = {"vehicles", "sky", "props", "trees", "fish", "walkers", "cows"};
 
-    // helper: compute water colors (top & bottom) for any x
-    auto getColors = [&](float x,
-                         float &topR, float &topG, float &topB,
-                         float &botR, float &botG, float &botB)
-    {
-        // base day/night
-        float dayR = 0.18f, dayG = 0.42f, dayB = 0.85f;
-        float nR   = 0.08f, nG   = 0.20f, nB   = 0.45f;
-
-        float baseR = dayR * dayNightBlend + nR * (1.0f - dayNightBlend);
-        float baseG = dayG * dayNightBlend + nG * (1.0f - dayNightBlend);
-        float baseB = dayB * dayNightBlend + nB * (1.0f - dayNightBlend);
-
-        // depth: middle darker + slight variation
-        float depth = 0.10f + 0.10f * std::sin(x * 0.02f + riverWave * 0.02f);
-
-        topR = baseR + 0.10f;
-        topG = baseG + 0.10f;
-        topB = baseB + 0.12f;
-
-        botR = baseR - depth;
-        botG = baseG - depth * 0.9f;
-        botB = baseB - depth * 0.6f;
-
-        // daytime sparkle zone
-        if (isDay && x > WIDTH * 0.70f && x < WIDTH * 0.92f) {
-            float s = 0.10f + 0.10f * std::sin((x - WIDTH * 0.78f) * 0.06f + riverWave * 0.10f);
-            topR += s; topG += s; topB += s;
-        }
-    };
+// the moving objects drawn one at a time
+enum CullObject { CO_CAR, CO_BUS, CO_ENGINE, CO_BOAT, CO_PLANE, CO_BALLOON, CO_KITE, CO_BIRDS, CO_COUNT };
 
-    // -------------------- WATER BODY (quad strip) --------------------
-    glBegin(GL_QUAD_STRIP);
+struct CullBox { float x0, y0, x1, y1; };
 
-    for (int xi = 0; xi < WIDTH; xi += 18) {   // ✅ < WIDTH
-        float x = (float)xi;
+const float SHADOW_REACH = 2.2f;   // footprint rx: slides up to 0.6, stretches up to 1.6
 
-        float w1 = waveIntensity * std::sin(x * 0.03f + riverWave * 0.10f);
-        float w2 = waveIntensity * std::sin(x * 0.03f + riverWave * 0.10f + 0.55f);
+CullBox cullView = {0.0f, 0.0f, (float)WIDTH, (float)HEIGHT};
+int     cullTested[CULL_KINDS], cullSkipped[CULL_KINDS];   // this frame
 
-        float topR, topG, topB, botR, botG, botB;
-        getColors(x, topR, topG, topB, botR, botG, botB);
+bool             cullShown[CO_COUNT];
+int              coachFirst = 0, coachLast = -1;   // coaches on view
+std::vector<int> fishShown, walkersShown, cowsShown, cloudsShown, forestShown;
 
-        glColor3f(topR, topG, topB);
-        glVertex2f(x, topY + w1);
+static inline bool onView(const CullBox& b) {
+    return b.x1 >= cullView.x0 && b.x0 <= cullView.x1 && b.y1 >= cullView.y0 && b.y0 <= cullView.y1;
+}
 
-        glColor3f(botR, botG, botB);
-        glVertex2f(x, bottomY + w2);
-    }
+static inline bool cullVisible(int kind, const CullBox& b) {
+    cullTested[kind]++;
+    if (onView(b)) return true;
+    cullSkipped[kind]++;
+    return false;
+}
 
-    // ✅ FORCE LAST VERTEX at WIDTH (fix right-side missing water)
-    {
-        float x = (float)WIDTH;
+static inline CullBox cullUnion(const CullBox& a, const CullBox& b) {
+    CullBox u = {std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1)};
+    return u;
+}
 
-        float w1 = waveIntensity * std::sin(x * 0.03f + riverWave * 0.10f);
-        float w2 = waveIntensity * std::sin(x * 0.03f + riverWave * 0.10f + 0.55f);
+// everything an addShadow(cx, cy, rx, ry) footprint can cover
+static inline CullBox shadowBox(float cx, float cy, float rx, float ry) {
+    CullBox b = {cx - rx * SHADOW_REACH, cy - ry, cx + rx * SHADOW_REACH, cy + ry};
+    return b;
+}
 
-        float topR, topG, topB, botR, botG, botB;
-        getColors(x, topR, topG, topB, botR, botG, botB);
+// an addLight() at (x, y): one cell for the deposit, then two box blurs
+static inline CullBox glowBox(float x, float y, int size) {
+    float r = (float)((2 * LIGHT_BLUR[size] + 1) * LIGHT_CELL);
+    CullBox b = {x - r, y - r, x + r, y + r};
+    return b;
+}
 
-        glColor3f(topR, topG, topB);
-        glVertex2f(x, topY + w1);
+// members of a group on view, in drawing order
+template <typename T, typename BoxOf>
+static void cullGroup(int kind, const std::vector<T>& all, std::vector<int>& shown, BoxOf boxOf) {
+    shown.clear();
+    for (size_t i = 0; i < all.size(); i++)
+        if (onView(boxOf(all[i]))) shown.push_back((int)i);
+    cullTested[kind]  += (int)all.size();
+    cullSkipped[kind] += (int)(all.size() - shown.size());
+}
 
-        glColor3f(botR, botG, botB);
-        glVertex2f(x, bottomY + w2);
-    }
+// ============================================================================
+// SHADOW PASS (ground shadows registered while drawing, one draw per frame)
+// Trees, vehicles, people and props call addShadow() with the footprint
+// they used to fill on the spot. The scene writes a surface mask into the
+// stencil buffer as it draws: ground (grass, field, rail bed, footpath,
+// road, dock, bus stop platform, sand pad) writes MASK_GROUND, open water
+// MASK_WATER (ground for shadows, see REFLECTION PASS) and everything else
+// MASK_OBJECT. drawShadowPass() then fills every footprint from one vertex
+// array under one blend state where the object bit is clear, setting it,
+// so a shadow never covers the object that casts it and overlaps do not
+// darken twice.
+// drawSunMoon() sets shadowLight once per frame: footprints slide away
+// from the sun and stretch as it gets low, and turn into faint moon
+// shadows at night. Without a stencil buffer addShadow() draws at once.
+// ============================================================================
 
-    glEnd();
+const int SHADOW_SEGMENTS = 24;
 
-    // -------------------- SPARKLES (daytime glitter) --------------------
-    if (isDay) {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+// stencil values written while the scene draws (bit 0: object, bit 1: water)
+enum SurfaceMask { MASK_GROUND = 0, MASK_OBJECT = 1, MASK_WATER = 2 };
 
-        glPointSize(2.0f);
-        glBegin(GL_POINTS);
-        for (int i = 0; i < 120; i++) {
-            float px = (i * 37 + (int)(riverWave * 10)) % WIDTH;
-            float py = midY + std::sin((px * 0.03f) + riverWave * 0.08f + i) * 10.0f;
+struct ShadowCaster {
+    float cx, cy, rx, ry, alpha;
+};
 
-            float a = 0.10f + 0.25f * (0.5f + 0.5f * std::sin(riverWave * 0.15f + i));
-            glColor4f(1.0f, 1.0f, 1.0f, a);
-            glVertex2f(px, py);
-        }
-        glEnd();
+struct ShadowLight {
+    float shift;      // footprint centre offset, in caster rx (+ = to the right)
+    float stretch;    // rx scale
+    float strength;   // alpha scale
+};
 
-        glDisable(GL_BLEND);
-    }
+std::vector<ShadowCaster> frameShadows;   // this frame's casters
+std::vector<float>        shadowXY;       // batch: 3 vertices per segment
+std::vector<GLubyte>      shadowRGBA;
+ShadowLight shadowLight = {0.0f, 1.0f, 1.0f};
+
+// arc: the light's angle on its path, 0 rising on the left .. PI setting on the right
+void setShadowLight(float arc, float strength) {
+    float low = 1.0f - std::sin(arc);   // 0 overhead .. 1 on the horizon
+    shadowLight.stretch  = 1.0f + 0.6f * low;
+    shadowLight.shift    = std::cos(arc) * 0.6f * low;   // keeps the near edge under the caster
+    shadowLight.strength = strength * (1.0f - 0.35f * low);
+}
 
-    // -------------------- BANK FOAM --------------------
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+// lit like the batch, but filled on the spot: for a caster that is itself
+// ground (the playground's sand pad), so it can draw over its own shadow
+void drawShadowNow(float cx, float cy, float rx, float ry, float alpha) {
+    const ShadowLight& L = shadowLight;
+    drawShadowEllipse(cx + rx * L.shift, cy, rx * L.stretch, ry, alpha * L.strength);
+}
 
-    glColor4f(0.90f, 0.95f, 1.0f, 0.18f);
-    for (int x = 0; x <= WIDTH; x += 28) {
-        float t = std::sin(x * 0.08f + riverWave * 0.18f) * 2.0f;
-        drawEllipse((float)x, topY - 3.0f + t,    10.0f, 2.6f, 18);
-        drawEllipse((float)x, bottomY + 3.0f + t, 10.0f, 2.6f, 18);
+void addShadow(float cx, float cy, float rx, float ry, float alpha) {
+    if (!shadowStencil) {
+        drawShadowNow(cx, cy, rx, ry, alpha);
+        return;
     }
+    ShadowCaster c = {cx, cy, rx, ry, alpha};
+    frameShadows.push_back(c);
+}
 
-    // -------------------- SUBTLE RIPPLE RINGS --------------------
-    glColor4f(0.85f, 0.95f, 1.0f, 0.10f);
-    for (int i = 0; i < 6; i++) {
-        float rx = (200.0f + i * 170.0f) + std::sin(riverWave * 0.04f + i) * 25.0f;
-        float ry = 140.0f + std::sin(riverWave * 0.07f + i * 2.0f) * 8.0f;
-        float rr = 10.0f + std::fmod(riverWave * (1.2f + i * 0.25f), 18.0f);
-        drawEllipse(rx, ry, rr, rr * 0.35f, 30);
+// start of the scene: every fragment marks the stencil, as an object by default
+void beginShadowMask() {
+    if (!shadowStencil) return;
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_ALWAYS, MASK_OBJECT, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+}
+
+// what the following draws are: MASK_GROUND, MASK_WATER or back to MASK_OBJECT
+void surfaceMask(int mask) {
+    if (shadowStencil) glStencilFunc(GL_ALWAYS, mask, 0xFF);
+}
+
+// casters -> triangle list (no GL), lit by shadowLight
+static int buildShadowBatch() {
+    static float ring[SHADOW_SEGMENTS + 1][2];
+    static bool  ringReady = false;
+    if (!ringReady) {
+        for (int i = 0; i <= SHADOW_SEGMENTS; i++) {
+            float a = 2.0f * 3.1415926f * i / SHADOW_SEGMENTS;
+            ring[i][0] = std::cos(a);
+            ring[i][1] = std::sin(a);
+        }
+        ringReady = true;
     }
 
-    glDisable(GL_BLEND);
+    const ShadowLight& L = shadowLight;
+    const int n = (int)frameShadows.size() * SHADOW_SEGMENTS * 3;
+    shadowXY.resize((size_t)n * 2);
+    shadowRGBA.assign((size_t)n * 4, 0);
+
+    float*   xy   = shadowXY.data();
+    GLubyte* rgba = shadowRGBA.data();
+    for (size_t k = 0; k < frameShadows.size(); k++) {
+        const ShadowCaster& c = frameShadows[k];
+        float   cx = c.cx + c.rx * L.shift;
+        float   rx = c.rx * L.stretch;
+        GLubyte a  = (GLubyte)(std::min(1.0f, c.alpha * L.strength) * 255.0f + 0.5f);
+        for (int i = 0; i < SHADOW_SEGMENTS; i++) {
+            xy[0] = cx;                       xy[1] = c.cy;
+            xy[2] = cx + rx * ring[i][0];     xy[3] = c.cy + c.ry * ring[i][1];
+            xy[4] = cx + rx * ring[i + 1][0]; xy[5] = c.cy + c.ry * ring[i + 1][1];
+            rgba[3] = rgba[7] = rgba[11] = a;
+            xy   += 6;
+            rgba += 12;
+        }
+    }
+    return n;
+}
 
-    // -------------------- MOON REFLECTION (night) --------------------
-    if (!isDay) {
-        float mx = WIDTH * 0.85f;
-        float cy = midY;
+// after the ground-level scene, before airborne effects (bulbs, fireflies, rain)
+void drawShadowPass() {
+    if (!shadowStencil) return;
+    if (!frameShadows.empty()) {
+        int n = buildShadowBatch();
+        frameShadows.clear();
 
+        glStencilFunc(GL_EQUAL, 0, MASK_OBJECT);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+        glStencilMask(MASK_OBJECT);
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 0, shadowXY.data());
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, shadowRGBA.data());
+        glDrawArrays(GL_TRIANGLES, 0, n);
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisable(GL_BLEND);
+        glStencilMask(0xFF);
+    }
+    glDisable(GL_STENCIL_TEST);
+}
 
-        glColor4f(0.9f, 0.9f, 1.0f, 0.22f);
-        drawEllipse(mx, cy, 48.0f, 9.0f, 44);
+// ============================================================================
+// CABLES (catenary spans between anchor pairs, cached, one draw per layer)
+// Power lines, festival garland wires and the fishing line hang as
+// catenaries y = a*cosh((x - x0)/a) + c through their two anchors, with a
+// solved (bisection) for the span's sag below the chord midpoint. Every
+// span owns a fixed slot of GL_LINES vertices in one shared array.
+// setCable() re-tessellates a slot only when its anchors or its swayed sag
+// (quantised to 1/4 unit) change, so cables in still air cost nothing per
+// frame. drawCables() draws every span of a layer set this frame with one
+// glDrawElements: the power lines behind the houses, the garlands and the
+// fishing line in front of everything on the ground.
+// Wind swings a cable towards / away from the viewer, which shows up as a
+// shallower sag.
+// ============================================================================
 
-        glColor4f(0.9f, 0.9f, 1.0f, 0.12f);
-        drawEllipse(mx + 10.0f, cy - 7.0f, 36.0f, 7.0f, 36);
-        drawEllipse(mx - 8.0f,  cy - 13.0f, 28.0f, 6.0f, 32);
+enum CableLayer { CABLE_BACK, CABLE_FRONT, CABLE_LAYERS };
 
-        glDisable(GL_BLEND);
+struct CableSpan {
+    int     layer;
+    int     first, segments;   // slot: vertices [first, first + 2 * segments)
+    float   sag;               // below the chord midpoint, in still air
+    float   swayPhase;
+    double  a, x0, c;          // current catenary
+    float   key[5];            // anchors + quantised sag of the cached slot
+    bool    shown;             // set this frame
+};
+
+std::vector<CableSpan> cables;
+std::vector<float>     cableXY;
+std::vector<GLubyte>   cableRGBA;
+std::vector<GLuint>    cableIndex;       // per-layer draw list, rebuilt per frame
+int cableTessellations = 0;              // re-tessellated slots (bench)
+
+int addCable(int layer, int segments, float sag, float r, float g, float b, float a) {
+    CableSpan c;
+    c.layer     = layer;
+    c.first     = (int)(cableXY.size() / 2);
+    c.segments  = segments;
+    c.sag       = sag;
+    c.swayPhase = cables.size() * 1.7f;
+    c.a = 1.0; c.x0 = 0.0; c.c = 0.0;
+    c.key[0]    = NAN;   // never matches: first setCable() tessellates
+    c.shown     = false;
+    cables.push_back(c);
+
+    cableXY.resize(cableXY.size() + segments * 4, 0.0f);
+    const GLubyte rgba[4] = {(GLubyte)(r * 255.0f + 0.5f), (GLubyte)(g * 255.0f + 0.5f),
+                             (GLubyte)(b * 255.0f + 0.5f), (GLubyte)(a * 255.0f + 0.5f)};
+    for (int i = 0; i < segments * 2; i++) cableRGBA.insert(cableRGBA.end(), rgba, rgba + 4);
+    return (int)cables.size() - 1;
+}
+
+// catenary through (ax, ay) and (bx, by), bx > ax, hanging `sag` below the
+// chord midpoint: fills a, x0, c
+static void solveCatenary(CableSpan& s, double ax, double ay, double bx, double by, double sag) {
+    double L = bx - ax, h = by - ay, xm = 0.5 * (ax + bx);
+    auto fit = [&](double a) {
+        s.a  = a;
+        s.x0 = xm - a * std::asinh(h / (2.0 * a * std::sinh(L / (2.0 * a))));
+        s.c  = ay - a * std::cosh((ax - s.x0) / a);
+        return 0.5 * (ay + by) - (a * std::cosh((xm - s.x0) / a) + s.c);   // sag for this a
+    };
+    if (sag <= 0.0) { fit(1e6 * L); return; }   // taut
+
+    // sag falls as a grows: bisect on log(a)
+    double lo = std::log(L / 40.0), hi = std::log(L * 1e4);
+    for (int i = 0; i < 40; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (fit(std::exp(mid)) > sag) lo = mid; else hi = mid;
     }
+    fit(std::exp(hi));
+}
 
-    // -------------------- RIVER BANK (soil strips) --------------------
-    glColor3f(0.45f, 0.35f, 0.20f);
-    glBegin(GL_QUADS);
-        glVertex2f(0, topY);
-        glVertex2f(WIDTH, topY);
-        glVertex2f(WIDTH, topY + 10);
-        glVertex2f(0, topY + 10);
+static inline float cableY(const CableSpan& s, float x) {
+    return (float)(s.a * std::cosh((x - s.x0) / s.a) + s.c);
+}
 
-        glVertex2f(0, bottomY - 10);
-        glVertex2f(WIDTH, bottomY - 10);
-        glVertex2f(WIDTH, bottomY);
-        glVertex2f(0, bottomY);
-    glEnd();
+// anchors for this frame (either order); marks the span for drawing
+void setCable(int id, float ax, float ay, float bx, float by) {
+    CableSpan& s = cables[id];
+    if (bx < ax) { std::swap(ax, bx); std::swap(ay, by); }
+    s.shown = true;
+
+    float swing = 0.5f * windIntensity * (0.5f + 0.5f * std::sin(riverWave * 0.02f + s.swayPhase));
+    float sag   = std::floor(s.sag * (1.0f - 0.3f * std::min(1.0f, swing)) * 4.0f + 0.5f) * 0.25f;
+    if (s.key[0] == ax && s.key[1] == ay && s.key[2] == bx && s.key[3] == by && s.key[4] == sag) return;
+    s.key[0] = ax; s.key[1] = ay; s.key[2] = bx; s.key[3] = by; s.key[4] = sag;
+    cableTessellations++;
+
+    if (bx - ax < 0.5f) bx = ax + 0.5f;   // plumb line: nearly vertical is fine
+    solveCatenary(s, ax, ay, bx, by, sag);
+
+    float* v  = &cableXY[s.first * 2];
+    float  px = ax, py = ay;
+    for (int i = 1; i <= s.segments; i++) {
+        float x = ax + (bx - ax) * i / s.segments;
+        float y = (i == s.segments) ? by : cableY(s, x);
+        v[0] = px; v[1] = py; v[2] = x; v[3] = y;
+        v += 4;
+        px = x; py = y;
+    }
 }
 
+// height of a span's current curve at x (bulbs hung along a garland)
+float cableHeightAt(int id, float x) {
+    return cableY(cables[id], x);
+}
 
+void drawCables(int layer) {
+    cableIndex.clear();
+    for (size_t k = 0; k < cables.size(); k++) {
+        CableSpan& s = cables[k];
+        if (s.layer != layer || !s.shown) continue;
+        s.shown = false;
+        for (int i = 0; i < s.segments * 2; i++) cableIndex.push_back((GLuint)(s.first + i));
+    }
+    if (cableIndex.empty()) return;
 
-void drawRailTrack() {
-    float k = 0.55f + 0.45f * dayNightBlend;   // day/night brightness
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glLineWidth(2.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, cableXY.data());
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, cableRGBA.data());
+    glDrawElements(GL_LINES, (GLsizei)cableIndex.size(), GL_UNSIGNED_INT, cableIndex.data());
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisable(GL_BLEND);
+}
 
-    float y0 = 335.0f;   // ballast bottom
-    float y1 = 360.0f;   // ballast top
+// the scene's spans (segment counts fit the anchors they are set with)
+const float POLE_X[]   = {140.0f, 300.0f, 460.0f, 620.0f, 780.0f, 940.0f, 1100.0f, 1260.0f};
+const int   POLE_COUNT = sizeof(POLE_X) / sizeof(POLE_X[0]);
+int powerLine[POLE_COUNT - 1];
+int garlandWire[2];
+int fishingLine = -1;
+
+void initCables() {
+    cables.clear();
+    cableXY.clear();
+    cableRGBA.clear();
+    for (int i = 0; i < POLE_COUNT - 1; i++)
+        powerLine[i] = addCable(CABLE_BACK, 16, 9.0f, 0.2f, 0.2f, 0.2f, 1.0f);
+    for (int h = 0; h < 2; h++)
+        garlandWire[h] = addCable(CABLE_FRONT, 12, 6.0f, 0.8f, 0.8f, 0.8f, 0.6f);
+    fishingLine = addCable(CABLE_FRONT, 10, 3.0f, 0.95f, 0.95f, 1.0f, 0.8f);
+}
+
+// ============================================================================
+// SKY AND BACKGROUND WITH SMOOTH TRANSITIONS
+// ============================================================================
+
+void drawSky() {
+    if (shaderPathActive()) { drawSkyShader(); return; }
 
-    // ---------- BALLAST (stone base) gradient ----------
     glBegin(GL_QUADS);
-        glColor3f(0.20f * k, 0.18f * k, 0.16f * k);
-        glVertex2f(0, y0);
-        glVertex2f(WIDTH, y0);
+    todColor(TOD_SKY_TOP);
+    glVertex2f(0, HEIGHT);
+    glVertex2f(WIDTH, HEIGHT);
 
-        glColor3f(0.28f * k, 0.25f * k, 0.22f * k);
-        glVertex2f(WIDTH, y1);
-        glVertex2f(0, y1);
+    todColor(TOD_SKY_BOTTOM);
+    glVertex2f(WIDTH, HEIGHT * 0.6f);
+    glVertex2f(0, HEIGHT * 0.6f);
     glEnd();
+}
 
-    // small random stones dots (gives realism)
-    glPointSize(2.0f);
-    glBegin(GL_POINTS);
-    for (int i = 0; i < 220; i++) {
-        float x = (i * 37) % WIDTH;
-        float y = y0 + 2 + (i * 19) % (int)(y1 - y0 - 4);
-        float c = 0.35f * k + 0.15f * ((i % 3) * 0.25f);
-        glColor3f(c, c, c);
-        glVertex2f(x, y);
-    }
-    glEnd();
+// ============================================================================
+// STARFIELD (static buffer, twinkle + sky rotation)
+// Stars are generated once over a disc around the pole STAR_POLE (top centre
+// of the sky) and the whole disc turns once per day/night cycle with
+// sunAngle; a clip plane keeps them above the horizon line. About a quarter
+// of the disc is on screen at a time.
+// Twinkle: every star has a phase, a rate class and a magnitude. Per frame
+// the fixed-function path fills a small 4 x 256 brightness table and then
+// only writes one alpha byte per star; the shader path does it per vertex.
+// Stars are sorted bright first so they draw as two ranges (2 px smooth,
+// 1 px plain) without per-vertex point sizes.
+// ============================================================================
 
-    // ---------- SLEEPERS (wooden ties) ----------
-    float sleeperY0 = y0 + 4;
-    float sleeperY1 = y1 - 4;
+const float STAR_POLE_X   = WIDTH * 0.5f;
+const float STAR_POLE_Y   = HEIGHT;
+const float STAR_HORIZON  = HEIGHT * 0.6f;
+const int   STAR_RATES    = 4;
+const int   MAX_STARS     = 1000000;
+
+struct Star {
+    float   x, y;           // unrotated, scene coords
+    uint8_t r, g, b, mag;   // tint + magnitude (brightness)
+    uint8_t phase, rate;    // twinkle phase (1/256 turns), rate class
+    uint8_t pad[2];
+};
 
-    for (float x = 0; x < WIDTH; x += 42.0f) {
-        // wood
-        glColor3f(0.36f * k, 0.25f * k, 0.14f * k);
-        glBegin(GL_QUADS);
-            glVertex2f(x,      sleeperY0);
-            glVertex2f(x+28.0f,sleeperY0);
-            glVertex2f(x+30.0f,sleeperY1);
-            glVertex2f(x-2.0f, sleeperY1);
-        glEnd();
+std::vector<Star>     starfield;
+std::vector<uint32_t> starColors;    // RGBA8, streamed (fixed-function path)
+int starCount  = 400;                // --stars N
+int brightStars = 0;                 // starfield[0 .. brightStars) draw at 2 px
+
+void initStarfield(int count) {
+    starfield.clear();
+    starColors.clear();
+    uint32_t seed = 424242u;
+    auto rnd = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) * (1.0f / 16777216.0f);
+    };
 
-        // darker bottom strip (depth)
-        glColor3f(0.22f * k, 0.15f * k, 0.08f * k);
-        glBegin(GL_QUADS);
-            glVertex2f(x,       sleeperY0);
-            glVertex2f(x+28.0f, sleeperY0);
-            glVertex2f(x+28.0f, sleeperY0+3.0f);
-            glVertex2f(x,       sleeperY0+3.0f);
-        glEnd();
+    // the disc must cover the sky band at every rotation angle
+    const float radius = std::sqrt(STAR_POLE_X * STAR_POLE_X +
+                                   (STAR_POLE_Y - STAR_HORIZON) * (STAR_POLE_Y - STAR_HORIZON));
+    const uint8_t tints[3][3] = {{255, 255, 255}, {230, 230, 255}, {255, 230, 230}};
+
+    for (int i = 0; i < count; i++) {
+        Star s;
+        float rr = radius * std::sqrt(rnd());          // uniform over the disc
+        float a  = rnd() * 2.0f * (float)M_PI;
+        s.x = STAR_POLE_X + rr * std::cos(a);
+        s.y = STAR_POLE_Y + rr * std::sin(a);
+        s.r = tints[i % 3][0]; s.g = tints[i % 3][1]; s.b = tints[i % 3][2];
+        float m = rnd();
+        s.mag   = (uint8_t)(90 + 165 * m * m * m);     // mostly faint
+        s.phase = (uint8_t)(rnd() * 256.0f);
+        s.rate  = (uint8_t)(i % STAR_RATES);
+        s.pad[0] = s.pad[1] = 0;
+        starfield.push_back(s);
     }
+    std::sort(starfield.begin(), starfield.end(),
+              [](const Star& a, const Star& b) { return a.mag > b.mag; });
 
-    // ---------- RAILS ----------
-    float railY1 = 347.0f;
-    float railY2 = 354.0f;
+    brightStars = 0;
+    while (brightStars < count && starfield[brightStars].mag >= 200) brightStars++;
 
-    // rail shadow (under rails)
-    glColor3f(0.10f * k, 0.10f * k, 0.10f * k);
-    glLineWidth(6.0f);
-    glBegin(GL_LINES);
-        glVertex2f(0, railY1 - 2); glVertex2f(WIDTH, railY1 - 2);
-        glVertex2f(0, railY2 - 2); glVertex2f(WIDTH, railY2 - 2);
-    glEnd();
+    // tints are fixed; updateStarColors() only rewrites the alpha bytes
+    starColors.resize(starfield.size());
+    for (size_t i = 0; i < starfield.size(); i++) {
+        uint8_t* c = (uint8_t*)&starColors[i];
+        c[0] = starfield[i].r; c[1] = starfield[i].g; c[2] = starfield[i].b; c[3] = 0;
+    }
+}
 
-    // main rails
-    glColor3f(0.55f * k, 0.55f * k, 0.58f * k);
-    glLineWidth(4.0f);
-    glBegin(GL_LINES);
-        glVertex2f(0, railY1); glVertex2f(WIDTH, railY1);
-        glVertex2f(0, railY2); glVertex2f(WIDTH, railY2);
-    glEnd();
+// 0 by day, 1 in full night (stars fade in below dayNightBlend 0.3)
+float starFade() {
+    if (isDay) return 0.0f;
+    return std::max(0.0f, 1.0f - dayNightBlend / 0.3f);
+}
 
-    // top shine line (metal highlight)
-    glColor3f(0.85f * k, 0.85f * k, 0.88f * k);
-    glLineWidth(1.5f);
-    glBegin(GL_LINES);
-        glVertex2f(0, railY1 + 1.0f); glVertex2f(WIDTH, railY1 + 1.0f);
-        glVertex2f(0, railY2 + 1.0f); glVertex2f(WIDTH, railY2 + 1.0f);
-    glEnd();
+// twinkle rate of class c, radians per tick
+static inline float starRate(int c) {
+    return 0.04f + 0.03f * c;
+}
 
-    // ---------- SMALL BOLTS / PLATES ----------
-    glColor3f(0.25f * k, 0.25f * k, 0.28f * k);
-    for (float x = 8; x < WIDTH; x += 42.0f) {
-        // plates
-        glBegin(GL_QUADS);
-            glVertex2f(x+6, railY1-3); glVertex2f(x+14, railY1-3);
-            glVertex2f(x+14, railY1+3); glVertex2f(x+6, railY1+3);
+// fixed-function path: brightness table, then one alpha byte per star.
+// sin(a + phase) = sin a cos phase + cos a sin phase, with the phase
+// sines fixed, so the table costs two sines per rate class.
+void updateStarColors(float fade) {
+    static float phaseSin[256], phaseCos[256];
+    if (phaseCos[0] == 0.0f) {
+        for (int p = 0; p < 256; p++) {
+            phaseSin[p] = std::sin(p * (2.0f * (float)M_PI / 256.0f));
+            phaseCos[p] = std::cos(p * (2.0f * (float)M_PI / 256.0f));
+        }
+    }
 
-            glVertex2f(x+6, railY2-3); glVertex2f(x+14, railY2-3);
-            glVertex2f(x+14, railY2+3); glVertex2f(x+6, railY2+3);
-        glEnd();
+    uint16_t twinkle[STAR_RATES][256];   // 0 .. 256 (8.8 fixed point)
+    const float t = (float)scene.tick;
+    for (int c = 0; c < STAR_RATES; c++) {
+        float sa = fastSin(t * starRate(c));
+        float ca = fastSin(t * starRate(c) + 0.5f * (float)M_PI);
+        for (int p = 0; p < 256; p++)
+            twinkle[c][p] = (uint16_t)(256.0f * fade *
+                (0.65f + 0.35f * (sa * phaseCos[p] + ca * phaseSin[p])));
+    }
 
-        // bolts dots
-        glPointSize(2.0f);
-        glBegin(GL_POINTS);
-            glVertex2f(x+7, railY1-1);
-            glVertex2f(x+13, railY1-1);
-            glVertex2f(x+7, railY2-1);
-            glVertex2f(x+13, railY2-1);
-        glEnd();
+    const size_t n = starfield.size();
+    uint8_t* color = (uint8_t*)starColors.data();
+    for (size_t i = 0; i < n; i++) {
+        const Star& s = starfield[i];
+        color[i * 4 + 3] = (uint8_t)((s.mag * twinkle[s.rate][s.phase]) >> 8);
     }
 }
 
+// clip plane y >= STAR_HORIZON, in eye coords (identity modelview)
+static void beginStarClip() {
+    const GLdouble horizon[4] = {0.0, 1.0, 0.0, -STAR_HORIZON};
+    glClipPlane(GL_CLIP_PLANE0, horizon);
+    glEnable(GL_CLIP_PLANE0);
+}
 
-// ============================================================================
-// DIVERSE HOUSES
-// ============================================================================
+static void drawStarRanges() {
+    glPointSize(2.0f);
+    glDrawArrays(GL_POINTS, 0, brightStars);
+    glDisable(GL_POINT_SMOOTH);
+    glPointSize(1.0f);
+    glDrawArrays(GL_POINTS, brightStars, (GLsizei)starfield.size() - brightStars);
+    glEnable(GL_POINT_SMOOTH);
+}
+
+void drawStars() {
+    float fade = starFade();
+    if (fade <= 0.0f || starfield.empty()) return;
 
-void drawModernHouse(float x, float y) {
-    // shadow
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(0,0,0,0.18f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+6, y-2); glVertex2f(x+126, y-2);
-        glVertex2f(x+126, y+142); glVertex2f(x+6, y+142);
-    glEnd();
-    glDisable(GL_BLEND);
+    beginStarClip();
 
-    // body
-    glColor3f(0.25f, 0.55f, 0.85f);
-    glBegin(GL_QUADS);
-        glVertex2f(x, y);
-        glVertex2f(x+120, y);
-        glVertex2f(x+120, y+140);
-        glVertex2f(x, y+140);
-    glEnd();
+    if (shaderPathActive()) {
+        drawStarsShader();
+    } else {
+        updateStarColors(fade);
 
-    // roof slab (overhang)
-    glColor3f(0.88f, 0.88f, 0.88f);
-    glBegin(GL_QUADS);
-        glVertex2f(x-6, y+140);
-        glVertex2f(x+126, y+140);
-        glVertex2f(x+122, y+152);
-        glVertex2f(x-2, y+152);
-    glEnd();
+        glPushMatrix();
+        glTranslatef(STAR_POLE_X, STAR_POLE_Y, 0.0f);
+        glRotatef(sunAngle * (180.0f / (float)M_PI), 0.0f, 0.0f, 1.0f);
+        glTranslatef(-STAR_POLE_X, -STAR_POLE_Y, 0.0f);
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(2, GL_FLOAT, sizeof(Star), &starfield[0].x);
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, starColors.data());
+        drawStarRanges();
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
 
-    // windows (2 big)
-    glColor3f(0.75f, 0.90f, 1.0f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+18, y+78); glVertex2f(x+52, y+78);
-        glVertex2f(x+52, y+118); glVertex2f(x+18, y+118);
+        glPopMatrix();
+    }
 
-        glVertex2f(x+68, y+78); glVertex2f(x+102, y+78);
-        glVertex2f(x+102, y+118); glVertex2f(x+68, y+118);
-    glEnd();
+    glDisable(GL_CLIP_PLANE0);
+    glDisable(GL_BLEND);
+}
 
-    // window frames
-    glColor3f(0.25f,0.25f,0.25f);
-    glLineWidth(2);
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(x+18, y+78); glVertex2f(x+52, y+78);
-        glVertex2f(x+52, y+118); glVertex2f(x+18, y+118);
-    glEnd();
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(x+68, y+78); glVertex2f(x+102, y+78);
-        glVertex2f(x+102, y+118); glVertex2f(x+68, y+118);
-    glEnd();
+// NEW: sun & moon move from horizon (bottom of sky) up and again down
+// ======================= REPLACE THIS FUNCTION =======================
+void drawSunMoon() {
+    const float PI = 3.1415926f;
 
-    // door + step
-    glColor3f(0.85f, 0.70f, 0.50f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+50, y);
-        glVertex2f(x+70, y);
-        glVertex2f(x+70, y+52);
-        glVertex2f(x+50, y+52);
-    glEnd();
+    float t = std::fmod(sunAngle, 2.0f * PI);
+    if (t < 0.0f) t += 2.0f * PI;
 
-    glColor3f(0.55f, 0.55f, 0.55f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+44, y);
-        glVertex2f(x+76, y);
-        glVertex2f(x+74, y+6);
-        glVertex2f(x+46, y+6);
-    glEnd();
+    float horizonY  = 460.0f;
+    float sunAmp    = 130.0f;
+    float moonAmp   = 100.0f;
 
-    // outline (makes it crisp)
-    glColor3f(0.15f,0.15f,0.15f);
-    glLineWidth(2);
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(x, y); glVertex2f(x+120, y);
-        glVertex2f(x+120, y+140); glVertex2f(x, y+140);
-    glEnd();
-}
-
-
-void drawTraditionalHouse(float x, float y) {
-    // shadow
+    // ✅ enable blending so glColor4f alpha actually works (glow, rays)
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(0,0,0,0.16f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+5, y-2); glVertex2f(x+110, y-2);
-        glVertex2f(x+110, y+128); glVertex2f(x+5, y+128);
-    glEnd();
-    glDisable(GL_BLEND);
 
-    // body
-    glColor3f(0.92f, 0.74f, 0.52f);
-    glBegin(GL_QUADS);
-        glVertex2f(x, y);
-        glVertex2f(x+105, y);
-        glVertex2f(x+105, y+120);
-        glVertex2f(x, y+120);
-    glEnd();
+    if (t < PI) {
+        // ---------------------- SUN (DAY) ----------------------------------
+        float local = t;
+        float phase = local / PI;
 
-    // roof with overhang
-    glColor3f(0.55f, 0.25f, 0.18f);
-    glBegin(GL_POLYGON);
-        glVertex2f(x-12, y+120);
-        glVertex2f(x+117, y+120);
-        glVertex2f(x+52, y+160);
-    glEnd();
+        float x = WIDTH * 0.15f + (WIDTH * 0.70f) * phase;
+        float y = horizonY + std::sin(local) * sunAmp;
+        setShadowLight(local, 1.0f);
 
-    // small chimney
-    glColor3f(0.40f,0.40f,0.40f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+78, y+130);
-        glVertex2f(x+90, y+130);
-        glVertex2f(x+90, y+155);
-        glVertex2f(x+78, y+155);
-    glEnd();
+        // main sun (its glow comes from the bloom pass)
+        glColor4f(1.0f, 1.0f, 0.0f, 1.0f);
+        drawCircle(x, y, 30.0f);
 
-    // windows (left/right)
-    glColor3f(0.88f, 0.95f, 1.0f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+16, y+70); glVertex2f(x+40, y+70);
-        glVertex2f(x+40, y+96); glVertex2f(x+16, y+96);
+        // rays
+        glColor4f(1.0f, 1.0f, 0.5f, 0.55f);
+        glLineWidth(2.5f + sunGlow);
+        for (int i = 0; i < 16; i++) {
+            float ang = 2.0f * PI * i / 16.0f + local * 0.5f;
+            float x1 = x + std::cos(ang) * 40.0f;
+            float y1 = y + std::sin(ang) * 40.0f;
+            float x2 = x + std::cos(ang) * 60.0f;
+            float y2 = y + std::sin(ang) * 60.0f;
 
-        glVertex2f(x+65, y+70); glVertex2f(x+89, y+70);
-        glVertex2f(x+89, y+96); glVertex2f(x+65, y+96);
-    glEnd();
+            glBegin(GL_LINES);
+            glVertex2f(x1, y1);
+            glVertex2f(x2, y2);
+            glEnd();
+        }
+    } else {
+        // ---------------------- MOON (NIGHT) -------------------------------
+        float local = t - PI;
+        float phase = local / PI;
 
-    glColor3f(0.25f,0.25f,0.25f);
-    glLineWidth(2);
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(x+16, y+70); glVertex2f(x+40, y+70);
-        glVertex2f(x+40, y+96); glVertex2f(x+16, y+96);
-    glEnd();
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(x+65, y+70); glVertex2f(x+89, y+70);
-        glVertex2f(x+89, y+96); glVertex2f(x+65, y+96);
-    glEnd();
+        float x = WIDTH * 0.15f + (WIDTH * 0.70f) * phase;
+        float y = horizonY + std::sin(local) * moonAmp + 10.0f;
+        setShadowLight(local, 0.45f);   // faint moon shadows
 
-    // door (center)
-    glColor3f(0.45f, 0.28f, 0.18f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+44, y);
-        glVertex2f(x+61, y);
-        glVertex2f(x+61, y+55);
-        glVertex2f(x+44, y+55);
-    glEnd();
+        float bright = 0.8f + 0.2f * std::sin(local * 0.8f);
 
-    // knob
-    glColor3f(0.95f, 0.90f, 0.20f);
-    drawCircle(x+58, y+28, 2.0f);
+        glColor4f(0.9f * bright, 0.9f * bright, 0.9f * bright, 1.0f);
+        drawCircle(x, y, 28.0f);
 
-    // outline
-    glColor3f(0.15f,0.15f,0.15f);
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(x, y); glVertex2f(x+105, y);
-        glVertex2f(x+105, y+120); glVertex2f(x, y+120);
-    glEnd();
+        glColor4f(0.7f * bright, 0.7f * bright, 0.7f * bright, 1.0f);
+        drawCircle(x - 10.0f, y + 10.0f, 6.0f);
+        drawCircle(x + 12.0f, y -  8.0f, 5.0f);
+        drawCircle(x +  8.0f, y + 12.0f, 4.0f);
+    }
+
+    glDisable(GL_BLEND);
 }
 
 
-void drawFarmHouse(float x, float y) {
-    // shadow
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(0,0,0,0.16f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+6, y-2); glVertex2f(x+146, y-2);
-        glVertex2f(x+146, y+122); glVertex2f(x+6, y+122);
-    glEnd();
-    glDisable(GL_BLEND);
+// ============================================================================
+// CLOUD IMPOSTORS (noise textures baked on worker threads + scrolling quads)
+// CLOUD_SHAPES soft clouds are generated once from value-noise fbm over a
+// few lumpy blobs, straight into a premultiplied RGBA atlas. The bake runs
+// on worker threads started in main() while GLUT opens the window; the
+// first frame joins them and uploads the atlas (with mipmaps).
+// Each cloud is then one textured quad, so overlapping puffs no longer
+// double-blend. Drift is the old parallax: cloudOffset * windIntensity,
+// faster for nearer layers, wrapped around the sky so any number of clouds
+// keeps the sky covered. The first 9 clouds are the old 3 x 3 layout.
+// ============================================================================
 
-    // main body
-    glColor3f(0.85f, 0.62f, 0.40f);
-    glBegin(GL_QUADS);
-        glVertex2f(x, y);
-        glVertex2f(x+140, y);
-        glVertex2f(x+140, y+110);
-        glVertex2f(x, y+110);
-    glEnd();
+const int CLOUD_CELL_W   = 256;
+const int CLOUD_CELL_H   = 128;
+const int CLOUD_SHAPES   = 8;
+const int CLOUD_ATLAS_W  = 1024;     // 4 x 2 cells
+const int CLOUD_ATLAS_H  = 256;
+const float CLOUD_MARGIN = 120.0f;   // off-screen run-out before wrapping
+const int MAX_CLOUDS     = 100000;
+
+struct CloudImpostor {
+    float x, y;        // centre at cloudOffset 0
+    float w;           // quad width (height is half)
+    float drift;       // parallax factor within its layer
+    float alpha;
+    int   shape, layer;
+};
 
-    // roof
-    glColor3f(0.70f, 0.18f, 0.12f);
-    glBegin(GL_POLYGON);
-        glVertex2f(x-16, y+110);
-        glVertex2f(x+156, y+110);
-        glVertex2f(x+70, y+150);
-    glEnd();
+std::vector<CloudImpostor> cloudImpostors;
+int cloudCount = 9;                              // --clouds N
 
-    // veranda (front shade)
-    glColor3f(0.60f, 0.40f, 0.22f);
-    glBegin(GL_QUADS);
-        glVertex2f(x-8,  y);
-        glVertex2f(x+148,y);
-        glVertex2f(x+148,y+18);
-        glVertex2f(x-8,  y+18);
-    glEnd();
+std::vector<unsigned char> cloudPixels;          // atlas, filled by the workers
+std::vector<std::thread>   cloudWorkers;
+GLuint cloudAtlas      = 0;
+bool   cloudAtlasReady = false;
 
-    // windows (3)
-    glColor3f(0.80f, 0.93f, 1.0f);
-    for (int i=0;i<3;i++){
-        float wx = x + 18 + i*40;
-        glBegin(GL_QUADS);
-            glVertex2f(wx, y+55);
-            glVertex2f(wx+26, y+55);
-            glVertex2f(wx+26, y+86);
-            glVertex2f(wx, y+86);
-        glEnd();
+static inline float cloudHash(int x, int y, int seed) {
+    uint32_t h = (uint32_t)x * 374761393u + (uint32_t)y * 668265263u + (uint32_t)seed * 2246822519u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return ((h ^ (h >> 16)) & 0xffffff) * (1.0f / 16777216.0f);
+}
 
-        glColor3f(0.25f,0.25f,0.25f);
-        glBegin(GL_LINE_LOOP);
-            glVertex2f(wx, y+55);
-            glVertex2f(wx+26, y+55);
-            glVertex2f(wx+26, y+86);
-            glVertex2f(wx, y+86);
-        glEnd();
-        glColor3f(0.80f, 0.93f, 1.0f);
+static float valueNoise(float x, float y, int seed) {
+    int   ix = (int)std::floor(x), iy = (int)std::floor(y);
+    float fx = x - ix, fy = y - iy;
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fy = fy * fy * (3.0f - 2.0f * fy);
+    float a = cloudHash(ix, iy, seed),     b = cloudHash(ix + 1, iy, seed);
+    float c = cloudHash(ix, iy + 1, seed), d = cloudHash(ix + 1, iy + 1, seed);
+    return (a + (b - a) * fx) + ((c + (d - c) * fx) - (a + (b - a) * fx)) * fy;
+}
+
+static float cloudFbm(float x, float y, int seed) {
+    float sum = 0.0f, amp = 0.5f;
+    for (int o = 0; o < 5; o++) {
+        sum += amp * valueNoise(x, y, seed + o * 101);
+        x *= 2.03f; y *= 2.03f; amp *= 0.5f;
     }
+    return sum;   // 0 .. ~0.97
+}
 
-    // chimney
-    glColor3f(0.40f,0.40f,0.40f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+105, y+112);
-        glVertex2f(x+118, y+112);
-        glVertex2f(x+118, y+148);
-        glVertex2f(x+105, y+148);
-    glEnd();
+// one atlas cell: a row of soft lumps, eroded by fbm, lit from above
+void bakeCloudShape(int shape, unsigned char* atlas) {
+    uint32_t seed = 7919u * (shape + 1);
+    auto rnd = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) * (1.0f / 16777216.0f);
+    };
 
-    // outline
-    glColor3f(0.15f,0.15f,0.15f);
-    glLineWidth(2);
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(x, y); glVertex2f(x+140, y);
-        glVertex2f(x+140, y+110); glVertex2f(x, y+110);
-    glEnd();
+    // lumps along the base, the middle ones bigger
+    float lx[6], ly[6], lr[6];
+    int   lumps = 3 + shape % 4;
+    float span  = 0.10f + 0.10f * lumps;
+    for (int i = 0; i < lumps; i++) {
+        float t = (float)i / (lumps - 1);
+        lx[i] = 0.5f + (t - 0.5f) * span + (rnd() - 0.5f) * 0.05f;
+        lr[i] = (0.13f + 0.05f * rnd()) * (1.0f + 0.35f * (1.0f - std::fabs(t - 0.5f) * 2.0f));
+        ly[i] = 0.34f + lr[i] * 0.8f + rnd() * 0.04f;
+    }
+
+    int cellX = (shape % 4) * CLOUD_CELL_W;
+    int cellY = (shape / 4) * CLOUD_CELL_H;
+    for (int py = 0; py < CLOUD_CELL_H; py++) {
+        for (int px = 0; px < CLOUD_CELL_W; px++) {
+            float u = (px + 0.5f) / CLOUD_CELL_W;          // 0..1 across
+            float v = (py + 0.5f) / CLOUD_CELL_H;          // 0 = bottom
+
+            float body = 0.0f;                              // lumps, 2:1 cell
+            for (int i = 0; i < lumps; i++) {
+                float dx = (u - lx[i]) * 2.0f, dy = v - ly[i];
+                body = std::max(body, 1.0f - (dx * dx + dy * dy) / (lr[i] * lr[i] * 4.0f));
+            }
+            float flat = std::max(0.0f, 1.0f - std::fabs(v - 0.40f) / 0.12f)        // flat base
+                       * std::max(0.0f, 1.0f - std::fabs(u - 0.5f) / (span * 0.5f + 0.06f));
+            float n       = cloudFbm(u * 8.0f, v * 4.0f, shape * 17);
+            float density = std::max(body, flat) * (0.55f + 0.9f * n);
+
+            float a = std::min(1.0f, std::max(0.0f, (density - 0.25f) / 0.45f));
+            a = a * a * (3.0f - 2.0f * a);
+            float shade = 0.80f + 0.20f * std::min(1.0f, std::max(0.0f, (v - 0.30f) / 0.45f))
+                        + 0.06f * (n - 0.5f);
+            shade = std::min(1.0f, shade);
+
+            unsigned char* out = &atlas[((cellY + py) * CLOUD_ATLAS_W + cellX + px) * 4];
+            out[0] = out[1] = (unsigned char)(255.0f * shade * a);        // premultiplied
+            out[2] = (unsigned char)(255.0f * std::min(1.0f, shade + 0.03f) * a);
+            out[3] = (unsigned char)(255.0f * a);
+        }
+    }
 }
 
+// worker k bakes shapes k, k + workers, ...
+void startCloudBake(int workers) {
+    cloudPixels.assign((size_t)CLOUD_ATLAS_W * CLOUD_ATLAS_H * 4, 0);
+    workers = std::max(1, std::min(workers, CLOUD_SHAPES));
+    for (int k = 0; k < workers; k++) {
+        cloudWorkers.push_back(std::thread([k, workers]() {
+            for (int s = k; s < CLOUD_SHAPES; s += workers)
+                bakeCloudShape(s, cloudPixels.data());
+        }));
+    }
+}
 
-void drawCottage(float x, float y) {
-    glColor3f(0.7f, 0.8f, 0.6f);
-    glBegin(GL_QUADS);
-    glVertex2f(x, y);
-    glVertex2f(x + 80, y);
-    glVertex2f(x + 80, y + 70);
-    glVertex2f(x, y + 70);
-    glEnd();
+// also registered with atexit(), like joinNavWorkers(): glutInit() exits
+// on its own when there is no display, with the bake still running
+void finishCloudBake() {
+    for (size_t i = 0; i < cloudWorkers.size(); i++) cloudWorkers[i].join();
+    cloudWorkers.clear();
+}
 
-    glColor3f(0.8f, 0.6f, 0.3f);
-    glBegin(GL_POLYGON);
-    glVertex2f(x - 10, y + 70);
-    glVertex2f(x + 90, y + 70);
-    glVertex2f(x + 40, y + 100);
-    glEnd();
+// first frame: wait for the workers, upload, drop the CPU copy
+void uploadCloudAtlas() {
+    finishCloudBake();
+    if (cloudPixels.empty()) {      // workers never started
+        startCloudBake(1);
+        finishCloudBake();
+    }
 
-    glColor3f(0.5f, 0.4f, 0.3f);
-    glBegin(GL_QUADS);
-    glVertex2f(x + 30, y);
-    glVertex2f(x + 50, y);
-    glVertex2f(x + 50, y + 40);
-    glVertex2f(x + 30, y + 40);
-    glEnd();
+    glGenTextures(1, &cloudAtlas);
+    glBindTexture(GL_TEXTURE_2D, cloudAtlas);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA, CLOUD_ATLAS_W, CLOUD_ATLAS_H,
+                      GL_RGBA, GL_UNSIGNED_BYTE, cloudPixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    std::vector<unsigned char>().swap(cloudPixels);
+    cloudAtlasReady = true;
+}
+
+void initClouds(int count) {
+    cloudImpostors.clear();
+
+    // the old 3 layers x 3 clouds (centres of the old circle groups)
+    const float oldX[3]     = {172.0f, 628.0f, 1019.0f};
+    const float oldDY[3]    = {2.0f, 26.0f, -6.0f};
+    const float oldW[3]     = {135.0f, 155.0f, 115.0f};
+    const float oldDrift[3] = {1.0f, 0.8f, 0.6f};
+    for (int i = 0; i < count && i < 9; i++) {
+        int layer = i / 3, k = i % 3;
+        CloudImpostor c;
+        c.x = oldX[k]; c.y = 500.0f + layer * 40.0f + oldDY[k];
+        c.w = oldW[k]; c.drift = oldDrift[k];
+        c.alpha = 0.7f - layer * 0.2f;
+        c.shape = i % CLOUD_SHAPES; c.layer = layer;
+        cloudImpostors.push_back(c);
+    }
+
+    uint32_t seed = 2718u;
+    auto rnd = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) * (1.0f / 16777216.0f);
+    };
+    for (int i = 9; i < count; i++) {
+        CloudImpostor c;
+        c.layer = (int)(rnd() * 3) % 3;
+        c.x     = -CLOUD_MARGIN + rnd() * (WIDTH + 2 * CLOUD_MARGIN);
+        c.y     = 485.0f + c.layer * 40.0f + rnd() * 150.0f;
+        c.w     = 70.0f + rnd() * 110.0f;
+        c.drift = 0.6f + 0.4f * rnd();
+        c.alpha = 0.7f - c.layer * 0.2f;
+        c.shape = (int)(rnd() * CLOUD_SHAPES) % CLOUD_SHAPES;
+        cloudImpostors.push_back(c);
+    }
+
+    // far (fainter) layers first
+    std::stable_sort(cloudImpostors.begin(), cloudImpostors.end(),
+                     [](const CloudImpostor& a, const CloudImpostor& b) { return a.layer > b.layer; });
+}
+
+// where a cloud is now (wraps over the screen plus a margin)
+static float cloudScreenX(const CloudImpostor& c) {
+    const float span = WIDTH + 2.0f * CLOUD_MARGIN;
+    float layerSpeed = 0.25f * windIntensity * (c.layer + 1);
+    float x = std::fmod(c.x + CLOUD_MARGIN + cloudOffset * layerSpeed * c.drift, span);
+    if (x < 0.0f) x += span;
+    return x - CLOUD_MARGIN;
+}
+
+void drawClouds() {
+    if (!cloudAtlasReady || cloudsShown.empty()) return;
 
-    glColor3f(0.9f, 0.95f, 1.0f);
+    const TodColor& light = todNow[TOD_SUNLIGHT];
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, cloudAtlas);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);     // atlas is premultiplied
     glBegin(GL_QUADS);
-    glVertex2f(x + 15, y + 40);
-    glVertex2f(x + 35, y + 40);
-    glVertex2f(x + 35, y + 60);
-    glVertex2f(x + 15, y + 60);
+    for (int i : cloudsShown) {
+        const CloudImpostor& c = cloudImpostors[i];
+        float x = cloudScreenX(c);
+
+        float hw = c.w * 0.5f, hh = c.w * 0.25f;
+        float u0 = (float)((c.shape % 4) * CLOUD_CELL_W) / CLOUD_ATLAS_W;
+        float v0 = (float)((c.shape / 4) * CLOUD_CELL_H) / CLOUD_ATLAS_H;
+        float u1 = u0 + (float)CLOUD_CELL_W / CLOUD_ATLAS_W;
+        float v1 = v0 + (float)CLOUD_CELL_H / CLOUD_ATLAS_H;
+
+        glColor4f(light.r * c.alpha, light.g * c.alpha, light.b * c.alpha, c.alpha);
+        glTexCoord2f(u0, v0); glVertex2f(x - hw, c.y - hh);
+        glTexCoord2f(u1, v0); glVertex2f(x + hw, c.y - hh);
+        glTexCoord2f(u1, v1); glVertex2f(x + hw, c.y + hh);
+        glTexCoord2f(u0, v1); glVertex2f(x - hw, c.y + hh);
+    }
     glEnd();
+    glDisable(GL_BLEND);
+    glDisable(GL_TEXTURE_2D);
 }
 
+
 // ============================================================================
-// VEGETATION
+// TERRAIN WITH REALISTIC LAYOUT
 // ============================================================================
 
-void drawTree(float x, float y, int type) {
-    // brightness factor for day/night (0.55..1.0)
-    float k = 0.55f + 0.45f * dayNightBlend;
+// void drawDistantHills() {
+//     glColor3f(0.08f, 0.35f, 0.08f);
 
-    // small wind sway (subtle movement)
-    float sway = std::sin(riverWave * 0.03f + x * 0.01f) * 4.0f * windIntensity;
+//     glBegin(GL_POLYGON);
+//     glVertex2f(0, 450);
+//     for (int x = 0; x <= WIDTH; x += 100) {
+//         float height = 450.0f + 80.0f * std::sin(x * 0.01f);
+//         glVertex2f(x, height);
+//     }
+//     glVertex2f(WIDTH, 450);
+//     glVertex2f(WIDTH, 400);
+//     glVertex2f(0, 400);
+//     glEnd();
 
-    // ground shadow (helps realism a lot)
-    drawShadowEllipse(x, y - 6, 40, 11, 0.22f);
+//     glColor3f(0.12f, 0.45f, 0.12f);
+//     glBegin(GL_POLYGON);
+//     glVertex2f(0, 420);
+//     for (int x = 0; x <= WIDTH; x += 80) {
+//         float height = 420.0f + 60.0f * std::sin(x * 0.015f);
+//         glVertex2f(x, height);
+//     }
+//     glVertex2f(WIDTH, 420);
+//     glVertex2f(WIDTH, 380);
+//     glVertex2f(0, 380);
+//     glEnd();
+// }
 
-    // ---- helper: taper trunk + bark + depth strip ----
-    auto trunkTaper = [&](float baseW, float topW, float h) {
-        // main trunk
-        glColor3f(0.40f * k, 0.25f * k, 0.12f * k);
-        glBegin(GL_POLYGON);
-            glVertex2f(x - baseW, y);
-            glVertex2f(x + baseW, y);
-            glVertex2f(x + topW,  y + h);
-            glVertex2f(x - topW,  y + h);
-        glEnd();
+// ============================================================================
+// DISTANT HILLS (generated once, static triangle strips)
+// The four hill layers never move, so their ridges are computed once into
+// one vertex array: each layer is a triangle strip of (bottom, ridge) pairs,
+// which is a correct triangulation of the non-convex silhouette (the old
+// GL_POLYGON was not). --hill-octaves N adds N octaves of value noise on top
+// of the two-sine ridge with a finer step; the per-frame cost stays four
+// draw calls.
+// ============================================================================
 
-        // right shadow strip (depth)
-        glColor3f(0.26f * k, 0.16f * k, 0.08f * k);
-        glBegin(GL_QUADS);
-            glVertex2f(x + baseW * 0.25f, y + 2);
-            glVertex2f(x + baseW,        y + 2);
-            glVertex2f(x + topW,         y + h - 2);
-            glVertex2f(x + topW * 0.25f, y + h - 2);
-        glEnd();
+struct HillLayer {
+    float baseY, bottomY;
+    float amp1, f1, amp2, f2;
+    float step;
+    float r, g, b;
+};
 
-        // bark lines
-        glColor3f(0.18f * k, 0.12f * k, 0.06f * k);
-        glLineWidth(1.0f);
-        glBegin(GL_LINES);
-        for (int i = 0; i < 6; i++) {
-            float xx = x - baseW * 0.6f + i * (baseW * 0.25f);
-            glVertex2f(xx, y + 6);
-            glVertex2f(xx + 2, y + h - 10);
-        }
-        glEnd();
-    };
+const HillLayer HILL_LAYERS[4] = {
+    {465.0f, 400.0f, 35.0f, 0.0065f, 18.0f, 0.0140f, 25.0f, 0.10f, 0.38f, 0.10f},   // far (light, smooth)
+    {445.0f, 380.0f, 45.0f, 0.0080f, 22.0f, 0.0180f, 22.0f, 0.08f, 0.34f, 0.08f},   // mid
+    {425.0f, 360.0f, 55.0f, 0.0100f, 28.0f, 0.0240f, 18.0f, 0.06f, 0.28f, 0.06f},   // near (darker)
+    {405.0f, 350.0f, 28.0f, 0.0180f, 14.0f, 0.0450f, 14.0f, 0.05f, 0.22f, 0.05f},   // very near strip
+};
 
-    // ---- helper: leaf cluster with shading + highlight ----
-    auto leafCluster = [&](float cx, float cy, float r, float darkMul, float lightMul) {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+std::vector<float> hillVertices;     // x, y pairs, all layers
+int hillFirst[4], hillCount[4];      // strip range per layer
+int hillOctaves = 0;                 // --hill-octaves N
 
-        // dark bottom mass
-        glColor4f(0.08f * k * darkMul, 0.40f * k * darkMul, 0.10f * k * darkMul, 1.0f);
-        drawCircle(cx, cy - r * 0.25f, r, 26);
-        drawCircle(cx - r * 0.75f, cy - r * 0.15f, r * 0.85f, 24);
-        drawCircle(cx + r * 0.75f, cy - r * 0.15f, r * 0.85f, 24);
+void buildHills(int octaves) {
+    hillVertices.clear();
+    int subdiv = 1 << std::min(octaves, 3);   // finer step for the detail
 
-        // lighter top mass
-        glColor4f(0.18f * k * lightMul, 0.62f * k * lightMul, 0.18f * k * lightMul, 1.0f);
-        drawCircle(cx, cy + r * 0.25f, r * 0.92f, 26);
-        drawCircle(cx - r * 0.65f, cy + r * 0.15f, r * 0.75f, 24);
-        drawCircle(cx + r * 0.65f, cy + r * 0.15f, r * 0.75f, 24);
+    for (int l = 0; l < 4; l++) {
+        const HillLayer& h = HILL_LAYERS[l];
+        float step = h.step / subdiv;
+        int   n    = (int)std::ceil(WIDTH / step);   // last column lands on WIDTH
 
-        // highlight (volume)
-        glColor4f(1.0f, 1.0f, 1.0f, 0.10f);
-        drawEllipse(cx + r * 0.25f, cy + r * 0.45f, r * 0.55f, r * 0.25f, 24);
+        hillFirst[l] = (int)hillVertices.size() / 2;
+        for (int i = 0; i <= n; i++) {
+            float x = std::min(i * step, (float)WIDTH);
+            // mix 2 sine waves -> irregular, more natural
+            float y = h.baseY + h.amp1 * std::sin(x * h.f1) + h.amp2 * std::sin(x * h.f2 + 1.7f);
 
-        glDisable(GL_BLEND);
-    };
+            float amp = h.amp2 * 0.6f, freq = h.f2 * 2.0f;
+            for (int o = 0; o < octaves; o++) {
+                y    += amp * (2.0f * valueNoise(x * freq, l * 7.3f, 31 + o) - 1.0f);
+                amp  *= 0.5f;
+                freq *= 2.0f;
+            }
 
-    int t = type % 4;
+            y = std::max(y, h.bottomY);
+            hillVertices.push_back(x); hillVertices.push_back(h.bottomY);
+            hillVertices.push_back(x); hillVertices.push_back(y);
+        }
+        hillCount[l] = (int)hillVertices.size() / 2 - hillFirst[l];
+    }
+}
 
-    // ==========================================================
-    // 0) PINE (layered triangles + slight gradient)
-    // ==========================================================
-    if (t == 0) {
-        trunkTaper(7, 4, 55);
+void drawDistantHills() {
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, hillVertices.data());
+    for (int l = 0; l < 4; l++) {
+        glColor3f(HILL_LAYERS[l].r, HILL_LAYERS[l].g, HILL_LAYERS[l].b);
+        glDrawArrays(GL_TRIANGLE_STRIP, hillFirst[l], hillCount[l]);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
 
-        float baseY = y + 35;
-        for (int i = 0; i < 4; i++) {
-            float layerH = 30.0f - i * 3.0f;
-            float w      = 48.0f - i * 10.0f;
+    // ✅ Optional: light mist line to soften horizon (looks very realistic)
+    if (!isDay) return; // keep mist mainly daytime (you can remove this line)
 
-            float dark = (0.18f - i * 0.01f) * k;
-            float mid  = (0.45f - i * 0.02f) * k;
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(0.9f, 0.95f, 1.0f, 0.08f);
+    glBegin(GL_QUADS);
+        glVertex2f(0, 455);
+        glVertex2f(WIDTH, 455);
+        glVertex2f(WIDTH, 395);
+        glVertex2f(0, 395);
+    glEnd();
+    glDisable(GL_BLEND);
+}
 
-            glBegin(GL_TRIANGLES);
-                glColor3f(0.06f * k, mid, 0.08f * k);
-                glVertex2f(x, baseY + i * 18 + layerH);
 
-                glColor3f(0.05f * k, dark, 0.07f * k);
-                glVertex2f(x - w, baseY + i * 18);
+void drawGround() {
+    glBegin(GL_QUADS);
+    todColor(TOD_GROUND_LOW);
+    glVertex2f(0, 0);
+    glVertex2f(WIDTH, 0);
+    todColor(TOD_GROUND_HIGH);
+    glVertex2f(WIDTH, 380);
+    glVertex2f(0, 380);
+    glEnd();
+}
 
-                glColor3f(0.08f * k, (mid + 0.08f) * k, 0.10f * k);
-                glVertex2f(x + w, baseY + i * 18);
-            glEnd();
-        }
+void drawFootpath() {
+    glBegin(GL_QUADS);
+    glColor3f(0.7f, 0.6f, 0.4f);
+    glVertex2f(0, 190);
+    glVertex2f(WIDTH, 190);
+    glVertex2f(WIDTH, 210);
+    glVertex2f(0, 210);
+    glEnd();
 
-        // tiny top highlight
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glColor4f(1, 1, 1, 0.08f);
-        drawEllipse(x + 10, y + 95, 12, 5, 18);
-        glDisable(GL_BLEND);
+    glColor3f(0.6f, 0.5f, 0.3f);
+    glLineWidth(1.0f);
+    glBegin(GL_LINES);
+    for (float x = 0; x < WIDTH; x += 40) {
+        glVertex2f(x, 200);
+        glVertex2f(x + 20, 200);
     }
+    glEnd();
+}
 
-    // ==========================================================
-    // 1) DECIDUOUS (round realistic tree)
-    // ==========================================================
-    else if (t == 1) {
-        trunkTaper(9, 5, 65);
-
-        leafCluster(x + sway * 0.2f, y + 88 + sway, 36.0f, 1.00f, 1.00f);
-        leafCluster(x - 26 + sway * 0.15f, y + 72 + sway * 0.6f, 28.0f, 1.05f, 0.98f);
-        leafCluster(x + 26 + sway * 0.15f, y + 72 + sway * 0.6f, 28.0f, 1.05f, 0.98f);
+void drawRoad() {
+    glBegin(GL_QUADS);
+    todColor(TOD_ROAD_NEAR);
+    glVertex2f(0, 210);
+    glVertex2f(WIDTH, 210);
+    todColor(TOD_ROAD_FAR);
+    glVertex2f(WIDTH, 280);
+    glVertex2f(0, 280);
+    glEnd();
 
-        // branches
-        glColor3f(0.28f * k, 0.17f * k, 0.08f * k);
-        glLineWidth(2.0f);
-        glBegin(GL_LINES);
-            glVertex2f(x, y + 45); glVertex2f(x - 18, y + 62);
-            glVertex2f(x, y + 50); glVertex2f(x + 18, y + 65);
-        glEnd();
+    todColor(TOD_ROAD_LINE);
+    glLineWidth(3.0f);
+    glBegin(GL_LINES);
+    for (float x = 0; x < WIDTH; x += 60) {
+        float y = 245;
+        glVertex2f(x, y);
+        glVertex2f(x + 30, y);
     }
+    glEnd();
 
-    // ==========================================================
-    // 2) PALM (FIXED: filled leaves, no spiky line-star)
-    // ==========================================================
-    else if (t == 2) {
-        // palm shadow a bit wider
-        drawShadowEllipse(x, y - 6, 50, 12, 0.22f);
+    // zebra crossing to the bus stop (NAV_CROSS_X0..X1, the crowd's only way across)
+    glBegin(GL_QUADS);
+    for (float y = 214; y < 278; y += 10) {
+        glVertex2f(548, y);
+        glVertex2f(572, y);
+        glVertex2f(572, y + 5);
+        glVertex2f(548, y + 5);
+    }
+    glEnd();
+}
 
-        // trunk segments (tapered)
-        float h = 110.0f;
-        float baseW = 10.0f;
+// ============================================================================
+// RIVER SURFACE
+// The water body is one triangle strip (top, bottom per column) computed
+// in a single pass into reusable position / color arrays, four columns at
+// a time with SSE2 where available. Waves, depth shading and the sparkle
+// band use fastSin() (odd polynomial after range reduction, within ~3e-5
+// of std::sin for the phases used here).
+// Columns are spaced ~18 window pixels apart, so the strip gets finer as
+// the window gets bigger.
+// ============================================================================
 
-        for (int i = 0; i < 10; i++) {
-            float yy1 = y + i * (h / 10.0f);
-            float yy2 = yy1 + (h / 10.0f);
+const float RIVER_TOP    = 180.0f;
+const float RIVER_BOTTOM = 120.0f;
+const int   RIVER_COLUMN_PX = 18;
 
-            float w1 = baseW - i * 0.45f;
-            float w2 = baseW - (i + 1) * 0.45f;
+struct RiverSurface {
+    int columns;
+    std::vector<float> pos;     // x, y per vertex (top, bottom, top, ...)
+    std::vector<float> color;   // r, g, b, a per vertex
+};
 
-            float col = (i % 2 == 0) ? 0.42f : 0.36f;
-            glColor3f(col * k, 0.26f * k, 0.13f * k);
+RiverSurface riverSurface;
 
-            glBegin(GL_QUADS);
-                glVertex2f(x - w1, yy1);
-                glVertex2f(x + w1, yy1);
-                glVertex2f(x + w2, yy2);
-                glVertex2f(x - w2, yy2);
-            glEnd();
-        }
+int riverColumnsFor(int pixelWidth) {
+    return std::max(2, (pixelWidth + RIVER_COLUMN_PX - 1) / RIVER_COLUMN_PX + 1);
+}
 
-        // depth strip
-        glColor3f(0.25f * k, 0.16f * k, 0.08f * k);
-        glBegin(GL_QUADS);
-            glVertex2f(x + 2.0f, y + 5);
-            glVertex2f(x + 8.0f, y + 5);
-            glVertex2f(x + 3.0f, y + h);
-            glVertex2f(x - 1.0f, y + h);
-        glEnd();
+static inline float fastSin(float x) {
+    const float TWO_PI = 6.28318531f, PI = 3.14159265f;
+    x -= TWO_PI * std::floor(x * (1.0f / TWO_PI) + 0.5f);   // [-PI, PI]
+    float ax = std::min(std::fabs(x), PI - std::fabs(x));   // fold to [0, PI/2]
+    float x2 = ax * ax;
+    float s  = ax * (1.0f + x2 * (-0.16666667f + x2 * (0.0083333310f +
+                    x2 * (-0.00019840874f + x2 * 2.7525562e-6f))));
+    return x < 0.0f ? -s : s;
+}
 
-        float topX = x;
-        float topY = y + h;
+#if defined(__SSE2__)
+static inline __m128 fastSin4(__m128 x) {
+    const __m128 TWO_PI   = _mm_set1_ps(6.28318531f);
+    const __m128 PI       = _mm_set1_ps(3.14159265f);
+    const __m128 SIGN     = _mm_set1_ps(-0.0f);
+
+    __m128 k  = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.0f / 6.28318531f))));
+    x = _mm_sub_ps(x, _mm_mul_ps(k, TWO_PI));
+    __m128 sign = _mm_and_ps(x, SIGN);
+    __m128 ax   = _mm_andnot_ps(SIGN, x);
+    ax = _mm_min_ps(ax, _mm_sub_ps(PI, ax));
+
+    __m128 x2 = _mm_mul_ps(ax, ax);
+    __m128 p  = _mm_set1_ps(2.7525562e-6f);
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-0.00019840874f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(0.0083333310f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-0.16666667f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.0f));
+    return _mm_or_ps(_mm_mul_ps(ax, p), sign);
+}
+#endif
 
-        // coconuts
-        glColor3f(0.28f * k, 0.20f * k, 0.10f * k);
-        drawCircle(topX - 7, topY - 10, 5, 16);
-        drawCircle(topX + 2, topY - 12, 5, 16);
-        drawCircle(topX + 9, topY - 9,  4, 16);
+// one column, scalar (tail of the SSE loop, or everything without SSE2)
+static inline void riverColumn(RiverSurface& r, int i, float x, float wave, float amp,
+                               const TodColor& water, bool sparkle) {
+    float w1    = amp * fastSin(x * 0.03f + wave * 0.10f);
+    float w2    = amp * fastSin(x * 0.03f + wave * 0.10f + 0.55f);
+    float depth = 0.10f + 0.10f * fastSin(x * 0.02f + wave * 0.02f);
+    float s     = 0.0f;
+    if (sparkle && x > WIDTH * 0.70f && x < WIDTH * 0.92f)
+        s = 0.10f + 0.10f * fastSin((x - WIDTH * 0.78f) * 0.06f + wave * 0.10f);
+
+    float* p = &r.pos[i * 4];
+    p[0] = x; p[1] = RIVER_TOP + w1;
+    p[2] = x; p[3] = RIVER_BOTTOM + w2;
+
+    float* c = &r.color[i * 8];
+    c[0] = water.r + 0.10f + s; c[1] = water.g + 0.10f + s; c[2] = water.b + 0.12f + s; c[3] = 1.0f;
+    c[4] = water.r - depth;     c[5] = water.g - depth * 0.9f; c[6] = water.b - depth * 0.6f; c[7] = 1.0f;
+}
 
-        float palmSway = std::sin(riverWave * 0.03f + x * 0.01f) * 6.0f * windIntensity;
+// wave = riverWave, amp = wave height, sparkle = daytime glitter band
+void buildRiverSurface(RiverSurface& r, int columns, float wave, float amp,
+                       const TodColor& water, bool sparkle) {
+    r.columns = columns;
+    r.pos.resize((size_t)columns * 4);
+    r.color.resize((size_t)columns * 8);
+    const float dx = (float)WIDTH / (columns - 1);   // last column lands on WIDTH
+
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 lane   = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 vdx    = _mm_set1_ps(dx);
+    const __m128 ph1    = _mm_set1_ps(wave * 0.10f);
+    const __m128 ph2    = _mm_set1_ps(wave * 0.10f + 0.55f);
+    const __m128 phD    = _mm_set1_ps(wave * 0.02f);
+    const __m128 phS    = _mm_set1_ps(wave * 0.10f - WIDTH * 0.78f * 0.06f);
+    const __m128 vamp   = _mm_set1_ps(amp);
+    const __m128 tenth  = _mm_set1_ps(0.10f);
+    const __m128 one    = _mm_set1_ps(1.0f);
+    const __m128 sLo    = _mm_set1_ps(WIDTH * 0.70f);
+    const __m128 sHi    = _mm_set1_ps(WIDTH * 0.92f);
+    const __m128 sOn    = sparkle ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : _mm_setzero_ps();
+    const __m128 baseR  = _mm_set1_ps(water.r), baseG = _mm_set1_ps(water.g), baseB = _mm_set1_ps(water.b);
+
+    for (; i + 4 <= columns; i += 4) {
+        __m128 x  = _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)i), lane), vdx);
+        __m128 x3 = _mm_mul_ps(x, _mm_set1_ps(0.03f));
+
+        __m128 top = _mm_add_ps(_mm_set1_ps(RIVER_TOP),    _mm_mul_ps(vamp, fastSin4(_mm_add_ps(x3, ph1))));
+        __m128 bot = _mm_add_ps(_mm_set1_ps(RIVER_BOTTOM), _mm_mul_ps(vamp, fastSin4(_mm_add_ps(x3, ph2))));
+        __m128 depth = _mm_add_ps(tenth, _mm_mul_ps(tenth,
+                           fastSin4(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(0.02f)), phD))));
+        __m128 s = _mm_add_ps(tenth, _mm_mul_ps(tenth,
+                       fastSin4(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(0.06f)), phS))));
+        s = _mm_and_ps(s, _mm_and_ps(sOn, _mm_and_ps(_mm_cmpgt_ps(x, sLo), _mm_cmplt_ps(x, sHi))));
+
+        // positions: x, top, x, bottom per column
+        __m128 xtLo = _mm_unpacklo_ps(x, top), xbLo = _mm_unpacklo_ps(x, bot);
+        __m128 xtHi = _mm_unpackhi_ps(x, top), xbHi = _mm_unpackhi_ps(x, bot);
+        float* p = &r.pos[i * 4];
+        _mm_storeu_ps(p,      _mm_movelh_ps(xtLo, xbLo));
+        _mm_storeu_ps(p + 4,  _mm_movehl_ps(xbLo, xtLo));
+        _mm_storeu_ps(p + 8,  _mm_movelh_ps(xtHi, xbHi));
+        _mm_storeu_ps(p + 12, _mm_movehl_ps(xbHi, xtHi));
+
+        // colors: top rgba, bottom rgba per column (4x4 transposes)
+        __m128 tr = _mm_add_ps(_mm_add_ps(baseR, tenth), s);
+        __m128 tg = _mm_add_ps(_mm_add_ps(baseG, tenth), s);
+        __m128 tb = _mm_add_ps(_mm_add_ps(baseB, _mm_set1_ps(0.12f)), s);
+        __m128 ta = one;
+        __m128 br = _mm_sub_ps(baseR, depth);
+        __m128 bg = _mm_sub_ps(baseG, _mm_mul_ps(depth, _mm_set1_ps(0.9f)));
+        __m128 bb = _mm_sub_ps(baseB, _mm_mul_ps(depth, _mm_set1_ps(0.6f)));
+        __m128 ba = one;
+        _MM_TRANSPOSE4_PS(tr, tg, tb, ta);
+        _MM_TRANSPOSE4_PS(br, bg, bb, ba);
+        float* c = &r.color[i * 8];
+        _mm_storeu_ps(c,      tr); _mm_storeu_ps(c + 4,  br);
+        _mm_storeu_ps(c + 8,  tg); _mm_storeu_ps(c + 12, bg);
+        _mm_storeu_ps(c + 16, tb); _mm_storeu_ps(c + 20, bb);
+        _mm_storeu_ps(c + 24, ta); _mm_storeu_ps(c + 28, ba);
+    }
+#endif
+    for (; i < columns; i++)
+        riverColumn(r, i, i * dx, wave, amp, water, sparkle);
+}
 
-        // one filled palm leaf (2 triangles) + highlight + midrib
-        auto palmLeaf = [&](float angDeg, float len, float w) {
-            float a = (angDeg + palmSway) * (3.1415926f / 180.0f);
-            float cx = std::cos(a), syy = std::sin(a);
+void drawRiverSurface(const RiverSurface& r) {
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, r.pos.data());
+    glColorPointer(4, GL_FLOAT, 0, r.color.data());
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, r.columns * 2);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
 
-            float ex = topX + cx * len;
-            float ey = topY + syy * (len * 0.55f);
+// ============================================================================
+// SHADER PATH (GLSL 3.30, optional)
+// Sky gradient, stars and the river water body drawn by shaders: the CPU
+// sets a few uniforms per frame (riverWave, sunAngle, dayNightBlend, tick)
+// and draws static buffers. The time-of-day table goes up once as a float texture
+// (x = material, y = phase row), so the shader fetches the same row as
+// updateTimeOfDay(). Waves run in the vertex shader; depth shading and the
+// sparkle band run per fragment, the sparkle fading with dayNightBlend.
+// The shaders only use core 3.30 features (own VAO/VBO, no built-in
+// matrices) but run inside the normal compatibility context, because the
+// rest of the scene is still fixed-function. Without GL 3.3 (or with U
+// pressed) the fixed-function path above is used.
+// ============================================================================
 
-            float px = -syy, py = cx; // perpendicular
+#define GL3_FUNCS(X) \
+    X(PFNGLCREATESHADERPROC,            CreateShader) \
+    X(PFNGLSHADERSOURCEPROC,            ShaderSource) \
+    X(PFNGLCOMPILESHADERPROC,           CompileShader) \
+    X(PFNGLGETSHADERIVPROC,             GetShaderiv) \
+    X(PFNGLGETSHADERINFOLOGPROC,        GetShaderInfoLog) \
+    X(PFNGLDELETESHADERPROC,            DeleteShader) \
+    X(PFNGLCREATEPROGRAMPROC,           CreateProgram) \
+    X(PFNGLATTACHSHADERPROC,            AttachShader) \
+    X(PFNGLBINDATTRIBLOCATIONPROC,      BindAttribLocation) \
+    X(PFNGLLINKPROGRAMPROC,             LinkProgram) \
+    X(PFNGLGETPROGRAMIVPROC,            GetProgramiv) \
+    X(PFNGLGETPROGRAMINFOLOGPROC,       GetProgramInfoLog) \
+    X(PFNGLUSEPROGRAMPROC,              UseProgram) \
+    X(PFNGLGETUNIFORMLOCATIONPROC,      GetUniformLocation) \
+    X(PFNGLUNIFORM1FPROC,               Uniform1f) \
+    X(PFNGLUNIFORM1IPROC,               Uniform1i) \
+    X(PFNGLUNIFORM2FPROC,               Uniform2f) \
+    X(PFNGLGENBUFFERSPROC,              GenBuffers) \
+    X(PFNGLBINDBUFFERPROC,              BindBuffer) \
+    X(PFNGLBUFFERDATAPROC,              BufferData) \
+    X(PFNGLGENVERTEXARRAYSPROC,         GenVertexArrays) \
+    X(PFNGLBINDVERTEXARRAYPROC,         BindVertexArray) \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, EnableVertexAttribArray) \
+    X(PFNGLVERTEXATTRIBPOINTERPROC,     VertexAttribPointer) \
+    X(PFNGLVERTEXATTRIBDIVISORPROC,     VertexAttribDivisor) \
+    X(PFNGLDRAWARRAYSINSTANCEDPROC,     DrawArraysInstanced) \
+    X(PFNGLMAPBUFFERPROC,               MapBuffer) \
+    X(PFNGLUNMAPBUFFERPROC,             UnmapBuffer)
+
+struct Gl3Funcs {
+#define GL3_MEMBER(type, name) type name;
+    GL3_FUNCS(GL3_MEMBER)
+#undef GL3_MEMBER
+};
 
-            float bW = w;
-            float tW = w * 0.15f;
+Gl3Funcs gl3;
 
-            // dark leaf body
-            glColor3f(0.08f * k, 0.45f * k, 0.12f * k);
-            glBegin(GL_TRIANGLES);
-                glVertex2f(topX, topY);
-                glVertex2f(topX + px*bW, topY + py*bW);
-                glVertex2f(ex + px*tW,   ey + py*tW);
+struct ShaderProgram {
+    GLuint id;
+    GLint  uView, uTod, uSunAngle, uRiverWave, uDayNight, uTime;
+};
 
-                glVertex2f(topX, topY);
-                glVertex2f(ex - px*tW,   ey - py*tW);
-                glVertex2f(topX - px*bW, topY - py*bW);
-            glEnd();
+ShaderProgram skyProgram, riverProgram, starProgram;
+GLuint todTexture  = 0;
+GLuint skyVao      = 0, skyVbo   = 0;
+GLuint riverVao    = 0, riverVbo = 0;
+int    riverVboColumns = 0;
+GLuint starVao     = 0, starVbo  = 0;
+
+// shared by both programs: scene coords -> clip space, time-of-day row fetch
+static const char* SHADER_COMMON =
+    "#version 330 core\n"
+    "uniform vec2  uView;\n"
+    "uniform float uSunAngle;\n"
+    "uniform float uRiverWave;\n"
+    "uniform float uDayNight;\n"
+    "uniform float uTime;\n"
+    "uniform sampler2D uTod;\n"
+    "vec4 sceneToClip(vec2 p) { return vec4(p / uView * 2.0 - 1.0, 0.0, 1.0); }\n"
+    "vec3 tod(int m) {\n"
+    "    int rows = textureSize(uTod, 0).y;\n"
+    "    int row  = int(floor(uSunAngle * (float(rows) / 6.28318531))) & (rows - 1);\n"
+    "    return texelFetch(uTod, ivec2(m, row), 0).rgb;\n"
+    "}\n";
+
+static const char* SKY_VS =
+    "layout(location = 0) in vec2 aPos;\n"
+    "out float vHeight;\n"
+    "void main() {\n"
+    "    vHeight = (aPos.y - uView.y * 0.6) / (uView.y * 0.4);\n"
+    "    gl_Position = sceneToClip(aPos);\n"
+    "}\n";
+
+static const char* SKY_FS =
+    "in float vHeight;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = vec4(mix(tod(TOD_SKY_BOTTOM), tod(TOD_SKY_TOP), vHeight), 1.0);\n"
+    "}\n";
+
+// aPos = (x, 1 for the top edge / 0 for the bottom edge)
+static const char* RIVER_VS =
+    "layout(location = 0) in vec2 aPos;\n"
+    "out float vX;\n"
+    "out float vTop;\n"
+    "void main() {\n"
+    "    float amp = 3.0 + 2.0 * sin(uRiverWave * 0.05);\n"
+    "    float ph  = aPos.x * 0.03 + uRiverWave * 0.10;\n"
+    "    float y   = aPos.y > 0.5 ? RIVER_TOP    + amp * sin(ph)\n"
+    "                             : RIVER_BOTTOM + amp * sin(ph + 0.55);\n"
+    "    vX = aPos.x;\n"
+    "    vTop = aPos.y;\n"
+    "    gl_Position = sceneToClip(vec2(aPos.x, y));\n"
+    "}\n";
+
+static const char* RIVER_FS =
+    "in float vX;\n"
+    "in float vTop;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    vec3  water = tod(TOD_WATER);\n"
+    "    float depth = 0.10 + 0.10 * sin(vX * 0.02 + uRiverWave * 0.02);\n"
+    "    float band  = step(uView.x * 0.70, vX) * step(vX, uView.x * 0.92);\n"
+    "    float s     = band * uDayNight *\n"
+    "                  (0.10 + 0.10 * sin((vX - uView.x * 0.78) * 0.06 + uRiverWave * 0.10));\n"
+    "    vec3  top    = water + vec3(0.10, 0.10, 0.12) + s;\n"
+    "    vec3  bottom = water - depth * vec3(1.0, 0.9, 0.6);\n"
+    "    fragColor = vec4(mix(bottom, top, vTop), 1.0);\n"
+    "}\n";
+
+// stars: rotation about the pole with sunAngle, twinkle per vertex
+static const char* STAR_VS =
+    "layout(location = 0) in vec2 aPos;\n"
+    "layout(location = 1) in vec4 aTintMag;\n"   // rgb tint, magnitude
+    "layout(location = 2) in vec2 aTwinkle;\n"   // phase (turns), rate class / 255
+    "out vec4 vColor;\n"
+    "void main() {\n"
+    "    float c = cos(uSunAngle), s = sin(uSunAngle);\n"
+    "    vec2  d = aPos - STAR_POLE;\n"
+    "    vec2  p = STAR_POLE + vec2(c * d.x - s * d.y, s * d.x + c * d.y);\n"
+    "    float rate = 0.04 + 0.03 * floor(aTwinkle.y * 255.0 + 0.5);\n"
+    "    float tw   = 0.65 + 0.35 * sin(uTime * rate + aTwinkle.x * 6.28318531);\n"
+    "    float fade = max(0.0, 1.0 - uDayNight / 0.3);\n"
+    "    vColor = vec4(aTintMag.rgb, aTintMag.a * tw * fade);\n"
+    "    gl_ClipDistance[0] = p.y - STAR_HORIZON;\n"
+    "    gl_Position = sceneToClip(p);\n"
+    "}\n";
+
+static const char* STAR_FS =
+    "in vec4 vColor;\n"
+    "out vec4 fragColor;\n"
+    "void main() { fragColor = vColor; }\n";
+
+static GLuint compileShader(GLenum type, const char* body) {
+    char defines[512];
+    snprintf(defines, sizeof(defines),
+             "#define TOD_SKY_TOP %d\n#define TOD_SKY_BOTTOM %d\n#define TOD_WATER %d\n"
+             "#define RIVER_TOP %.1f\n#define RIVER_BOTTOM %.1f\n"
+             "#define STAR_POLE vec2(%.1f, %.1f)\n#define STAR_HORIZON %.1f\n",
+             (int)TOD_SKY_TOP, (int)TOD_SKY_BOTTOM, (int)TOD_WATER, RIVER_TOP, RIVER_BOTTOM,
+             STAR_POLE_X, STAR_POLE_Y, STAR_HORIZON);
+    const char* src[3] = {SHADER_COMMON, defines, body};
+
+    GLuint s = gl3.CreateShader(type);
+    gl3.ShaderSource(s, 3, src, NULL);
+    gl3.CompileShader(s);
+
+    GLint ok = 0;
+    gl3.GetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        gl3.GetShaderInfoLog(s, sizeof(log), NULL, log);
+        printf("Shader compile failed:\n%s\n", log);
+        gl3.DeleteShader(s);
+        return 0;
+    }
+    return s;
+}
 
-            // light highlight
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glColor4f(0.30f * k, 0.85f * k, 0.30f * k, 0.35f);
-            glBegin(GL_TRIANGLES);
-                glVertex2f(topX, topY);
-                glVertex2f(topX + px*(bW*0.45f), topY + py*(bW*0.45f));
-                glVertex2f(ex + px*(tW*0.6f),    ey + py*(tW*0.6f));
-            glEnd();
-            glDisable(GL_BLEND);
+static bool linkProgram(ShaderProgram& p, const char* vs, const char* fs) {
+    GLuint v = compileShader(GL_VERTEX_SHADER, vs);
+    GLuint f = compileShader(GL_FRAGMENT_SHADER, fs);
+    if (!v || !f) return false;
+
+    p.id = gl3.CreateProgram();
+    gl3.AttachShader(p.id, v);
+    gl3.AttachShader(p.id, f);
+    gl3.LinkProgram(p.id);
+    gl3.DeleteShader(v);
+    gl3.DeleteShader(f);
+
+    GLint ok = 0;
+    gl3.GetProgramiv(p.id, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        gl3.GetProgramInfoLog(p.id, sizeof(log), NULL, log);
+        printf("Shader link failed:\n%s\n", log);
+        return false;
+    }
 
-            // midrib
-            glColor3f(0.05f * k, 0.30f * k, 0.08f * k);
-            glLineWidth(2.0f);
-            glBegin(GL_LINES);
-                glVertex2f(topX, topY);
-                glVertex2f(ex, ey);
-            glEnd();
-        };
+    p.uView      = gl3.GetUniformLocation(p.id, "uView");
+    p.uTod       = gl3.GetUniformLocation(p.id, "uTod");
+    p.uSunAngle  = gl3.GetUniformLocation(p.id, "uSunAngle");
+    p.uRiverWave = gl3.GetUniformLocation(p.id, "uRiverWave");
+    p.uDayNight  = gl3.GetUniformLocation(p.id, "uDayNight");
+    p.uTime      = gl3.GetUniformLocation(p.id, "uTime");
+    return true;
+}
 
-        // leaves
-        palmLeaf( 20, 78, 12);
-        palmLeaf( 55, 70, 11);
-        palmLeaf( 95, 62, 10);
-        palmLeaf(140, 70, 11);
-        palmLeaf(170, 78, 12);
-        palmLeaf(-20, 78, 12);
-        palmLeaf(-55, 70, 11);
-        palmLeaf(-95, 62, 10);
+// Call once with the window's context current (after glutCreateWindow).
+// Leaves shadersReady false, and the fixed-function path in use, on any failure.
+void initShaders() {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+    if (!version || sscanf(version, "%d.%d", &major, &minor) != 2 || major * 10 + minor < 33) {
+        printf("OpenGL %s: no GLSL 3.30, using the fixed-function path\n", version ? version : "?");
+        return;
     }
 
-    // ==========================================================
-    // 3) FRUIT TREE (canopy + fruits + highlight)
-    // ==========================================================
-    else {
-        trunkTaper(10, 6, 70);
+#if defined(FREEGLUT)
+#define GL3_LOAD(type, name) \
+    gl3.name = (type)glutGetProcAddress("gl" #name); \
+    if (!gl3.name) { printf("gl" #name " missing, using the fixed-function path\n"); return; }
+    GL3_FUNCS(GL3_LOAD)
+#undef GL3_LOAD
+#else
+    printf("GLUT without glutGetProcAddress, using the fixed-function path\n");
+    return;
+#endif
 
-        leafCluster(x + sway * 0.2f, y + 95 + sway * 0.9f, 34.0f, 1.00f, 1.05f);
-        leafCluster(x - 22 + sway * 0.15f, y + 78 + sway * 0.6f, 26.0f, 1.02f, 1.00f);
-        leafCluster(x + 22 + sway * 0.15f, y + 78 + sway * 0.6f, 26.0f, 1.02f, 1.00f);
+    if (!linkProgram(skyProgram, SKY_VS, SKY_FS) ||
+        !linkProgram(riverProgram, RIVER_VS, RIVER_FS) ||
+        !linkProgram(starProgram, STAR_VS, STAR_FS)) return;
+
+    // time-of-day table: one RGB32F texel per (material, row)
+    glGenTextures(1, &todTexture);
+    glBindTexture(GL_TEXTURE_2D, todTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, TOD_COUNT, TOD_LUT_SIZE, 0, GL_RGB, GL_FLOAT, todTable);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    const float sky[8] = {0, HEIGHT * 0.6f, WIDTH, HEIGHT * 0.6f, 0, HEIGHT, WIDTH, HEIGHT};
+    gl3.GenVertexArrays(1, &skyVao);
+    gl3.GenBuffers(1, &skyVbo);
+    gl3.BindVertexArray(skyVao);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, skyVbo);
+    gl3.BufferData(GL_ARRAY_BUFFER, sizeof(sky), sky, GL_STATIC_DRAW);
+    gl3.EnableVertexAttribArray(0);
+    gl3.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (const void*)0);
+
+    gl3.GenVertexArrays(1, &riverVao);
+    gl3.GenBuffers(1, &riverVbo);
+    gl3.BindVertexArray(riverVao);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, riverVbo);
+    gl3.EnableVertexAttribArray(0);
+    gl3.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (const void*)0);
+
+    // stars: the Star array as is (position, tint + magnitude, twinkle)
+    gl3.GenVertexArrays(1, &starVao);
+    gl3.GenBuffers(1, &starVbo);
+    gl3.BindVertexArray(starVao);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, starVbo);
+    gl3.BufferData(GL_ARRAY_BUFFER, starfield.size() * sizeof(Star),
+                   starfield.empty() ? NULL : starfield.data(), GL_STATIC_DRAW);
+    gl3.EnableVertexAttribArray(0);
+    gl3.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Star), (const void*)offsetof(Star, x));
+    gl3.EnableVertexAttribArray(1);
+    gl3.VertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Star), (const void*)offsetof(Star, r));
+    gl3.EnableVertexAttribArray(2);
+    gl3.VertexAttribPointer(2, 2, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Star), (const void*)offsetof(Star, phase));
+
+    // the rest of the scene uses client-side arrays: leave no buffer / VAO bound
+    gl3.BindVertexArray(0);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    initCrowdShader();   // optional: crowd, herd and coaches fall back to client-side arrays
+    initHerdShader();
+    initCoachShader();
+    shadersReady = true;
+    printf("OpenGL %s: GLSL sky + river path ready (U toggles)\n", version);
+}
 
-        // fruits
-        glColor3f(1.0f * k, 0.50f * k, 0.05f * k);
-        drawCircle(x - 10, y + 88, 4, 16);
-        drawCircle(x +  6, y + 84, 4, 16);
-        drawCircle(x + 14, y + 96, 4, 16);
+// ---- bloom read-back: two pixel-pack buffers used in turn ----
+// Each frame starts an async glReadPixels into one buffer and maps the
+// other, filled by the frame before: the copy runs while the CPU blurs,
+// instead of draining the pipeline every frame. The bloom is one frame
+// late, which does not show at 60 Hz.
+GLuint framePbo[2]   = {0, 0};
+int    framePboW     = 0, framePboH = 0;
+int    framePboNext  = 0;       // the buffer this frame reads into
+bool   framePboFull  = false;   // the other one holds a frame of this size
+bool   framePboMapped = false;
+
+const unsigned char* mapLastFrame(int w, int h) {
+    if (!shadersReady) return NULL;
+    size_t bytes = (size_t)w * h * 4;
+    if (!framePbo[0]) gl3.GenBuffers(2, framePbo);
+    if (w != framePboW || h != framePboH) {
+        for (int i = 0; i < 2; i++) {
+            gl3.BindBuffer(GL_PIXEL_PACK_BUFFER, framePbo[i]);
+            gl3.BufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+        }
+        framePboW    = w;
+        framePboH    = h;
+        framePboFull = false;
+    }
 
-        // fruit highlights
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glColor4f(1, 1, 1, 0.18f);
-        drawCircle(x - 11, y + 90, 1.2f, 10);
-        drawCircle(x +  5, y + 86, 1.2f, 10);
-        glDisable(GL_BLEND);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    gl3.BindBuffer(GL_PIXEL_PACK_BUFFER, framePbo[framePboNext]);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    framePboNext ^= 1;
+
+    const unsigned char* last = NULL;
+    if (framePboFull) {
+        gl3.BindBuffer(GL_PIXEL_PACK_BUFFER, framePbo[framePboNext]);
+        last = (const unsigned char*)gl3.MapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        framePboMapped = last != NULL;
     }
+    framePboFull = true;
+    if (!framePboMapped) gl3.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return last;
 }
 
+void unmapLastFrame() {
+    if (!framePboMapped) return;
+    gl3.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    gl3.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    framePboMapped = false;
+}
 
-void drawBush(float x, float y, float size) {
-    glColor3f(0.1f, 0.4f, 0.1f);
-    drawCircle(x, y, size);
-    drawCircle(x + size * 0.8f, y, size * 0.7f);
-    drawCircle(x - size * 0.8f, y, size * 0.7f);
-    drawCircle(x, y + size * 0.7f, size * 0.6f);
+static void useSceneProgram(const ShaderProgram& p) {
+    gl3.UseProgram(p.id);
+    gl3.Uniform2f(p.uView, (float)WIDTH, (float)HEIGHT);
+    gl3.Uniform1i(p.uTod, 0);
+    gl3.Uniform1f(p.uSunAngle, sunAngle);
+    gl3.Uniform1f(p.uRiverWave, riverWave);
+    gl3.Uniform1f(p.uDayNight, dayNightBlend);
+    gl3.Uniform1f(p.uTime, (float)scene.tick);
+    glBindTexture(GL_TEXTURE_2D, todTexture);
 }
 
-// ============================================================================
-// VEHICLES
-// ============================================================================
+static void endSceneProgram() {
+    glBindTexture(GL_TEXTURE_2D, 0);
+    gl3.BindVertexArray(0);
+    gl3.UseProgram(0);
+}
 
-// ======================= REPLACE THIS FUNCTION =======================
-// Cleaner engine "first bogie": grill looks nicer + less weird when covered
-void drawTrain(float x, float y) {
-    int bogieCount = trainBogieCount;
+bool shaderPathActive() {
+    return shadersReady && useShaders;
+}
 
-    // ============================================================
-    // 1) SOFT GROUND SHADOWS (NO BIG RECTANGLE SHADOW)
-    //    (This fixes the weird big "shape" shadow)
-    // ============================================================
-    // Engine ground shadow
-    drawShadowEllipse(x + 75,  y - 14, 78, 12, 0.22f);
+void drawSkyShader() {
+    useSceneProgram(skyProgram);
+    gl3.BindVertexArray(skyVao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    endSceneProgram();
+}
 
-    // Extra small shadow near engine back bogie (connector side)
-    // (This is the one you asked: "engine bogie back side shadow")
-    drawShadowEllipse(x + 138, y - 13, 26, 9,  0.18f);
+// called by drawStars() with blending and the horizon clip already set
+void drawStarsShader() {
+    useSceneProgram(starProgram);
+    gl3.BindVertexArray(starVao);
+    drawStarRanges();
+    endSceneProgram();
+}
 
-    // Coach ground shadows
-    float shadowX = x + 170;
-    for (int i = 0; i < bogieCount; i++) {
-        drawShadowEllipse(shadowX + 45, y - 14, 55, 10, 0.18f);
-        shadowX += 100;
+void drawRiverShader() {
+    // same column spacing as the CPU strip; only re-uploaded on resize
+    int columns = riverColumnsFor(winW);
+    if (columns != riverVboColumns) {
+        std::vector<float> v((size_t)columns * 4);
+        const float dx = (float)WIDTH / (columns - 1);
+        for (int i = 0; i < columns; i++) {
+            v[i * 4 + 0] = i * dx; v[i * 4 + 1] = 1.0f;
+            v[i * 4 + 2] = i * dx; v[i * 4 + 3] = 0.0f;
+        }
+        gl3.BindBuffer(GL_ARRAY_BUFFER, riverVbo);
+        gl3.BufferData(GL_ARRAY_BUFFER, v.size() * sizeof(float), v.data(), GL_STATIC_DRAW);
+        gl3.BindBuffer(GL_ARRAY_BUFFER, 0);
+        riverVboColumns = columns;
     }
 
-    // -------------------- ENGINE (front) --------------------
-
-    // Main engine body
-    glColor3f(0.70f, 0.10f, 0.12f);
-    glBegin(GL_QUADS);
-        glVertex2f(x,     y);
-        glVertex2f(x+120, y);
-        glVertex2f(x+120, y+48);
-        glVertex2f(x,     y+48);
-    glEnd();
-
-    // Engine back-side shading strip (near coach connection side)
-    // (gives depth + fixes flat look)
-    glColor3f(0.52f, 0.07f, 0.09f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+104, y+2);
-        glVertex2f(x+120, y+2);
-        glVertex2f(x+120, y+46);
-        glVertex2f(x+104, y+46);
-    glEnd();
+    useSceneProgram(riverProgram);
+    gl3.BindVertexArray(riverVao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, columns * 2);
+    endSceneProgram();
+}
 
-    // Engine nose (angled)
-    glColor3f(0.60f, 0.08f, 0.10f);
-    glBegin(GL_POLYGON);
-        glVertex2f(x+120, y);
-        glVertex2f(x+150, y+8);
-        glVertex2f(x+150, y+40);
-        glVertex2f(x+120, y+48);
-    glEnd();
+// ============================================================================
+// REFLECTION PASS (the water mirrors the finished frame above it)
+// Instead of hand-made reflection blobs, drawReflections() copies the
+// frame from the near river bank up past the sun and moon into a texture
+// once (GPU side, glCopyTexSubImage2D, no read-back) and lays mirrored
+// spans of it over the 120..180 band:
+//  - the far bank, 190..600, flipped and squashed into the band (seen at
+//    a grazing angle): sky, hills, trees, houses, train, sun and moon;
+//  - whatever floats on the river (boat, dock) registers an addMirror()
+//    box, flipped about mid-river like the old blobs, faded at the sides.
+// Each span is cut into 2-unit slices shifted sideways by a riverWave
+// ripple and blended more strongly near the far bank (grazing angle).
+// The stencil keeps the result on open water (MASK_WATER), so the boat,
+// dock and banks stay on top. The cost is one copy plus a few hundred
+// quads whatever the scene holds. Needs the stencil buffer.
+// ============================================================================
 
-    // Roof
-    glColor3f(0.25f, 0.25f, 0.25f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+10,  y+48);
-        glVertex2f(x+115, y+48);
-        glVertex2f(x+108, y+62);
-        glVertex2f(x+15,  y+62);
-    glEnd();
+const float REFLECT_SRC_BOTTOM = 100.0f;   // copied rows (scene units)
+const float REFLECT_SRC_TOP    = 600.0f;
+const float REFLECT_MIRROR_Y   = 150.0f;   // mid-river: floating things flip here
+const float REFLECT_SLICE      = 2.0f;     // ripple slice height (scene units)
+
+struct MirrorSpan {
+    float x0, x1;       // columns (scene units)
+    float sy0, sy1;     // source rows
+    float dy0, dy1;     // where sy0 / sy1 land (flipped when dy1 < dy0)
+    float alpha;
+    float fade;         // side fade width, 0 for full-width spans
+};
 
-    // Window (engine)
-    glColor3f(0.80f, 0.93f, 1.0f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+20, y+22);
-        glVertex2f(x+45, y+22);
-        glVertex2f(x+45, y+40);
-        glVertex2f(x+20, y+40);
-    glEnd();
+std::vector<MirrorSpan> frameMirrors;
+std::vector<float>      mirrorXY, mirrorUV;
+std::vector<GLubyte>    mirrorRGBA;
+GLuint reflectTexture = 0;
+int    reflectTexW = 0, reflectTexH = 0;
+
+// box [x0,x1] x [y0,y1] on the water, flipped about mid-river and squashed
+void addMirror(float x0, float x1, float y0, float y1, float squash, float alpha) {
+    MirrorSpan m = {x0, x1, y0, y1,
+                    REFLECT_MIRROR_Y - (y0 - REFLECT_MIRROR_Y) * squash,
+                    REFLECT_MIRROR_Y - (y1 - REFLECT_MIRROR_Y) * squash,
+                    alpha, (x1 - x0) * 0.2f};
+    frameMirrors.push_back(m);
+}
 
-    // Door (engine)
-    glColor3f(0.40f, 0.05f, 0.08f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+55, y+10);
-        glVertex2f(x+78, y+10);
-        glVertex2f(x+78, y+40);
-        glVertex2f(x+55, y+40);
-    glEnd();
+static inline float rippleShift(float y) {
+    return std::sin(riverWave * 0.12f + y * 0.70f) * 2.5f
+         + std::sin(riverWave * 0.05f + y * 0.23f) * 1.5f;
+}
 
-    // Front grill lines
-    glColor3f(0.20f, 0.20f, 0.20f);
-    glLineWidth(2.0f);
-    glBegin(GL_LINES);
-        for (int i = 0; i < 6; i++) {
-            float gx = x + 92 + i * 4.0f;
-            glVertex2f(gx, y+8);
-            glVertex2f(gx, y+40);
+// spans -> quads (no GL); u, v in texture space for a copy of the window
+// rows REFLECT_SRC_BOTTOM.. at winW x winH
+static int buildMirrorQuads(float texW, float texH) {
+    const float su = (float)winW / WIDTH / texW;
+    const float sv = (float)winH / HEIGHT / texH;
+    const float band0 = RIVER_BOTTOM, band1 = RIVER_TOP;
+
+    mirrorXY.clear();
+    mirrorUV.clear();
+    mirrorRGBA.clear();
+    for (size_t k = 0; k < frameMirrors.size(); k++) {
+        const MirrorSpan& m = frameMirrors[k];
+        float lo = std::max(band0, std::min(m.dy0, m.dy1));
+        float hi = std::min(band1, std::max(m.dy0, m.dy1));
+        if (lo >= hi) continue;
+
+        // columns: fade in, full, fade out (one quad per column pair)
+        float xs[4] = {m.x0, m.x0 + m.fade, m.x1 - m.fade, m.x1};
+        float as[4] = {m.fade > 0.0f ? 0.0f : 1.0f, 1.0f, 1.0f, m.fade > 0.0f ? 0.0f : 1.0f};
+
+        for (float y = lo; y < hi; y += REFLECT_SLICE) {
+            float yb = y, yt = std::min(hi, y + REFLECT_SLICE);
+            float dx = rippleShift(yb);
+            float vb = (m.sy0 + (yb - m.dy0) / (m.dy1 - m.dy0) * (m.sy1 - m.sy0) - REFLECT_SRC_BOTTOM) * sv;
+            float vt = (m.sy0 + (yt - m.dy0) / (m.dy1 - m.dy0) * (m.sy1 - m.sy0) - REFLECT_SRC_BOTTOM) * sv;
+            // stronger near the far bank, where the water is seen at a grazing angle
+            float depth = 0.45f + 0.55f * (yb - band0) / (band1 - band0);
+
+            for (int c = 0; c < 3; c++) {
+                if (xs[c + 1] <= xs[c]) continue;
+                const float qx[4] = {xs[c], xs[c + 1], xs[c + 1], xs[c]};
+                const float qy[4] = {yb, yb, yt, yt};
+                const float qv[4] = {vb, vb, vt, vt};
+                const float qa[4] = {as[c], as[c + 1], as[c + 1], as[c]};
+                for (int i = 0; i < 4; i++) {
+                    mirrorXY.push_back(qx[i]);
+                    mirrorXY.push_back(qy[i]);
+                    mirrorUV.push_back((qx[i] + dx) * su);
+                    mirrorUV.push_back(qv[i]);
+                    float a = m.alpha * depth * qa[i];
+                    mirrorRGBA.push_back(217);   // a little of the water's blue
+                    mirrorRGBA.push_back(230);
+                    mirrorRGBA.push_back(255);
+                    mirrorRGBA.push_back((GLubyte)(std::min(1.0f, a) * 255.0f + 0.5f));
+                }
+            }
         }
-    glEnd();
-
-    // Headlight (glow at night)
-    if (!isDay) {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-        glColor4f(1.0f, 1.0f, 0.85f, 0.85f);
-        drawCircle(x+148, y+24, 5.0f, 18);
-
-        glColor4f(1.0f, 1.0f, 0.85f, 0.18f);
-        drawCircle(x+148, y+24, 14.0f, 28);
-
-        glDisable(GL_BLEND);
-    } else {
-        glColor3f(1.0f, 1.0f, 0.85f);
-        drawCircle(x+148, y+24, 4.0f, 18);
     }
+    return (int)(mirrorXY.size() / 2);
+}
 
-    // Stripe on engine
-    glColor3f(0.95f, 0.85f, 0.20f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+0,   y+18);
-        glVertex2f(x+150, y+18);
-        glVertex2f(x+150, y+24);
-        glVertex2f(x+0,   y+24);
-    glEnd();
+// after everything that stands on or above the water, before the shadow pass
+void drawReflections() {
+    if (!shadowStencil) {
+        frameMirrors.clear();
+        return;
+    }
 
-    // ============================================================
-    // ENGINE BOGIE BASE (THIS REMOVES "WEIRD SHAPE" LOOK)
-    // + extra shadow on back side of bogie frame
-    // ============================================================
-    // Main bogie frame
-    glColor3f(0.20f, 0.20f, 0.22f);
-    glBegin(GL_QUADS);
-        glVertex2f(x + 18, y - 4);
-        glVertex2f(x + 108, y - 4);
-        glVertex2f(x + 108, y + 6);
-        glVertex2f(x + 18, y + 6);
-    glEnd();
+    // the far bank (and the sky above it) over the whole band
+    MirrorSpan bank = {0.0f, (float)WIDTH, RIVER_TOP + 10.0f, REFLECT_SRC_TOP,
+                       RIVER_TOP, RIVER_BOTTOM, 0.42f, 0.0f};
+    frameMirrors.push_back(bank);
+
+    int srcY = (int)(REFLECT_SRC_BOTTOM * winH / HEIGHT);
+    int srcH = std::min(winH - srcY, (int)std::ceil(REFLECT_SRC_TOP * winH / HEIGHT) - srcY);
+    int texW = 1, texH = 1;
+    while (texW < winW) texW <<= 1;
+    while (texH < srcH) texH <<= 1;
+    if (!reflectTexture || texW != reflectTexW || texH != reflectTexH) {
+        if (!reflectTexture) glGenTextures(1, &reflectTexture);
+        glBindTexture(GL_TEXTURE_2D, reflectTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, texW, texH, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        reflectTexW = texW;
+        reflectTexH = texH;
+    }
+    glBindTexture(GL_TEXTURE_2D, reflectTexture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, srcY, winW, srcH);
 
-    // Back-side bogie shadow strip (connector side)
-    glColor3f(0.12f, 0.12f, 0.14f);
-    glBegin(GL_QUADS);
-        glVertex2f(x + 92,  y - 4);
-        glVertex2f(x + 108, y - 4);
-        glVertex2f(x + 108, y + 6);
-        glVertex2f(x + 92,  y + 6);
-    glEnd();
+    int n = buildMirrorQuads((float)texW, (float)texH);
+    frameMirrors.clear();
 
-    // Coupler (engine to coach)
-    glColor3f(0.15f, 0.15f, 0.15f);
-    glLineWidth(4.0f);
-    glBegin(GL_LINES);
-        glVertex2f(x+150, y+10);
-        glVertex2f(x+165, y+10);
-    glEnd();
+    glStencilFunc(GL_EQUAL, MASK_WATER, MASK_WATER);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, mirrorXY.data());
+    glTexCoordPointer(2, GL_FLOAT, 0, mirrorUV.data());
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, mirrorRGBA.data());
+    glDrawArrays(GL_QUADS, 0, n);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisable(GL_BLEND);
+    glDisable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+}
 
-    // -------------------- COACHES --------------------
-    float bx = x + 170;
+void drawRiver() {
+    float topY    = RIVER_TOP;
+    float bottomY = RIVER_BOTTOM;
+    float midY    = (topY + bottomY) * 0.5f;
 
-    for (int i = 0; i < bogieCount; i++) {
-        float r = 0.10f + 0.02f * (i % 3);
-        float g = 0.35f + 0.03f * (i % 2);
-        float b = 0.65f + 0.02f * (i % 3);
+    float waveIntensity = 3.0f + 2.0f * std::sin(riverWave * 0.05f);
 
-        glColor3f(r, g, b);
-        glBegin(GL_QUADS);
-            glVertex2f(bx,      y);
-            glVertex2f(bx+90,   y);
-            glVertex2f(bx+90,   y+40);
-            glVertex2f(bx,      y+40);
-        glEnd();
+    // -------------------- WATER BODY (one strip, see RIVER SURFACE) --------------------
+    if (shaderPathActive()) {
+        drawRiverShader();
+    } else {
+        buildRiverSurface(riverSurface, riverColumnsFor(winW), riverWave, waveIntensity,
+                          todNow[TOD_WATER], isDay);
+        drawRiverSurface(riverSurface);
+    }
 
-        // Coach roof
-        glColor3f(0.30f, 0.30f, 0.30f);
-        glBegin(GL_QUADS);
-            glVertex2f(bx+6,   y+40);
-            glVertex2f(bx+84,  y+40);
-            glVertex2f(bx+78,  y+52);
-            glVertex2f(bx+12,  y+52);
-        glEnd();
+    // -------------------- SPARKLES (daytime glitter) --------------------
+    if (isDay) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        // Windows (3)
-        glColor3f(0.85f, 0.95f, 1.0f);
-        for (int w = 0; w < 3; w++) {
-            float wx = bx + 12 + w * 25;
-            glBegin(GL_QUADS);
-                glVertex2f(wx,     y+18);
-                glVertex2f(wx+18,  y+18);
-                glVertex2f(wx+18,  y+34);
-                glVertex2f(wx,     y+34);
-            glEnd();
-        }
+        glPointSize(2.0f);
+        glBegin(GL_POINTS);
+        for (int i = 0; i < 120; i++) {
+            float px = (i * 37 + (int)(riverWave * 10)) % WIDTH;
+            float py = midY + std::sin((px * 0.03f) + riverWave * 0.08f + i) * 10.0f;
 
-        // Window frames
-        glColor3f(0.15f, 0.15f, 0.15f);
-        glLineWidth(2.0f);
-        for (int w = 0; w < 3; w++) {
-            float wx = bx + 12 + w * 25;
-            glBegin(GL_LINE_LOOP);
-                glVertex2f(wx,     y+18);
-                glVertex2f(wx+18,  y+18);
-                glVertex2f(wx+18,  y+34);
-                glVertex2f(wx,     y+34);
-            glEnd();
+            float a = 0.10f + 0.25f * (0.5f + 0.5f * std::sin(riverWave * 0.15f + i));
+            glColor4f(1.0f, 1.0f, 1.0f, a);
+            glVertex2f(px, py);
         }
-
-        // Door
-        glColor3f(0.20f, 0.20f, 0.22f);
-        glBegin(GL_QUADS);
-            glVertex2f(bx+72, y+8);
-            glVertex2f(bx+86, y+8);
-            glVertex2f(bx+86, y+36);
-            glVertex2f(bx+72, y+36);
-        glEnd();
-
-        // Connector between coaches
-        glColor3f(0.15f, 0.15f, 0.15f);
-        glLineWidth(4.0f);
-        glBegin(GL_LINES);
-            glVertex2f(bx+90,  y+10);
-            glVertex2f(bx+100, y+10);
         glEnd();
 
-        bx += 100;
+        glDisable(GL_BLEND);
     }
 
-    // -------------------- WHEELS --------------------
-    auto drawWheelPair = [&](float wx) {
-        glColor3f(0.08f, 0.08f, 0.08f);
-        drawCircle(wx,      y - 8, 8, 20);
-        drawCircle(wx + 34, y - 8, 8, 20);
-
-        glColor3f(0.75f, 0.75f, 0.75f);
-        drawCircle(wx,      y - 8, 3, 16);
-        drawCircle(wx + 34, y - 8, 3, 16);
-    };
+    // -------------------- BANK FOAM --------------------
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    // Engine wheels (2 pairs)
-    drawWheelPair(x + 30);
-    drawWheelPair(x + 85);
+    glColor4f(0.90f, 0.95f, 1.0f, 0.18f);
+    for (int x = 0; x <= WIDTH; x += 28) {
+        float t = std::sin(x * 0.08f + riverWave * 0.18f) * 2.0f;
+        drawEllipse((float)x, topY - 3.0f + t,    10.0f, 2.6f, 18);
+        drawEllipse((float)x, bottomY + 3.0f + t, 10.0f, 2.6f, 18);
+    }
 
-    // Coach wheels (1 pair per coach)
-    float wx = x + 190;
-    for (int i = 0; i < bogieCount; i++) {
-        drawWheelPair(wx + 18);
-        wx += 100;
+    // -------------------- SUBTLE RIPPLE RINGS --------------------
+    glColor4f(0.85f, 0.95f, 1.0f, 0.10f);
+    for (int i = 0; i < 6; i++) {
+        float rx = (200.0f + i * 170.0f) + std::sin(riverWave * 0.04f + i) * 25.0f;
+        float ry = 140.0f + std::sin(riverWave * 0.07f + i * 2.0f) * 8.0f;
+        float rr = 10.0f + std::fmod(riverWave * (1.2f + i * 0.25f), 18.0f);
+        drawEllipse(rx, ry, rr, rr * 0.35f, 30);
     }
 
-    // -------------------- OUTLINE --------------------
-    glColor3f(0.12f, 0.12f, 0.12f);
-    glLineWidth(2.0f);
+    glDisable(GL_BLEND);
 
-    // Engine outline
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(x, y); glVertex2f(x+120, y);
-        glVertex2f(x+120, y+48); glVertex2f(x, y+48);
-    glEnd();
+    // -------------------- RIVER BANK (soil strips) --------------------
+    glColor3f(0.45f, 0.35f, 0.20f);
+    glBegin(GL_QUADS);
+        glVertex2f(0, topY);
+        glVertex2f(WIDTH, topY);
+        glVertex2f(WIDTH, topY + 10);
+        glVertex2f(0, topY + 10);
 
-    // Coaches outline
-    float ox = x + 170;
-    for (int i = 0; i < bogieCount; i++) {
-        glBegin(GL_LINE_LOOP);
-            glVertex2f(ox, y); glVertex2f(ox+90, y);
-            glVertex2f(ox+90, y+40); glVertex2f(ox, y+40);
-        glEnd();
-        ox += 100;
-    }
+        glVertex2f(0, bottomY - 10);
+        glVertex2f(WIDTH, bottomY - 10);
+        glVertex2f(WIDTH, bottomY);
+        glVertex2f(0, bottomY);
+    glEnd();
 }
 
 
-void drawBus(float x, float y) {
-    // --- soft shadow ---
-    drawShadowEllipse(x + 72, y - 18, 72, 11, 0.28f);
 
-    // ===================== BODY (two-tone + shading) =====================
-    // main body
-    glColor3f(0.92f, 0.72f, 0.12f);
-    glBegin(GL_QUADS);
-        glVertex2f(x,      y);
-        glVertex2f(x+150,  y);
-        glVertex2f(x+150,  y+55);
-        glVertex2f(x,      y+55);
-    glEnd();
+void drawRailTrack() {
+    float y0 = 335.0f;   // ballast bottom
+    float y1 = 360.0f;   // ballast top
 
-    // roof band (slightly darker)
-    glColor3f(0.80f, 0.60f, 0.10f);
+    // ---------- BALLAST (stone base) gradient ----------
     glBegin(GL_QUADS);
-        glVertex2f(x,     y+45);
-        glVertex2f(x+150, y+45);
-        glVertex2f(x+150, y+55);
-        glVertex2f(x,     y+55);
+        matColor(MAT_BALLAST_LOW);
+        glVertex2f(0, y0);
+        glVertex2f(WIDTH, y0);
+
+        matColor(MAT_BALLAST_HIGH);
+        glVertex2f(WIDTH, y1);
+        glVertex2f(0, y1);
     glEnd();
 
-    // back-side shading strip (depth)
-    glColor3f(0.70f, 0.50f, 0.08f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+132, y+2);
-        glVertex2f(x+150, y+2);
-        glVertex2f(x+150, y+53);
-        glVertex2f(x+132, y+53);
+    // small random stones dots (gives realism)
+    glPointSize(2.0f);
+    glBegin(GL_POINTS);
+    for (int i = 0; i < 220; i++) {
+        float x = (i * 37) % WIDTH;
+        float y = y0 + 2 + (i * 19) % (int)(y1 - y0 - 4);
+        matColor(MAT_STONE + i % 3);
+        glVertex2f(x, y);
+    }
     glEnd();
 
-    // front nose (small angle)
-    glColor3f(0.86f, 0.66f, 0.10f);
-    glBegin(GL_POLYGON);
-        glVertex2f(x+150, y);
-        glVertex2f(x+162, y+10);
-        glVertex2f(x+162, y+45);
-        glVertex2f(x+150, y+55);
-    glEnd();
+    // ---------- SLEEPERS (wooden ties) ----------
+    float sleeperY0 = y0 + 4;
+    float sleeperY1 = y1 - 4;
 
-    // ===================== WINDOWS (glass + frames) =====================
-    glColor3f(0.78f, 0.92f, 1.0f);
-    for (int i = 0; i < 7; i++) {
-        float wx = x + 12 + i * 18;
+    for (float x = 0; x < WIDTH; x += 42.0f) {
+        // wood
+        matColor(MAT_SLEEPER);
         glBegin(GL_QUADS);
-            glVertex2f(wx,     y + 28);
-            glVertex2f(wx + 14,y + 28);
-            glVertex2f(wx + 14,y + 44);
-            glVertex2f(wx,     y + 44);
+            glVertex2f(x,      sleeperY0);
+            glVertex2f(x+28.0f,sleeperY0);
+            glVertex2f(x+30.0f,sleeperY1);
+            glVertex2f(x-2.0f, sleeperY1);
         glEnd();
-    }
 
-    // window frames
-    glColor3f(0.15f, 0.15f, 0.15f);
-    glLineWidth(2.0f);
-    for (int i = 0; i < 7; i++) {
-        float wx = x + 12 + i * 18;
-        glBegin(GL_LINE_LOOP);
-            glVertex2f(wx,     y + 28);
-            glVertex2f(wx + 14,y + 28);
-            glVertex2f(wx + 14,y + 44);
-            glVertex2f(wx,     y + 44);
+        // darker bottom strip (depth)
+        matColor(MAT_SLEEPER_SHADOW);
+        glBegin(GL_QUADS);
+            glVertex2f(x,       sleeperY0);
+            glVertex2f(x+28.0f, sleeperY0);
+            glVertex2f(x+28.0f, sleeperY0+3.0f);
+            glVertex2f(x,       sleeperY0+3.0f);
         glEnd();
     }
 
-    // ===================== DOOR =====================
-    glColor3f(0.25f, 0.25f, 0.28f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+110, y+6);
-        glVertex2f(x+128, y+6);
-        glVertex2f(x+128, y+46);
-        glVertex2f(x+110, y+46);
-    glEnd();
-
-    // door glass
-    glColor3f(0.78f, 0.92f, 1.0f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+112, y+28);
-        glVertex2f(x+126, y+28);
-        glVertex2f(x+126, y+44);
-        glVertex2f(x+112, y+44);
-    glEnd();
-
-    // handle
-    glColor3f(0.95f, 0.95f, 0.95f);
-    drawCircle(x+125, y+20, 1.8f, 14);
+    // ---------- RAILS ----------
+    float railY1 = 347.0f;
+    float railY2 = 354.0f;
 
-    // ===================== STRIPE + BUMPER =====================
-    glColor3f(0.10f, 0.10f, 0.10f);
-    glBegin(GL_QUADS);
-        glVertex2f(x,     y+18);
-        glVertex2f(x+162, y+18);
-        glVertex2f(x+162, y+23);
-        glVertex2f(x,     y+23);
+    // rail shadow (under rails)
+    matColor(MAT_RAIL_SHADOW);
+    glLineWidth(6.0f);
+    glBegin(GL_LINES);
+        glVertex2f(0, railY1 - 2); glVertex2f(WIDTH, railY1 - 2);
+        glVertex2f(0, railY2 - 2); glVertex2f(WIDTH, railY2 - 2);
     glEnd();
 
-    glColor3f(0.18f, 0.18f, 0.18f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+148, y+2);
-        glVertex2f(x+162, y+2);
-        glVertex2f(x+162, y+12);
-        glVertex2f(x+148, y+12);
+    // main rails
+    matColor(MAT_RAIL);
+    glLineWidth(4.0f);
+    glBegin(GL_LINES);
+        glVertex2f(0, railY1); glVertex2f(WIDTH, railY1);
+        glVertex2f(0, railY2); glVertex2f(WIDTH, railY2);
     glEnd();
 
-    // mirror
-    glColor3f(0.12f, 0.12f, 0.12f);
-    glBegin(GL_QUADS);
-        glVertex2f(x+145, y+35);
-        glVertex2f(x+153, y+35);
-        glVertex2f(x+153, y+40);
-        glVertex2f(x+145, y+40);
+    // top shine line (metal highlight)
+    matColor(MAT_RAIL_SHINE);
+    glLineWidth(1.5f);
+    glBegin(GL_LINES);
+        glVertex2f(0, railY1 + 1.0f); glVertex2f(WIDTH, railY1 + 1.0f);
+        glVertex2f(0, railY2 + 1.0f); glVertex2f(WIDTH, railY2 + 1.0f);
     glEnd();
 
-    // ===================== WHEELS + arches =====================
-    // arches
-    glColor3f(0.25f, 0.25f, 0.25f);
-    drawEllipse(x + 35,  y + 2, 18, 9, 24);
-    drawEllipse(x + 120, y + 2, 18, 9, 24);
-
-    // wheels
-    glColor3f(0.06f, 0.06f, 0.06f);
-    drawCircle(x + 35,  y - 8, 12, 24);
-    drawCircle(x + 120, y - 8, 12, 24);
-
-    glColor3f(0.75f, 0.75f, 0.75f);
-    drawCircle(x + 35,  y - 8, 5, 18);
-    drawCircle(x + 120, y - 8, 5, 18);
-
-    // ===================== LIGHTS =====================
-    // headlight glow at night
-    if (!isDay) {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // ---------- SMALL BOLTS / PLATES ----------
+    matColor(MAT_RAIL_PLATE);
+    for (float x = 8; x < WIDTH; x += 42.0f) {
+        // plates
+        glBegin(GL_QUADS);
+            glVertex2f(x+6, railY1-3); glVertex2f(x+14, railY1-3);
+            glVertex2f(x+14, railY1+3); glVertex2f(x+6, railY1+3);
 
-        glColor4f(1.0f, 1.0f, 0.85f, 0.85f);
-        drawCircle(x+160, y+16, 5, 18);
-        glColor4f(1.0f, 1.0f, 0.85f, 0.18f);
-        drawCircle(x+160, y+16, 13, 28);
+            glVertex2f(x+6, railY2-3); glVertex2f(x+14, railY2-3);
+            glVertex2f(x+14, railY2+3); glVertex2f(x+6, railY2+3);
+        glEnd();
 
-        glDisable(GL_BLEND);
-    } else {
-        glColor3f(1.0f, 1.0f, 0.85f);
-        drawCircle(x+160, y+16, 4, 18);
+        // bolts dots
+        glPointSize(2.0f);
+        glBegin(GL_POINTS);
+            glVertex2f(x+7, railY1-1);
+            glVertex2f(x+13, railY1-1);
+            glVertex2f(x+7, railY2-1);
+            glVertex2f(x+13, railY2-1);
+        glEnd();
     }
-
-    // tail light
-    glColor3f(0.95f, 0.20f, 0.20f);
-    drawCircle(x+6, y+16, 3.2f, 16);
-
-    // ===================== OUTLINE =====================
-    glColor3f(0.12f, 0.12f, 0.12f);
-    glLineWidth(2.0f);
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(x, y); glVertex2f(x+150, y);
-        glVertex2f(x+150, y+55); glVertex2f(x, y+55);
-    glEnd();
-
-    // small text (optional)
-    glColor3f(0,0,0);
-    glRasterPos2f(x + 55, y + 8);
-    glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, '2');
-    glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, '0');
-    glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, '2');
 }
 
 
-void drawCar(float x, float y) {
-    // shadow
-    drawShadowEllipse(x + 50, y - 18, 48, 10, 0.28f);
+// ============================================================================
+// DIVERSE HOUSES
+// ============================================================================
 
-    // ===================== BODY (two-tone) =====================
-    glColor3f(0.20f, 0.60f, 0.90f);
-    glBegin(GL_POLYGON);
-        glVertex2f(x,      y);
-        glVertex2f(x+96,   y);
-        glVertex2f(x+104,  y+12);
-        glVertex2f(x+92,   y+35);
-        glVertex2f(x+62,   y+48);
-        glVertex2f(x+28,   y+48);
-        glVertex2f(x+10,   y+35);
-        glVertex2f(x+2,    y+18);
+void drawModernHouse(float x, float y) {
+    // shadow
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(0,0,0,0.18f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+6, y-2); glVertex2f(x+126, y-2);
+        glVertex2f(x+126, y+142); glVertex2f(x+6, y+142);
     glEnd();
+    glDisable(GL_BLEND);
 
-    // lower darker skirt (depth)
-    glColor3f(0.12f, 0.42f, 0.68f);
+    // body
+    matColor(MAT_MODERN_WALL);
     glBegin(GL_QUADS);
-        glVertex2f(x+6,  y+2);
-        glVertex2f(x+98, y+2);
-        glVertex2f(x+92, y+10);
-        glVertex2f(x+10, y+10);
+        glVertex2f(x, y);
+        glVertex2f(x+120, y);
+        glVertex2f(x+120, y+140);
+        glVertex2f(x, y+140);
     glEnd();
 
-    // bumper front
-    glColor3f(0.18f, 0.18f, 0.18f);
+    // roof slab (overhang)
+    matColor(MAT_MODERN_ROOF);
     glBegin(GL_QUADS);
-        glVertex2f(x+98, y+2);
-        glVertex2f(x+106,y+2);
-        glVertex2f(x+106,y+14);
-        glVertex2f(x+98, y+14);
+        glVertex2f(x-6, y+140);
+        glVertex2f(x+126, y+140);
+        glVertex2f(x+122, y+152);
+        glVertex2f(x-2, y+152);
     glEnd();
 
-    // ===================== WINDOWS =====================
-    glColor3f(0.80f, 0.93f, 1.0f);
-    glBegin(GL_POLYGON);
-        glVertex2f(x+22, y+34);
-        glVertex2f(x+40, y+46);
-        glVertex2f(x+64, y+46);
-        glVertex2f(x+82, y+34);
-        glVertex2f(x+22, y+34);
+    // windows (2 big)
+    matColor(MAT_MODERN_WINDOW);
+    glBegin(GL_QUADS);
+        glVertex2f(x+18, y+78); glVertex2f(x+52, y+78);
+        glVertex2f(x+52, y+118); glVertex2f(x+18, y+118);
+
+        glVertex2f(x+68, y+78); glVertex2f(x+102, y+78);
+        glVertex2f(x+102, y+118); glVertex2f(x+68, y+118);
     glEnd();
+    if (!isDay) {   // lit at night: light pass
+        addLight(x+35, y+98, LIGHT_MEDIUM, 1.0f, 0.8f, 0.45f, 0.5f * (1.0f - dayNightBlend));
+        addLight(x+85, y+98, LIGHT_MEDIUM, 1.0f, 0.8f, 0.45f, 0.5f * (1.0f - dayNightBlend));
+    }
 
-    // window split + frame
-    glColor3f(0.15f, 0.15f, 0.15f);
-    glLineWidth(2.0f);
+    // window frames
+    matColor(MAT_WINDOW_FRAME);
+    glLineWidth(2);
     glBegin(GL_LINE_LOOP);
-        glVertex2f(x+22, y+34);
-        glVertex2f(x+40, y+46);
-        glVertex2f(x+64, y+46);
-        glVertex2f(x+82, y+34);
+        glVertex2f(x+18, y+78); glVertex2f(x+52, y+78);
+        glVertex2f(x+52, y+118); glVertex2f(x+18, y+118);
     glEnd();
-    glBegin(GL_LINES);
-        glVertex2f(x+52, y+46);
-        glVertex2f(x+52, y+34);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(x+68, y+78); glVertex2f(x+102, y+78);
+        glVertex2f(x+102, y+118); glVertex2f(x+68, y+118);
     glEnd();
 
-    // mirror
-    glColor3f(0.12f,0.12f,0.12f);
+    // door + step
+    matColor(MAT_MODERN_DOOR);
     glBegin(GL_QUADS);
-        glVertex2f(x+80, y+30);
-        glVertex2f(x+88, y+30);
-        glVertex2f(x+88, y+35);
-        glVertex2f(x+80, y+35);
+        glVertex2f(x+50, y);
+        glVertex2f(x+70, y);
+        glVertex2f(x+70, y+52);
+        glVertex2f(x+50, y+52);
     glEnd();
 
-    // door line + handle
-    glColor3f(0.12f,0.12f,0.12f);
-    glLineWidth(1.5f);
-    glBegin(GL_LINES);
-        glVertex2f(x+50, y+10); glVertex2f(x+50, y+34);
-    glEnd();
+    matColor(MAT_DOOR_STEP);
     glBegin(GL_QUADS);
-        glVertex2f(x+55, y+22);
-        glVertex2f(x+62, y+22);
-        glVertex2f(x+62, y+24);
-        glVertex2f(x+55, y+24);
+        glVertex2f(x+44, y);
+        glVertex2f(x+76, y);
+        glVertex2f(x+74, y+6);
+        glVertex2f(x+46, y+6);
     glEnd();
 
-    // ===================== WHEELS + arches =====================
-    glColor3f(0.25f, 0.25f, 0.25f);
-    drawEllipse(x+26, y+2, 16, 9, 24);
-    drawEllipse(x+78, y+2, 16, 9, 24);
-
-    glColor3f(0.06f, 0.06f, 0.06f);
-    drawCircle(x+26, y-8, 11, 24);
-    drawCircle(x+78, y-8, 11, 24);
-
-    glColor3f(0.75f, 0.75f, 0.75f);
-    drawCircle(x+26, y-8, 4.5f, 18);
-    drawCircle(x+78, y-8, 4.5f, 18);
-
-    // ===================== LIGHTS =====================
-    if (!isDay) {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-        // headlight
-        glColor4f(1.0f, 1.0f, 0.90f, 0.85f);
-        drawCircle(x+104, y+18, 4.5f, 18);
-        glColor4f(1.0f, 1.0f, 0.90f, 0.18f);
-        drawCircle(x+104, y+18, 12.0f, 28);
-
-        glDisable(GL_BLEND);
-    } else {
-        glColor3f(1.0f, 1.0f, 0.90f);
-        drawCircle(x+104, y+18, 3.8f, 18);
-    }
-
-    // tail light
-    glColor3f(0.95f, 0.20f, 0.20f);
-    drawCircle(x+4, y+18, 3.0f, 16);
-
-    // ===================== OUTLINE =====================
-    glColor3f(0.12f, 0.12f, 0.12f);
-    glLineWidth(2.0f);
+    // outline (makes it crisp)
+    matColor(MAT_HOUSE_OUTLINE);
+    glLineWidth(2);
     glBegin(GL_LINE_LOOP);
-        glVertex2f(x,      y);
-        glVertex2f(x+96,   y);
-        glVertex2f(x+104,  y+12);
-        glVertex2f(x+92,   y+35);
-        glVertex2f(x+62,   y+48);
-        glVertex2f(x+28,   y+48);
-        glVertex2f(x+10,   y+35);
-        glVertex2f(x+2,    y+18);
+        glVertex2f(x, y); glVertex2f(x+120, y);
+        glVertex2f(x+120, y+140); glVertex2f(x, y+140);
     glEnd();
 }
 
-// ======================= MORE REALISTIC BOAT (WITH REFLECTION) ==============
-
-void drawBoat(float x, float y) {
-    glPushMatrix();
-    glTranslatef(x, y, 0);
-
-    // ------------------- WATER SHADOW -------------------
-    drawShadowEllipse(55.0f, -10.0f, 55.0f, 8.5f, 0.28f);
-
-    // ------------------- HULL (curved + depth) -------------------
-    // top hull
-    glColor3f(0.42f, 0.22f, 0.10f);
-    glBegin(GL_POLYGON);
-        glVertex2f(  6,  4);
-        glVertex2f( 18,  0);
-        glVertex2f( 90,  0);
-        glVertex2f(106,  6);
-        glVertex2f( 96, 22);
-        glVertex2f( 20, 22);
-    glEnd();
-
-    // underside darker strip (depth)
-    glColor3f(0.28f, 0.14f, 0.06f);
-    glBegin(GL_POLYGON);
-        glVertex2f( 16,  0);
-        glVertex2f( 92,  0);
-        glVertex2f(102,  6);
-        glVertex2f( 96, 14);
-        glVertex2f( 22, 14);
-        glVertex2f( 18,  6);
-    glEnd();
 
-    // upper highlight strip (shine)
-    glColor3f(0.58f, 0.33f, 0.16f);
+void drawTraditionalHouse(float x, float y) {
+    // shadow
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(0,0,0,0.16f);
     glBegin(GL_QUADS);
-        glVertex2f(18, 18);
-        glVertex2f(94, 18);
-        glVertex2f(90, 22);
-        glVertex2f(22, 22);
+        glVertex2f(x+5, y-2); glVertex2f(x+110, y-2);
+        glVertex2f(x+110, y+128); glVertex2f(x+5, y+128);
     glEnd();
+    glDisable(GL_BLEND);
 
-    // ------------------- CABIN (better) -------------------
-    glColor3f(0.68f, 0.40f, 0.20f);
+    // body
+    matColor(MAT_TRAD_WALL);
     glBegin(GL_QUADS);
-        glVertex2f(34, 24);
-        glVertex2f(76, 24);
-        glVertex2f(76, 50);
-        glVertex2f(34, 50);
+        glVertex2f(x, y);
+        glVertex2f(x+105, y);
+        glVertex2f(x+105, y+120);
+        glVertex2f(x, y+120);
     glEnd();
 
-    // cabin shading strip (depth)
-    glColor3f(0.50f, 0.28f, 0.14f);
-    glBegin(GL_QUADS);
-        glVertex2f(70, 24);
-        glVertex2f(76, 24);
-        glVertex2f(76, 50);
-        glVertex2f(70, 50);
+    // roof with overhang
+    matColor(MAT_TRAD_ROOF);
+    glBegin(GL_POLYGON);
+        glVertex2f(x-12, y+120);
+        glVertex2f(x+117, y+120);
+        glVertex2f(x+52, y+160);
     glEnd();
 
-    // roof
-    glColor3f(0.93f, 0.93f, 0.93f);
+    // small chimney
+    matColor(MAT_CHIMNEY);
     glBegin(GL_QUADS);
-        glVertex2f(32, 50);
-        glVertex2f(78, 50);
-        glVertex2f(74, 58);
-        glVertex2f(36, 58);
+        glVertex2f(x+78, y+130);
+        glVertex2f(x+90, y+130);
+        glVertex2f(x+90, y+155);
+        glVertex2f(x+78, y+155);
     glEnd();
 
-    // windows (glass)
-    glColor3f(0.80f, 0.93f, 1.0f);
+    // windows (left/right)
+    matColor(MAT_TRAD_WINDOW);
     glBegin(GL_QUADS);
-        glVertex2f(38, 34); glVertex2f(52, 34);
-        glVertex2f(52, 46); glVertex2f(38, 46);
+        glVertex2f(x+16, y+70); glVertex2f(x+40, y+70);
+        glVertex2f(x+40, y+96); glVertex2f(x+16, y+96);
 
-        glVertex2f(54, 34); glVertex2f(72, 34);
-        glVertex2f(72, 46); glVertex2f(54, 46);
+        glVertex2f(x+65, y+70); glVertex2f(x+89, y+70);
+        glVertex2f(x+89, y+96); glVertex2f(x+65, y+96);
     glEnd();
+    if (!isDay) {   // lit at night: light pass
+        addLight(x+28, y+83, LIGHT_MEDIUM, 1.0f, 0.8f, 0.45f, 0.5f * (1.0f - dayNightBlend));
+        addLight(x+77, y+83, LIGHT_MEDIUM, 1.0f, 0.8f, 0.45f, 0.5f * (1.0f - dayNightBlend));
+    }
 
-    // window frames
-    glColor3f(0.15f, 0.15f, 0.15f);
-    glLineWidth(2.0f);
+    matColor(MAT_WINDOW_FRAME);
+    glLineWidth(2);
     glBegin(GL_LINE_LOOP);
-        glVertex2f(38, 34); glVertex2f(52, 34);
-        glVertex2f(52, 46); glVertex2f(38, 46);
+        glVertex2f(x+16, y+70); glVertex2f(x+40, y+70);
+        glVertex2f(x+40, y+96); glVertex2f(x+16, y+96);
     glEnd();
     glBegin(GL_LINE_LOOP);
-        glVertex2f(54, 34); glVertex2f(72, 34);
-        glVertex2f(72, 46); glVertex2f(54, 46);
-    glEnd();
-
-    // window split line
-    glBegin(GL_LINES);
-        glVertex2f(52, 34);
-        glVertex2f(52, 46);
+        glVertex2f(x+65, y+70); glVertex2f(x+89, y+70);
+        glVertex2f(x+89, y+96); glVertex2f(x+65, y+96);
     glEnd();
 
-    // ------------------- SMALL DETAILS -------------------
-    // railing line
-    glColor3f(0.85f, 0.85f, 0.85f);
-    glLineWidth(2.0f);
-    glBegin(GL_LINES);
-        glVertex2f(20, 24);
-        glVertex2f(96, 24);
+    // door (center)
+    matColor(MAT_TRAD_DOOR);
+    glBegin(GL_QUADS);
+        glVertex2f(x+44, y);
+        glVertex2f(x+61, y);
+        glVertex2f(x+61, y+55);
+        glVertex2f(x+44, y+55);
     glEnd();
 
-    // portholes on hull (3 circles)
-    glColor3f(0.18f, 0.18f, 0.18f);
-    drawCircle(34, 12, 3.0f, 18);
-    drawCircle(52, 12, 3.0f, 18);
-    drawCircle(70, 12, 3.0f, 18);
-
-    glColor3f(0.78f, 0.92f, 1.0f);
-    drawCircle(34, 12, 1.2f, 14);
-    drawCircle(52, 12, 1.2f, 14);
-    drawCircle(70, 12, 1.2f, 14);
+    // knob
+    matColor(MAT_DOOR_KNOB);
+    drawCircle(x+58, y+28, 2.0f);
 
-    // mast + flag (a bit more realistic)
-    glColor3f(0.20f, 0.20f, 0.22f);
-    glLineWidth(3.0f);
-    glBegin(GL_LINES);
-        glVertex2f(76, 58);
-        glVertex2f(76, 74);
+    // outline
+    matColor(MAT_HOUSE_OUTLINE);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(x, y); glVertex2f(x+105, y);
+        glVertex2f(x+105, y+120); glVertex2f(x, y+120);
     glEnd();
+}
 
-    glColor3f(0.95f, 0.20f, 0.20f);
-    glBegin(GL_TRIANGLES);
-        glVertex2f(76, 72);
-        glVertex2f(92, 66);
-        glVertex2f(76, 60);
-    glEnd();
 
-    // life ring (cute detail)
+void drawFarmHouse(float x, float y) {
+    // shadow
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(1.0f, 0.55f, 0.10f, 0.90f);
-    drawCircle(26, 18, 5.0f, 20);
-    glColor4f(0.85f, 0.95f, 1.0f, 0.85f);
-    drawCircle(26, 18, 2.5f, 20);
+    glColor4f(0,0,0,0.16f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+6, y-2); glVertex2f(x+146, y-2);
+        glVertex2f(x+146, y+122); glVertex2f(x+6, y+122);
+    glEnd();
     glDisable(GL_BLEND);
 
-    // ------------------- WATER WAKE (foam trail) -------------------
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    glColor4f(0.90f, 0.95f, 1.0f, 0.45f);
-    glLineWidth(2.5f);
-    glBegin(GL_LINE_STRIP);
-        for (int i = 0; i <= 6; i++) {
-            float t = i / 6.0f;
-            float wx = 6.0f - t * 35.0f;
-            float wy = 10.0f + std::sin(riverWave * 0.12f + t * 6.0f) * 2.0f;
-            glVertex2f(wx, wy);
-        }
+    // main body
+    matColor(MAT_FARM_WALL);
+    glBegin(GL_QUADS);
+        glVertex2f(x, y);
+        glVertex2f(x+140, y);
+        glVertex2f(x+140, y+110);
+        glVertex2f(x, y+110);
     glEnd();
 
-    glColor4f(0.90f, 0.95f, 1.0f, 0.25f);
-    drawEllipse(10.0f, 6.0f, 18.0f, 3.5f, 26);
-
-    glDisable(GL_BLEND);
-
-    // ------------------- OUTLINE (crisp) -------------------
-    glColor3f(0.12f, 0.12f, 0.12f);
-    glLineWidth(2.0f);
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(  6,  4);
-        glVertex2f( 18,  0);
-        glVertex2f( 90,  0);
-        glVertex2f(106,  6);
-        glVertex2f( 96, 22);
-        glVertex2f( 20, 22);
+    // roof
+    matColor(MAT_FARM_ROOF);
+    glBegin(GL_POLYGON);
+        glVertex2f(x-16, y+110);
+        glVertex2f(x+156, y+110);
+        glVertex2f(x+70, y+150);
     glEnd();
 
-    glPopMatrix();
-}
-
-// SIMPLE blue reflection shape under boat in river
-void drawBoatWaterReflection(float boatX, float boatY) {
-    float waterMid = 150.0f;
-    float refY     = waterMid - (boatY - waterMid);
-    float centerX  = boatX + 55.0f;
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // main reflection blob
-    glColor4f(0.0f, 0.10f, 0.25f, 0.28f);
-    drawEllipse(centerX, refY, 62.0f, 11.0f, 44);
-
-    // ripple layers (animated with riverWave)
-    float wob = std::sin(riverWave * 0.10f) * 3.0f;
-
-    glColor4f(0.0f, 0.12f, 0.28f, 0.18f);
-    drawEllipse(centerX + 6.0f, refY - 4.0f + wob, 48.0f, 8.0f, 40);
-
-    glColor4f(0.0f, 0.12f, 0.28f, 0.12f);
-    drawEllipse(centerX - 8.0f, refY - 10.0f - wob, 36.0f, 6.0f, 36);
-
-    glDisable(GL_BLEND);
-}
-
-
-// Boat wake + foam + ripple rings (synced with riverWave & boatPosition)
-void drawBoatWake(float boatX, float boatY) {
-    // river bounds (same as your drawRiver)
-    float topY    = 180.0f;
-    float bottomY = 120.0f;
-    float midY    = (topY + bottomY) * 0.5f;
-
-    // boat center
-    float cx = boatX + 55.0f;     // boat center X (your boat width ~110)
-    float cy = boatY + 6.0f;      // slightly above hull bottom
-
-    // phase: uses both riverWave and boatPosition
-    float t = riverWave * 0.10f + boatX * 0.01f;
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // ---------------- 1) Main white foam trail (behind boat) ----------------
-    // a few stretched ellipses behind the boat
-    for (int i = 0; i < 6; i++) {
-        float k  = (float)i;
-        float fx = cx - 18.0f - k * 22.0f;              // behind boat
-        float fy = midY + std::sin(t + k * 0.7f) * 2.0f;
+    // veranda (front shade)
+    matColor(MAT_FARM_VERANDA);
+    glBegin(GL_QUADS);
+        glVertex2f(x-8,  y);
+        glVertex2f(x+148,y);
+        glVertex2f(x+148,y+18);
+        glVertex2f(x-8,  y+18);
+    glEnd();
 
-        // fade out as it goes back
-        float a = 0.22f - k * 0.03f;
-        if (a < 0.03f) a = 0.03f;
+    // windows (3)
+    matColor(MAT_FARM_WINDOW);
+    for (int i=0;i<3;i++){
+        float wx = x + 18 + i*40;
+        if (!isDay)     // lit at night: light pass
+            addLight(wx + 13, y + 70, LIGHT_MEDIUM, 1.0f, 0.8f, 0.45f, 0.5f * (1.0f - dayNightBlend));
+        glBegin(GL_QUADS);
+            glVertex2f(wx, y+55);
+            glVertex2f(wx+26, y+55);
+            glVertex2f(wx+26, y+86);
+            glVertex2f(wx, y+86);
+        glEnd();
 
-        glColor4f(0.95f, 0.98f, 1.0f, a);
-        drawEllipse(fx, fy, 18.0f + k * 2.0f, 3.2f, 28);
+        matColor(MAT_WINDOW_FRAME);
+        glBegin(GL_LINE_LOOP);
+            glVertex2f(wx, y+55);
+            glVertex2f(wx+26, y+55);
+            glVertex2f(wx+26, y+86);
+            glVertex2f(wx, y+86);
+        glEnd();
+        matColor(MAT_FARM_WINDOW);
     }
 
-    // ---------------- 2) Side foam near hull edges ----------------
-    glColor4f(0.90f, 0.95f, 1.0f, 0.14f);
-    drawEllipse(cx - 8.0f, cy - 3.0f, 10.0f, 2.5f, 24);
-    drawEllipse(cx + 10.0f, cy - 3.0f, 10.0f, 2.5f, 24);
-
-    // ---------------- 3) Ripple rings (expanding circles) ----------------
-    // 3 rings that expand with time
-    for (int i = 0; i < 3; i++) {
-        float phase = std::fmod(riverWave * (1.4f + i * 0.35f), 22.0f);
-        float rr    = 8.0f + phase + i * 6.0f;
-
-        float rx = cx - 10.0f - i * 18.0f;  // slightly behind boat
-        float ry = midY + std::sin(t + i) * 2.0f;
-
-        float a = 0.10f - i * 0.02f;
-        if (a < 0.03f) a = 0.03f;
-
-        glColor4f(0.85f, 0.95f, 1.0f, a);
-        drawEllipse(rx, ry, rr, rr * 0.32f, 32);
-    }
+    // chimney
+    matColor(MAT_CHIMNEY);
+    glBegin(GL_QUADS);
+        glVertex2f(x+105, y+112);
+        glVertex2f(x+118, y+112);
+        glVertex2f(x+118, y+148);
+        glVertex2f(x+105, y+148);
+    glEnd();
 
-    glDisable(GL_BLEND);
+    // outline
+    matColor(MAT_HOUSE_OUTLINE);
+    glLineWidth(2);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(x, y); glVertex2f(x+140, y);
+        glVertex2f(x+140, y+110); glVertex2f(x, y+110);
+    glEnd();
 }
 
 
-void drawAirplane() {
-    float x = std::fmod(planePosition, WIDTH + 400.0f) - 200.0f;
-    float y = HEIGHT - 100.0f + 20.0f * std::sin(planePosition * 0.02f);
-
-    glColor3f(0.95f, 0.95f, 0.95f);
+void drawCottage(float x, float y) {
+    matColor(MAT_COTTAGE_WALL);
     glBegin(GL_QUADS);
     glVertex2f(x, y);
-    glVertex2f(x + 100, y);
-    glVertex2f(x + 100, y + 25);
-    glVertex2f(x, y + 25);
-    glEnd();
-
-    glBegin(GL_TRIANGLES);
-    glVertex2f(x + 100, y);
-    glVertex2f(x + 100, y + 25);
-    glVertex2f(x + 120, y + 12.5f);
+    glVertex2f(x + 80, y);
+    glVertex2f(x + 80, y + 70);
+    glVertex2f(x, y + 70);
     glEnd();
 
-    glBegin(GL_TRIANGLES);
-    glVertex2f(x, y + 25);
-    glVertex2f(x - 15, y + 40);
-    glVertex2f(x + 15, y + 25);
+    matColor(MAT_COTTAGE_ROOF);
+    glBegin(GL_POLYGON);
+    glVertex2f(x - 10, y + 70);
+    glVertex2f(x + 90, y + 70);
+    glVertex2f(x + 40, y + 100);
     glEnd();
 
+    matColor(MAT_COTTAGE_DOOR);
     glBegin(GL_QUADS);
-    glVertex2f(x + 30, y + 25);
-    glVertex2f(x + 70, y + 25);
-    glVertex2f(x + 65, y + 45);
-    glVertex2f(x + 35, y + 45);
-    glVertex2f(x + 10, y + 15);
-    glVertex2f(x + 30, y + 15);
-    glVertex2f(x + 30, y + 20);
-    glVertex2f(x + 10, y + 20);
+    glVertex2f(x + 30, y);
+    glVertex2f(x + 50, y);
+    glVertex2f(x + 50, y + 40);
+    glVertex2f(x + 30, y + 40);
     glEnd();
 
-    glColor3f(0.6f, 0.9f, 1.0f);
+    matColor(MAT_COTTAGE_WINDOW);
     glBegin(GL_QUADS);
-    for (int i = 0; i < 6; i++) {
-        float wx = x + 15 + i * 14;
-        glVertex2f(wx, y + 8);
-        glVertex2f(wx + 10, y + 8);
-        glVertex2f(wx + 10, y + 18);
-        glVertex2f(wx, y + 18);
-    }
+    glVertex2f(x + 15, y + 40);
+    glVertex2f(x + 35, y + 40);
+    glVertex2f(x + 35, y + 60);
+    glVertex2f(x + 15, y + 60);
     glEnd();
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(1.0f, 1.0f, 1.0f, 0.6f);
-    for (int i = 0; i < 3; i++) {
-        float trailX    = x - 20 - i * 25;
-        float trailSize = 15.0f - i * 4.0f;
-        drawCircle(trailX, y + 12.5f, trailSize);
-    }
-    glDisable(GL_BLEND);
 }
 
-void drawFish() {
-    auto drawOneFish = [&](float baseX, float baseY, float scale, bool faceRight,
-                           float phase, float r, float g, float b) {
-        float swim = std::sin(fishPosition * 0.08f + phase) * 3.0f;
-        float sway = std::sin(fishPosition * 0.25f + phase) * 2.2f;
+// ============================================================================
+// VEGETATION
+// ============================================================================
 
-        glPushMatrix();
-        glTranslatef(baseX, baseY + swim, 0.0f);
-        glScalef((faceRight ? 1.0f : -1.0f) * scale, scale, 1.0f);
-        glTranslatef(0.0f, sway * 0.12f, 0.0f);
+// The full tree geometry (no ground shadow). Used to bake the sprite atlas
+// with wind = 0, and directly until the atlas exists.
+void drawTreeShape(float x, float y, int type, float wind) {
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // small wind sway (subtle movement)
+    float sway = std::sin(riverWave * 0.03f + x * 0.01f) * 4.0f * wind;
 
-        glColor4f(r, g, b, 0.85f);
-        drawEllipse(0.0f, 0.0f, 18.0f, 8.0f, 32);
+    // ---- helper: taper trunk + bark + depth strip ----
+    auto trunkTaper = [&](float baseW, float topW, float h) {
+        // main trunk
+        matColor(MAT_BARK);
+        glBegin(GL_POLYGON);
+            glVertex2f(x - baseW, y);
+            glVertex2f(x + baseW, y);
+            glVertex2f(x + topW,  y + h);
+            glVertex2f(x - topW,  y + h);
+        glEnd();
 
-        glColor4f(1.0f, 1.0f, 1.0f, 0.18f);
-        drawEllipse(4.0f, 2.0f, 10.0f, 3.0f, 24);
+        // right shadow strip (depth)
+        matColor(MAT_BARK_SHADOW);
+        glBegin(GL_QUADS);
+            glVertex2f(x + baseW * 0.25f, y + 2);
+            glVertex2f(x + baseW,        y + 2);
+            glVertex2f(x + topW,         y + h - 2);
+            glVertex2f(x + topW * 0.25f, y + h - 2);
+        glEnd();
 
-        float tailWag = std::sin(fishPosition * 0.35f + phase) * 3.5f;
-        glColor4f(r * 0.95f, g * 0.85f, b * 0.85f, 0.90f);
-        glBegin(GL_TRIANGLES);
-            glVertex2f(-18.0f, 0.0f);
-            glVertex2f(-30.0f, 7.0f + tailWag);
-            glVertex2f(-30.0f, -7.0f - tailWag);
+        // bark lines
+        matColor(MAT_BARK_LINE);
+        glLineWidth(1.0f);
+        glBegin(GL_LINES);
+        for (int i = 0; i < 6; i++) {
+            float xx = x - baseW * 0.6f + i * (baseW * 0.25f);
+            glVertex2f(xx, y + 6);
+            glVertex2f(xx + 2, y + h - 10);
+        }
         glEnd();
+    };
 
-        glColor4f(1.0f, 1.0f, 1.0f, 0.95f);
-        drawCircle(12.0f, 3.0f, 2.0f, 16);
-        glColor4f(0.0f, 0.0f, 0.0f, 0.95f);
-        drawCircle(12.5f, 3.0f, 1.0f, 12);
+    // ---- helper: leaf cluster with shading + highlight ----
+    auto leafCluster = [&](float cx, float cy, float r, int darkMat, int lightMat) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // dark bottom mass
+        matColor(darkMat);
+        drawCircle(cx, cy - r * 0.25f, r, 26);
+        drawCircle(cx - r * 0.75f, cy - r * 0.15f, r * 0.85f, 24);
+        drawCircle(cx + r * 0.75f, cy - r * 0.15f, r * 0.85f, 24);
+
+        // lighter top mass
+        matColor(lightMat);
+        drawCircle(cx, cy + r * 0.25f, r * 0.92f, 26);
+        drawCircle(cx - r * 0.65f, cy + r * 0.15f, r * 0.75f, 24);
+        drawCircle(cx + r * 0.65f, cy + r * 0.15f, r * 0.75f, 24);
 
-        float bubbleUp = std::fmod(riverWave * 0.8f + phase * 30.0f, 30.0f);
-        glColor4f(0.85f, 0.95f, 1.0f, 0.35f);
-        drawCircle(22.0f, 3.0f + bubbleUp, 2.8f, 16);
-        drawCircle(30.0f, 8.0f + bubbleUp * 0.7f, 2.0f, 14);
-        drawCircle(38.0f, 12.0f + bubbleUp * 0.5f, 1.5f, 12);
+        // highlight (volume)
+        glColor4f(1.0f, 1.0f, 1.0f, 0.10f);
+        drawEllipse(cx + r * 0.25f, cy + r * 0.45f, r * 0.55f, r * 0.25f, 24);
 
         glDisable(GL_BLEND);
-        glPopMatrix();
     };
 
-    float x0 = std::fmod(fishPosition, WIDTH + 250.0f) - 125.0f;
-    drawOneFish(x0 + 120, 150.0f, 1.00f, true,  0.2f, 1.0f, 0.55f, 0.10f);
-    drawOneFish(x0 + 40,  142.0f, 0.75f, true,  1.1f, 0.30f, 0.80f, 0.95f);
-    drawOneFish(x0 - 30,  160.0f, 0.65f, true, 2.0f, 0.90f, 0.35f, 0.25f);
-    drawOneFish(x0 - 110, 136.0f, 0.55f, true,  2.8f, 0.35f, 0.90f, 0.40f);
-}
+    int t = type % 4;
 
-// ============================================================================
-// ANIMATED OBJECTS
-// ============================================================================
+    // ==========================================================
+    // 0) PINE (layered triangles + slight gradient)
+    // ==========================================================
+    if (t == 0) {
+        trunkTaper(7, 4, 55);
 
-void drawMovingTrain() {
-    float trainX = trainPosition;
-    if (trainX > -400 && trainX < WIDTH + 400) {
-        drawTrain(trainX, 365);
-    }
-}
+        float baseY = y + 35;
+        for (int i = 0; i < 4; i++) {
+            float layerH = 30.0f - i * 3.0f;
+            float w      = 48.0f - i * 10.0f;
 
-void drawMovingBus() {
-    float busX = std::fmod(busPosition, WIDTH + 500.0f) - 200.0f;
-    drawBus(busX, 240);
-}
+            glBegin(GL_TRIANGLES);
+                matColor(MAT_PINE_TIP + i);
+                glVertex2f(x, baseY + i * 18 + layerH);
 
-void drawMovingCar() {
-    float carX = std::fmod(carPosition, WIDTH + 300.0f) - 150.0f;
-    drawCar(carX, 240);
-}
+                matColor(MAT_PINE_LEFT + i);
+                glVertex2f(x - w, baseY + i * 18);
+
+                matColor(MAT_PINE_RIGHT + i);
+                glVertex2f(x + w, baseY + i * 18);
+            glEnd();
+        }
+
+        // tiny top highlight
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glColor4f(1, 1, 1, 0.08f);
+        drawEllipse(x + 10, y + 95, 12, 5, 18);
+        glDisable(GL_BLEND);
+    }
+
+    // ==========================================================
+    // 1) DECIDUOUS (round realistic tree)
+    // ==========================================================
+    else if (t == 1) {
+        trunkTaper(9, 5, 65);
+
+        leafCluster(x + sway * 0.2f, y + 88 + sway, 36.0f, MAT_LEAF_DARK, MAT_LEAF_LIGHT);
+        leafCluster(x - 26 + sway * 0.15f, y + 72 + sway * 0.6f, 28.0f, MAT_LEAF_DARK_SIDE, MAT_LEAF_LIGHT_SIDE);
+        leafCluster(x + 26 + sway * 0.15f, y + 72 + sway * 0.6f, 28.0f, MAT_LEAF_DARK_SIDE, MAT_LEAF_LIGHT_SIDE);
+
+        // branches
+        matColor(MAT_BRANCH);
+        glLineWidth(2.0f);
+        glBegin(GL_LINES);
+            glVertex2f(x, y + 45); glVertex2f(x - 18, y + 62);
+            glVertex2f(x, y + 50); glVertex2f(x + 18, y + 65);
+        glEnd();
+    }
+
+    // ==========================================================
+    // 2) PALM (FIXED: filled leaves, no spiky line-star)
+    // ==========================================================
+    else if (t == 2) {
+        // trunk segments (tapered)
+        float h = 110.0f;
+        float baseW = 10.0f;
+
+        for (int i = 0; i < 10; i++) {
+            float yy1 = y + i * (h / 10.0f);
+            float yy2 = yy1 + (h / 10.0f);
+
+            float w1 = baseW - i * 0.45f;
+            float w2 = baseW - (i + 1) * 0.45f;
+
+            matColor((i % 2 == 0) ? MAT_PALM_BARK : MAT_PALM_BARK_ALT);
+
+            glBegin(GL_QUADS);
+                glVertex2f(x - w1, yy1);
+                glVertex2f(x + w1, yy1);
+                glVertex2f(x + w2, yy2);
+                glVertex2f(x - w2, yy2);
+            glEnd();
+        }
+
+        // depth strip
+        matColor(MAT_PALM_SHADOW);
+        glBegin(GL_QUADS);
+            glVertex2f(x + 2.0f, y + 5);
+            glVertex2f(x + 8.0f, y + 5);
+            glVertex2f(x + 3.0f, y + h);
+            glVertex2f(x - 1.0f, y + h);
+        glEnd();
+
+        float topX = x;
+        float topY = y + h;
+
+        // coconuts
+        matColor(MAT_COCONUT);
+        drawCircle(topX - 7, topY - 10, 5, 16);
+        drawCircle(topX + 2, topY - 12, 5, 16);
+        drawCircle(topX + 9, topY - 9,  4, 16);
+
+        float palmSway = std::sin(riverWave * 0.03f + x * 0.01f) * 6.0f * wind;
+
+        // one filled palm leaf (2 triangles) + highlight + midrib
+        auto palmLeaf = [&](float angDeg, float len, float w) {
+            float a = (angDeg + palmSway) * (3.1415926f / 180.0f);
+            float cx = std::cos(a), syy = std::sin(a);
+
+            float ex = topX + cx * len;
+            float ey = topY + syy * (len * 0.55f);
+
+            float px = -syy, py = cx; // perpendicular
+
+            float bW = w;
+            float tW = w * 0.15f;
+
+            // dark leaf body
+            matColor(MAT_PALM_LEAF);
+            glBegin(GL_TRIANGLES);
+                glVertex2f(topX, topY);
+                glVertex2f(topX + px*bW, topY + py*bW);
+                glVertex2f(ex + px*tW,   ey + py*tW);
+
+                glVertex2f(topX, topY);
+                glVertex2f(ex - px*tW,   ey - py*tW);
+                glVertex2f(topX - px*bW, topY - py*bW);
+            glEnd();
+
+            // light highlight
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            matColor(MAT_PALM_LEAF_SHINE);
+            glBegin(GL_TRIANGLES);
+                glVertex2f(topX, topY);
+                glVertex2f(topX + px*(bW*0.45f), topY + py*(bW*0.45f));
+                glVertex2f(ex + px*(tW*0.6f),    ey + py*(tW*0.6f));
+            glEnd();
+            glDisable(GL_BLEND);
+
+            // midrib
+            matColor(MAT_PALM_RIB);
+            glLineWidth(2.0f);
+            glBegin(GL_LINES);
+                glVertex2f(topX, topY);
+                glVertex2f(ex, ey);
+            glEnd();
+        };
+
+        // leaves
+        palmLeaf( 20, 78, 12);
+        palmLeaf( 55, 70, 11);
+        palmLeaf( 95, 62, 10);
+        palmLeaf(140, 70, 11);
+        palmLeaf(170, 78, 12);
+        palmLeaf(-20, 78, 12);
+        palmLeaf(-55, 70, 11);
+        palmLeaf(-95, 62, 10);
+    }
+
+    // ==========================================================
+    // 3) FRUIT TREE (canopy + fruits + highlight)
+    // ==========================================================
+    else {
+        trunkTaper(10, 6, 70);
+
+        leafCluster(x + sway * 0.2f, y + 95 + sway * 0.9f, 34.0f, MAT_LEAF_DARK, MAT_LEAF_LIGHT_FRUIT);
+        leafCluster(x - 22 + sway * 0.15f, y + 78 + sway * 0.6f, 26.0f, MAT_LEAF_DARK_FRUIT, MAT_LEAF_LIGHT);
+        leafCluster(x + 22 + sway * 0.15f, y + 78 + sway * 0.6f, 26.0f, MAT_LEAF_DARK_FRUIT, MAT_LEAF_LIGHT);
+
+        // fruits
+        matColor(MAT_FRUIT);
+        drawCircle(x - 10, y + 88, 4, 16);
+        drawCircle(x +  6, y + 84, 4, 16);
+        drawCircle(x + 14, y + 96, 4, 16);
+
+        // fruit highlights
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glColor4f(1, 1, 1, 0.18f);
+        drawCircle(x - 11, y + 90, 1.2f, 10);
+        drawCircle(x +  5, y + 86, 1.2f, 10);
+        glDisable(GL_BLEND);
+    }
+}
+
+// ============================================================================
+// TREE SPRITES (texture atlas + forest batch)
+// Each tree type is rendered once into a 192x192 atlas cell on the first
+// frame (on black and on white, which gives coverage; the black pass is
+// the premultiplied color). The bake uses full-light materials: every tree
+// color is base * TOD_SUNLIGHT, so modulating the sprite by the current
+// sunlight gives every time of day without brightness buckets.
+// Wind sway becomes a shear of the quad around the trunk base.
+// ============================================================================
+
+const int TREE_CELL    = 192;     // atlas cell (pixels = scene units at scale 1)
+const int TREE_BASE_Y  = 16;      // trunk base height inside the cell
+const int TREE_TYPES   = 4;
+const int TREE_ATLAS_W = 1024;    // power of two for old GL
+const int TREE_ATLAS_H = 256;
+const float TREE_CROWN = 90.0f;   // height where the shear equals the sway
+
+GLuint treeAtlas      = 0;
+bool   treeAtlasReady = false;
+
+struct TreeSprite {
+    float x, y;       // trunk base
+    float scale;
+    int   type;
+};
+
+std::vector<TreeSprite> forest;   // --forest N, on the hills
+int forestCount = 0;
+
+void bakeTreeAtlas() {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    // full light while baking; the sprite is tinted when drawn
+    static TodColor fullLight[TOD_COUNT];
+    for (int m = 0; m < TOD_COUNT; m++) fullLight[m].r = fullLight[m].g = fullLight[m].b = 1.0f;
+    const TodColor* row = todNow;
+    todNow = fullLight;
+    resolveMaterials();
+
+    glViewport(0, 0, TREE_CELL, TREE_CELL);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluOrtho2D(-TREE_CELL / 2, TREE_CELL / 2, -TREE_BASE_Y, TREE_CELL - TREE_BASE_Y);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    std::vector<unsigned char> onBlack(TREE_CELL * TREE_CELL * 4);
+    std::vector<unsigned char> onWhite(TREE_CELL * TREE_CELL * 4);
+    std::vector<unsigned char> atlas(TREE_ATLAS_W * TREE_ATLAS_H * 4, 0);
+
+    for (int type = 0; type < TREE_TYPES; type++) {
+        for (int pass = 0; pass < 2; pass++) {
+            glClearColor((float)pass, (float)pass, (float)pass, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            drawTreeShape(0.0f, 0.0f, type, 0.0f);
+            glReadPixels(0, 0, TREE_CELL, TREE_CELL, GL_RGBA, GL_UNSIGNED_BYTE,
+                         pass == 0 ? onBlack.data() : onWhite.data());
+        }
+
+        for (int py = 0; py < TREE_CELL; py++) {
+            for (int px = 0; px < TREE_CELL; px++) {
+                const unsigned char* b = &onBlack[(py * TREE_CELL + px) * 4];
+                const unsigned char* w = &onWhite[(py * TREE_CELL + px) * 4];
+                int seen  = (w[0] - b[0]) + (w[1] - b[1]) + (w[2] - b[2]);
+                int alpha = 255 - seen / 3;
+                if (alpha < 0)   alpha = 0;
+                if (alpha > 255) alpha = 255;
+
+                unsigned char* out = &atlas[(py * TREE_ATLAS_W + type * TREE_CELL + px) * 4];
+                for (int c = 0; c < 3; c++) out[c] = (unsigned char)std::min<int>(b[c], alpha);
+                out[3] = (unsigned char)alpha;
+            }
+        }
+    }
+
+    glGenTextures(1, &treeAtlas);
+    glBindTexture(GL_TEXTURE_2D, treeAtlas);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TREE_ATLAS_W, TREE_ATLAS_H, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, atlas.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    todNow = row;
+    resolveMaterials();
+    glClearColor(0.1f, 0.15f, 0.25f, 1.0f);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    treeAtlasReady = true;
+}
+
+static void beginTreeSprites() {
+    const TodColor& light = todNow[TOD_SUNLIGHT];
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, treeAtlas);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);     // atlas is premultiplied
+    glColor4f(light.r, light.g, light.b, 1.0f);
+    glBegin(GL_QUADS);
+}
+
+static void endTreeSprites() {
+    glEnd();
+    glDisable(GL_BLEND);
+    glDisable(GL_TEXTURE_2D);
+}
+
+// one sheared quad; call between beginTreeSprites / endTreeSprites
+static void emitTreeSprite(const TreeSprite& t, float sway) {
+    float u0 = (float)(t.type * TREE_CELL) / TREE_ATLAS_W;
+    float u1 = (float)((t.type + 1) * TREE_CELL) / TREE_ATLAS_W;
+    float v1 = (float)TREE_CELL / TREE_ATLAS_H;
+
+    float half   = TREE_CELL * 0.5f * t.scale;
+    float bottom = t.y - TREE_BASE_Y * t.scale;
+    float top    = bottom + TREE_CELL * t.scale;
+    float shear  = sway / TREE_CROWN;                 // around the trunk base
+    float xBot   = -shear * TREE_BASE_Y * t.scale;
+    float xTop   =  shear * (TREE_CELL - TREE_BASE_Y) * t.scale;
+
+    glTexCoord2f(u0, 0.0f); glVertex2f(t.x - half + xBot, bottom);
+    glTexCoord2f(u1, 0.0f); glVertex2f(t.x + half + xBot, bottom);
+    glTexCoord2f(u1, v1);   glVertex2f(t.x + half + xTop, top);
+    glTexCoord2f(u0, v1);   glVertex2f(t.x - half + xTop, top);
+}
+
+static float treeSway(float x) {
+    return std::sin(riverWave * 0.03f + x * 0.01f) * 4.0f * windIntensity;
+}
+
+void drawTree(float x, float y, int type) {
+    // ground shadow (helps realism a lot); palms get a wider one
+    if (type % TREE_TYPES == 2) addShadow(x, y - 6, 50, 12, 0.22f);
+    else                        addShadow(x, y - 6, 40, 11, 0.22f);
+
+    if (!treeAtlasReady) {
+        drawTreeShape(x, y, type, windIntensity);
+        return;
+    }
+
+    TreeSprite t = { x, y, 1.0f, type % TREE_TYPES };
+    beginTreeSprites();
+    emitTreeSprite(t, treeSway(x));
+    endTreeSprites();
+}
+
+// far-away trees on the hills: scattered once, back to front
+void initForest(int count) {
+    forest.clear();
+    uint32_t seed = 12345u;
+    auto rnd = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) * (1.0f / 16777216.0f);
+    };
+    for (int i = 0; i < count; i++) {
+        TreeSprite t;
+        float depth = rnd();                       // 0 = near, 1 = far
+        t.x     = rnd() * WIDTH;
+        t.y     = 384.0f + depth * 50.0f;
+        t.scale = 0.34f - depth * 0.22f;
+        t.type  = (int)(rnd() * TREE_TYPES) % TREE_TYPES;
+        forest.push_back(t);
+    }
+    std::sort(forest.begin(), forest.end(),
+              [](const TreeSprite& a, const TreeSprite& b) { return a.y > b.y; });
+}
+
+void drawForest() {
+    if (forest.empty() || !treeAtlasReady) return;
+
+    beginTreeSprites();
+    for (int i : forestShown)
+        emitTreeSprite(forest[i], treeSway(forest[i].x) * forest[i].scale);
+    endTreeSprites();
+}
+
+
+void drawBush(float x, float y, float size) {
+    glColor3f(0.1f, 0.4f, 0.1f);
+    drawCircle(x, y, size);
+    drawCircle(x + size * 0.8f, y, size * 0.7f);
+    drawCircle(x - size * 0.8f, y, size * 0.7f);
+    drawCircle(x, y + size * 0.7f, size * 0.6f);
+}
+
+// ============================================================================
+// VEHICLES
+// ============================================================================
+
+// ======================= REPLACE THIS FUNCTION =======================
+// Cleaner engine "first bogie": grill looks nicer + less weird when covered
+// ============================================================================
+// TRAIN COACH MESH
+// One coach (body, roof, windows, door, coupler, wheels,
+// outline) is built once at the origin into a client-side vertex array.
+// drawTrain() then only translates + draws it for the coaches that are on
+// screen, so a 1000-coach freight train costs what the visible ~15 cost.
+// Six variants cover the i % 3 / i % 2 body tints. With GLSL 3.30 the
+// visible coaches are one glDrawArraysInstanced over a triangle template.
+// ============================================================================
+
+const int   MAX_TRAIN_COACHES = 1000;
+const float COACH_PITCH       = 100.0f;   // coach + coupler
+const float COACH_FIRST_X     = 170.0f;   // first coach, from the engine's x
+const int   COACH_VARIANTS    = 6;
+
+// the train is gone (and wraps) once its last coach is off the left edge
+float trainWrapX(int coaches) {
+    return -(300.0f + COACH_PITCH * coaches);
+}
+
+struct MeshPart {
+    GLenum mode;
+    int    first, count;
+    float  lineWidth;
+    bool   blend;
+};
+
+struct ColorMesh {
+    std::vector<float>    xy;
+    std::vector<GLubyte>  rgba;
+    std::vector<MeshPart> parts;
+    GLubyte cur[4];
+
+    void begin(GLenum mode, float lineWidth = 1.0f, bool blend = false) {
+        MeshPart p = { mode, (int)(xy.size() / 2), 0, lineWidth, blend };
+        parts.push_back(p);
+    }
+    void color(float r, float g, float b, float a = 1.0f) {
+        cur[0] = (GLubyte)(r * 255.0f + 0.5f);
+        cur[1] = (GLubyte)(g * 255.0f + 0.5f);
+        cur[2] = (GLubyte)(b * 255.0f + 0.5f);
+        cur[3] = (GLubyte)(a * 255.0f + 0.5f);
+    }
+    void vertex(float x, float y) {
+        xy.push_back(x);
+        xy.push_back(y);
+        rgba.insert(rgba.end(), cur, cur + 4);
+        parts.back().count++;
+    }
+    // (inside a GL_TRIANGLES part)
+    void quad(float ax, float ay, float bx, float by,
+              float cx, float cy, float dx, float dy) {
+        vertex(ax, ay); vertex(bx, by); vertex(cx, cy);
+        vertex(ax, ay); vertex(cx, cy); vertex(dx, dy);
+    }
+    void rect(float x0, float y0, float x1, float y1) {
+        quad(x0, y0, x1, y0, x1, y1, x0, y1);
+    }
+    void ellipse(float cx, float cy, float rx, float ry, int segments) {
+        for (int i = 0; i < segments; i++) {
+            float a0 = 2.0f * 3.1415926f * i / segments;
+            float a1 = 2.0f * 3.1415926f * (i + 1) / segments;
+            vertex(cx, cy);
+            vertex(cx + rx * std::cos(a0), cy + ry * std::sin(a0));
+            vertex(cx + rx * std::cos(a1), cy + ry * std::sin(a1));
+        }
+    }
+    // (inside a GL_LINES part)
+    void box(float x0, float y0, float x1, float y1) {
+        vertex(x0, y0); vertex(x1, y0);  vertex(x1, y0); vertex(x1, y1);
+        vertex(x1, y1); vertex(x0, y1);  vertex(x0, y1); vertex(x0, y0);
+    }
+};
+
+ColorMesh coachMesh[COACH_VARIANTS];
+
+// coach with its left end at (0, 0); same shapes as the old per-coach code
+static void buildCoachMesh(ColorMesh& m, int variant) {
+    m.begin(GL_TRIANGLES);
+    m.color(0.10f + 0.02f * (variant % 3), 0.35f + 0.03f * (variant % 2), 0.65f + 0.02f * (variant % 3));
+    m.rect(0, 0, 90, 40);                             // body (first quad: the GLSL template tints it)
+    m.color(0.30f, 0.30f, 0.30f);
+    m.quad(6, 40, 84, 40, 78, 52, 12, 52);            // roof
+    m.color(0.85f, 0.95f, 1.0f);
+    for (int w = 0; w < 3; w++) m.rect(12 + w * 25.0f, 18, 30 + w * 25.0f, 34);
+    m.color(0.20f, 0.20f, 0.22f);
+    m.rect(72, 8, 86, 36);                            // door
+
+    m.begin(GL_LINES, 2.0f);                          // window frames
+    m.color(0.15f, 0.15f, 0.15f);
+    for (int w = 0; w < 3; w++) m.box(12 + w * 25.0f, 18, 30 + w * 25.0f, 34);
+
+    m.begin(GL_LINES, 4.0f);                          // coupler to the next coach
+    m.vertex(90, 10); m.vertex(100, 10);
+
+    m.begin(GL_TRIANGLES);                            // wheel pair
+    for (int k = 0; k < 2; k++) {
+        float wx = 38.0f + k * 34.0f;
+        m.color(0.08f, 0.08f, 0.08f);
+        m.ellipse(wx, -8, 8, 8, 20);
+        m.color(0.75f, 0.75f, 0.75f);
+        m.ellipse(wx, -8, 3, 3, 16);
+    }
+
+    m.begin(GL_LINES, 2.0f);                          // outline
+    m.color(0.12f, 0.12f, 0.12f);
+    m.box(0, 0, 90, 40);
+}
+
+void buildCoachMeshes() {
+    for (int v = 0; v < COACH_VARIANTS; v++) {
+        coachMesh[v] = ColorMesh();
+        buildCoachMesh(coachMesh[v], v);
+    }
+}
+
+static void drawColorMesh(const ColorMesh& m) {
+    glVertexPointer(2, GL_FLOAT, 0, m.xy.data());
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, m.rgba.data());
+    for (const MeshPart& p : m.parts) {
+        if (p.blend) {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        if (p.mode == GL_LINES) glLineWidth(p.lineWidth);
+        glDrawArrays(p.mode, p.first, p.count);
+        if (p.blend) glDisable(GL_BLEND);
+    }
+}
+
+// GLSL path: coachMesh[0] as one triangle template (its lines become quads
+// of their width) + the visible coaches as per-instance attributes
+struct CoachVertex {
+    float   x, y;
+    GLubyte rgba[4];
+    float   body;          // 1 on the body quad, which takes the variant tint
+};
+
+struct CoachInstance {
+    float   x, y;          // left end
+    GLubyte tint[4];       // body colour of coachMesh[i % COACH_VARIANTS]
+};
+
+std::vector<CoachVertex> coachTemplate;
+ShaderProgram coachProgram;
+GLuint coachVao = 0, coachTemplateVbo = 0, coachInstanceVbo = 0;
+bool   coachShaderReady = false;
+
+static void buildCoachTemplate() {
+    if (coachMesh[0].xy.empty()) buildCoachMeshes();
+    const ColorMesh& m = coachMesh[0];
+    coachTemplate.clear();
+    auto add = [&](float x, float y, int colorOf) {
+        CoachVertex v = {x, y, {0, 0, 0, 0}, colorOf < 6 ? 1.0f : 0.0f};   // body = first quad
+        std::memcpy(v.rgba, &m.rgba[colorOf * 4], 4);
+        coachTemplate.push_back(v);
+    };
+    for (const MeshPart& p : m.parts) {
+        if (p.mode != GL_LINES) {
+            for (int v = p.first; v < p.first + p.count; v++) add(m.xy[v * 2], m.xy[v * 2 + 1], v);
+            continue;
+        }
+        for (int v = p.first; v + 1 < p.first + p.count; v += 2) {
+            float ax = m.xy[v * 2], ay = m.xy[v * 2 + 1];
+            float bx = m.xy[v * 2 + 2], by = m.xy[v * 2 + 3];
+            float dx = bx - ax, dy = by - ay;
+            float len = std::sqrt(dx * dx + dy * dy);
+            if (len < 1e-4f) continue;
+            float nx = -dy / len * 0.5f * p.lineWidth, ny = dx / len * 0.5f * p.lineWidth;
+            add(ax - nx, ay - ny, v); add(bx - nx, by - ny, v); add(bx + nx, by + ny, v);
+            add(ax - nx, ay - ny, v); add(bx + nx, by + ny, v); add(ax + nx, ay + ny, v);
+        }
+    }
+}
+
+static const char* COACH_VS =
+    "layout(location = 0) in vec2 aPos;\n"
+    "layout(location = 1) in vec4 aColor;\n"
+    "layout(location = 2) in float aBody;\n"
+    "layout(location = 3) in vec2 aCoach;\n"    // per instance: left end
+    "layout(location = 4) in vec4 aTint;\n"     // per instance: body colour
+    "out vec4 vColor;\n"
+    "void main() {\n"
+    "    vColor = aBody > 0.5 ? aTint : aColor;\n"
+    "    gl_Position = sceneToClip(aCoach + aPos);\n"
+    "}\n";
+
+static const char* COACH_FS =
+    "in vec4 vColor;\n"
+    "out vec4 fragColor;\n"
+    "void main() { fragColor = vColor; }\n";
+
+// from initShaders(), with the GL 3.3 entry points loaded
+void initCoachShader() {
+    if (!linkProgram(coachProgram, COACH_VS, COACH_FS)) return;
+    if (coachTemplate.empty()) buildCoachTemplate();
+
+    gl3.GenVertexArrays(1, &coachVao);
+    gl3.GenBuffers(1, &coachTemplateVbo);
+    gl3.GenBuffers(1, &coachInstanceVbo);
+    gl3.BindVertexArray(coachVao);
+
+    gl3.BindBuffer(GL_ARRAY_BUFFER, coachTemplateVbo);
+    gl3.BufferData(GL_ARRAY_BUFFER, coachTemplate.size() * sizeof(CoachVertex), coachTemplate.data(), GL_STATIC_DRAW);
+    gl3.EnableVertexAttribArray(0);
+    gl3.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(CoachVertex), (const void*)offsetof(CoachVertex, x));
+    gl3.EnableVertexAttribArray(1);
+    gl3.VertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CoachVertex), (const void*)offsetof(CoachVertex, rgba));
+    gl3.EnableVertexAttribArray(2);
+    gl3.VertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(CoachVertex), (const void*)offsetof(CoachVertex, body));
+
+    gl3.BindBuffer(GL_ARRAY_BUFFER, coachInstanceVbo);
+    gl3.EnableVertexAttribArray(3);
+    gl3.VertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(CoachInstance), (const void*)offsetof(CoachInstance, x));
+    gl3.EnableVertexAttribArray(4);
+    gl3.VertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CoachInstance), (const void*)offsetof(CoachInstance, tint));
+    for (int a = 3; a <= 4; a++) gl3.VertexAttribDivisor(a, 1);
+
+    gl3.BindVertexArray(0);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, 0);
+    coachShaderReady = true;
+}
+
+// coaches [first, last] of a train whose engine is at x
+static void drawCoaches(float x, float y, int first, int last) {
+    for (int i = first; i <= last; i++)
+        addShadow(x + COACH_FIRST_X + i * COACH_PITCH + 45.0f, y - 14.0f, 55.0f, 10.0f, 0.18f);
+
+    if (shaderPathActive() && coachShaderReady) {
+        static std::vector<CoachInstance> shown;
+        shown.clear();
+        for (int i = first; i <= last; i++) {
+            const GLubyte* tint = coachMesh[i % COACH_VARIANTS].rgba.data();   // body colour
+            CoachInstance c = {x + COACH_FIRST_X + i * COACH_PITCH, y, {tint[0], tint[1], tint[2], tint[3]}};
+            shown.push_back(c);
+        }
+        gl3.BindBuffer(GL_ARRAY_BUFFER, coachInstanceVbo);
+        gl3.BufferData(GL_ARRAY_BUFFER, shown.size() * sizeof(CoachInstance), shown.data(), GL_STREAM_DRAW);
+        gl3.BindBuffer(GL_ARRAY_BUFFER, 0);
+        useSceneProgram(coachProgram);
+        gl3.BindVertexArray(coachVao);
+        gl3.DrawArraysInstanced(GL_TRIANGLES, 0, (GLsizei)coachTemplate.size(), (GLsizei)shown.size());
+        endSceneProgram();
+        return;
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    for (int i = first; i <= last; i++) {
+        glPushMatrix();
+        glTranslatef(x + COACH_FIRST_X + i * COACH_PITCH, y, 0.0f);
+        drawColorMesh(coachMesh[i % COACH_VARIANTS]);
+        glPopMatrix();
+    }
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void drawTrain(float x, float y) {
+    // only the coaches and engine on view (see cullScene())
+    if (coachFirst <= coachLast) drawCoaches(x, y, coachFirst, coachLast);
+    if (!cullShown[CO_ENGINE]) return;
+
+    // ============================================================
+    // 1) SOFT GROUND SHADOWS (NO BIG RECTANGLE SHADOW)
+    //    (This fixes the weird big "shape" shadow)
+    // ============================================================
+    // Engine ground shadow
+    addShadow(x + 75,  y - 14, 78, 12, 0.22f);
+
+    // Extra small shadow near engine back bogie (connector side)
+    // (This is the one you asked: "engine bogie back side shadow")
+    addShadow(x + 138, y - 13, 26, 9,  0.18f);
+
+    // -------------------- ENGINE (front) --------------------
+
+    // Main engine body
+    glColor3f(0.70f, 0.10f, 0.12f);
+    glBegin(GL_QUADS);
+        glVertex2f(x,     y);
+        glVertex2f(x+120, y);
+        glVertex2f(x+120, y+48);
+        glVertex2f(x,     y+48);
+    glEnd();
+
+    // Engine back-side shading strip (near coach connection side)
+    // (gives depth + fixes flat look)
+    glColor3f(0.52f, 0.07f, 0.09f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+104, y+2);
+        glVertex2f(x+120, y+2);
+        glVertex2f(x+120, y+46);
+        glVertex2f(x+104, y+46);
+    glEnd();
+
+    // Engine nose (angled)
+    glColor3f(0.60f, 0.08f, 0.10f);
+    glBegin(GL_POLYGON);
+        glVertex2f(x+120, y);
+        glVertex2f(x+150, y+8);
+        glVertex2f(x+150, y+40);
+        glVertex2f(x+120, y+48);
+    glEnd();
+
+    // Roof
+    glColor3f(0.25f, 0.25f, 0.25f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+10,  y+48);
+        glVertex2f(x+115, y+48);
+        glVertex2f(x+108, y+62);
+        glVertex2f(x+15,  y+62);
+    glEnd();
+
+    // Window (engine)
+    glColor3f(0.80f, 0.93f, 1.0f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+20, y+22);
+        glVertex2f(x+45, y+22);
+        glVertex2f(x+45, y+40);
+        glVertex2f(x+20, y+40);
+    glEnd();
+
+    // Door (engine)
+    glColor3f(0.40f, 0.05f, 0.08f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+55, y+10);
+        glVertex2f(x+78, y+10);
+        glVertex2f(x+78, y+40);
+        glVertex2f(x+55, y+40);
+    glEnd();
+
+    // Front grill lines
+    glColor3f(0.20f, 0.20f, 0.20f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINES);
+        for (int i = 0; i < 6; i++) {
+            float gx = x + 92 + i * 4.0f;
+            glVertex2f(gx, y+8);
+            glVertex2f(gx, y+40);
+        }
+    glEnd();
+
+    // Headlight (glow at night)
+    if (!isDay) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        glColor4f(1.0f, 1.0f, 0.85f, 0.85f);
+        drawCircle(x+148, y+24, 5.0f, 18);
+        addLight(x+148, y+24, LIGHT_MEDIUM, 1.0f, 1.0f, 0.85f, 0.6f);
+
+        glDisable(GL_BLEND);
+    } else {
+        glColor3f(1.0f, 1.0f, 0.85f);
+        drawCircle(x+148, y+24, 4.0f, 18);
+    }
+
+    // Stripe on engine
+    glColor3f(0.95f, 0.85f, 0.20f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+0,   y+18);
+        glVertex2f(x+150, y+18);
+        glVertex2f(x+150, y+24);
+        glVertex2f(x+0,   y+24);
+    glEnd();
+
+    // ============================================================
+    // ENGINE BOGIE BASE (THIS REMOVES "WEIRD SHAPE" LOOK)
+    // + extra shadow on back side of bogie frame
+    // ============================================================
+    // Main bogie frame
+    glColor3f(0.20f, 0.20f, 0.22f);
+    glBegin(GL_QUADS);
+        glVertex2f(x + 18, y - 4);
+        glVertex2f(x + 108, y - 4);
+        glVertex2f(x + 108, y + 6);
+        glVertex2f(x + 18, y + 6);
+    glEnd();
+
+    // Back-side bogie shadow strip (connector side)
+    glColor3f(0.12f, 0.12f, 0.14f);
+    glBegin(GL_QUADS);
+        glVertex2f(x + 92,  y - 4);
+        glVertex2f(x + 108, y - 4);
+        glVertex2f(x + 108, y + 6);
+        glVertex2f(x + 92,  y + 6);
+    glEnd();
+
+    // Coupler (engine to coach)
+    glColor3f(0.15f, 0.15f, 0.15f);
+    glLineWidth(4.0f);
+    glBegin(GL_LINES);
+        glVertex2f(x+150, y+10);
+        glVertex2f(x+165, y+10);
+    glEnd();
+
+    // -------------------- WHEELS --------------------
+    auto drawWheelPair = [&](float wx) {
+        glColor3f(0.08f, 0.08f, 0.08f);
+        drawCircle(wx,      y - 8, 8, 20);
+        drawCircle(wx + 34, y - 8, 8, 20);
+
+        glColor3f(0.75f, 0.75f, 0.75f);
+        drawCircle(wx,      y - 8, 3, 16);
+        drawCircle(wx + 34, y - 8, 3, 16);
+    };
+
+    // Engine wheels (2 pairs)
+    drawWheelPair(x + 30);
+    drawWheelPair(x + 85);
+
+    // -------------------- OUTLINE --------------------
+    glColor3f(0.12f, 0.12f, 0.12f);
+    glLineWidth(2.0f);
+
+    // Engine outline
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(x, y); glVertex2f(x+120, y);
+        glVertex2f(x+120, y+48); glVertex2f(x, y+48);
+    glEnd();
+}
+
+
+void drawBus(float x, float y) {
+    // --- soft shadow ---
+    addShadow(x + 72, y - 18, 72, 11, 0.28f);
+
+    // ===================== BODY (two-tone + shading) =====================
+    // main body
+    glColor3f(0.92f, 0.72f, 0.12f);
+    glBegin(GL_QUADS);
+        glVertex2f(x,      y);
+        glVertex2f(x+150,  y);
+        glVertex2f(x+150,  y+55);
+        glVertex2f(x,      y+55);
+    glEnd();
+
+    // roof band (slightly darker)
+    glColor3f(0.80f, 0.60f, 0.10f);
+    glBegin(GL_QUADS);
+        glVertex2f(x,     y+45);
+        glVertex2f(x+150, y+45);
+        glVertex2f(x+150, y+55);
+        glVertex2f(x,     y+55);
+    glEnd();
+
+    // back-side shading strip (depth)
+    glColor3f(0.70f, 0.50f, 0.08f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+132, y+2);
+        glVertex2f(x+150, y+2);
+        glVertex2f(x+150, y+53);
+        glVertex2f(x+132, y+53);
+    glEnd();
+
+    // front nose (small angle)
+    glColor3f(0.86f, 0.66f, 0.10f);
+    glBegin(GL_POLYGON);
+        glVertex2f(x+150, y);
+        glVertex2f(x+162, y+10);
+        glVertex2f(x+162, y+45);
+        glVertex2f(x+150, y+55);
+    glEnd();
+
+    // ===================== WINDOWS (glass + frames) =====================
+    glColor3f(0.78f, 0.92f, 1.0f);
+    for (int i = 0; i < 7; i++) {
+        float wx = x + 12 + i * 18;
+        glBegin(GL_QUADS);
+            glVertex2f(wx,     y + 28);
+            glVertex2f(wx + 14,y + 28);
+            glVertex2f(wx + 14,y + 44);
+            glVertex2f(wx,     y + 44);
+        glEnd();
+    }
+
+    // window frames
+    glColor3f(0.15f, 0.15f, 0.15f);
+    glLineWidth(2.0f);
+    for (int i = 0; i < 7; i++) {
+        float wx = x + 12 + i * 18;
+        glBegin(GL_LINE_LOOP);
+            glVertex2f(wx,     y + 28);
+            glVertex2f(wx + 14,y + 28);
+            glVertex2f(wx + 14,y + 44);
+            glVertex2f(wx,     y + 44);
+        glEnd();
+    }
+
+    // ===================== DOOR =====================
+    glColor3f(0.25f, 0.25f, 0.28f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+110, y+6);
+        glVertex2f(x+128, y+6);
+        glVertex2f(x+128, y+46);
+        glVertex2f(x+110, y+46);
+    glEnd();
+
+    // door glass
+    glColor3f(0.78f, 0.92f, 1.0f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+112, y+28);
+        glVertex2f(x+126, y+28);
+        glVertex2f(x+126, y+44);
+        glVertex2f(x+112, y+44);
+    glEnd();
+
+    // handle
+    glColor3f(0.95f, 0.95f, 0.95f);
+    drawCircle(x+125, y+20, 1.8f, 14);
+
+    // ===================== STRIPE + BUMPER =====================
+    glColor3f(0.10f, 0.10f, 0.10f);
+    glBegin(GL_QUADS);
+        glVertex2f(x,     y+18);
+        glVertex2f(x+162, y+18);
+        glVertex2f(x+162, y+23);
+        glVertex2f(x,     y+23);
+    glEnd();
+
+    glColor3f(0.18f, 0.18f, 0.18f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+148, y+2);
+        glVertex2f(x+162, y+2);
+        glVertex2f(x+162, y+12);
+        glVertex2f(x+148, y+12);
+    glEnd();
+
+    // mirror
+    glColor3f(0.12f, 0.12f, 0.12f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+145, y+35);
+        glVertex2f(x+153, y+35);
+        glVertex2f(x+153, y+40);
+        glVertex2f(x+145, y+40);
+    glEnd();
+
+    // ===================== WHEELS + arches =====================
+    // arches
+    glColor3f(0.25f, 0.25f, 0.25f);
+    drawEllipse(x + 35,  y + 2, 18, 9, 24);
+    drawEllipse(x + 120, y + 2, 18, 9, 24);
+
+    // wheels
+    glColor3f(0.06f, 0.06f, 0.06f);
+    drawCircle(x + 35,  y - 8, 12, 24);
+    drawCircle(x + 120, y - 8, 12, 24);
+
+    glColor3f(0.75f, 0.75f, 0.75f);
+    drawCircle(x + 35,  y - 8, 5, 18);
+    drawCircle(x + 120, y - 8, 5, 18);
+
+    // ===================== LIGHTS =====================
+    // headlight glow at night
+    if (!isDay) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        glColor4f(1.0f, 1.0f, 0.85f, 0.85f);
+        drawCircle(x+160, y+16, 5, 18);
+        addLight(x+160, y+16, LIGHT_MEDIUM, 1.0f, 1.0f, 0.85f, 0.6f);
+
+        glDisable(GL_BLEND);
+    } else {
+        glColor3f(1.0f, 1.0f, 0.85f);
+        drawCircle(x+160, y+16, 4, 18);
+    }
+
+    // tail light
+    glColor3f(0.95f, 0.20f, 0.20f);
+    drawCircle(x+6, y+16, 3.2f, 16);
+
+    // ===================== OUTLINE =====================
+    glColor3f(0.12f, 0.12f, 0.12f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(x, y); glVertex2f(x+150, y);
+        glVertex2f(x+150, y+55); glVertex2f(x, y+55);
+    glEnd();
+
+    // small text (optional)
+    glColor3f(0,0,0);
+    glRasterPos2f(x + 55, y + 8);
+    glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, '2');
+    glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, '0');
+    glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, '2');
+}
+
+
+void drawCar(float x, float y) {
+    // shadow
+    addShadow(x + 50, y - 18, 48, 10, 0.28f);
+
+    // ===================== BODY (two-tone) =====================
+    glColor3f(0.20f, 0.60f, 0.90f);
+    glBegin(GL_POLYGON);
+        glVertex2f(x,      y);
+        glVertex2f(x+96,   y);
+        glVertex2f(x+104,  y+12);
+        glVertex2f(x+92,   y+35);
+        glVertex2f(x+62,   y+48);
+        glVertex2f(x+28,   y+48);
+        glVertex2f(x+10,   y+35);
+        glVertex2f(x+2,    y+18);
+    glEnd();
+
+    // lower darker skirt (depth)
+    glColor3f(0.12f, 0.42f, 0.68f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+6,  y+2);
+        glVertex2f(x+98, y+2);
+        glVertex2f(x+92, y+10);
+        glVertex2f(x+10, y+10);
+    glEnd();
+
+    // bumper front
+    glColor3f(0.18f, 0.18f, 0.18f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+98, y+2);
+        glVertex2f(x+106,y+2);
+        glVertex2f(x+106,y+14);
+        glVertex2f(x+98, y+14);
+    glEnd();
+
+    // ===================== WINDOWS =====================
+    glColor3f(0.80f, 0.93f, 1.0f);
+    glBegin(GL_POLYGON);
+        glVertex2f(x+22, y+34);
+        glVertex2f(x+40, y+46);
+        glVertex2f(x+64, y+46);
+        glVertex2f(x+82, y+34);
+        glVertex2f(x+22, y+34);
+    glEnd();
+
+    // window split + frame
+    glColor3f(0.15f, 0.15f, 0.15f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(x+22, y+34);
+        glVertex2f(x+40, y+46);
+        glVertex2f(x+64, y+46);
+        glVertex2f(x+82, y+34);
+    glEnd();
+    glBegin(GL_LINES);
+        glVertex2f(x+52, y+46);
+        glVertex2f(x+52, y+34);
+    glEnd();
+
+    // mirror
+    glColor3f(0.12f,0.12f,0.12f);
+    glBegin(GL_QUADS);
+        glVertex2f(x+80, y+30);
+        glVertex2f(x+88, y+30);
+        glVertex2f(x+88, y+35);
+        glVertex2f(x+80, y+35);
+    glEnd();
+
+    // door line + handle
+    glColor3f(0.12f,0.12f,0.12f);
+    glLineWidth(1.5f);
+    glBegin(GL_LINES);
+        glVertex2f(x+50, y+10); glVertex2f(x+50, y+34);
+    glEnd();
+    glBegin(GL_QUADS);
+        glVertex2f(x+55, y+22);
+        glVertex2f(x+62, y+22);
+        glVertex2f(x+62, y+24);
+        glVertex2f(x+55, y+24);
+    glEnd();
+
+    // ===================== WHEELS + arches =====================
+    glColor3f(0.25f, 0.25f, 0.25f);
+    drawEllipse(x+26, y+2, 16, 9, 24);
+    drawEllipse(x+78, y+2, 16, 9, 24);
+
+    glColor3f(0.06f, 0.06f, 0.06f);
+    drawCircle(x+26, y-8, 11, 24);
+    drawCircle(x+78, y-8, 11, 24);
+
+    glColor3f(0.75f, 0.75f, 0.75f);
+    drawCircle(x+26, y-8, 4.5f, 18);
+    drawCircle(x+78, y-8, 4.5f, 18);
+
+    // ===================== LIGHTS =====================
+    if (!isDay) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // headlight
+        glColor4f(1.0f, 1.0f, 0.90f, 0.85f);
+        drawCircle(x+104, y+18, 4.5f, 18);
+        addLight(x+104, y+18, LIGHT_MEDIUM, 1.0f, 1.0f, 0.90f, 0.5f);
+
+        glDisable(GL_BLEND);
+    } else {
+        glColor3f(1.0f, 1.0f, 0.90f);
+        drawCircle(x+104, y+18, 3.8f, 18);
+    }
+
+    // tail light
+    glColor3f(0.95f, 0.20f, 0.20f);
+    drawCircle(x+4, y+18, 3.0f, 16);
+
+    // ===================== OUTLINE =====================
+    glColor3f(0.12f, 0.12f, 0.12f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(x,      y);
+        glVertex2f(x+96,   y);
+        glVertex2f(x+104,  y+12);
+        glVertex2f(x+92,   y+35);
+        glVertex2f(x+62,   y+48);
+        glVertex2f(x+28,   y+48);
+        glVertex2f(x+10,   y+35);
+        glVertex2f(x+2,    y+18);
+    glEnd();
+}
+
+// ======================= MORE REALISTIC BOAT (WITH REFLECTION) ==============
+
+void drawBoat(float x, float y) {
+    // ------------------- WATER SHADOW -------------------
+    addShadow(x + 55.0f, y - 10.0f, 55.0f, 8.5f, 0.28f);
+
+    glPushMatrix();
+    glTranslatef(x, y, 0);
+
+    // ------------------- HULL (curved + depth) -------------------
+    // top hull
+    glColor3f(0.42f, 0.22f, 0.10f);
+    glBegin(GL_POLYGON);
+        glVertex2f(  6,  4);
+        glVertex2f( 18,  0);
+        glVertex2f( 90,  0);
+        glVertex2f(106,  6);
+        glVertex2f( 96, 22);
+        glVertex2f( 20, 22);
+    glEnd();
+
+    // underside darker strip (depth)
+    glColor3f(0.28f, 0.14f, 0.06f);
+    glBegin(GL_POLYGON);
+        glVertex2f( 16,  0);
+        glVertex2f( 92,  0);
+        glVertex2f(102,  6);
+        glVertex2f( 96, 14);
+        glVertex2f( 22, 14);
+        glVertex2f( 18,  6);
+    glEnd();
+
+    // upper highlight strip (shine)
+    glColor3f(0.58f, 0.33f, 0.16f);
+    glBegin(GL_QUADS);
+        glVertex2f(18, 18);
+        glVertex2f(94, 18);
+        glVertex2f(90, 22);
+        glVertex2f(22, 22);
+    glEnd();
+
+    // ------------------- CABIN (better) -------------------
+    glColor3f(0.68f, 0.40f, 0.20f);
+    glBegin(GL_QUADS);
+        glVertex2f(34, 24);
+        glVertex2f(76, 24);
+        glVertex2f(76, 50);
+        glVertex2f(34, 50);
+    glEnd();
+
+    // cabin shading strip (depth)
+    glColor3f(0.50f, 0.28f, 0.14f);
+    glBegin(GL_QUADS);
+        glVertex2f(70, 24);
+        glVertex2f(76, 24);
+        glVertex2f(76, 50);
+        glVertex2f(70, 50);
+    glEnd();
+
+    // roof
+    glColor3f(0.93f, 0.93f, 0.93f);
+    glBegin(GL_QUADS);
+        glVertex2f(32, 50);
+        glVertex2f(78, 50);
+        glVertex2f(74, 58);
+        glVertex2f(36, 58);
+    glEnd();
+
+    // windows (glass)
+    glColor3f(0.80f, 0.93f, 1.0f);
+    glBegin(GL_QUADS);
+        glVertex2f(38, 34); glVertex2f(52, 34);
+        glVertex2f(52, 46); glVertex2f(38, 46);
+
+        glVertex2f(54, 34); glVertex2f(72, 34);
+        glVertex2f(72, 46); glVertex2f(54, 46);
+    glEnd();
+
+    // window frames
+    glColor3f(0.15f, 0.15f, 0.15f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(38, 34); glVertex2f(52, 34);
+        glVertex2f(52, 46); glVertex2f(38, 46);
+    glEnd();
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(54, 34); glVertex2f(72, 34);
+        glVertex2f(72, 46); glVertex2f(54, 46);
+    glEnd();
+
+    // window split line
+    glBegin(GL_LINES);
+        glVertex2f(52, 34);
+        glVertex2f(52, 46);
+    glEnd();
+
+    // ------------------- SMALL DETAILS -------------------
+    // railing line
+    glColor3f(0.85f, 0.85f, 0.85f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINES);
+        glVertex2f(20, 24);
+        glVertex2f(96, 24);
+    glEnd();
+
+    // portholes on hull (3 circles)
+    glColor3f(0.18f, 0.18f, 0.18f);
+    drawCircle(34, 12, 3.0f, 18);
+    drawCircle(52, 12, 3.0f, 18);
+    drawCircle(70, 12, 3.0f, 18);
+
+    glColor3f(0.78f, 0.92f, 1.0f);
+    drawCircle(34, 12, 1.2f, 14);
+    drawCircle(52, 12, 1.2f, 14);
+    drawCircle(70, 12, 1.2f, 14);
+
+    // mast + flag (a bit more realistic)
+    glColor3f(0.20f, 0.20f, 0.22f);
+    glLineWidth(3.0f);
+    glBegin(GL_LINES);
+        glVertex2f(76, 58);
+        glVertex2f(76, 74);
+    glEnd();
+
+    glColor3f(0.95f, 0.20f, 0.20f);
+    glBegin(GL_TRIANGLES);
+        glVertex2f(76, 72);
+        glVertex2f(92, 66);
+        glVertex2f(76, 60);
+    glEnd();
+
+    // life ring (cute detail)
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(1.0f, 0.55f, 0.10f, 0.90f);
+    drawCircle(26, 18, 5.0f, 20);
+    glColor4f(0.85f, 0.95f, 1.0f, 0.85f);
+    drawCircle(26, 18, 2.5f, 20);
+    glDisable(GL_BLEND);
+
+    // ------------------- WATER WAKE (foam trail) -------------------
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glColor4f(0.90f, 0.95f, 1.0f, 0.45f);
+    glLineWidth(2.5f);
+    glBegin(GL_LINE_STRIP);
+        for (int i = 0; i <= 6; i++) {
+            float t = i / 6.0f;
+            float wx = 6.0f - t * 35.0f;
+            float wy = 10.0f + std::sin(riverWave * 0.12f + t * 6.0f) * 2.0f;
+            glVertex2f(wx, wy);
+        }
+    glEnd();
+
+    glColor4f(0.90f, 0.95f, 1.0f, 0.25f);
+    drawEllipse(10.0f, 6.0f, 18.0f, 3.5f, 26);
+
+    glDisable(GL_BLEND);
+
+    // ------------------- OUTLINE (crisp) -------------------
+    glColor3f(0.12f, 0.12f, 0.12f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(  6,  4);
+        glVertex2f( 18,  0);
+        glVertex2f( 90,  0);
+        glVertex2f(106,  6);
+        glVertex2f( 96, 22);
+        glVertex2f( 20, 22);
+    glEnd();
+
+    glPopMatrix();
+}
+
+// Boat wake + foam + ripple rings (synced with riverWave & boatPosition)
+void drawBoatWake(float boatX, float boatY) {
+    // river bounds (same as your drawRiver)
+    float topY    = 180.0f;
+    float bottomY = 120.0f;
+    float midY    = (topY + bottomY) * 0.5f;
+
+    // boat center
+    float cx = boatX + 55.0f;     // boat center X (your boat width ~110)
+    float cy = boatY + 6.0f;      // slightly above hull bottom
+
+    // phase: uses both riverWave and boatPosition
+    float t = riverWave * 0.10f + boatX * 0.01f;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // ---------------- 1) Main white foam trail (behind boat) ----------------
+    // a few stretched ellipses behind the boat
+    for (int i = 0; i < 6; i++) {
+        float k  = (float)i;
+        float fx = cx - 18.0f - k * 22.0f;              // behind boat
+        float fy = midY + std::sin(t + k * 0.7f) * 2.0f;
+
+        // fade out as it goes back
+        float a = 0.22f - k * 0.03f;
+        if (a < 0.03f) a = 0.03f;
+
+        glColor4f(0.95f, 0.98f, 1.0f, a);
+        drawEllipse(fx, fy, 18.0f + k * 2.0f, 3.2f, 28);
+    }
+
+    // ---------------- 2) Side foam near hull edges ----------------
+    glColor4f(0.90f, 0.95f, 1.0f, 0.14f);
+    drawEllipse(cx - 8.0f, cy - 3.0f, 10.0f, 2.5f, 24);
+    drawEllipse(cx + 10.0f, cy - 3.0f, 10.0f, 2.5f, 24);
+
+    // ---------------- 3) Ripple rings (expanding circles) ----------------
+    // 3 rings that expand with time
+    for (int i = 0; i < 3; i++) {
+        float phase = std::fmod(riverWave * (1.4f + i * 0.35f), 22.0f);
+        float rr    = 8.0f + phase + i * 6.0f;
+
+        float rx = cx - 10.0f - i * 18.0f;  // slightly behind boat
+        float ry = midY + std::sin(t + i) * 2.0f;
+
+        float a = 0.10f - i * 0.02f;
+        if (a < 0.03f) a = 0.03f;
+
+        glColor4f(0.85f, 0.95f, 1.0f, a);
+        drawEllipse(rx, ry, rr, rr * 0.32f, 32);
+    }
+
+    glDisable(GL_BLEND);
+}
+
+
+void drawAirplane() {
+    if (!cullShown[CO_PLANE]) return;
+    float x = std::fmod(planePosition, WIDTH + 400.0f) - 200.0f;
+    float y = HEIGHT - 100.0f + 20.0f * std::sin(planePosition * 0.02f);
+
+    glColor3f(0.95f, 0.95f, 0.95f);
+    glBegin(GL_QUADS);
+    glVertex2f(x, y);
+    glVertex2f(x + 100, y);
+    glVertex2f(x + 100, y + 25);
+    glVertex2f(x, y + 25);
+    glEnd();
+
+    glBegin(GL_TRIANGLES);
+    glVertex2f(x + 100, y);
+    glVertex2f(x + 100, y + 25);
+    glVertex2f(x + 120, y + 12.5f);
+    glEnd();
+
+    glBegin(GL_TRIANGLES);
+    glVertex2f(x, y + 25);
+    glVertex2f(x - 15, y + 40);
+    glVertex2f(x + 15, y + 25);
+    glEnd();
+
+    glBegin(GL_QUADS);
+    glVertex2f(x + 30, y + 25);
+    glVertex2f(x + 70, y + 25);
+    glVertex2f(x + 65, y + 45);
+    glVertex2f(x + 35, y + 45);
+    glVertex2f(x + 10, y + 15);
+    glVertex2f(x + 30, y + 15);
+    glVertex2f(x + 30, y + 20);
+    glVertex2f(x + 10, y + 20);
+    glEnd();
+
+    glColor3f(0.6f, 0.9f, 1.0f);
+    glBegin(GL_QUADS);
+    for (int i = 0; i < 6; i++) {
+        float wx = x + 15 + i * 14;
+        glVertex2f(wx, y + 8);
+        glVertex2f(wx + 10, y + 8);
+        glVertex2f(wx + 10, y + 18);
+        glVertex2f(wx, y + 18);
+    }
+    glEnd();
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(1.0f, 1.0f, 1.0f, 0.6f);
+    for (int i = 0; i < 3; i++) {
+        float trailX    = x - 20 - i * 25;
+        float trailSize = 15.0f - i * 4.0f;
+        drawCircle(trailX, y + 12.5f, trailSize);
+    }
+    glDisable(GL_BLEND);
+}
+
+// ============================================================================
+// FISH SCHOOL (boids in the river band, 1D bucket grid along x)
+// ============================================================================
+
+struct Fish {
+    float x, y;        // world position (centre of body)
+    float vx, vy;      // velocity in px / tick
+    float scale;
+    float phase;       // swim / tail animation offset
+    float r, g, b;
+};
+
+std::vector<Fish> fishSchool;
+std::vector<int>  fishBucketStart;   // bucket -> first index into fishBucketItems
+std::vector<int>  fishBucketItems;   // fish indices sorted by bucket
+std::vector<int>  fishBucketOf;      // fish -> bucket (scratch)
+std::vector<int>  fishBucketCursor;  // write cursor per bucket (scratch)
+
+const int   MAX_FISH        = 10000;   // --fish cap (the largest school in --bench)
+const float FISH_MARGIN     = 125.0f;  // fish wrap this far outside the screen
+const float FISH_BUCKET_W   = 24.0f;   // must be >= FISH_NEIGHBOR_R
+const float FISH_NEIGHBOR_R = 22.0f;
+const float FISH_CRUISE     = 1.3f;    // same pace as the old fishPosition drift
+const int   FISH_MAX_NEIGHBORS = 8;    // real schools track ~7 neighbours; keeps dense schools O(n)
+
+// small deterministic LCG (same sequence on every run / platform)
+static unsigned int fishRandState = 12345u;
+static inline float fishRand() {
+    fishRandState = fishRandState * 1664525u + 1013904223u;
+    return (fishRandState >> 8) * (1.0f / 16777216.0f);   // 0..1
+}
+
+// water surface / bed height at x (same wave as drawRiver)
+static inline float riverWaveOffset(float x, float extraPhase) {
+    float waveIntensity = 3.0f + 2.0f * std::sin(riverWave * 0.05f);
+    return waveIntensity * std::sin(x * 0.03f + riverWave * 0.10f + extraPhase);
+}
+
+static inline float boatScreenX() { return std::fmod(boatPosition, WIDTH + 250.0f) - 150.0f; }
+static inline float boatScreenY() { return 125.0f + 4.0f * std::sin(boatPosition * 0.05f); }
+
+void initFishSchool(int count) {
+    static const float palette[4][3] = {
+        {1.00f, 0.55f, 0.10f}, {0.30f, 0.80f, 0.95f},
+        {0.90f, 0.35f, 0.25f}, {0.35f, 0.90f, 0.40f}
+    };
+
+    fishRandState = 12345u;
+    fishSchool.assign(count < 0 ? 0 : count, Fish());
+
+    for (size_t i = 0; i < fishSchool.size(); i++) {
+        Fish& f = fishSchool[i];
+        const float* c = palette[i % 4];
+        f.x     = -FISH_MARGIN + fishRand() * (WIDTH + 2.0f * FISH_MARGIN);
+        f.y     = 135.0f + fishRand() * 30.0f;
+        f.vx    = FISH_CRUISE * (0.7f + 0.6f * fishRand());
+        f.vy    = (fishRand() - 0.5f) * 0.4f;
+        f.scale = 0.45f + 0.55f * fishRand();
+        f.phase = fishRand() * 6.2831853f;
+        f.r = c[0]; f.g = c[1]; f.b = c[2];
+    }
+}
+
+void updateFishSchool(float speed) {
+    int n = (int)fishSchool.size();
+    if (n == 0) return;
+
+    // ---- 1) counting sort into x buckets ----
+    const float worldMin = -FISH_MARGIN;
+    const float worldW   = WIDTH + 2.0f * FISH_MARGIN;
+    int buckets = (int)(worldW / FISH_BUCKET_W) + 1;
+
+    fishBucketStart.assign(buckets + 1, 0);
+    fishBucketItems.resize(n);
+    fishBucketOf.resize(n);
+
+    for (int i = 0; i < n; i++) {
+        int b = (int)((fishSchool[i].x - worldMin) / FISH_BUCKET_W);
+        if (b < 0) b = 0;
+        if (b >= buckets) b = buckets - 1;
+        fishBucketOf[i] = b;
+        fishBucketStart[b + 1]++;
+    }
+    for (int b = 0; b < buckets; b++) fishBucketStart[b + 1] += fishBucketStart[b];
+    fishBucketCursor.assign(fishBucketStart.begin(), fishBucketStart.end() - 1);
+    for (int i = 0; i < n; i++) fishBucketItems[fishBucketCursor[fishBucketOf[i]]++] = i;
+
+    // boat hull (slightly inflated) in world space
+    float hullX0 = boatScreenX() - 10.0f, hullX1 = hullX0 + 130.0f;
+    float hullY0 = boatScreenY() - 12.0f, hullY1 = boatScreenY() + 26.0f;
+
+    const float r2 = FISH_NEIGHBOR_R * FISH_NEIGHBOR_R;
+
+    // ---- 2) steering (separation / alignment / cohesion + bounds) ----
+    for (int i = 0; i < n; i++) {
+        Fish& f = fishSchool[i];
+        int b = fishBucketOf[i];
+
+        float sepX = 0, sepY = 0, aliX = 0, aliY = 0, cohX = 0, cohY = 0;
+        int   near = 0;
+
+        int b0 = (b > 0) ? b - 1 : 0;
+        int b1 = (b < buckets - 1) ? b + 1 : buckets - 1;
+        for (int k = fishBucketStart[b0]; k < fishBucketStart[b1 + 1]; k++) {
+            int j = fishBucketItems[k];
+            if (j == i) continue;
+            const Fish& o = fishSchool[j];
+            float dx = o.x - f.x, dy = o.y - f.y;
+            float d2 = dx * dx + dy * dy;
+            if (d2 > r2) continue;
+
+            near++;
+            aliX += o.vx; aliY += o.vy;
+            cohX += dx;   cohY += dy;
+            if (d2 < 100.0f) {                 // too close: push apart
+                float inv = 1.0f / (d2 + 1.0f);
+                sepX -= dx * inv; sepY -= dy * inv;
+            }
+            if (near == FISH_MAX_NEIGHBORS) break;
+        }
+
+        float ax = 0.0f, ay = 0.0f;
+        if (near > 0) {
+            float invN = 1.0f / near;
+            ax += (aliX * invN - f.vx) * 0.05f + cohX * invN * 0.003f;
+            ay += (aliY * invN - f.vy) * 0.05f + cohY * invN * 0.003f;
+        }
+        ax += sepX * 0.6f;
+        ay += sepY * 0.6f;
+
+        // gentle drift downstream (all fish used to swim right)
+        ax += (FISH_CRUISE - f.vx) * 0.01f;
+
+        // stay inside the water (surface & bed follow the waves)
+        float top    = 180.0f + riverWaveOffset(f.x, 0.0f)  - 10.0f;
+        float bottom = 120.0f + riverWaveOffset(f.x, 0.55f) + 10.0f;
+        if (f.y > top - 6.0f)    ay -= (f.y - (top - 6.0f)) * 0.04f;
+        if (f.y < bottom + 6.0f) ay += ((bottom + 6.0f) - f.y) * 0.04f;
+
+        // keep clear of the boat hull
+        if (f.x > hullX0 - 20.0f && f.x < hullX1 + 20.0f &&
+            f.y > hullY0 - 10.0f && f.y < hullY1 + 10.0f) {
+            float cy = (hullY0 + hullY1) * 0.5f;
+            ay += (f.y >= cy ? 0.08f : -0.08f);
+            if (f.x < hullX0) ax -= 0.04f;
+        }
+
+        f.vx += ax * speed;
+        f.vy += ay * speed;
+
+        // clamp speed (and never stall completely)
+        float v2 = f.vx * f.vx + f.vy * f.vy;
+        float vmax = 2.2f;
+        if (v2 > vmax * vmax) {
+            float s = vmax / std::sqrt(v2);
+            f.vx *= s; f.vy *= s;
+        }
+        if (std::fabs(f.vx) < 0.2f) f.vx = (f.vx < 0.0f) ? -0.2f : 0.2f;
+    }
+
+    // ---- 3) integrate + wrap ----
+    for (int i = 0; i < n; i++) {
+        Fish& f = fishSchool[i];
+        f.x += f.vx * speed;
+        f.y += f.vy * speed;
+
+        if (f.y > 172.0f) { f.y = 172.0f; if (f.vy > 0) f.vy = -f.vy * 0.5f; }
+        if (f.y < 128.0f) { f.y = 128.0f; if (f.vy < 0) f.vy = -f.vy * 0.5f; }
+
+        if (f.x > WIDTH + FISH_MARGIN) f.x -= WIDTH + 2.0f * FISH_MARGIN;
+        if (f.x < -FISH_MARGIN)        f.x += WIDTH + 2.0f * FISH_MARGIN;
+    }
+}
+
+// one fish's body frame: local (lx, ly) -> world
+struct FishFrame {
+    float ox, oy, hx, hy, nx, ny, s;
+    void pt(float lx, float ly) const {
+        glVertex2f(ox + (lx * hx + ly * nx) * s, oy + (lx * hy + ly * ny) * s);
+    }
+};
+
+void drawFish() {
+    // unit circle, shared by every fish
+    const int SEG = 12;
+    static float ucos[SEG + 1], usin[SEG + 1];
+    static bool  tableReady = false;
+    if (!tableReady) {
+        for (int i = 0; i <= SEG; i++) {
+            ucos[i] = std::cos(2.0f * 3.1415926f * i / SEG);
+            usin[i] = std::sin(2.0f * 3.1415926f * i / SEG);
+        }
+        tableReady = true;
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // ---- bodies, highlights and tails: one triangle batch ----
+    glBegin(GL_TRIANGLES);
+    for (int i : fishShown) {
+        const Fish& f = fishSchool[i];
+
+        float sp = std::sqrt(f.vx * f.vx + f.vy * f.vy) + 1e-4f;
+        float hx = f.vx / sp, hy = f.vy / sp;          // heading
+        float side = (hx < 0.0f) ? -1.0f : 1.0f;       // keep belly down
+        float nx = -hy * side, ny = hx * side;
+
+        float s    = f.scale;
+        float swim = std::sin(fishPosition * 0.08f + f.phase) * 3.0f;
+        float wag  = std::sin(fishPosition * 0.35f + f.phase) * 3.5f;
+        float ox = f.x, oy = f.y + swim;
+
+        FishFrame fr = {ox, oy, hx, hy, nx, ny, s};
+
+        glColor4f(f.r, f.g, f.b, 0.85f);
+        for (int k = 0; k < SEG; k++) {
+            fr.pt(0.0f, 0.0f);
+            fr.pt(18.0f * ucos[k],     8.0f * usin[k]);
+            fr.pt(18.0f * ucos[k + 1], 8.0f * usin[k + 1]);
+        }
+
+        glColor4f(1.0f, 1.0f, 1.0f, 0.18f);
+        for (int k = 0; k < SEG; k += 2) {
+            fr.pt(4.0f, 2.0f);
+            fr.pt(4.0f + 10.0f * ucos[k],     2.0f + 3.0f * usin[k]);
+            fr.pt(4.0f + 10.0f * ucos[k + 2], 2.0f + 3.0f * usin[k + 2]);
+        }
+
+        glColor4f(f.r * 0.95f, f.g * 0.85f, f.b * 0.85f, 0.90f);
+        fr.pt(-18.0f, 0.0f);
+        fr.pt(-30.0f,  7.0f + wag);
+        fr.pt(-30.0f, -7.0f - wag);
+    }
+    glEnd();
+
+    // ---- eyes + a few bubbles: one point batch ----
+    glPointSize(2.5f);
+    glBegin(GL_POINTS);
+    for (int i : fishShown) {
+        const Fish& f = fishSchool[i];
+
+        float sp = std::sqrt(f.vx * f.vx + f.vy * f.vy) + 1e-4f;
+        float hx = f.vx / sp, hy = f.vy / sp;
+        float side = (hx < 0.0f) ? -1.0f : 1.0f;
+        float swim = std::sin(fishPosition * 0.08f + f.phase) * 3.0f;
+
+        float ex = f.x + (12.0f * hx - 3.0f * hy * side) * f.scale;
+        float ey = f.y + swim + (12.0f * hy + 3.0f * hx * side) * f.scale;
+        glColor4f(0.0f, 0.0f, 0.0f, 0.95f);
+        glVertex2f(ex, ey);
+
+        if (i % 8 == 0) {
+            float up = std::fmod(riverWave * 0.8f + f.phase * 30.0f, 30.0f);
+            glColor4f(0.85f, 0.95f, 1.0f, 0.35f);
+            glVertex2f(ex + 10.0f * hx, ey + up);
+            glVertex2f(ex + 18.0f * hx, ey + 5.0f + up * 0.7f);
+        }
+    }
+    glEnd();
+
+    glDisable(GL_BLEND);
+}
+
+// ============================================================================
+// ANIMATED OBJECTS
+// ============================================================================
+
+void drawMovingTrain() {
+    drawTrain(trainPosition, 365);   // culls the engine and each coach itself
+}
+
+void drawMovingBus() {
+    if (!cullShown[CO_BUS]) return;
+    float busX = std::fmod(busPosition, WIDTH + 500.0f) - 200.0f;
+    drawBus(busX, 240);
+}
+
+void drawMovingCar() {
+    if (!cullShown[CO_CAR]) return;
+    float carX = std::fmod(carPosition, WIDTH + 300.0f) - 150.0f;
+    drawCar(carX, 240);
+}
 
 void drawMovingBoat() {
-    float boatX = std::fmod(boatPosition, WIDTH + 250.0f) - 150.0f;
-    float boatY = 125.0f + 4.0f * std::sin(boatPosition * 0.05f);
+    if (!cullShown[CO_BOAT]) return;
+    float boatX = boatScreenX();
+    float boatY = boatScreenY();
+
+    // ✅ wake first (so it stays under boat); foam is still water
+    surfaceMask(MASK_WATER);
+    drawBoatWake(boatX, boatY);
+    surfaceMask(MASK_OBJECT);
+
+    // reflected from the frame about mid-river (see REFLECTION PASS)
+    addMirror(boatX - 10.0f, boatX + 130.0f, boatY - 12.0f, boatY + 26.0f, 0.6f, 0.45f);
+
+    // boat on top
+    drawBoat(boatX, boatY);
+}
+
+
+void drawBirds() {
+    if (!showBirds || !cullShown[CO_BIRDS]) return;
+
+    const int numBirds    = 6;
+    const int birdsPerRow = 3;      // 3 birds per row
+    const float spacingX  = 45.0f;  // left-right spacing
+    const float rowGapY   = 28.0f;  // top-bottom row gap
+    const float rowBackX  = 25.0f;  // 2nd row slightly behind (more realistic)
+
+    float flockX = std::fmod(birdOffset * 1.5f, WIDTH + 200.0f) - 100.0f;
+
+    for (int i = 0; i < numBirds; i++) {
+
+        // ---- 2-row formation (3 birds each row) ----
+        int row = i / birdsPerRow;   // 0 or 1
+        int col = i % birdsPerRow;   // 0,1,2
+
+        float bx = flockX + col * spacingX - row * rowBackX;
+        float by = 540.0f - row * rowGapY
+                 + std::sin(birdOffset * 0.08f + i * 0.5f) * 12.0f;
+
+        float scale = 0.8f + 0.1f * (i % 3);
+        float flap  = std::sin(birdOffset * 0.30f + i * 0.8f) * 25.0f;
+
+        glPushMatrix();
+        glTranslatef(bx, by, 0.0f);
+        glScalef(scale, scale, 1.0f);
+
+        float br = isDay ? 0.22f : 0.12f;
+        float bg = isDay ? 0.22f : 0.12f;
+        float bb = isDay ? 0.28f : 0.20f;
+        glColor3f(br, bg, bb);
+        drawEllipse(0.0f, 0.0f, 10.0f, 6.0f, 24);
+
+        glColor3f(0.50f, 0.50f, 0.55f);
+        drawEllipse(2.0f, -1.0f, 6.0f, 3.0f, 20);
+
+        glColor3f(0.24f, 0.24f, 0.28f);
+        drawCircle(9.0f, 3.0f, 4.0f, 18);
+
+        glColor3f(1.0f, 1.0f, 1.0f);
+        drawCircle(10.0f, 3.0f, 1.1f, 12);
+        glColor3f(0.0f, 0.0f, 0.0f);
+        drawCircle(10.4f, 3.0f, 0.6f, 10);
+
+        glColor3f(0.95f, 0.65f, 0.10f);
+        glBegin(GL_TRIANGLES);
+            glVertex2f(12.5f, 2.0f);
+            glVertex2f(16.0f, 3.5f);
+            glVertex2f(12.5f, 5.0f);
+        glEnd();
+
+        glColor3f(0.16f, 0.16f, 0.20f);
+        glBegin(GL_TRIANGLES);
+            glVertex2f(-10.0f, 1.0f);
+            glVertex2f(-18.0f, 6.0f);
+            glVertex2f(-15.0f, -2.0f);
+        glEnd();
+
+        glPushMatrix();
+        glTranslatef(0.0f, 4.0f, 0.0f);
+        glRotatef(flap, 0.0f, 0.0f, 1.0f);
+        glColor3f(0.30f, 0.30f, 0.35f);
+        glBegin(GL_TRIANGLES);
+            glVertex2f(-2.0f, 0.0f);
+            glVertex2f(12.0f, 6.0f);
+            glVertex2f(4.0f, -2.0f);
+        glEnd();
+        glPopMatrix();
+
+        glPopMatrix();
+    }
+}
+
+
+// ============================================================================
+// STRUCTURES
+// ============================================================================
+
+void drawWindmill(float x, float y) {
+    matColor(MAT_MILL_TOWER);
+    glBegin(GL_QUADS);
+    glVertex2f(x - 18, y);
+    glVertex2f(x + 18, y);
+    glVertex2f(x + 18, y + 120);
+    glVertex2f(x - 18, y + 120);
+    glEnd();
+
+    matColor(MAT_MILL_CAP);
+    glBegin(GL_TRIANGLES);
+    glVertex2f(x - 35, y + 120);
+    glVertex2f(x + 35, y + 120);
+    glVertex2f(x, y + 160);
+    glEnd();
+
+    glPushMatrix();
+    glTranslatef(x, y + 140, 0);
+    glRotatef(windmillAngle * windIntensity, 0, 0, 1);
+
+    matColor(MAT_MILL_SAIL);
+    for (int i = 0; i < 4; i++) {
+        glPushMatrix();
+        glRotatef(90.0f * i, 0, 0, 1);
+        glBegin(GL_TRIANGLES);
+        glVertex2f(0, 0);
+        glVertex2f(0, 80);
+        glVertex2f(12, 80);
+        glEnd();
+        glPopMatrix();
+    }
+
+    glPopMatrix();
+}
+
+void drawStreetLight(float x, float y) {
+    matColor(MAT_LAMP_POST);
+    glBegin(GL_QUADS);
+    glVertex2f(x - 4, y);
+    glVertex2f(x + 4, y);
+    glVertex2f(x + 4, y + 70);
+    glVertex2f(x - 4, y + 70);
+    glEnd();
+
+    matColor(MAT_LAMP_HEAD);
+    glBegin(GL_QUADS);
+    glVertex2f(x - 12, y + 70);
+    glVertex2f(x + 12, y + 70);
+    glVertex2f(x + 12, y + 85);
+    glVertex2f(x - 12, y + 85);
+    glEnd();
+
+    if (!isDay && showLights) {
+        float intensity = 1.0f - dayNightBlend;
+
+        // halo: light pass
+        addLight(x, y + 60, LIGHT_LARGE, 1.0f, 1.0f, 0.7f, 0.8f * intensity);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        glColor4f(1.0f, 1.0f, 0.6f, 0.85f * intensity);
+        drawCircle(x, y + 60, 8);
+
+        glDisable(GL_BLEND);
+    } else {
+        matColor(MAT_LAMP_OFF);
+        drawCircle(x, y + 60, 5);
+    }
+}
+
+void drawSwing(float x, float y) {
+    // kept (not visible directly) – angle reused for playground seesaw
+    glColor3f(0.5f, 0.3f, 0.2f);
+    glLineWidth(3.0f);
+    glBegin(GL_LINES);
+    glVertex2f(x - 45, y);
+    glVertex2f(x - 15, y + 80);
+    glVertex2f(x + 45, y);
+    glVertex2f(x + 15, y + 80);
+    glVertex2f(x - 15, y + 80);
+    glVertex2f(x + 15, y + 80);
+    glEnd();
+}
+
+// ============================================================================
+// NEW EXTRA DETAILS
+// ============================================================================
+
+// River-side dock + fisherman with reflection
+void drawDockAndFisherman() {
+    float dockX = 340.0f;
+    float dockY = 172.0f;
+
+    // Dock, moored boat and fisherman reflect from the frame (REFLECTION PASS)
+    addMirror(dockX - 66.0f, dockX + 80.0f, 150.0f, dockY + 40.0f, 0.6f, 0.5f);
+
+    // ----------------- WOODEN DOCK -----------------
+    surfaceMask(MASK_GROUND);   // planks take the fisherman's shadow
+    glColor3f(0.55f, 0.38f, 0.22f);
+    glBegin(GL_QUADS);
+        glVertex2f(dockX - 60, dockY);
+        glVertex2f(dockX + 60, dockY);
+        glVertex2f(dockX + 60, dockY + 10);
+        glVertex2f(dockX - 60, dockY + 10);
+    glEnd();
+
+    glColor3f(0.42f, 0.28f, 0.16f);
+    glLineWidth(1.0f);
+    glBegin(GL_LINES);
+        for (float x = dockX - 58; x <= dockX + 58; x += 8.0f) {
+            glVertex2f(x, dockY);
+            glVertex2f(x, dockY + 10);
+        }
+    glEnd();
+    surfaceMask(MASK_OBJECT);
+
+    glColor3f(0.40f, 0.26f, 0.14f);
+    for (int i = -2; i <= 2; ++i) {
+        float px = dockX + i * 25.0f;
+        glBegin(GL_QUADS);
+            glVertex2f(px - 3, 150.0f);
+            glVertex2f(px + 3, 150.0f);
+            glVertex2f(px + 3, dockY);
+            glVertex2f(px - 3, dockY);
+        glEnd();
+    }
+
+    // ----------------- SMALL BOAT TIED TO DOCK -----------------
+    float boatBaseX = dockX + 50.0f;
+    float boatBaseY = 150.0f;
+
+    glColor3f(0.32f, 0.20f, 0.10f);
+    glBegin(GL_POLYGON);
+        glVertex2f(boatBaseX - 24, boatBaseY);
+        glVertex2f(boatBaseX + 24, boatBaseY);
+        glVertex2f(boatBaseX + 18, boatBaseY + 10);
+        glVertex2f(boatBaseX - 18, boatBaseY + 10);
+    glEnd();
+
+    glColor3f(0.40f, 0.26f, 0.14f);
+    glBegin(GL_LINES);
+        glVertex2f(boatBaseX, boatBaseY + 10);
+        glVertex2f(dockX + 40, dockY + 5);
+    glEnd();
+
+    // ----------------- FISHERMAN -----------------
+    float fx = dockX - 30.0f;
+    float fy = dockY + 10.0f;
+
+    addShadow(fx, fy - 6.0f, 10.0f, 3.5f, 0.35f);
+
+    glColor3f(1.0f, 0.90f, 0.80f);
+    drawCircle(fx, fy + 22.0f, 7.0f);
+
+    glColor3f(0.15f, 0.35f, 0.75f);
+    glBegin(GL_TRIANGLES);
+        glVertex2f(fx - 7, fy + 24);
+        glVertex2f(fx + 7, fy + 24);
+        glVertex2f(fx,     fy + 32);
+    glEnd();
+
+    glColor3f(0.1f, 0.4f, 0.9f);
+    glLineWidth(5.0f);
+    glBegin(GL_LINES);
+        glVertex2f(fx, fy + 16.0f);
+        glVertex2f(fx, fy);        // torso
+    glEnd();
+
+    glBegin(GL_LINES);
+        glVertex2f(fx, fy + 12.0f);
+        glVertex2f(fx + 14.0f, fy + 4.0f);
+        glVertex2f(fx, fy + 12.0f);
+        glVertex2f(fx - 12.0f, fy + 4.0f);
+    glEnd();
+
+    glColor3f(0.1f, 0.2f, 0.35f);
+    glBegin(GL_LINES);
+        glVertex2f(fx, fy);
+        glVertex2f(fx - 6.0f, fy - 12.0f);
+        glVertex2f(fx, fy);
+        glVertex2f(fx + 6.0f, fy - 12.0f);
+    glEnd();
+
+    // Fishing rod + line
+    glColor3f(0.25f, 0.15f, 0.05f);
+    glLineWidth(3.0f);
+    glBegin(GL_LINES);
+        glVertex2f(fx + 14.0f, fy + 4.0f);
+        glVertex2f(fx + 70.0f, fy + 40.0f);
+    glEnd();
+
+    float bobPhase = std::sin(riverWave * 0.15f) * 4.0f;
+    float lineX    = fx + 70.0f;
+    float lineYTop = fy + 40.0f;
+    float bobX     = lineX + 10.0f;
+    float bobY     = 150.0f + bobPhase;
+
+    setCable(fishingLine, lineX, lineYTop, bobX, bobY);   // drawn with the front cables
+
+
+    glColor3f(1.0f, 1.0f, 1.0f);
+    drawCircle(bobX, bobY, 4.5f);
+    glColor3f(1.0f, 0.15f, 0.15f);
+    drawCircle(bobX, bobY, 3.0f);
+}
+
+// ============================================================================
+// COW HERD (grazing herd inside the fenced field)
+// A cow either GRAZEs (stands, tail going), WANDERs along a slowly drifting
+// heading, or FLOCKs back towards the herd when no herd-mate is near.
+// Grazing / wandering alternate on per-cow timers from a fixed-seed LCG,
+// so the herd replays exactly. Neighbours come from the same x-bucket
+// counting sort as the fish school (no more than HERD_MAX_NEIGHBORS looked
+// at). The fence 80..320 x 40..110 is a soft push inside HERD_MARGIN plus
+// a hard clamp on the whole body. The array is kept sorted far to near,
+// so it is also the draw order.
+// Every cow is the old drawSingleCow() shape, baked once into a triangle
+// template with the legs and tail marked so they can swing: one instanced
+// draw with per-cow position, scale, facing and gait on the GLSL path,
+// otherwise one CPU-expanded triangle array.
+// ============================================================================
+
+enum CowState { COW_GRAZE, COW_WANDER, COW_FLOCK };
+
+struct Cow {
+    float   x, y;        // body anchor, as the old drawSingleCow(cx, cy)
+    float   scale;
+    float   gait;        // leg phase, advanced by distance walked
+    float   tail;        // tail swing offset
+    float   vx, vy;      // px / tick
+    float   heading;     // wander direction
+    float   timer;       // ticks left in the current state
+    uint8_t state;       // CowState
+    int8_t  facing;      // +1 right, -1 left
+    uint8_t pad[2];
+};
+
+const int   MAX_HERD           = 5000;
+const float HERD_X0 = 80.0f, HERD_X1 = 320.0f;    // fence (drawFieldAndCow)
+const float HERD_Y0 = 40.0f, HERD_Y1 = 110.0f;
+const float HERD_MARGIN        = 12.0f;
+const float HERD_BUCKET_W      = 24.0f;   // >= HERD_NEIGHBOR_R
+const float HERD_NEIGHBOR_R    = 24.0f;
+const int   HERD_MAX_NEIGHBORS = 8;
+
+std::vector<Cow> herd;
+std::vector<int> herdBucketStart, herdBucketItems, herdBucketOf, herdBucketCursor;
+
+uint32_t& herdRandState = scene.herdRand;   // in SceneState, like pedRandState
+static inline float herdRand() {
+    herdRandState = herdRandState * 1664525u + 1013904223u;
+    return (herdRandState >> 8) * (1.0f / 16777216.0f);   // 0..1
+}
+
+// the whole figure around the anchor (at scale 1, either facing): muzzle at
+// 54, feet at -18 less the 2.5 step, horn tips at 24.75, the tail tuft at
+// 24 plus its 3 unit swing
+const float COW_REACH_X = 54.0f, COW_REACH_DOWN = 20.5f, COW_REACH_UP = 27.0f;
+
+// anchor range that keeps all of it inside the fence
+static inline void herdBounds(float s, float& x0, float& x1, float& y0, float& y1) {
+    x0 = HERD_X0 + COW_REACH_X * s;     x1 = HERD_X1 - COW_REACH_X * s;
+    y0 = HERD_Y0 + COW_REACH_DOWN * s;  y1 = HERD_Y1 - COW_REACH_UP * s;
+}
+
+void initHerd(int count) {
+    herdRandState = 777u;
+    herd.assign(std::max(0, std::min(count, MAX_HERD)), Cow());
+
+    // big herds get smaller cows so the field still reads as a field
+    float base = std::min(0.55f, std::max(0.12f, 1.6f / std::sqrt((float)std::max(1, (int)herd.size()))));
+    for (size_t i = 0; i < herd.size(); i++) {
+        Cow& c = herd[i];
+        c.scale = base * (0.8f + 0.35f * herdRand());
+        float x0, x1, y0, y1;
+        herdBounds(c.scale, x0, x1, y0, y1);
+        c.x       = x0 + herdRand() * (x1 - x0);
+        c.y       = y0 + herdRand() * (y1 - y0);
+        c.gait    = 0.0f;
+        c.tail    = herdRand() * 6.2831853f;
+        c.vx      = c.vy = 0.0f;
+        c.heading = herdRand() * 6.2831853f;
+        c.timer   = herdRand() * 600.0f;
+        c.state   = COW_GRAZE;
+        c.facing  = herdRand() < 0.5f ? -1 : 1;
+        c.pad[0]  = c.pad[1] = 0;
+    }
+    std::stable_sort(herd.begin(), herd.end(), [](const Cow& a, const Cow& b) { return a.y > b.y; });
+}
+
+void updateHerd(float speed) {
+    int n = (int)herd.size();
+    if (n == 0) return;
+
+    // ---- 1) counting sort into x buckets, herd centre ----
+    const int buckets = (int)((HERD_X1 - HERD_X0) / HERD_BUCKET_W) + 1;
+    herdBucketStart.assign(buckets + 1, 0);
+    herdBucketItems.resize(n);
+    herdBucketOf.resize(n);
+    float midX = 0.0f, midY = 0.0f;
+    for (int i = 0; i < n; i++) {
+        int b = (int)((herd[i].x - HERD_X0) / HERD_BUCKET_W);
+        herdBucketOf[i] = std::max(0, std::min(buckets - 1, b));
+        herdBucketStart[herdBucketOf[i] + 1]++;
+        midX += herd[i].x;
+        midY += herd[i].y;
+    }
+    midX /= n;
+    midY /= n;
+    for (int b = 0; b < buckets; b++) herdBucketStart[b + 1] += herdBucketStart[b];
+    herdBucketCursor.assign(herdBucketStart.begin(), herdBucketStart.end() - 1);
+    for (int i = 0; i < n; i++) herdBucketItems[herdBucketCursor[herdBucketOf[i]]++] = i;
+
+    // ---- 2) states + steering ----
+    for (int i = 0; i < n; i++) {
+        Cow& c = herd[i];
+        float pace = 0.25f * c.scale / 0.55f + 0.05f;
+
+        // neighbours: personal space, and whether anyone is close at all
+        float sepX = 0.0f, sepY = 0.0f;
+        int   near = 0;
+        int   b = herdBucketOf[i];
+        for (int k = herdBucketStart[std::max(0, b - 1)];
+             k < herdBucketStart[std::min(buckets - 1, b + 1) + 1] && near < HERD_MAX_NEIGHBORS; k++) {
+            int j = herdBucketItems[k];
+            if (j == i) continue;
+            float dx = c.x - herd[j].x, dy = (c.y - herd[j].y) * 2.0f;   // the field is shallow
+            float d2 = dx * dx + dy * dy;
+            if (d2 > HERD_NEIGHBOR_R * HERD_NEIGHBOR_R) continue;
+            near++;
+            float room = 40.0f * (c.scale + herd[j].scale);
+            if (d2 < room * room && d2 > 1e-4f) {
+                float inv = 1.0f / std::sqrt(d2);
+                sepX += dx * inv;
+                sepY += dy * inv;
+            }
+        }
+
+        c.timer -= speed;
+        if (c.state != COW_FLOCK && near == 0 && n > 1 &&
+            std::fabs(c.x - midX) + std::fabs(c.y - midY) > 50.0f) {
+            c.state = COW_FLOCK;
+        } else if (c.state == COW_FLOCK && (near > 0 || std::fabs(c.x - midX) + std::fabs(c.y - midY) < 25.0f)) {
+            c.state = COW_GRAZE;
+            c.timer = 200.0f + herdRand() * 400.0f;
+        } else if (c.timer <= 0.0f) {
+            bool wander = c.state == COW_GRAZE && herdRand() < 0.6f;
+            c.state   = wander ? COW_WANDER : COW_GRAZE;
+            c.timer   = wander ? 150.0f + herdRand() * 350.0f : 250.0f + herdRand() * 650.0f;
+            c.heading = herdRand() * 6.2831853f;
+        }
+
+        float wantVx = 0.0f, wantVy = 0.0f;
+        if (c.state == COW_WANDER) {
+            c.heading += (herdRand() - 0.5f) * 0.08f * speed;
+            wantVx = std::cos(c.heading) * pace;
+            wantVy = std::sin(c.heading) * pace * 0.4f;
+        } else if (c.state == COW_FLOCK) {
+            float dx = midX - c.x, dy = midY - c.y;
+            float len = std::sqrt(dx * dx + dy * dy);
+            if (len > 1e-3f) {
+                wantVx = dx / len * pace * 1.4f;
+                wantVy = dy / len * pace * 1.4f;
+            }
+        }
+        wantVx += sepX * 0.05f;
+        wantVy += sepY * 0.02f;
+
+        // fence: push back inside the margin band, and turn the wanderer round
+        float x0, x1, y0, y1;
+        herdBounds(c.scale, x0, x1, y0, y1);
+        if (c.x < x0 + HERD_MARGIN) wantVx += (x0 + HERD_MARGIN - c.x) * 0.02f;
+        if (c.x > x1 - HERD_MARGIN) wantVx -= (c.x - (x1 - HERD_MARGIN)) * 0.02f;
+        if (c.y < y0 + HERD_MARGIN * 0.5f) wantVy += (y0 + HERD_MARGIN * 0.5f - c.y) * 0.02f;
+        if (c.y > y1 - HERD_MARGIN * 0.5f) wantVy -= (c.y - (y1 - HERD_MARGIN * 0.5f)) * 0.02f;
+        if (c.state == COW_WANDER && (c.x <= x0 || c.x >= x1 || c.y <= y0 || c.y >= y1))
+            c.heading = std::atan2(midY - c.y, midX - c.x);
+
+        float blend = std::min(1.0f, 0.08f * speed);
+        c.vx += (wantVx - c.vx) * blend;
+        c.vy += (wantVy - c.vy) * blend;
+    }
+
+    // ---- 3) integrate, gait, facing; keep the draw order ----
+    for (int i = 0; i < n; i++) {
+        Cow& c = herd[i];
+        float x0, x1, y0, y1;
+        herdBounds(c.scale, x0, x1, y0, y1);
+        c.x = std::max(x0, std::min(x1, c.x + c.vx * speed));
+        c.y = std::max(y0, std::min(y1, c.y + c.vy * speed));
+
+        float moved = std::sqrt(c.vx * c.vx + c.vy * c.vy) * speed;
+        if (moved > 0.01f) c.gait += moved * 0.35f / c.scale;
+        else               c.gait = std::floor(c.gait / 3.1415926f + 0.5f) * 3.1415926f;   // stand square
+        if      (c.vx >  0.03f) c.facing = 1;
+        else if (c.vx < -0.03f) c.facing = -1;
+    }
+    std::stable_sort(herd.begin(), herd.end(), [](const Cow& a, const Cow& b) { return a.y > b.y; });
+}
+
+// ---- cow template: the old drawSingleCow() at scale 1, facing right ----
+// kind: 0 rigid, 1 / 2 leg foot (-step / +step), 3 tail (+swing in y)
+struct CowVertex {
+    float x, y;
+    float r, g, b;
+    float kind;
+};
+
+std::vector<CowVertex> cowTemplate;
+
+static void buildCowTemplate() {
+    cowTemplate.clear();
+    float cr = 0, cg = 0, cb = 0;
+    auto color = [&](float r, float g, float b) { cr = r; cg = g; cb = b; };
+    auto vert  = [&](float x, float y, float kind) {
+        CowVertex v = {x, y, cr, cg, cb, kind};
+        cowTemplate.push_back(v);
+    };
+    auto quad = [&](float x0, float y0, float x1, float y1) {
+        vert(x0, y0, 0); vert(x1, y0, 0); vert(x1, y1, 0);
+        vert(x0, y0, 0); vert(x1, y1, 0); vert(x0, y1, 0);
+    };
+    auto ellipse = [&](float cx, float cy, float rx, float ry, int seg, float kind) {
+        for (int i = 0; i < seg; i++) {
+            float a0 = 6.2831853f * i / seg, a1 = 6.2831853f * (i + 1) / seg;
+            vert(cx, cy, kind);
+            vert(cx + rx * std::cos(a0), cy + ry * std::sin(a0), kind);
+            vert(cx + rx * std::cos(a1), cy + ry * std::sin(a1), kind);
+        }
+    };
+    // a line of width w; kind applies to the b end only
+    auto line = [&](float ax, float ay, float bx, float by, float w, float kind) {
+        float dx = bx - ax, dy = by - ay, len = std::sqrt(dx * dx + dy * dy);
+        float nx = -dy / len * w * 0.5f, ny = dx / len * w * 0.5f;
+        vert(ax - nx, ay - ny, 0); vert(ax + nx, ay + ny, 0); vert(bx + nx, by + ny, kind);
+        vert(ax - nx, ay - ny, 0); vert(bx + nx, by + ny, kind); vert(bx - nx, by - ny, kind);
+    };
+
+    color(0.95f, 0.90f, 0.80f);
+    quad(-32, -2, 32, 18);
+    ellipse(-32, 8, 8, 10, 12, 0);
+    ellipse( 32, 8, 8, 10, 12, 0);
+
+    color(0.20f, 0.20f, 0.20f);
+    ellipse(-10, 12, 4, 4, 10, 0);
+    ellipse(  6,  8, 3, 3, 8, 0);
+    ellipse( 16, 14, 3, 3, 8, 0);
+
+    color(0.95f, 0.90f, 0.80f);
+    ellipse(40, 10, 9, 7, 12, 0);
+    color(0.90f, 0.80f, 0.70f);
+    quad(44, 4, 54, 11);
+
+    color(0.0f, 0.0f, 0.0f);
+    ellipse(39, 12, 1.3f, 1.3f, 6, 0);
+    ellipse(43, 12, 1.3f, 1.3f, 6, 0);
+    line(36, 18, 32, 24, 1.5f, 0);          // horns
+    line(44, 18, 48, 24, 1.5f, 0);
+    vert(34, 14, 0); vert(30, 11, 0); vert(32, 17, 0);   // ears
+    vert(46, 14, 0); vert(50, 11, 0); vert(48, 17, 0);
+
+    line(-20, -2, -20, -18, 3.0f, 1);      // legs, alternate pairs
+    line( -5, -2,  -5, -18, 3.0f, 2);
+    line( 10, -2,  10, -18, 3.0f, 1);
+    line( 25, -2,  25, -18, 3.0f, 2);
+
+    line(-32, 16, -40, 22, 3.0f, 3);       // tail
+    ellipse(-40, 22, 2.0f, 2.0f, 8, 3);
+}
+
+// CPU path: the whole herd into one triangle array
+std::vector<float>   herdXY;
+std::vector<GLubyte> herdRGBA;
+
+static int expandHerd() {
+    if (cowTemplate.empty()) buildCowTemplate();
+    const int per = (int)cowTemplate.size();
+    herdXY.resize(herd.size() * per * 2);
+    herdRGBA.resize(herd.size() * per * 4);
+
+    const float t = scene.tick * 0.083f;   // the old personPosition * 0.08 * 1.3
+    float*   xy   = herdXY.data();
+    GLubyte* rgba = herdRGBA.data();
+    for (int i : cowsShown) {
+        const Cow& c = herd[i];
+        float step  = std::sin(c.gait) * 2.5f;
+        float swing = std::sin(t + c.tail) * 3.0f;
+        float sx = c.scale * c.facing, sy = c.scale;
+        for (int v = 0; v < per; v++) {
+            const CowVertex& tv = cowTemplate[v];
+            float y = tv.y;
+            if      (tv.kind == 1.0f) y -= step;
+            else if (tv.kind == 2.0f) y += step;
+            else if (tv.kind == 3.0f) y += swing;
+            xy[0] = c.x + tv.x * sx;
+            xy[1] = c.y + y * sy;
+            rgba[0] = (GLubyte)(tv.r * 255.0f);
+            rgba[1] = (GLubyte)(tv.g * 255.0f);
+            rgba[2] = (GLubyte)(tv.b * 255.0f);
+            rgba[3] = 255;
+            xy   += 2;
+            rgba += 4;
+        }
+    }
+    return (int)cowsShown.size() * per;
+}
+
+// GLSL path: template VBO + the Cow array as per-instance attributes
+ShaderProgram herdProgram;
+GLuint herdVao = 0, herdTemplateVbo = 0, herdInstanceVbo = 0;
+bool   herdShaderReady = false;
+
+static const char* HERD_VS =
+    "layout(location = 0) in vec2 aPos;\n"
+    "layout(location = 1) in vec3 aColor;\n"
+    "layout(location = 2) in float aKind;\n"
+    "layout(location = 3) in vec4 aCow;\n"      // per instance: x, y, scale, gait
+    "layout(location = 4) in float aTail;\n"
+    "layout(location = 5) in float aFacing;\n"
+    "out vec3 vColor;\n"
+    "void main() {\n"
+    "    float step  = sin(aCow.w) * 2.5;\n"
+    "    float swing = sin(uTime * 0.083 + aTail) * 3.0;\n"
+    "    vec2  p = aPos;\n"
+    "    p.y += aKind == 1.0 ? -step : aKind == 2.0 ? step : aKind == 3.0 ? swing : 0.0;\n"
+    "    vColor = aColor;\n"
+    "    gl_Position = sceneToClip(aCow.xy + p * vec2(aCow.z * aFacing, aCow.z));\n"
+    "}\n";
+
+static const char* HERD_FS =
+    "in vec3 vColor;\n"
+    "out vec4 fragColor;\n"
+    "void main() { fragColor = vec4(vColor, 1.0); }\n";
+
+// from initShaders(), with the GL 3.3 entry points loaded
+void initHerdShader() {
+    if (!linkProgram(herdProgram, HERD_VS, HERD_FS)) return;
+    if (cowTemplate.empty()) buildCowTemplate();
+
+    gl3.GenVertexArrays(1, &herdVao);
+    gl3.GenBuffers(1, &herdTemplateVbo);
+    gl3.GenBuffers(1, &herdInstanceVbo);
+    gl3.BindVertexArray(herdVao);
+
+    gl3.BindBuffer(GL_ARRAY_BUFFER, herdTemplateVbo);
+    gl3.BufferData(GL_ARRAY_BUFFER, cowTemplate.size() * sizeof(CowVertex), cowTemplate.data(), GL_STATIC_DRAW);
+    gl3.EnableVertexAttribArray(0);
+    gl3.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(CowVertex), (const void*)offsetof(CowVertex, x));
+    gl3.EnableVertexAttribArray(1);
+    gl3.VertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(CowVertex), (const void*)offsetof(CowVertex, r));
+    gl3.EnableVertexAttribArray(2);
+    gl3.VertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(CowVertex), (const void*)offsetof(CowVertex, kind));
+
+    gl3.BindBuffer(GL_ARRAY_BUFFER, herdInstanceVbo);
+    gl3.EnableVertexAttribArray(3);
+    gl3.VertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Cow), (const void*)offsetof(Cow, x));
+    gl3.EnableVertexAttribArray(4);
+    gl3.VertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Cow), (const void*)offsetof(Cow, tail));
+    gl3.EnableVertexAttribArray(5);
+    gl3.VertexAttribPointer(5, 1, GL_BYTE, GL_FALSE, sizeof(Cow), (const void*)offsetof(Cow, facing));
+    for (int a = 3; a <= 5; a++) gl3.VertexAttribDivisor(a, 1);
+
+    gl3.BindVertexArray(0);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, 0);
+    herdShaderReady = true;
+}
+
+void drawHerd() {
+    if (cowsShown.empty()) return;
+
+    for (int i : cowsShown) {
+        const Cow& c = herd[i];
+        addShadow(c.x, c.y - 20.0f * c.scale, 26.0f * c.scale, 7.0f * c.scale, 0.30f);
+    }
+
+    if (shaderPathActive() && herdShaderReady) {
+        // the herd array is the instance buffer; only packed when some are off view
+        static std::vector<Cow> packed;
+        const Cow* cows = herd.data();
+        if (cowsShown.size() < herd.size()) {
+            packed.clear();
+            for (int i : cowsShown) packed.push_back(herd[i]);
+            cows = packed.data();
+        }
+        gl3.BindBuffer(GL_ARRAY_BUFFER, herdInstanceVbo);
+        gl3.BufferData(GL_ARRAY_BUFFER, cowsShown.size() * sizeof(Cow), cows, GL_STREAM_DRAW);
+        gl3.BindBuffer(GL_ARRAY_BUFFER, 0);
+        useSceneProgram(herdProgram);
+        gl3.BindVertexArray(herdVao);
+        gl3.DrawArraysInstanced(GL_TRIANGLES, 0, (GLsizei)cowTemplate.size(), (GLsizei)cowsShown.size());
+        endSceneProgram();
+        return;
+    }
+
+    int n = expandHerd();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, herdXY.data());
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, herdRGBA.data());
+    glDrawArrays(GL_TRIANGLES, 0, n);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// Crop field + cows + wooden fence
+void drawFieldAndCow() {
+    float x1 = 80.0f;
+    float y1 = 40.0f;
+    float x2 = 320.0f;
+    float y2 = 110.0f;
+
+    surfaceMask(MASK_GROUND);
+    glColor3f(0.20f, 0.45f, 0.15f);
+    glBegin(GL_QUADS);
+    glVertex2f(x1, y1);
+    glVertex2f(x2, y1);
+    glVertex2f(x2, y2);
+    glVertex2f(x1, y2);
+    glEnd();
+
+    glColor3f(0.25f, 0.60f, 0.18f);
+    glLineWidth(1.0f);
+    glBegin(GL_LINES);
+    for (float x = x1 + 6; x < x2; x += 8) {
+        glVertex2f(x, y1);
+        glVertex2f(x, y2);
+    }
+    glEnd();
+    surfaceMask(MASK_OBJECT);
+
+    // Fence around field
+    glColor3f(0.55f, 0.35f, 0.18f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINES);
+        glVertex2f(x1 - 6, y2 + 4);
+        glVertex2f(x2 + 6, y2 + 4);
+    glEnd();
+    for (float x = x1 - 6; x <= x2 + 6; x += 20.0f) {
+        glBegin(GL_LINES);
+            glVertex2f(x, y2 + 4);
+            glVertex2f(x, y2 + 18);
+        glEnd();
+    }
+
+    drawHerd();
+}
+
+// Bus stop on roadside
+// Bus stop (NO text/board) - compact shelter + bench + waiting person
+void drawBusStop() {
+    float x     = 600.0f;   // move left/right
+    float baseY = 282.0f;   // near road top
+
+    // ---------- platform ----------
+    surfaceMask(MASK_GROUND);
+    matColor(MAT_PLATFORM);
+    glBegin(GL_QUADS);
+        glVertex2f(x - 70, baseY - 6);
+        glVertex2f(x + 70, baseY - 6);
+        glVertex2f(x + 70, baseY + 6);
+        glVertex2f(x - 70, baseY + 6);
+    glEnd();
+    surfaceMask(MASK_OBJECT);
+
+    // ---------- pillars ----------
+    matColor(MAT_SHELTER_PILLAR);
+    glBegin(GL_QUADS);
+        glVertex2f(x - 48, baseY + 6);
+        glVertex2f(x - 42, baseY + 6);
+        glVertex2f(x - 42, baseY + 52);
+        glVertex2f(x - 48, baseY + 52);
+
+        glVertex2f(x + 42, baseY + 6);
+        glVertex2f(x + 48, baseY + 6);
+        glVertex2f(x + 48, baseY + 52);
+        glVertex2f(x + 42, baseY + 52);
+    glEnd();
+
+    // ---------- back panel (semi-transparent so house visible) ----------
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    matColor(MAT_SHELTER_PANEL);
+    glBegin(GL_QUADS);
+        glVertex2f(x - 55, baseY + 12);
+        glVertex2f(x + 55, baseY + 12);
+        glVertex2f(x + 55, baseY + 45);
+        glVertex2f(x - 55, baseY + 45);
+    glEnd();
+    glDisable(GL_BLEND);
+
+    // ---------- roof ----------
+    matColor(MAT_SHELTER_ROOF);
+    glBegin(GL_POLYGON);
+        glVertex2f(x - 62, baseY + 52);
+        glVertex2f(x + 62, baseY + 52);
+        glVertex2f(x + 56, baseY + 62);
+        glVertex2f(x - 68, baseY + 62);
+    glEnd();
+
+    // ---------- bench ----------
+    matColor(MAT_BENCH);
+    glBegin(GL_QUADS);
+        glVertex2f(x - 35, baseY + 14);
+        glVertex2f(x + 25, baseY + 14);
+        glVertex2f(x + 25, baseY + 20);
+        glVertex2f(x - 35, baseY + 20);
+    glEnd();
+
+    // ---------- waiting person ----------
+    float px = x - 5;
+    float py = baseY + 6;
+
+    addShadow(px, py - 3.0f, 9.0f, 3.0f, 0.35f);
+
+    glColor3f(1.0f, 0.9f, 0.8f);
+    drawCircle(px, py + 20.0f, 5.0f, 18);
+
+    glColor3f(0.1f, 0.4f, 0.9f);
+    glLineWidth(3.0f);
+    glBegin(GL_LINES);
+        glVertex2f(px, py + 16); glVertex2f(px, py + 6);
+        glVertex2f(px, py + 12); glVertex2f(px - 6, py + 8);
+        glVertex2f(px, py + 12); glVertex2f(px + 6, py + 8);
+        glVertex2f(px, py + 6);  glVertex2f(px - 4, py);
+        glVertex2f(px, py + 6);  glVertex2f(px + 4, py);
+    glEnd();
+}
+
+
+// Hot air balloon in sky
+void drawHotAirBalloon() {
+    if (!cullShown[CO_BALLOON]) return;
+    float bx = std::fmod(balloonPosition, WIDTH + 300.0f) - 150.0f;
+    float by = 520.0f + 18.0f * std::sin(balloonPosition * 0.01f);
+
+    glPushMatrix();
+    glTranslatef(bx, by, 0.0f);
+
+    glColor3f(0.95f, 0.4f, 0.4f);
+    drawCircle(0.0f, 0.0f, 22.0f);
+
+    glColor3f(0.9f, 0.8f, 0.2f);
+    glBegin(GL_TRIANGLES);
+    glVertex2f(-12, -6);
+    glVertex2f(12, -6);
+    glVertex2f(0, -24);
+    glEnd();
+
+    glColor3f(0.3f, 0.2f, 0.1f);
+    glBegin(GL_LINES);
+    glVertex2f(-6, -18);
+    glVertex2f(-6, -30);
+    glVertex2f(6, -18);
+    glVertex2f(6, -30);
+    glEnd();
+
+    glColor3f(0.6f, 0.4f, 0.2f);
+    glBegin(GL_QUADS);
+    glVertex2f(-10, -30);
+    glVertex2f(10, -30);
+    glVertex2f(8, -40);
+    glVertex2f(-8, -40);
+    glEnd();
+
+    glPopMatrix();
+}
+
+// Fireflies at night
+void drawFireflies() {
+    if (isDay || dayNightBlend > 0.4f) return;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glPointSize(3.0f);
+    glBegin(GL_POINTS);
+    for (int i = 0; i < 40; ++i) {
+        float x = 120.0f + (i * 37) % (WIDTH - 240);
+        float y = 290.0f + (i * 23) % 80;
+
+        float phase = sunAngle * 10.0f + i * 0.4f;
+        float a = 0.2f + 0.4f * (std::sin(phase) * 0.5f + 0.5f);
+
+        glColor4f(1.0f, 1.0f, 0.6f, a);
+        glVertex2f(x, y);
+        addLight(x, y, LIGHT_SMALL, 1.0f, 1.0f, 0.6f, a * 0.6f);
+    }
+    glEnd();
+
+    glDisable(GL_BLEND);
+}
+
+// bulb colours; each bulb is drawn and lit from the same entry (no GL readback)
+static const float FESTIVAL_BULB[3][3] = {{1.0f, 0.3f, 0.3f}, {0.3f, 1.0f, 0.3f}, {1.0f, 1.0f, 0.3f}};
+
+// Festival decorative lights (DDA wire)
+void drawFestivalLights() {
+    if (!festivalMode || isDay) return;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    float y     = 330.0f;
+    int   cycle = (int)(sunAngle * 4);
+
+    for (int h = 0; h < 2; ++h) {
+        float startX = 110.0f + h * 200.0f;
+        float endX   = startX + 90.0f;
+
+        // ------------------ WIRE (catenary, drawn with the front cables) ------------------
+        setCable(garlandWire[h], startX, y, endX, y);
+
+        // ------------------ BULBS hung along the wire ------------------
+        for (int i = 0; i <= 6; ++i) {
+            float t  = i / 6.0f;
+            float x  = startX + t * (endX - startX);
+            float yy = cableHeightAt(garlandWire[h], x);
+
+            const float* c = FESTIVAL_BULB[(i + cycle) % 3];
+            glColor4f(c[0], c[1], c[2], 0.9f);
+            addLight(x, yy, LIGHT_SMALL, c[0], c[1], c[2], 1.4f);
+
+            // drawCircle(x, yy, 3.0f);
+            glPointSize(2.0f);
+            drawCircleMidpoint((int)x, (int)yy, 3);
+
+        }
+    }
+
+    glDisable(GL_BLEND);
+}
+
+
+// Electric poles + wires behind houses
+void drawElectricPolesAndWires() {
+    float yBase      = 360.0f;
+    float poleHeight = 70.0f;
+    float wireY      = yBase + poleHeight - 10.0f;
+
+    matColor(MAT_POLE);
+    for (int i = 0; i < POLE_COUNT; ++i) {
+        float x = POLE_X[i];
+        glBegin(GL_QUADS);
+            glVertex2f(x - 4, yBase);
+            glVertex2f(x + 4, yBase);
+            glVertex2f(x + 4, yBase + poleHeight);
+            glVertex2f(x - 4, yBase + poleHeight);
+        glEnd();
+
+        glBegin(GL_QUADS);
+            glVertex2f(x - 12, yBase + poleHeight);
+            glVertex2f(x + 12, yBase + poleHeight);
+            glVertex2f(x + 12, yBase + poleHeight + 6);
+            glVertex2f(x - 12, yBase + poleHeight + 6);
+        glEnd();
+    }
+
+    // wires hang from pole to pole (fixed anchors: re-tessellated only in wind)
+    for (int i = 0; i + 1 < POLE_COUNT; ++i) {
+        float x0 = POLE_X[i], x1 = POLE_X[i + 1];
+        setCable(powerLine[i], x0, wireY + std::sin(x0 * 0.01f) * 4.0f,
+                               x1, wireY + std::sin(x1 * 0.01f) * 4.0f);
+    }
+    drawCables(CABLE_BACK);
+}
+
+// Simple playground with seesaw + 2 kids (uses swingAngle)
+void drawPlayground() {
+    float sx = 900.0f;
+    float sy = 70.0f;
+
+    // ===================== SAND / GROUND PAD =====================
+    // shadow under pad: drawn now, before the pad covers it (the pad is
+    // ground, so a batched shadow would land on top of the sand)
+    drawShadowNow(sx, sy - 24, 95, 12, 0.22f);
+
+    // sand gradient
+    surfaceMask(MASK_GROUND);
+    glBegin(GL_QUADS);
+        glColor3f(0.92f, 0.84f, 0.55f);
+        glVertex2f(sx - 105, sy - 28);
+        glVertex2f(sx + 105, sy - 28);
+
+        glColor3f(0.85f, 0.75f, 0.46f);
+        glVertex2f(sx + 105, sy + 14);
+        glVertex2f(sx - 105, sy + 14);
+    glEnd();
+
+    // border frame
+    glColor3f(0.45f, 0.30f, 0.16f);
+    glLineWidth(2.5f);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(sx - 105, sy - 28);
+        glVertex2f(sx + 105, sy - 28);
+        glVertex2f(sx + 105, sy + 14);
+        glVertex2f(sx - 105, sy + 14);
+    glEnd();
+
+    // tiny sand dots
+    glPointSize(2.0f);
+    glBegin(GL_POINTS);
+    for (int i = 0; i < 110; i++) {
+        float x = (i * 29) % 190 - 95;   // -95..95
+        float y = (i * 17) % 34 - 24;    // -24..10
+        float c = 0.86f + (i % 3) * 0.03f;
+        glColor3f(c, c * 0.98f, c * 0.85f);
+        glVertex2f(sx + x, sy + y);
+    }
+    glEnd();
+    surfaceMask(MASK_OBJECT);
+
+    // ===================== SEESAW SUPPORT (TRIANGLE + METAL BAR) =====================
+    // support shadow
+    addShadow(sx, sy - 12, 26, 7, 0.28f);
+
+    // wooden triangle support
+    glColor3f(0.48f, 0.30f, 0.18f);
+    glBegin(GL_TRIANGLES);
+        glVertex2f(sx - 14, sy - 20);
+        glVertex2f(sx + 14, sy - 20);
+        glVertex2f(sx,      sy + 2);
+    glEnd();
 
-    // ✅ wake first (so it stays under boat)
-    drawBoatWake(boatX, boatY);
+    // highlight on support
+    glColor3f(0.62f, 0.42f, 0.25f);
+    glBegin(GL_TRIANGLES);
+        glVertex2f(sx - 6,  sy - 18);
+        glVertex2f(sx + 6,  sy - 18);
+        glVertex2f(sx,      sy - 2);
+    glEnd();
+
+    // center metal pivot bar
+    glColor3f(0.25f, 0.25f, 0.28f);
+    glBegin(GL_QUADS);
+        glVertex2f(sx - 18, sy + 2);
+        glVertex2f(sx + 18, sy + 2);
+        glVertex2f(sx + 18, sy + 6);
+        glVertex2f(sx - 18, sy + 6);
+    glEnd();
 
-    // reflection in water
-    drawBoatWaterReflection(boatX, boatY);
+    // pivot bolt
+    glColor3f(0.75f, 0.75f, 0.78f);
+    drawCircle(sx, sy + 4, 3.2f, 18);
+    glColor3f(0.25f, 0.25f, 0.25f);
+    drawCircle(sx, sy + 4, 1.2f, 14);
 
-    // boat on top
-    drawBoat(boatX, boatY);
+    // ===================== SEESAW PLANK (ROTATE WITH swingAngle) =====================
+    float angle = swingAngle * 0.85f;
+
+    glPushMatrix();
+    glTranslatef(sx, sy + 6.0f, 0.0f);
+    glRotatef(angle, 0, 0, 1);
+
+    // plank shadow (under it)
+    glColor3f(0.15f, 0.12f, 0.10f);
+    glLineWidth(8.0f);
+    glBegin(GL_LINES);
+        glVertex2f(-78, -6);
+        glVertex2f( 78, -6);
+    glEnd();
+
+    // plank (wood) with shading
+    glBegin(GL_QUADS);
+        glColor3f(0.78f, 0.58f, 0.32f);
+        glVertex2f(-80,  4);
+        glVertex2f( 80,  4);
+
+        glColor3f(0.62f, 0.44f, 0.22f);
+        glVertex2f( 80, -6);
+        glVertex2f(-80, -6);
+    glEnd();
+
+    // plank outline
+    glColor3f(0.20f, 0.15f, 0.10f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(-80,  4);
+        glVertex2f( 80,  4);
+        glVertex2f( 80, -6);
+        glVertex2f(-80, -6);
+    glEnd();
+
+    // seats (left & right)
+    auto seat = [&](float x) {
+        glColor3f(0.20f, 0.22f, 0.24f);
+        glBegin(GL_QUADS);
+            glVertex2f(x - 12,  5);
+            glVertex2f(x + 12,  5);
+            glVertex2f(x + 10,  11);
+            glVertex2f(x - 10,  11);
+        glEnd();
+
+        // seat highlight
+        glColor3f(0.45f, 0.48f, 0.52f);
+        glBegin(GL_LINES);
+            glVertex2f(x - 9, 9);
+            glVertex2f(x + 9, 9);
+        glEnd();
+    };
+    seat(-65);
+    seat( 65);
+
+    // handles
+    glColor3f(0.85f, 0.20f, 0.20f);
+    glLineWidth(3.5f);
+    glBegin(GL_LINES);
+        glVertex2f(-70, 12); glVertex2f(-58, 12);
+        glVertex2f( 58, 12); glVertex2f( 70, 12);
+    glEnd();
+
+    // ===================== KIDS (MORE REALISTIC SIMPLE) =====================
+    auto kid = [&](float x, float headY, float shirtR, float shirtG, float shirtB) {
+        // head
+        glColor3f(1.0f, 0.9f, 0.8f);
+        drawCircle(x, headY, 5.2f, 18);
+
+        // body (shirt)
+        glColor3f(shirtR, shirtG, shirtB);
+        glBegin(GL_QUADS);
+            glVertex2f(x - 4.5f, headY - 6);
+            glVertex2f(x + 4.5f, headY - 6);
+            glVertex2f(x + 6.0f, headY - 18);
+            glVertex2f(x - 6.0f, headY - 18);
+        glEnd();
+
+        // arms
+        glColor3f(shirtR * 0.85f, shirtG * 0.85f, shirtB * 0.85f);
+        glLineWidth(2.5f);
+        glBegin(GL_LINES);
+            glVertex2f(x, headY - 10); glVertex2f(x - 9, headY - 14);
+            glVertex2f(x, headY - 10); glVertex2f(x + 9, headY - 14);
+        glEnd();
+
+        // legs
+        glColor3f(0.10f, 0.10f, 0.12f);
+        glLineWidth(3.0f);
+        glBegin(GL_LINES);
+            glVertex2f(x - 2, headY - 18); glVertex2f(x - 7, headY - 30);
+            glVertex2f(x + 2, headY - 18); glVertex2f(x + 7, headY - 30);
+        glEnd();
+
+        // shoes
+        glColor3f(0.05f, 0.05f, 0.05f);
+        drawCircle(x - 7, headY - 30, 2.2f, 14);
+        drawCircle(x + 7, headY - 30, 2.2f, 14);
+    };
+
+    float kidBase = 24.0f;
+    kid(-65, kidBase, 0.20f, 0.65f, 0.95f);  // left kid (blue)
+    kid( 65, kidBase, 0.90f, 0.35f, 0.35f);  // right kid (red)
+
+    glPopMatrix();
 }
 
 
-void drawBirds() {
-    if (!showBirds) return;
+// Kite in sky
+void drawKite() {
+    if (!cullShown[CO_KITE]) return;
+    float tx = std::fmod(kitePosition, WIDTH + 200.0f) - 100.0f;
+    float ty = 520.0f + 15.0f * std::sin(kitePosition * 0.03f);
 
-    const int numBirds    = 6;
-    const int birdsPerRow = 3;      // 3 birds per row
-    const float spacingX  = 45.0f;  // left-right spacing
-    const float rowGapY   = 28.0f;  // top-bottom row gap
-    const float rowBackX  = 25.0f;  // 2nd row slightly behind (more realistic)
+    // ✅ BIG values for clear demo
+    float sx  = useScaleT ? 1.8f : 1.0f;
+    float sy  = useScaleT ? 1.8f : 1.0f;
 
-    float flockX = std::fmod(birdOffset * 1.5f, WIDTH + 200.0f) - 100.0f;
+    float rot = useRotateT ? (std::sin(kitePosition * 0.02f) * 60.0f) : 0.0f;
 
-    for (int i = 0; i < numBirds; i++) {
+    // ✅ Reflection always ON when toggle is ON (no random flip)
+    bool refX = false;
+    bool refY = useReflectT;
 
-        // ---- 2-row formation (3 birds each row) ----
-        int row = i / birdsPerRow;   // 0 or 1
-        int col = i % birdsPerRow;   // 0,1,2
+    // ✅ BIG shear values so V is clearly visible
+    float shx = useShearT ? 0.90f : 0.0f;
+    float shy = useShearT ? 0.40f : 0.0f;
 
-        float bx = flockX + col * spacingX - row * rowBackX;
-        float by = 540.0f - row * rowGapY
-                 + std::sin(birdOffset * 0.08f + i * 0.5f) * 12.0f;
+    // ✅ bigger diamond for better visibility
+    Vec2 top    = {  0,  28 };
+    Vec2 right  = { 22,   0 };
+    Vec2 bottom = {  0, -28 };
+    Vec2 left   = { -22,  0 };
 
-        float scale = 0.8f + 0.1f * (i % 3);
-        float flap  = std::sin(birdOffset * 0.30f + i * 0.8f) * 25.0f;
+    Vec2 T = applyAllTransforms(top,    sx, sy, rot, refX, refY, shx, shy, tx, ty);
+    Vec2 R = applyAllTransforms(right,  sx, sy, rot, refX, refY, shx, shy, tx, ty);
+    Vec2 B = applyAllTransforms(bottom, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+    Vec2 L = applyAllTransforms(left,   sx, sy, rot, refX, refY, shx, shy, tx, ty);
 
-        glPushMatrix();
-        glTranslatef(bx, by, 0.0f);
-        glScalef(scale, scale, 1.0f);
+    // ✅ Two different colors (so Reflection C is obvious)
+    // Right half (red)
+    glColor3f(1.0f, 0.25f, 0.25f);
+    glBegin(GL_TRIANGLES);
+        glVertex2f(T.x, T.y);
+        glVertex2f(R.x, R.y);
+        glVertex2f(B.x, B.y);
+    glEnd();
+
+    // Left half (blue)
+    glColor3f(0.25f, 0.65f, 1.0f);
+    glBegin(GL_TRIANGLES);
+        glVertex2f(T.x, T.y);
+        glVertex2f(B.x, B.y);
+        glVertex2f(L.x, L.y);
+    glEnd();
+
+    // Outline (black)
+    glColor3f(0.08f, 0.08f, 0.08f);
+    glLineWidth(2.0f);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(T.x, T.y);
+        glVertex2f(R.x, R.y);
+        glVertex2f(B.x, B.y);
+        glVertex2f(L.x, L.y);
+    glEnd();
+
+    // Cross stick (single line)
+    Vec2 stickL = { -20, 0 };
+    Vec2 stickR = {  20, 0 };
+    stickL = applyAllTransforms(stickL, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+    stickR = applyAllTransforms(stickR, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+
+    glColor3f(0.95f, 0.85f, 0.25f);
+    glLineWidth(3.0f);
+    glBegin(GL_LINES);
+        glVertex2f(stickL.x, stickL.y);
+        glVertex2f(stickR.x, stickR.y);
+    glEnd();
+
+    // ✅ Asymmetric sticker on RIGHT side (Reflection moves it to LEFT)
+    Vec2 s1 = {  8,  10 };
+    Vec2 s2 = { 16,  10 };
+    Vec2 s3 = { 16,   2 };
+    Vec2 s4 = {  8,   2 };
+
+    s1 = applyAllTransforms(s1, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+    s2 = applyAllTransforms(s2, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+    s3 = applyAllTransforms(s3, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+    s4 = applyAllTransforms(s4, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+
+    glColor3f(0.10f, 0.95f, 0.30f); // green
+    glBegin(GL_QUADS);
+        glVertex2f(s1.x, s1.y);
+        glVertex2f(s2.x, s2.y);
+        glVertex2f(s3.x, s3.y);
+        glVertex2f(s4.x, s4.y);
+    glEnd();
+
+    // ✅ Tail (offset) -> reflection very clear
+    Vec2 tailA = { 10, -28 };
+    Vec2 tailB = { 20, -75 };
+
+    tailA = applyAllTransforms(tailA, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+    tailB = applyAllTransforms(tailB, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+
+    glColor3f(0.95f, 0.85f, 0.25f);
+    glLineWidth(2.5f);
+    glBegin(GL_LINES);
+        glVertex2f(tailA.x, tailA.y);
+        glVertex2f(tailB.x, tailB.y);
+    glEnd();
+}
+
+
+
+
+// // Welcome sign board
+// void drawWelcomeSign() {
+//     float x     = 80.0f;
+//     float baseY = 260.0f;
 
-        float br = isDay ? 0.22f : 0.12f;
-        float bg = isDay ? 0.22f : 0.12f;
-        float bb = isDay ? 0.28f : 0.20f;
-        glColor3f(br, bg, bb);
-        drawEllipse(0.0f, 0.0f, 10.0f, 6.0f, 24);
+//     glColor3f(0.4f, 0.25f, 0.12f);
+//     glBegin(GL_QUADS);
+//         glVertex2f(x - 4, baseY);
+//         glVertex2f(x + 4, baseY);
+//         glVertex2f(x + 4, baseY + 40);
+//         glVertex2f(x - 4, baseY + 40);
+//     glEnd();
 
-        glColor3f(0.50f, 0.50f, 0.55f);
-        drawEllipse(2.0f, -1.0f, 6.0f, 3.0f, 20);
+//     glColor3f(0.9f, 0.8f, 0.2f);
+//     glBegin(GL_QUADS);
+//         glVertex2f(x - 70, baseY + 40);
+//         glVertex2f(x + 70, baseY + 40);
+//         glVertex2f(x + 70, baseY + 70);
+//         glVertex2f(x - 70, baseY + 70);
+//     glEnd();
 
-        glColor3f(0.24f, 0.24f, 0.28f);
-        drawCircle(9.0f, 3.0f, 4.0f, 18);
+//     glColor3f(0.0f, 0.0f, 0.0f);
+//     glRasterPos2f(x - 60, baseY + 55);
+//     const char* msg = "WELCOME TO VILLAGE";
+//     for (int i = 0; msg[i] != '\0'; ++i) {
+//         glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, msg[i]);
+//     }
+// }
 
-        glColor3f(1.0f, 1.0f, 1.0f);
-        drawCircle(10.0f, 3.0f, 1.1f, 12);
-        glColor3f(0.0f, 0.0f, 0.0f);
-        drawCircle(10.4f, 3.0f, 0.6f, 10);
+// Well near a house
+void drawWell(float x, float y) {
+    matColor(MAT_WELL_STONE);
+    glBegin(GL_QUADS);
+        glVertex2f(x - 18, y);
+        glVertex2f(x + 18, y);
+        glVertex2f(x + 18, y + 25);
+        glVertex2f(x - 18, y + 25);
+    glEnd();
 
-        glColor3f(0.95f, 0.65f, 0.10f);
-        glBegin(GL_TRIANGLES);
-            glVertex2f(12.5f, 2.0f);
-            glVertex2f(16.0f, 3.5f);
-            glVertex2f(12.5f, 5.0f);
-        glEnd();
+    matColor(MAT_WELL_RIM);
+    drawEllipse(x, y + 25, 18.0f, 6.0f, 24);
+    matColor(MAT_WELL_WATER);
+    drawEllipse(x, y + 22, 14.0f, 4.0f, 24);
 
-        glColor3f(0.16f, 0.16f, 0.20f);
-        glBegin(GL_TRIANGLES);
-            glVertex2f(-10.0f, 1.0f);
-            glVertex2f(-18.0f, 6.0f);
-            glVertex2f(-15.0f, -2.0f);
-        glEnd();
+    matColor(MAT_WELL_WOOD);
+    glBegin(GL_LINES);
+        glVertex2f(x - 16, y + 25);
+        glVertex2f(x - 16, y + 55);
+        glVertex2f(x + 16, y + 25);
+        glVertex2f(x + 16, y + 55);
+        glVertex2f(x - 16, y + 55);
+        glVertex2f(x + 16, y + 55);
+    glEnd();
 
-        glPushMatrix();
-        glTranslatef(0.0f, 4.0f, 0.0f);
-        glRotatef(flap, 0.0f, 0.0f, 1.0f);
-        glColor3f(0.30f, 0.30f, 0.35f);
-        glBegin(GL_TRIANGLES);
-            glVertex2f(-2.0f, 0.0f);
-            glVertex2f(12.0f, 6.0f);
-            glVertex2f(4.0f, -2.0f);
-        glEnd();
-        glPopMatrix();
+    glBegin(GL_LINES);
+        glVertex2f(x, y + 55);
+        glVertex2f(x, y + 35);
+    glEnd();
 
-        glPopMatrix();
-    }
+    drawCircle(x, y + 33, 2.0f);
 }
 
-
 // ============================================================================
-// STRUCTURES
+// WEATHER EFFECTS
 // ============================================================================
+void drawRain() {
+    if (!isRaining) return;
 
-void drawWindmill(float x, float y) {
-    glColor3f(0.5f, 0.3f, 0.2f);
-    glBegin(GL_QUADS);
-    glVertex2f(x - 18, y);
-    glVertex2f(x + 18, y);
-    glVertex2f(x + 18, y + 120);
-    glVertex2f(x - 18, y + 120);
-    glEnd();
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glColor3f(0.6f, 0.4f, 0.3f);
-    glBegin(GL_TRIANGLES);
-    glVertex2f(x - 35, y + 120);
-    glVertex2f(x + 35, y + 120);
-    glVertex2f(x, y + 160);
+    // wind slant
+    float slant = 10.0f * windIntensity;   // increase with wind
+
+    // -------- FAR LAYER (thin, faint) --------
+    glColor4f(0.80f, 0.85f, 1.0f, 0.22f);
+    glLineWidth(1.0f);
+    glBegin(GL_LINES);
+    for (int i = 0; i < 260; i++) {
+        float x = (i * 37) % WIDTH;
+        float y = std::fmod((float)(i * 61) - rainOffset * 0.7f + HEIGHT, (float)HEIGHT);
+        glVertex2f(x, y);
+        glVertex2f(x + slant * 0.6f, y - 14.0f);
+    }
     glEnd();
 
-    glPushMatrix();
-    glTranslatef(x, y + 140, 0);
-    glRotatef(windmillAngle * windIntensity, 0, 0, 1);
+    // -------- MID LAYER --------
+    glColor4f(0.85f, 0.88f, 1.0f, 0.45f);
+    glLineWidth(1.5f);
+    glBegin(GL_LINES);
+    for (int i = 0; i < 320; i++) {
+        float x = (i * 29) % WIDTH;
+        float y = std::fmod((float)(i * 47) - rainOffset + HEIGHT, (float)HEIGHT);
 
-    glColor3f(0.9f, 0.9f, 0.8f);
-    for (int i = 0; i < 4; i++) {
-        glPushMatrix();
-        glRotatef(90.0f * i, 0, 0, 1);
-        glBegin(GL_TRIANGLES);
-        glVertex2f(0, 0);
-        glVertex2f(0, 80);
-        glVertex2f(12, 80);
-        glEnd();
-        glPopMatrix();
+        float len = 18.0f + (i % 5) * 2.5f;     // different length
+        glVertex2f(x, y);
+        glVertex2f(x + slant * 0.8f, y - len);
     }
+    glEnd();
 
-    glPopMatrix();
-}
+    // -------- NEAR LAYER (bright, thick) --------
+    glColor4f(0.90f, 0.90f, 1.0f, 0.70f);
+    glLineWidth(2.2f);
+    glBegin(GL_LINES);
+    for (int i = 0; i < 180; i++) {
+        float x = (i * 53 + 120) % WIDTH;
+        float y = std::fmod((float)(i * 83) - rainOffset * 1.3f + HEIGHT, (float)HEIGHT);
 
-void drawStreetLight(float x, float y) {
-    glColor3f(0.25f, 0.25f, 0.25f);
-    glBegin(GL_QUADS);
-    glVertex2f(x - 4, y);
-    glVertex2f(x + 4, y);
-    glVertex2f(x + 4, y + 70);
-    glVertex2f(x - 4, y + 70);
+        float len = 26.0f + (i % 4) * 4.0f;
+        glVertex2f(x, y);
+        glVertex2f(x + slant, y - len);
+    }
     glEnd();
 
-    glColor3f(0.35f, 0.35f, 0.35f);
-    glBegin(GL_QUADS);
-    glVertex2f(x - 12, y + 70);
-    glVertex2f(x + 12, y + 70);
-    glVertex2f(x + 12, y + 85);
-    glVertex2f(x - 12, y + 85);
-    glEnd();
+    // -------- SPLASH (near ground & river line) --------
+    glPointSize(2.0f);
+    glBegin(GL_POINTS);
+    for (int i = 0; i < 120; i++) {
+        float x = (i * 41) % WIDTH;
 
-    if (!isDay && showLights) {
-        float intensity = 1.0f - dayNightBlend;
+        // splash on ground area (around y=200..260) and river edges (110..190)
+        float y;
+        if (i % 2 == 0) y = 200.0f + (i % 25);   // footpath/road zone
+        else           y = 118.0f + (i % 60);    // river zone
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glColor4f(0.90f, 0.95f, 1.0f, 0.45f);
+        glVertex2f(x, y);
+        glVertex2f(x + 2, y + 1);
+    }
+    glEnd();
 
-        glColor4f(1.0f, 1.0f, 0.7f, 0.12f * intensity);
-        for (int i = 2; i >= 0; --i) {
-            drawCircle(x, y + 60, 16 + i * 6);
-        }
+    glDisable(GL_BLEND);
+}
 
-        glColor4f(1.0f, 1.0f, 0.6f, 0.85f * intensity);
-        drawCircle(x, y + 60, 8);
+// ============================================================================
+// NAVIGATION GRID + FLOW FIELDS (where walkers can go, and how to get there)
+// The ground (y 0..384) is rasterised once into 4 px cells from the scene
+// layout: the river (except the dock planks), the road (except the zebra
+// crossing), the rail track, the house fronts, the well and the field fence
+// are blocked. For every destination a Dijkstra sweep out from the goal
+// cells (8 neighbours, costs 10 / 14, no corner cutting) leaves each cell
+// the direction of its cheapest neighbour, so an agent steers with a single
+// lookup whatever the number of agents sharing the destination.
+// The fields are baked on worker threads at start-up, like the cloud atlas,
+// and joined the first time the crowd needs one.
+// The field is south of the river with no way across, so it is a region of
+// its own; no walker is ever routed into it, and there is no field
+// destination. The herd does not use the grid either: inside the fence
+// rectangle a flow field is just a straight heading, which is what the
+// herd's own steering (COW HERD) already does.
+// ============================================================================
 
-        glDisable(GL_BLEND);
-    } else {
-        glColor3f(0.9f, 0.9f, 0.7f);
-        drawCircle(x, y + 60, 5);
+enum NavDest { NAV_FOOTPATH, NAV_BUS_STOP, NAV_WELL, NAV_DOCK, NAV_HOUSE0,
+               NAV_HOUSES = 6, NAV_DEST_COUNT = NAV_HOUSE0 + NAV_HOUSES };
+enum NavCell { NAV_BLOCKED, NAV_OPEN, NAV_CROSSING };
+
+const int     NAV_CELL     = 4;
+const int     NAV_COLS     = WIDTH / NAV_CELL;
+const int     NAV_ROWS     = 384 / NAV_CELL;   // ground only
+const uint8_t NAV_AT_GOAL  = 8;
+const uint8_t NAV_NO_PATH  = 255;
+const float   NAV_CROSS_X0 = 548.0f;           // zebra crossing (drawRoad)
+const float   NAV_CROSS_X1 = 572.0f;
+
+static const int   NAV_DX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+static const int   NAV_DY[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+static const float NAV_UX[8] = {1.0f, 0.7071f, 0.0f, -0.7071f, -1.0f, -0.7071f, 0.0f, 0.7071f};
+static const float NAV_UY[8] = {0.0f, 0.7071f, 1.0f, 0.7071f, 0.0f, -0.7071f, -1.0f, -0.7071f};
+
+std::vector<uint8_t>     navGrid;                   // NavCell per cell
+std::vector<uint8_t>     navFlow[NAV_DEST_COUNT];   // 0..7, NAV_AT_GOAL or NAV_NO_PATH
+std::vector<std::thread> navWorkers;
+bool navReady = false;
+
+struct NavRect { float x0, y0, x1, y1; };
+
+// houses as placed in drawVillageScene(): left edge, width, door centre
+static const float NAV_HOUSE[NAV_HOUSES][3] = {
+    {  80.0f, 120.0f, 60.0f}, { 290.0f, 105.0f, 52.0f}, { 500.0f, 140.0f, 70.0f},
+    { 710.0f, 105.0f, 52.0f}, { 920.0f, 120.0f, 60.0f}, {1130.0f, 140.0f, 70.0f}
+};
+
+// where a walker's feet count as arrived
+static NavRect navGoal(int dest) {
+    switch (dest) {
+    case NAV_FOOTPATH: { NavRect r = {0.0f, 192.0f, (float)WIDTH, 208.0f}; return r; }
+    case NAV_BUS_STOP: { NavRect r = {535.0f, 280.0f, 590.0f, 288.0f}; return r; }
+    case NAV_WELL:     { NavRect r = {250.0f, 282.0f, 262.0f, 290.0f}; return r; }
+    case NAV_DOCK:     { NavRect r = {300.0f, 172.0f, 380.0f, 180.0f}; return r; }
+    default: {
+        const float* h = NAV_HOUSE[dest - NAV_HOUSE0];
+        NavRect r = {h[0] + h[2] - 8.0f, 282.0f, h[0] + h[2] + 8.0f, 290.0f};
+        return r;
+    }
     }
 }
 
-void drawSwing(float x, float y) {
-    // kept (not visible directly) – angle reused for playground seesaw
-    glColor3f(0.5f, 0.3f, 0.2f);
-    glLineWidth(3.0f);
-    glBegin(GL_LINES);
-    glVertex2f(x - 45, y);
-    glVertex2f(x - 15, y + 80);
-    glVertex2f(x + 45, y);
-    glVertex2f(x + 15, y + 80);
-    glVertex2f(x - 15, y + 80);
-    glVertex2f(x + 15, y + 80);
-    glEnd();
+// sets every cell whose centre lies inside r
+static void navFill(NavRect r, uint8_t v) {
+    int c0 = std::max(0, (int)std::ceil(r.x0 / NAV_CELL - 0.5f));
+    int c1 = std::min(NAV_COLS - 1, (int)std::floor(r.x1 / NAV_CELL - 0.5f));
+    int r0 = std::max(0, (int)std::ceil(r.y0 / NAV_CELL - 0.5f));
+    int r1 = std::min(NAV_ROWS - 1, (int)std::floor(r.y1 / NAV_CELL - 0.5f));
+    for (int y = r0; y <= r1; y++)
+        for (int x = c0; x <= c1; x++) navGrid[y * NAV_COLS + x] = v;
 }
 
-// ============================================================================
-// NEW EXTRA DETAILS
-// ============================================================================
+void rasterizeNavGrid() {
+    navGrid.assign((size_t)NAV_COLS * NAV_ROWS, NAV_OPEN);
+    const NavRect river = {0.0f, 120.0f, (float)WIDTH, 180.0f};
+    const NavRect dock  = {280.0f, 172.0f, 400.0f, 180.0f};
+    const NavRect road  = {0.0f, 211.0f, (float)WIDTH, 279.0f};   // kerb rows stay open
+    const NavRect zebra = {NAV_CROSS_X0, 211.0f, NAV_CROSS_X1, 279.0f};
+    const NavRect rail  = {0.0f, 335.0f, (float)WIDTH, 360.0f};
+    const NavRect well  = {212.0f, 279.0f, 248.0f, 292.0f};
+    navFill(river, NAV_BLOCKED);
+    navFill(dock, NAV_OPEN);
+    navFill(road, NAV_BLOCKED);
+    navFill(zebra, NAV_CROSSING);
+    navFill(rail, NAV_BLOCKED);
+    navFill(well, NAV_BLOCKED);
+    for (int i = 0; i < NAV_HOUSES; i++) {
+        NavRect house = {NAV_HOUSE[i][0], 292.0f, NAV_HOUSE[i][0] + NAV_HOUSE[i][1], 335.0f};
+        navFill(house, NAV_BLOCKED);
+    }
 
-// River-side dock + fisherman with reflection
-void drawDockAndFisherman() {
-    float dockX = 340.0f;
-    float dockY = 172.0f;
+    // field fence (drawFieldAndCow), 4 units thick all round
+    const float fx0 = 74.0f, fy0 = 34.0f, fx1 = 326.0f, fy1 = 118.0f;
+    const NavRect fence[4] = {{fx0, fy0, fx1, fy0 + 4.0f}, {fx0, fy1 - 4.0f, fx1, fy1},
+                              {fx0, fy0, fx0 + 4.0f, fy1}, {fx1 - 4.0f, fy0, fx1, fy1}};
+    for (int i = 0; i < 4; i++) navFill(fence[i], NAV_BLOCKED);
+}
 
-    // Dock reflection in water
-    float waterMid = 150.0f;
-    float refY     = waterMid - ((dockY + 5.0f) - waterMid);
+// a diagonal step needs both orthogonal cells open (no cutting corners)
+static inline bool navStepOpen(int x, int y, int k) {
+    int nx = x + NAV_DX[k], ny = y + NAV_DY[k];
+    if (nx < 0 || ny < 0 || nx >= NAV_COLS || ny >= NAV_ROWS) return false;
+    if (navGrid[ny * NAV_COLS + nx] == NAV_BLOCKED) return false;
+    return (k & 1) == 0 || (navGrid[y * NAV_COLS + nx] != NAV_BLOCKED &&
+                            navGrid[ny * NAV_COLS + x] != NAV_BLOCKED);
+}
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(0.0f, 0.10f, 0.25f, 0.40f);
-    drawEllipse(dockX, refY, 70.0f, 6.5f, 40);
-    glDisable(GL_BLEND);
+void bakeFlowField(int dest) {
+    const int n = NAV_COLS * NAV_ROWS;
+    std::vector<int> cost(n, INT32_MAX);
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >,
+                        std::greater<std::pair<int, int> > > open;
+
+    NavRect g = navGoal(dest);
+    int c0 = std::max(0, (int)(g.x0 / NAV_CELL)), c1 = std::min(NAV_COLS - 1, (int)(g.x1 / NAV_CELL));
+    int r0 = std::max(0, (int)(g.y0 / NAV_CELL)), r1 = std::min(NAV_ROWS - 1, (int)(g.y1 / NAV_CELL));
+    for (int y = r0; y <= r1; y++)
+        for (int x = c0; x <= c1; x++)
+            if (navGrid[y * NAV_COLS + x] != NAV_BLOCKED) {
+                cost[y * NAV_COLS + x] = 0;
+                open.push(std::make_pair(0, y * NAV_COLS + x));
+            }
 
-    // ----------------- WOODEN DOCK -----------------
-    glColor3f(0.55f, 0.38f, 0.22f);
-    glBegin(GL_QUADS);
-        glVertex2f(dockX - 60, dockY);
-        glVertex2f(dockX + 60, dockY);
-        glVertex2f(dockX + 60, dockY + 10);
-        glVertex2f(dockX - 60, dockY + 10);
-    glEnd();
+    while (!open.empty()) {
+        std::pair<int, int> top = open.top();
+        open.pop();
+        int c = top.second;
+        if (top.first > cost[c]) continue;
+        int x = c % NAV_COLS, y = c / NAV_COLS;
+        for (int k = 0; k < 8; k++) {
+            if (!navStepOpen(x, y, k)) continue;
+            int nc = c + NAV_DY[k] * NAV_COLS + NAV_DX[k];
+            int nd = top.first + ((k & 1) ? 14 : 10);
+            if (nd < cost[nc]) {
+                cost[nc] = nd;
+                open.push(std::make_pair(nd, nc));
+            }
+        }
+    }
 
-    glColor3f(0.42f, 0.28f, 0.16f);
-    glLineWidth(1.0f);
-    glBegin(GL_LINES);
-        for (float x = dockX - 58; x <= dockX + 58; x += 8.0f) {
-            glVertex2f(x, dockY);
-            glVertex2f(x, dockY + 10);
+    std::vector<uint8_t>& flow = navFlow[dest];
+    flow.assign(n, NAV_NO_PATH);
+    for (int c = 0; c < n; c++) {
+        if (cost[c] == INT32_MAX) continue;
+        if (cost[c] == 0) { flow[c] = NAV_AT_GOAL; continue; }
+        int x = c % NAV_COLS, y = c / NAV_COLS, best = INT32_MAX;
+        for (int k = 0; k < 8; k++) {
+            if (!navStepOpen(x, y, k)) continue;
+            int nc = c + NAV_DY[k] * NAV_COLS + NAV_DX[k];
+            if (cost[nc] < best) { best = cost[nc]; flow[c] = (uint8_t)k; }
         }
-    glEnd();
+    }
+}
 
-    glColor3f(0.40f, 0.26f, 0.14f);
-    for (int i = -2; i <= 2; ++i) {
-        float px = dockX + i * 25.0f;
-        glBegin(GL_QUADS);
-            glVertex2f(px - 3, 150.0f);
-            glVertex2f(px + 3, 150.0f);
-            glVertex2f(px + 3, dockY);
-            glVertex2f(px - 3, dockY);
-        glEnd();
+// worker k bakes destinations k, k + workers, ...
+void startNavBake(int workers) {
+    rasterizeNavGrid();
+    workers = std::max(1, std::min(workers, (int)NAV_DEST_COUNT));
+    for (int k = 0; k < workers; k++) {
+        navWorkers.push_back(std::thread([k, workers]() {
+            for (int d = k; d < NAV_DEST_COUNT; d += workers) bakeFlowField(d);
+        }));
+    }
+}
+
+// also registered with atexit(): exit() (ESC, end of --bench-gl) must not
+// find a joinable bake thread, even when no walker ever asked for a field
+static void joinNavWorkers() {
+    for (size_t i = 0; i < navWorkers.size(); i++) navWorkers[i].join();
+    navWorkers.clear();
+}
+
+// first use: wait for the workers (or bake here if they were never started)
+void finishNavBake() {
+    if (navReady) return;
+    joinNavWorkers();
+    if (navGrid.empty()) {
+        startNavBake(1);
+        navWorkers[0].join();
+        navWorkers.clear();
     }
+    navReady = true;
+}
 
-    // ----------------- SMALL BOAT TIED TO DOCK -----------------
-    float boatBaseX = dockX + 50.0f;
-    float boatBaseY = 150.0f;
+static inline int navCellAt(float x, float y) {
+    int cx = std::max(0, std::min(NAV_COLS - 1, (int)(x / NAV_CELL)));
+    int cy = std::max(0, std::min(NAV_ROWS - 1, (int)(y / NAV_CELL)));
+    return cy * NAV_COLS + cx;
+}
 
-    glColor3f(0.32f, 0.20f, 0.10f);
-    glBegin(GL_POLYGON);
-        glVertex2f(boatBaseX - 24, boatBaseY);
-        glVertex2f(boatBaseX + 24, boatBaseY);
-        glVertex2f(boatBaseX + 18, boatBaseY + 10);
-        glVertex2f(boatBaseX - 18, boatBaseY + 10);
-    glEnd();
+// ============================================================================
+// PEDESTRIAN CROWD (footpath walkers, bucketed avoidance, flow-field trips)
+// Walkers go both ways along the footpath (feet y 192..208, right-goers on
+// the near half) and wrap at the screen edges. Each tick they are counting-
+// sorted into a 16 px grid; a walker looks at no more than
+// PED_MAX_NEIGHBORS others in its 3x3 cells: it slows behind someone
+// slower (and edges out to pass), steps to its own side for oncoming
+// people and keeps a little personal space, so the sim stays O(n).
+// One in PED_TRIP_ODDS walkers who wrap goes on a trip to the bus stop, a
+// house door, the well or the dock, following that destination's flow
+// field; it waits at the kerb until the light is red and no vehicle is on
+// the crossing, stays a while, then follows the footpath field back.
+// Every figure is the same hip-relative template (head fan, torso, arms
+// and legs as 3 px quads) moved by the walker's position and gait phase:
+// one glDrawArraysInstanced over the Pedestrian array with GLSL 3.30,
+// otherwise expanded on the CPU into one client-side triangle array.
+// ============================================================================
 
-    glColor3f(0.40f, 0.26f, 0.14f);
-    glBegin(GL_LINES);
-        glVertex2f(boatBaseX, boatBaseY + 10);
-        glVertex2f(dockX + 40, dockY + 5);
-    glEnd();
+enum PedState { PED_WALK, PED_TRIP, PED_WAIT, PED_RETURN };
+
+struct Pedestrian {
+    float   x, y;        // feet, scene units
+    float   vx, vy;      // px / tick
+    float   pace;        // preferred walking speed
+    float   phase;       // gait, advanced by distance walked
+    float   timer;       // ticks left at the destination
+    uint8_t state;       // PedState
+    int8_t  dir;         // +1 walks right, -1 left
+    uint8_t look;        // shirt (low 3 bits) + trousers (bits 3..4)
+    uint8_t dest;        // NavDest of the current trip
+};
 
-    // ----------------- FISHERMAN -----------------
-    float fx = dockX - 30.0f;
-    float fy = dockY + 10.0f;
+const int   MAX_CROWD         = 100000;
+const float PED_MARGIN        = 40.0f;    // walkers wrap this far outside the screen
+const float PED_CELL          = 16.0f;    // grid cell; >= the look-ahead distance
+const float PED_GRID_Y0       = 184.0f;   // grid covers footpath, road and platform
+const float PED_GRID_Y1       = 296.0f;
+const int   PED_MAX_NEIGHBORS = 6;
+const int   PED_TRIP_ODDS     = 10;
+const float PED_PATH_LO       = 192.0f;   // feet on the footpath
+const float PED_PATH_HI       = 208.0f;
+
+std::vector<Pedestrian> crowd;
+std::vector<int> pedCellStart, pedCellItems, pedCellOf, pedCellCursor;
+
+// lives in SceneState: trips drawn after a snapshot / replay load repeat exactly
+uint32_t& pedRandState = scene.pedRand;
+static inline float pedRand() {
+    pedRandState = pedRandState * 1664525u + 1013904223u;
+    return (pedRandState >> 8) * (1.0f / 16777216.0f);   // 0..1
+}
 
-    drawShadowEllipse(fx, fy - 6.0f, 10.0f, 3.5f, 0.35f);
+void initCrowd(int count) {
+    pedRandState = 4242u;
+    crowd.assign(std::max(0, std::min(count, MAX_CROWD)), Pedestrian());
+    for (size_t i = 0; i < crowd.size(); i++) {
+        Pedestrian& p = crowd[i];
+        p.dir   = (i % 2) ? -1 : 1;
+        p.x     = -PED_MARGIN + pedRand() * (WIDTH + 2.0f * PED_MARGIN);
+        p.y     = (p.dir > 0 ? 194.0f : 202.0f) + pedRand() * 4.0f;
+        p.pace  = 0.55f + 0.45f * pedRand();
+        p.vx    = p.dir * p.pace;
+        p.vy    = 0.0f;
+        p.phase = pedRand() * 6.2831853f;    // gait offset: nobody walks in step
+        p.timer = 0.0f;
+        p.state = PED_WALK;
+        p.look  = (uint8_t)(pedRand() * 32.0f) & 31;
+        p.dest  = NAV_FOOTPATH;
+    }
+}
 
-    glColor3f(1.0f, 0.90f, 0.80f);
-    drawCircle(fx, fy + 22.0f, 7.0f);
+// the light is red for the road and neither vehicle is on (or about to reach) the crossing
+static bool crossingClear() {
+    if (trafficState != 0) return false;
+    float carX = std::fmod(carPosition, WIDTH + 300.0f) - 150.0f;   // as in drawMovingCar()
+    float busX = std::fmod(busPosition, WIDTH + 500.0f) - 200.0f;
+    bool carOn = carX > NAV_CROSS_X0 - 130.0f && carX < NAV_CROSS_X1 + 10.0f;
+    bool busOn = busX > NAV_CROSS_X0 - 180.0f && busX < NAV_CROSS_X1 + 10.0f;
+    return !carOn && !busOn;
+}
 
-    glColor3f(0.15f, 0.35f, 0.75f);
-    glBegin(GL_TRIANGLES);
-        glVertex2f(fx - 7, fy + 24);
-        glVertex2f(fx + 7, fy + 24);
-        glVertex2f(fx,     fy + 32);
-    glEnd();
+// bus stop 40 %, well and dock 10 % each, the rest spread over the houses
+static uint8_t pickTripDest() {
+    float r = pedRand();
+    if (r < 0.40f) return NAV_BUS_STOP;
+    if (r < 0.50f) return NAV_WELL;
+    if (r < 0.60f) return NAV_DOCK;
+    return (uint8_t)(NAV_HOUSE0 + std::min(NAV_HOUSES - 1, (int)((r - 0.60f) / 0.40f * NAV_HOUSES)));
+}
 
-    glColor3f(0.1f, 0.4f, 0.9f);
-    glLineWidth(5.0f);
-    glBegin(GL_LINES);
-        glVertex2f(fx, fy + 16.0f);
-        glVertex2f(fx, fy);        // torso
-    glEnd();
+void updateCrowd(float speed) {
+    finishNavBake();   // before the early out: an empty crowd still joins the bake
+    int n = (int)crowd.size();
+    if (n == 0) return;
+
+    // ---- 1) counting sort into grid cells ----
+    const float worldMin = -PED_MARGIN;
+    const int   cols = (int)((WIDTH + 2.0f * PED_MARGIN) / PED_CELL) + 1;
+    const int   rows = (int)((PED_GRID_Y1 - PED_GRID_Y0) / PED_CELL) + 1;
+    const int   cells = cols * rows;
+
+    pedCellStart.assign(cells + 1, 0);
+    pedCellItems.resize(n);
+    pedCellOf.resize(n);
+    for (int i = 0; i < n; i++) {
+        int cx = (int)((crowd[i].x - worldMin) / PED_CELL);
+        int cy = (int)((crowd[i].y - PED_GRID_Y0) / PED_CELL);
+        cx = std::max(0, std::min(cols - 1, cx));
+        cy = std::max(0, std::min(rows - 1, cy));
+        pedCellOf[i] = cy * cols + cx;
+        pedCellStart[pedCellOf[i] + 1]++;
+    }
+    for (int c = 0; c < cells; c++) pedCellStart[c + 1] += pedCellStart[c];
+    pedCellCursor.assign(pedCellStart.begin(), pedCellStart.end() - 1);
+    for (int i = 0; i < n; i++) pedCellItems[pedCellCursor[pedCellOf[i]]++] = i;
+
+    const bool clear = crossingClear();
+
+    // ---- 2) steering ----
+    for (int i = 0; i < n; i++) {
+        Pedestrian& p = crowd[i];
+        const float d = p.dir;
+        float wantVx = 0.0f, wantVy = 0.0f;
+
+        switch (p.state) {
+        case PED_WALK: {
+            wantVx = d * p.pace;
+
+            // neighbours: follow the slower, pass, dodge the oncoming, personal space
+            float ay = ((d > 0 ? 196.0f : 204.0f) - p.y) * 0.02f;   // keep to your side
+            int   cx = pedCellOf[i] % cols, cy = pedCellOf[i] / cols;
+            int   seen = 0;
+            for (int y = std::max(0, cy - 1); y <= std::min(rows - 1, cy + 1) && seen < PED_MAX_NEIGHBORS; y++) {
+                int row = y * cols;
+                for (int k = pedCellStart[row + std::max(0, cx - 1)];
+                     k < pedCellStart[row + std::min(cols - 1, cx + 1) + 1]; k++) {
+                    int j = pedCellItems[k];
+                    if (j == i) continue;
+                    const Pedestrian& o = crowd[j];
+                    float dx = o.x - p.x, dy = o.y - p.y;
+                    if (std::fabs(dx) > PED_CELL || std::fabs(dy) > 8.0f) continue;
+
+                    float ahead = dx * d;
+                    if (ahead > 0.0f && ahead < 14.0f && std::fabs(dy) < 4.0f) {
+                        if (o.vx * d > 0.0f) {
+                            wantVx = d * std::min(std::fabs(wantVx), std::fabs(o.vx));
+                            ay += (dy > 0.0f ? -0.04f : 0.04f);
+                        } else {
+                            ay += (d > 0.0f ? -0.12f : 0.12f);
+                        }
+                    }
+                    if (dx * dx + dy * dy < 25.0f)
+                        ay += (dy > 0.0f || (dy == 0.0f && j > i)) ? -0.10f : 0.10f;
+                    if (++seen == PED_MAX_NEIGHBORS) break;
+                }
+            }
+            p.vy = (p.vy + ay * speed) * 0.8f;
+            p.vy = std::max(-0.6f, std::min(0.6f, p.vy));
+            wantVy = p.vy;
+            break;
+        }
+        case PED_TRIP:
+        case PED_RETURN: {
+            // one lookup in the destination's flow field
+            int     c    = navCellAt(p.x, p.y);
+            uint8_t flow = navFlow[p.dest][c];
+            if (flow == NAV_AT_GOAL) {
+                if (p.state == PED_RETURN) {
+                    p.state = PED_WALK;
+                } else {
+                    p.state = PED_WAIT;
+                    p.timer = (p.dest == NAV_BUS_STOP ? 300.0f : 120.0f) + pedRand() * 1200.0f;
+                }
+                break;
+            }
+            if (flow == NAV_NO_PATH) break;
+            wantVx = NAV_UX[flow] * p.pace;
+            wantVy = NAV_UY[flow] * p.pace;
+
+            // wait at the kerb until the crossing is clear
+            int next = navCellAt(p.x + NAV_UX[flow] * NAV_CELL, p.y + NAV_UY[flow] * NAV_CELL);
+            if (!clear && navGrid[next] == NAV_CROSSING && navGrid[c] != NAV_CROSSING)
+                wantVx = wantVy = 0.0f;
+            break;
+        }
+        case PED_WAIT:
+            p.timer -= speed;
+            if (p.timer <= 0.0f) {
+                p.state = PED_RETURN;
+                p.dest  = NAV_FOOTPATH;
+            }
+            break;
+        }
 
-    glBegin(GL_LINES);
-        glVertex2f(fx, fy + 12.0f);
-        glVertex2f(fx + 14.0f, fy + 4.0f);
-        glVertex2f(fx, fy + 12.0f);
-        glVertex2f(fx - 12.0f, fy + 4.0f);
-    glEnd();
+        p.vx += (wantVx - p.vx) * std::min(1.0f, 0.15f * speed);
+        if (p.state != PED_WALK) p.vy = wantVy;
+    }
 
-    glColor3f(0.1f, 0.2f, 0.35f);
-    glBegin(GL_LINES);
-        glVertex2f(fx, fy);
-        glVertex2f(fx - 6.0f, fy - 12.0f);
-        glVertex2f(fx, fy);
-        glVertex2f(fx + 6.0f, fy - 12.0f);
-    glEnd();
+    // ---- 3) integrate, gait, wrap ----
+    for (int i = 0; i < n; i++) {
+        Pedestrian& p = crowd[i];
+        float nx = p.x + p.vx * speed, ny = p.y + p.vy * speed;
+        if (p.state != PED_WALK && navGrid[navCellAt(nx, ny)] == NAV_BLOCKED) {
+            // slide along walls instead of stepping into a blocked cell
+            if      (navGrid[navCellAt(nx, p.y)] != NAV_BLOCKED) ny = p.y;
+            else if (navGrid[navCellAt(p.x, ny)] != NAV_BLOCKED) nx = p.x;
+            else    { nx = p.x; ny = p.y; }
+        }
+        p.x = nx;
+        p.y = ny;
+
+        float moved = std::sqrt(p.vx * p.vx + p.vy * p.vy) * speed;
+        if (moved > 0.02f) p.phase += moved * 0.375f;
+        else               p.phase = std::floor(p.phase / 3.1415926f + 0.5f) * 3.1415926f;   // stand
+
+        if (p.state == PED_WALK) {
+            p.y = std::max(PED_PATH_LO, std::min(PED_PATH_HI, p.y));
+            float wrapW = WIDTH + 2.0f * PED_MARGIN;
+            bool  wrapped = false;
+            if (p.x > WIDTH + PED_MARGIN) { p.x -= wrapW; wrapped = true; }
+            if (p.x < -PED_MARGIN)        { p.x += wrapW; wrapped = true; }
+            if (wrapped && pedRand() * PED_TRIP_ODDS < 1.0f) {
+                p.state = PED_TRIP;
+                p.dest  = pickTripDest();
+            }
+        }
+    }
+}
 
-    // Fishing rod + line
-    glColor3f(0.25f, 0.15f, 0.05f);
-    glLineWidth(3.0f);
-    glBegin(GL_LINES);
-        glVertex2f(fx + 14.0f, fy + 4.0f);
-        glVertex2f(fx + 70.0f, fy + 40.0f);
-    glEnd();
+// ---- figure template (hip at the origin), shared by both render paths ----
+// a limb is a quad from a to b (b.x moves by k * stride), 1.5 units each side
+struct PedVertex {
+    float ax, ay, bx, by;
+    float t, side, k, part;    // part: 0 skin, 1 shirt, 2 trousers
+};
 
-    float bobPhase = std::sin(riverWave * 0.15f) * 4.0f;
-    float lineX    = fx + 70.0f;
-    float lineYTop = fy + 40.0f;
-    float bobX     = lineX + 10.0f;
-    float bobY     = 150.0f + bobPhase;
+std::vector<PedVertex> pedTemplate;
 
-    glColor3f(0.95f, 0.95f, 1.0f);
-    glPointSize(2.0f);
-    drawLineBresenham((int)lineX, (int)lineYTop, (int)bobX, (int)bobY);
+static const float PED_SHIRTS[8][3] = {
+    {0.80f, 0.20f, 0.20f}, {0.20f, 0.45f, 0.80f}, {0.95f, 0.75f, 0.20f}, {0.30f, 0.65f, 0.35f},
+    {0.90f, 0.90f, 0.88f}, {0.55f, 0.30f, 0.65f}, {0.95f, 0.50f, 0.20f}, {0.25f, 0.70f, 0.75f}
+};
+static const float PED_TROUSERS[4][3] = {
+    {0.18f, 0.20f, 0.30f}, {0.30f, 0.25f, 0.20f}, {0.15f, 0.15f, 0.15f}, {0.40f, 0.40f, 0.45f}
+};
 
+static void buildPedTemplate() {
+    pedTemplate.clear();
+    auto limb = [](float ax, float ay, float bx, float by, float k, float part) {
+        const float ts[6] = {0, 0, 1, 0, 1, 1}, ss[6] = {-1, 1, 1, -1, 1, -1};
+        for (int i = 0; i < 6; i++) {
+            PedVertex v = {ax, ay, bx, by, ts[i], ss[i], k, part};
+            pedTemplate.push_back(v);
+        }
+    };
+    limb(0, 0, -6, -14, -1.0f, 2);     // legs (old drawWalkingPerson stride)
+    limb(0, 0,  6, -14,  1.0f, 2);
+    limb(0, 0,  0,  16,  0.0f, 1);     // torso
+    limb(0, 12, -8, 4, -0.4f, 1);      // arms
+    limb(0, 12,  8, 4,  0.4f, 1);
+
+    const int SEG = 10;                // head
+    for (int i = 0; i < SEG; i++) {
+        float a0 = 2.0f * 3.1415926f * i / SEG, a1 = 2.0f * 3.1415926f * (i + 1) / SEG;
+        const float px[3] = {0.0f, 7.0f * std::cos(a0), 7.0f * std::cos(a1)};
+        const float py[3] = {22.0f, 22.0f + 7.0f * std::sin(a0), 22.0f + 7.0f * std::sin(a1)};
+        for (int c = 0; c < 3; c++) {
+            PedVertex v = {px[c], py[c], px[c], py[c], 0, 0, 0, 0};
+            pedTemplate.push_back(v);
+        }
+    }
+}
 
-    glColor3f(1.0f, 1.0f, 1.0f);
-    drawCircle(bobX, bobY, 4.5f);
-    glColor3f(1.0f, 0.15f, 0.15f);
-    drawCircle(bobX, bobY, 3.0f);
+// CPU path: the whole crowd into one triangle array
+std::vector<float>   crowdXY;
+std::vector<GLubyte> crowdRGBA;
+
+static int expandCrowd() {
+    if (pedTemplate.empty()) buildPedTemplate();
+    const int per = (int)pedTemplate.size();
+    crowdXY.resize(crowd.size() * per * 2);
+    crowdRGBA.resize(crowd.size() * per * 4);
+
+    float*   xy   = crowdXY.data();
+    GLubyte* rgba = crowdRGBA.data();
+    for (int i : walkersShown) {
+        const Pedestrian& p = crowd[i];
+
+        float s   = std::sin(p.phase);
+        float hip = p.y + 14.0f + 1.5f * std::fabs(s);
+        float stride = s * 6.0f;
+        const float* shirt    = PED_SHIRTS[p.look & 7];
+        const float* trousers = PED_TROUSERS[(p.look >> 3) & 3];
+        GLubyte cols[3][4] = {
+            {255, 230, 204, 255},
+            {(GLubyte)(shirt[0] * 255), (GLubyte)(shirt[1] * 255), (GLubyte)(shirt[2] * 255), 255},
+            {(GLubyte)(trousers[0] * 255), (GLubyte)(trousers[1] * 255), (GLubyte)(trousers[2] * 255), 255}
+        };
+
+        for (int v = 0; v < per; v++) {
+            const PedVertex& t = pedTemplate[v];
+            float bx = t.bx + t.k * stride;
+            float dx = bx - t.ax, dy = t.by - t.ay;
+            float len = std::sqrt(dx * dx + dy * dy);
+            float nx = 0.0f, ny = 0.0f;
+            if (len > 1e-4f) { nx = -dy / len * 1.5f; ny = dx / len * 1.5f; }
+            xy[0] = p.x + t.ax + dx * t.t + nx * t.side;
+            xy[1] = hip + t.ay + dy * t.t + ny * t.side;
+            std::memcpy(rgba, cols[(int)t.part], 4);
+            xy   += 2;
+            rgba += 4;
+        }
+    }
+    return (int)walkersShown.size() * per;
 }
 
-// ----------------- COW HELPER -----------------
-void drawSingleCow(float cx, float cy, float scale, bool faceRight) {
-    glPushMatrix();
-    glTranslatef(cx, cy, 0.0f);
+// GLSL path: template VBO + the Pedestrian array as per-instance attributes
+ShaderProgram crowdProgram;
+GLuint crowdVao = 0, crowdTemplateVbo = 0, crowdInstanceVbo = 0;
+bool   crowdShaderReady = false;
+
+static const char* CROWD_VS =
+    "layout(location = 0) in vec4 aSeg;\n"      // a.xy, b.xy (hip-relative)
+    "layout(location = 1) in vec4 aVert;\n"     // t, side, stride factor, part
+    "layout(location = 2) in vec2 aFeet;\n"     // per instance
+    "layout(location = 3) in float aPhase;\n"
+    "layout(location = 4) in vec4 aLook;\n"     // state, dir, look, pad (bytes / 255)
+    "out vec3 vColor;\n"
+    "const vec3 SHIRTS[8] = vec3[8](vec3(0.80,0.20,0.20), vec3(0.20,0.45,0.80), vec3(0.95,0.75,0.20),\n"
+    "    vec3(0.30,0.65,0.35), vec3(0.90,0.90,0.88), vec3(0.55,0.30,0.65), vec3(0.95,0.50,0.20), vec3(0.25,0.70,0.75));\n"
+    "const vec3 TROUSERS[4] = vec3[4](vec3(0.18,0.20,0.30), vec3(0.30,0.25,0.20), vec3(0.15), vec3(0.40,0.40,0.45));\n"
+    "void main() {\n"
+    "    float s   = sin(aPhase);\n"
+    "    vec2  a   = aSeg.xy;\n"
+    "    vec2  b   = aSeg.zw + vec2(aVert.z * s * 6.0, 0.0);\n"
+    "    vec2  d   = b - a;\n"
+    "    float len = length(d);\n"
+    "    vec2  n   = len > 1e-4 ? vec2(-d.y, d.x) / len * 1.5 : vec2(0.0);\n"
+    "    vec2  hip = aFeet + vec2(0.0, 14.0 + 1.5 * abs(s));\n"
+    "    int   look = int(aLook.z * 255.0 + 0.5);\n"
+    "    int   part = int(aVert.w + 0.5);\n"
+    "    vColor = part == 0 ? vec3(1.0, 0.9, 0.8) : part == 1 ? SHIRTS[look & 7] : TROUSERS[(look >> 3) & 3];\n"
+    "    gl_Position = sceneToClip(hip + a + d * aVert.x + n * aVert.y);\n"
+    "}\n";
+
+static const char* CROWD_FS =
+    "in vec3 vColor;\n"
+    "out vec4 fragColor;\n"
+    "void main() { fragColor = vec4(vColor, 1.0); }\n";
+
+// from initShaders(), with the GL 3.3 entry points loaded
+void initCrowdShader() {
+    if (!linkProgram(crowdProgram, CROWD_VS, CROWD_FS)) return;
+    if (pedTemplate.empty()) buildPedTemplate();
+
+    gl3.GenVertexArrays(1, &crowdVao);
+    gl3.GenBuffers(1, &crowdTemplateVbo);
+    gl3.GenBuffers(1, &crowdInstanceVbo);
+    gl3.BindVertexArray(crowdVao);
+
+    gl3.BindBuffer(GL_ARRAY_BUFFER, crowdTemplateVbo);
+    gl3.BufferData(GL_ARRAY_BUFFER, pedTemplate.size() * sizeof(PedVertex), pedTemplate.data(), GL_STATIC_DRAW);
+    gl3.EnableVertexAttribArray(0);
+    gl3.VertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(PedVertex), (const void*)offsetof(PedVertex, ax));
+    gl3.EnableVertexAttribArray(1);
+    gl3.VertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(PedVertex), (const void*)offsetof(PedVertex, t));
+
+    gl3.BindBuffer(GL_ARRAY_BUFFER, crowdInstanceVbo);
+    gl3.EnableVertexAttribArray(2);
+    gl3.VertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Pedestrian), (const void*)offsetof(Pedestrian, x));
+    gl3.EnableVertexAttribArray(3);
+    gl3.VertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Pedestrian), (const void*)offsetof(Pedestrian, phase));
+    gl3.EnableVertexAttribArray(4);
+    gl3.VertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Pedestrian), (const void*)offsetof(Pedestrian, state));
+    for (int a = 2; a <= 4; a++) gl3.VertexAttribDivisor(a, 1);
+
+    gl3.BindVertexArray(0);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, 0);
+    crowdShaderReady = true;
+}
 
-    if (faceRight)
-        glScalef(scale, scale, 1.0f);
-    else
-        glScalef(-scale, scale, 1.0f);
+void drawCrowd() {
+    if (walkersShown.empty()) return;
 
-    float t         = personPosition * 0.08f;
-    float step      = std::sin(t) * 2.5f;
-    float tailSwing = std::sin(t * 1.3f) * 3.0f;
+    // shadows go through the batched shadow pass like everyone else's
+    for (int i : walkersShown) {
+        const Pedestrian& p = crowd[i];
+        addShadow(p.x, p.y - 2.0f, 9.0f, 3.0f, 0.30f);
+    }
 
-    drawShadowEllipse(0.0f, -20.0f, 26.0f, 7.0f, 0.30f);
+    if (shaderPathActive() && crowdShaderReady) {
+        // the crowd array is the instance buffer; only packed when some are off view
+        static std::vector<Pedestrian> packed;
+        const Pedestrian* walkers = crowd.data();
+        if (walkersShown.size() < crowd.size()) {
+            packed.clear();
+            for (int i : walkersShown) packed.push_back(crowd[i]);
+            walkers = packed.data();
+        }
+        gl3.BindBuffer(GL_ARRAY_BUFFER, crowdInstanceVbo);
+        gl3.BufferData(GL_ARRAY_BUFFER, walkersShown.size() * sizeof(Pedestrian), walkers, GL_STREAM_DRAW);
+        gl3.BindBuffer(GL_ARRAY_BUFFER, 0);
+        useSceneProgram(crowdProgram);
+        gl3.BindVertexArray(crowdVao);
+        gl3.DrawArraysInstanced(GL_TRIANGLES, 0, (GLsizei)pedTemplate.size(), (GLsizei)walkersShown.size());
+        endSceneProgram();
+        return;
+    }
 
-    glColor3f(0.95f, 0.90f, 0.80f);
-    glBegin(GL_QUADS);
-        glVertex2f(-32, -2);
-        glVertex2f( 32, -2);
-        glVertex2f( 32, 18);
-        glVertex2f(-32, 18);
-    glEnd();
-    drawEllipse(-32, 8, 8, 10, 24);
-    drawEllipse( 32, 8, 8, 10, 24);
+    int n = expandCrowd();
+    if (n == 0) return;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, crowdXY.data());
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, crowdRGBA.data());
+    glDrawArrays(GL_TRIANGLES, 0, n);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
 
-    glColor3f(0.20f, 0.20f, 0.20f);
-    drawCircle(-10, 12, 4, 16);
-    drawCircle(  6,  8, 3, 16);
-    drawCircle( 16, 14, 3, 16);
 
-    glColor3f(0.95f, 0.90f, 0.80f);
-    drawEllipse(40, 10, 9, 7, 24);
+// ============================================================================
+// SCENE COMPOSITION - FIXED LAYER ORDER
+// ============================================================================
 
-    glColor3f(0.90f, 0.80f, 0.70f);
-    glBegin(GL_QUADS);
-        glVertex2f(44,  4);
-        glVertex2f(54,  4);
-        glVertex2f(54, 11);
-        glVertex2f(44, 11);
-    glEnd();
+// The culling pass (see VIEWPORT CULLING): boxes from the same numbers the
+// draw functions use, nothing is built here.
+void cullScene() {
+    std::memset(cullTested, 0, sizeof(cullTested));
+    std::memset(cullSkipped, 0, sizeof(cullSkipped));
 
-    glColor3f(0.0f, 0.0f, 0.0f);
-    drawCircle(39, 12, 1.3f, 12);
-    drawCircle(43, 12, 1.3f, 12);
+    // ---- road and river (body, addShadow() footprints, headlights) ----
+    float carX = std::fmod(carPosition, WIDTH + 300.0f) - 150.0f;
+    CullBox car = {carX - 2.0f, 222.0f, carX + 106.0f, 288.0f};
+    car = cullUnion(car, shadowBox(carX + 50.0f, 222.0f, 48.0f, 10.0f));
+    car = cullUnion(car, glowBox(carX + 104.0f, 258.0f, LIGHT_MEDIUM));
+    cullShown[CO_CAR] = cullVisible(CULL_VEHICLE, car);
 
-    glBegin(GL_LINES);
-        glVertex2f(36, 18);
-        glVertex2f(32, 24);
-        glVertex2f(44, 18);
-        glVertex2f(48, 24);
-    glEnd();
+    float busX = std::fmod(busPosition, WIDTH + 500.0f) - 200.0f;
+    CullBox bus = {busX - 6.0f, 222.0f, busX + 162.0f, 295.0f};
+    bus = cullUnion(bus, shadowBox(busX + 72.0f, 222.0f, 72.0f, 11.0f));
+    bus = cullUnion(bus, glowBox(busX + 160.0f, 256.0f, LIGHT_MEDIUM));
+    cullShown[CO_BUS] = cullVisible(CULL_VEHICLE, bus);
+
+    float boatX = boatScreenX(), boatY = boatScreenY();
+    CullBox boat = {boatX - 110.0f, 108.0f, boatX + 180.0f, boatY + 80.0f};   // wake trails 156 back
+    cullShown[CO_BOAT] = cullVisible(CULL_VEHICLE, boat);
+
+    // train: engine, then the run of coaches on view (coach i at base + i * pitch)
+    cullShown[CO_ENGINE] = false;
+    coachFirst = 0;
+    coachLast  = -1;
+    if (showTrain) {
+        float x = trainPosition, y = 365.0f;
+        CullBox engine = {x - 2.0f, y - 14.0f, x + 170.0f, y + 62.0f};
+        engine = cullUnion(engine, shadowBox(x + 75.0f, y - 14.0f, 78.0f, 12.0f));
+        engine = cullUnion(engine, glowBox(x + 148.0f, y + 24.0f, LIGHT_MEDIUM));
+        cullShown[CO_ENGINE] = cullVisible(CULL_VEHICLE, engine);
+
+        int   coaches = trainBogieCount;
+        float base    = x + COACH_FIRST_X;
+        float left    = 45.0f - 55.0f * SHADOW_REACH;    // coach shadow: +45, rx 55
+        float right   = 45.0f + 55.0f * SHADOW_REACH;
+        if (y + 70.0f >= cullView.y0 && y - 24.0f <= cullView.y1) {
+            float first = std::ceil((cullView.x0 - right - base) / COACH_PITCH);
+            float last  = std::floor((cullView.x1 - left - base) / COACH_PITCH);
+            coachFirst = (int)std::max(0.0f, first);
+            coachLast  = (int)std::min((float)(coaches - 1), last);
+        }
+        cullTested[CULL_VEHICLE]  += coaches;
+        cullSkipped[CULL_VEHICLE] += coaches - std::max(0, coachLast - coachFirst + 1);
+    }
 
-    glBegin(GL_TRIANGLES);
-        glVertex2f(34, 14); glVertex2f(30, 11); glVertex2f(32, 17);
-        glVertex2f(46, 14); glVertex2f(50, 11); glVertex2f(48, 17);
-    glEnd();
+    // ---- sky ----
+    cullShown[CO_PLANE] = false;
+    if (showPlane) {
+        float x = std::fmod(planePosition, WIDTH + 400.0f) - 200.0f;
+        float y = HEIGHT - 100.0f + 20.0f * std::sin(planePosition * 0.02f);
+        CullBox plane = {x - 90.0f, y - 5.0f, x + 125.0f, y + 48.0f};   // trail puffs behind
+        cullShown[CO_PLANE] = cullVisible(CULL_SKY, plane);
+    }
 
-    glLineWidth(3.0f);
-    glBegin(GL_LINES);
-        glVertex2f(-20, -2); glVertex2f(-20, -18 - step);
-        glVertex2f( -5, -2); glVertex2f( -5, -18 + step);
-        glVertex2f( 10, -2); glVertex2f( 10, -18 - step);
-        glVertex2f( 25, -2); glVertex2f( 25, -18 + step);
-    glEnd();
+    float bx = std::fmod(balloonPosition, WIDTH + 300.0f) - 150.0f;
+    float by = 520.0f + 18.0f * std::sin(balloonPosition * 0.01f);
+    CullBox balloon = {bx - 22.0f, by - 40.0f, bx + 22.0f, by + 22.0f};
+    cullShown[CO_BALLOON] = cullVisible(CULL_SKY, balloon);
 
-    glBegin(GL_LINES);
-        glVertex2f(-32, 16);
-        glVertex2f(-40, 22 + tailSwing);
-    glEnd();
-    drawCircle(-40, 22 + tailSwing, 2.0f, 14);
+    // kite: the tail tip is 78 out; scale, rotation and shear stay inside r
+    float tx = std::fmod(kitePosition, WIDTH + 200.0f) - 100.0f;
+    float ty = 520.0f + 15.0f * std::sin(kitePosition * 0.03f);
+    float r  = 80.0f * (useScaleT ? 1.8f : 1.0f) * (useShearT ? 1.9f * 1.4f : 1.0f);
+    CullBox kite = {tx - r, ty - r, tx + r, ty + r};
+    cullShown[CO_KITE] = cullVisible(CULL_SKY, kite);
+
+    cullShown[CO_BIRDS] = false;
+    if (showBirds) {
+        float flockX = std::fmod(birdOffset * 1.5f, WIDTH + 200.0f) - 100.0f;
+        CullBox birds = {flockX - 50.0f, 475.0f, flockX + 115.0f, 575.0f};
+        cullShown[CO_BIRDS] = cullVisible(CULL_SKY, birds);
+    }
 
-    glPopMatrix();
+    cullGroup(CULL_SKY, cloudImpostors, cloudsShown, [](const CloudImpostor& c) {
+        float x = cloudScreenX(c), hw = c.w * 0.5f, hh = c.w * 0.25f;
+        CullBox b = {x - hw, c.y - hh, x + hw, c.y + hh};
+        return b;
+    });
+
+    // ---- sprite trees on the hills (same quad as emitTreeSprite()) ----
+    cullGroup(CULL_TREE, forest, forestShown, [](const TreeSprite& t) {
+        float half  = TREE_CELL * 0.5f * t.scale;
+        float shear = treeSway(t.x) * t.scale / TREE_CROWN;
+        float xBot  = -shear * TREE_BASE_Y * t.scale;
+        float xTop  =  shear * (TREE_CELL - TREE_BASE_Y) * t.scale;
+        float bottom = t.y - TREE_BASE_Y * t.scale;
+        CullBox b = {t.x - half + std::min(xBot, xTop), bottom,
+                     t.x + half + std::max(xBot, xTop), bottom + TREE_CELL * t.scale};
+        return b;
+    });
+
+    // ---- agents (template extents + shadow) ----
+    cullGroup(CULL_FISH, fishSchool, fishShown, [](const Fish& f) {
+        float r = 32.0f * f.scale;                  // tail tip 30, swim 3, bubbles above
+        CullBox b = {f.x - r - 18.0f, f.y - 3.0f - r, f.x + r + 18.0f, f.y + 43.0f + r};
+        return b;
+    });
+
+    walkersShown.clear();
+    if (showPerson) {
+        cullGroup(CULL_WALKER, crowd, walkersShown, [](const Pedestrian& p) {
+            CullBox b = {p.x - 20.0f, p.y - 5.0f, p.x + 20.0f, p.y + 46.0f};   // head top 45
+            return b;
+        });
+    }
+
+    cullGroup(CULL_COW, herd, cowsShown, [](const Cow& c) {
+        float s = c.scale;                          // body +-54, legs and tail +-3
+        CullBox b = {c.x - 58.0f * s, c.y - 28.0f * s, c.x + 58.0f * s, c.y + 28.0f * s};
+        return b;
+    });
 }
 
-// Crop field + cows + wooden fence
-void drawFieldAndCow() {
-    float x1 = 80.0f;
-    float y1 = 40.0f;
-    float x2 = 320.0f;
-    float y2 = 110.0f;
+// props are placed here, so their boxes are too
+static bool propVisible(float x0, float y0, float x1, float y1) {
+    CullBox b = {x0, y0, x1, y1};
+    return cullVisible(CULL_PROP, b);
+}
 
-    glColor3f(0.20f, 0.45f, 0.15f);
-    glBegin(GL_QUADS);
-    glVertex2f(x1, y1);
-    glVertex2f(x2, y1);
-    glVertex2f(x2, y2);
-    glVertex2f(x1, y2);
-    glEnd();
+void drawVillageScene() {
+    cullScene();
+    beginShadowMask();
+    drawSky();
+    drawStars();
+    drawSunMoon();
+    drawClouds();
+    drawHotAirBalloon();
+    drawKite();
 
-    glColor3f(0.25f, 0.60f, 0.18f);
-    glLineWidth(1.0f);
-    glBegin(GL_LINES);
-    for (float x = x1 + 6; x < x2; x += 8) {
-        glVertex2f(x, y1);
-        glVertex2f(x, y2);
-    }
-    glEnd();
+    drawDistantHills();
+    drawForest();
 
-    // Fence around field
-    glColor3f(0.55f, 0.35f, 0.18f);
-    glLineWidth(2.0f);
-    glBegin(GL_LINES);
-        glVertex2f(x1 - 6, y2 + 4);
-        glVertex2f(x2 + 6, y2 + 4);
-    glEnd();
-    for (float x = x1 - 6; x <= x2 + 6; x += 20.0f) {
-        glBegin(GL_LINES);
-            glVertex2f(x, y2 + 4);
-            glVertex2f(x, y2 + 18);
-        glEnd();
-    }
+    surfaceMask(MASK_GROUND);
+    drawGround();
+    surfaceMask(MASK_OBJECT);
+    drawFieldAndCow();
+    drawElectricPolesAndWires();
 
-    float baseY = 90.0f;
-    drawSingleCow(WIDTH - 260.0f, baseY, 1.0f, true);
-    drawSingleCow(WIDTH - 320.0f, baseY - 6.0f, 0.7f, true);
-}
+    surfaceMask(MASK_WATER);
+    drawRiver();
+    drawFish();
+    surfaceMask(MASK_GROUND);
+    drawRailTrack();
+    surfaceMask(MASK_OBJECT);
+    if (showTrain) drawMovingTrain();
 
-// Bus stop on roadside
-// Bus stop (NO text/board) - compact shelter + bench + waiting person
-void drawBusStop() {
-    float x     = 600.0f;   // move left/right
-    float baseY = 282.0f;   // near road top
+    if (propVisible(950 - 92, 320, 950 + 92, 320 + 232)) drawWindmill(950, 320);   // blades reach 92
+    for (int i = 0; i < 10; i++) {
+        float tx = 150 + i * 120, ty = 320 + (i % 3) * 10;
+        CullBox tree = {tx - 110, ty - 18, tx + 110, ty + TREE_CELL};   // palm shadow rx 50
+        if (cullVisible(CULL_TREE, tree)) drawTree(tx, ty, i);
+    }
 
-    // ---------- platform ----------
-    glColor3f(0.70f, 0.70f, 0.70f);
-    glBegin(GL_QUADS);
-        glVertex2f(x - 70, baseY - 6);
-        glVertex2f(x + 70, baseY - 6);
-        glVertex2f(x + 70, baseY + 6);
-        glVertex2f(x - 70, baseY + 6);
-    glEnd();
+    // Houses row
+    float houseY = 285.0f;     // ✅ same base for all houses
+    float gap    = 210.0f;     // spacing
 
-    // ---------- pillars ----------
-    glColor3f(0.18f, 0.18f, 0.18f);
-    glBegin(GL_QUADS);
-        glVertex2f(x - 48, baseY + 6);
-        glVertex2f(x - 42, baseY + 6);
-        glVertex2f(x - 42, baseY + 52);
-        glVertex2f(x - 48, baseY + 52);
+    static void (*const houses[6])(float, float) = {
+        drawModernHouse, drawTraditionalHouse, drawFarmHouse,
+        drawTraditionalHouse, drawModernHouse, drawFarmHouse
+    };
+    for (int i = 0; i < 6; i++) {
+        float hx = 80 + i * gap;
+        if (propVisible(hx - 20, houseY - 10, hx + 160, houseY + 165)) houses[i](hx, houseY);
+    }
 
-        glVertex2f(x + 42, baseY + 6);
-        glVertex2f(x + 48, baseY + 6);
-        glVertex2f(x + 48, baseY + 52);
-        glVertex2f(x + 42, baseY + 52);
-    glEnd();
 
-    // ---------- back panel (semi-transparent so house visible) ----------
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(0.85f, 0.90f, 0.95f, 0.55f);
-    glBegin(GL_QUADS);
-        glVertex2f(x - 55, baseY + 12);
-        glVertex2f(x + 55, baseY + 12);
-        glVertex2f(x + 55, baseY + 45);
-        glVertex2f(x - 55, baseY + 45);
-    glEnd();
-    glDisable(GL_BLEND);
+    // Well near second house
+    if (propVisible(230 - 30, 260 - 10, 230 + 30, 260 + 65)) drawWell(230, 260);
 
-    // ---------- roof ----------
-    glColor3f(0.95f, 0.75f, 0.15f);
-    glBegin(GL_POLYGON);
-        glVertex2f(x - 62, baseY + 52);
-        glVertex2f(x + 62, baseY + 52);
-        glVertex2f(x + 56, baseY + 62);
-        glVertex2f(x - 68, baseY + 62);
-    glEnd();
+    surfaceMask(MASK_GROUND);
+    drawFootpath();
+    drawRoad();
+    surfaceMask(MASK_OBJECT);
 
-    // ---------- bench ----------
-    glColor3f(0.35f, 0.22f, 0.10f);
-    glBegin(GL_QUADS);
-        glVertex2f(x - 35, baseY + 14);
-        glVertex2f(x + 25, baseY + 14);
-        glVertex2f(x + 25, baseY + 20);
-        glVertex2f(x - 35, baseY + 20);
-    glEnd();
+    // drawWelcomeSign();
+    if (propVisible(515, 260, 685, 360)) drawBusStop();
+    drawTrafficLight();
+    if (propVisible(900 - 215, 30, 900 + 215, 180)) drawPlayground();
+
+    for (int i = 0; i < 4; i++) {
+        float lx = 180 + i * 320;
+        CullBox lamp = cullUnion({lx - 12, 280, lx + 12, 365}, glowBox(lx, 340, LIGHT_LARGE));
+        if (cullVisible(CULL_PROP, lamp)) drawStreetLight(lx, 280);
+    }
 
-    // ---------- waiting person ----------
-    float px = x - 5;
-    float py = baseY + 6;
+    drawMovingCar();
+    drawMovingBus();
 
-    drawShadowEllipse(px, py - 3.0f, 9.0f, 3.0f, 0.35f);
+    if (propVisible(260, 130, 440, 260)) drawDockAndFisherman();  // dock on river bank
+    drawMovingBoat();        // boat is top layer on water
 
-    glColor3f(1.0f, 0.9f, 0.8f);
-    drawCircle(px, py + 20.0f, 5.0f, 18);
+    if (showBirds)  drawBirds();
+    if (showPlane)  drawAirplane();
+    if (showPerson) drawCrowd();
 
-    glColor3f(0.1f, 0.4f, 0.9f);
-    glLineWidth(3.0f);
-    glBegin(GL_LINES);
-        glVertex2f(px, py + 16); glVertex2f(px, py + 6);
-        glVertex2f(px, py + 12); glVertex2f(px - 6, py + 8);
-        glVertex2f(px, py + 12); glVertex2f(px + 6, py + 8);
-        glVertex2f(px, py + 6);  glVertex2f(px - 4, py);
-        glVertex2f(px, py + 6);  glVertex2f(px + 4, py);
-    glEnd();
+    drawReflections();  // water shows the finished frame above it
+    drawShadowPass();   // everything above has registered its shadow
+
+    drawFestivalLights();
+    drawCables(CABLE_FRONT);   // garland wires + fishing line
+    drawFireflies();
+    drawRain();
 }
 
+// ============================================================================
+// SIGNAL CONTROLLER
+// Any number of intersections along the road, each with a phase plan (red,
+// yellow, green in timer units) and an offset into it, all on the one
+// traffic timer; offsets that follow the travel time between lights make a
+// green wave. A phase change is an event: every signal sits in a min-heap
+// keyed on the tick it can next change (same conservative estimate as the
+// scene timers) and TM_TRAFFIC fires for the earliest one. A vehicle only
+// looks at the next stop line ahead of it; one caught by a red joins that
+// signal's queue and is not touched again until the light leaves red, so a
+// tick costs O(moving vehicles + changing signals), not O(vehicles x signals).
+// ============================================================================
 
-// Traffic light with simple cycle
-void drawTrafficLight() {
-    float x = 700.0f;
-    float y = 280.0f;
+const int MAX_ROAD_SIGNALS = 12;   // stop zones are 70 px wide, lights >= 100 px apart
 
-    glColor3f(0.2f, 0.2f, 0.2f);
-    glBegin(GL_QUADS);
-    glVertex2f(x - 4, y);
-    glVertex2f(x + 4, y);
-    glVertex2f(x + 4, y + 50);
-    glVertex2f(x - 4, y + 50);
-    glEnd();
+struct PhasePlan { int red, yellow, green; };
 
-    glBegin(GL_QUADS);
-    glVertex2f(x - 12, y + 50);
-    glVertex2f(x + 12, y + 50);
-    glVertex2f(x + 12, y + 85);
-    glVertex2f(x - 12, y + 85);
-    glEnd();
+struct Signal {
+    float   x;          // pole; vehicles stop while x-80 < X < x-10 on red
+    int     plan;       // index into TrafficRoad::plans
+    int     offset;     // added to the timer before the plan is read
+    int32_t state;      // 0=red,1=yellow,2=green
+    int     queue;      // first vehicle waiting here, -1 = none
+};
 
-    float redA    = (trafficState == 0) ? 1.0f : 0.25f;
-    float yellowA = (trafficState == 1) ? 1.0f : 0.25f;
-    float greenA  = (trafficState == 2) ? 1.0f : 0.25f;
+struct RoadVehicle {
+    float* pos;         // the scene's car / bus position, or the bench's own
+    float  step;        // px per tick at speed 1
+    float  span, back;  // on-road X = fmod(pos, span) - back (as drawn)
+    int    next;        // first signal whose stop zone is not behind us
+    int    queueNext;   // next vehicle waiting at the same light
+    bool   queued;
+};
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+typedef std::pair<uint32_t, int> SignalDue;   // (tick, signal)
 
-    glColor4f(1.0f, 0.2f, 0.2f, redA);
-    drawCircle(x, y + 79, 6);
-    glColor4f(1.0f, 0.9f, 0.3f, yellowA);
-    drawCircle(x, y + 67, 6);
-    glColor4f(0.2f, 1.0f, 0.2f, greenA);
-    drawCircle(x, y + 55, 6);
+struct TrafficRoad {
+    std::vector<PhasePlan>   plans;
+    std::vector<Signal>      signals;    // sorted by x
+    std::vector<RoadVehicle> vehicles;
+    std::vector<SignalDue>   heap;       // earliest first
+    uint64_t changes, wakes;             // for --bench
+};
 
-    glDisable(GL_BLEND);
-}
+TrafficRoad sceneRoad;
+int         mainSignal       = 0;          // the light at x = 700 (trafficState)
+int         signalCount      = 1;          // --signals N
+PhasePlan   signalPlan       = {120, 40, 100};   // --signal-plan R:Y:G
+uint32_t    signalLayout     = 0;          // bumped on every re-layout (stateAt caches)
 
-// Hot air balloon in sky
-void drawHotAirBalloon() {
-    float bx = std::fmod(balloonPosition, WIDTH + 300.0f) - 150.0f;
-    float by = 520.0f + 18.0f * std::sin(balloonPosition * 0.01f);
+static uint32_t ticksBefore(float dist, float step, float from);   // SCENE TIMERS
 
-    glPushMatrix();
-    glTranslatef(bx, by, 0.0f);
+// heap order on wrapping tick numbers
+static bool signalLater(const SignalDue& a, const SignalDue& b) {
+    return (int32_t)(a.first - b.first) > 0;
+}
 
-    glColor3f(0.95f, 0.4f, 0.4f);
-    drawCircle(0.0f, 0.0f, 22.0f);
+static int planCycle(const PhasePlan& p) { return p.red + p.yellow + p.green; }
 
-    glColor3f(0.9f, 0.8f, 0.2f);
-    glBegin(GL_TRIANGLES);
-    glVertex2f(-12, -6);
-    glVertex2f(12, -6);
-    glVertex2f(0, -24);
-    glEnd();
+// same formula the single light always used: (int)timer % 260 < 120 -> red ...
+static int32_t signalPhase(const PhasePlan& p, int offset, float timer) {
+    int c = ((int)timer + offset) % planCycle(p);
+    return (c < p.red) ? 0 : (c < p.red + p.yellow) ? 1 : 2;
+}
 
-    glColor3f(0.3f, 0.2f, 0.1f);
-    glBegin(GL_LINES);
-    glVertex2f(-6, -18);
-    glVertex2f(-6, -30);
-    glVertex2f(6, -18);
-    glVertex2f(6, -30);
-    glEnd();
+// timer units to the next phase edge of a signal, read the way
+// signalPhase() reads it: (int)timer + offset (a float timer + offset can
+// round up across the edge and push the next check a whole phase late)
+static float signalEdgeDistance(const PhasePlan& p, int offset, float timer) {
+    int c    = ((int)timer + offset) % planCycle(p);
+    int edge = (c < p.red) ? p.red : (c < p.red + p.yellow) ? p.red + p.yellow : planCycle(p);
+    return (float)(edge - c) - (timer - (float)(int)timer);
+}
 
-    glColor3f(0.6f, 0.4f, 0.2f);
-    glBegin(GL_QUADS);
-    glVertex2f(-10, -30);
-    glVertex2f(10, -30);
-    glVertex2f(8, -40);
-    glVertex2f(-8, -40);
-    glEnd();
+static void pushSignal(TrafficRoad& r, int i, float timer, float speed, uint32_t now) {
+    const Signal& s = r.signals[i];
+    uint32_t delay = ticksBefore(signalEdgeDistance(r.plans[s.plan], s.offset, timer), speed, timer);
+    r.heap.push_back(SignalDue(now + delay, i));
+    std::push_heap(r.heap.begin(), r.heap.end(), signalLater);
+}
 
-    glPopMatrix();
+// every signal from scratch: keys, seeks, loads and the 10000 timer reset
+static void resetSignals(TrafficRoad& r, float timer, float speed, uint32_t now) {
+    r.heap.clear();
+    for (size_t i = 0; i < r.signals.size(); i++) {
+        Signal& s = r.signals[i];
+        s.state = signalPhase(r.plans[s.plan], s.offset, timer);
+        s.queue = -1;
+        pushSignal(r, (int)i, timer, speed, now);
+    }
+    for (size_t v = 0; v < r.vehicles.size(); v++) {
+        r.vehicles[v].queued = false;
+        r.vehicles[v].next   = 0;
+    }
 }
 
-// Fireflies at night
-void drawFireflies() {
-    if (isDay || dayNightBlend > 0.4f) return;
+// the signals due at `now` re-read their phase; a light leaving red lets
+// its queue go (those vehicles move again this same tick)
+static void fireSignals(TrafficRoad& r, float timer, float speed, uint32_t now) {
+    while (!r.heap.empty() && !signalLater(r.heap.front(), SignalDue(now, 0))) {
+        std::pop_heap(r.heap.begin(), r.heap.end(), signalLater);
+        int i = r.heap.back().second;
+        r.heap.pop_back();
+
+        Signal& s     = r.signals[i];
+        int32_t state = signalPhase(r.plans[s.plan], s.offset, timer);
+        if (state != s.state) r.changes++;
+        if (s.state == 0 && state != 0) {
+            for (int v = s.queue; v >= 0; v = r.vehicles[v].queueNext) {
+                r.vehicles[v].queued = false;
+                r.wakes++;
+            }
+            s.queue = -1;
+        }
+        s.state = state;
+        pushSignal(r, i, timer, speed, now);
+    }
+}
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+static uint32_t nextSignalDue(const TrafficRoad& r) {
+    return r.heap.empty() ? UINT32_MAX : r.heap.front().first;
+}
 
-    glPointSize(3.0f);
-    glBegin(GL_POINTS);
-    for (int i = 0; i < 40; ++i) {
-        float x = 120.0f + (i * 37) % (WIDTH - 240);
-        float y = 290.0f + (i * 23) % 80;
+// one tick for every vehicle that is not waiting at a red
+static void moveRoadVehicles(TrafficRoad& r, float speed) {
+    const int count = (int)r.signals.size();
+    for (size_t v = 0; v < r.vehicles.size(); v++) {
+        RoadVehicle& rv = r.vehicles[v];
+        if (rv.queued) continue;
+
+        float x = std::fmod(*rv.pos, rv.span) - rv.back;
+        if (rv.next > 0 && x < r.signals[rv.next - 1].x - 10.0f) rv.next = 0;   // wrapped
+        while (rv.next < count && x >= r.signals[rv.next].x - 10.0f) rv.next++;
+
+        if (rv.next < count) {
+            Signal& s = r.signals[rv.next];
+            if (s.state == 0 && x > s.x - 80.0f) {
+                rv.queued    = true;
+                rv.queueNext = s.queue;
+                s.queue      = (int)v;
+                continue;
+            }
+        }
+        *rv.pos += rv.step * speed;
+    }
+}
 
-        float phase = sunAngle * 10.0f + i * 0.4f;
-        float a = 0.2f + 0.4f * (std::sin(phase) * 0.5f + 0.5f);
+// green-wave offset: a light dx further on turns green dx / step ticks later
+static int waveOffset(float dx, float step, const PhasePlan& p) {
+    int cycle = planCycle(p);
+    int lag   = (int)std::floor(dx / step + 0.5f) % cycle;
+    return ((cycle - lag) % cycle + cycle) % cycle;
+}
 
-        glColor4f(1.0f, 1.0f, 0.6f, a);
-        glVertex2f(x, y);
+// The village road: the light at x = 700 plus (count - 1) more spread
+// evenly along the road, offset for a green wave at the car's speed.
+void initRoadSignals(int count) {
+    count = std::max(1, std::min(count, MAX_ROAD_SIGNALS));
+    sceneRoad.plans.assign(1, signalPlan);
+    sceneRoad.signals.clear();
+
+    float spacing = (WIDTH - 200.0f) / count;
+    for (int k = 0; k < count; k++) {
+        float x  = 100.0f + std::fmod(600.0f + spacing * k, WIDTH - 200.0f);
+        Signal s = {x, 0, waveOffset(x - 700.0f, 1.8f, signalPlan), 0, -1};
+        sceneRoad.signals.push_back(s);
     }
-    glEnd();
-
-    glDisable(GL_BLEND);
+    std::sort(sceneRoad.signals.begin(), sceneRoad.signals.end(),
+              [](const Signal& a, const Signal& b) { return a.x < b.x; });
+    for (int k = 0; k < count; k++)
+        if (sceneRoad.signals[k].x == 700.0f) mainSignal = k;
+
+    RoadVehicle car = {&carPosition, 1.8f, WIDTH + 300.0f, 150.0f, 0, -1, false};
+    RoadVehicle bus = {&busPosition, 1.5f, WIDTH + 500.0f, 200.0f, 0, -1, false};
+    sceneRoad.vehicles.assign(1, car);
+    sceneRoad.vehicles.push_back(bus);
+
+    sceneRoad.changes = sceneRoad.wakes = 0;
+    signalLayout++;
 }
 
-// Festival decorative lights (DDA wire)
-void drawFestivalLights() {
-    if (!festivalMode || isDay) return;
+// Traffic light with simple cycle (one per signal)
+void drawTrafficLight() {
+    for (size_t i = 0; i < sceneRoad.signals.size(); i++) {
+        float   x     = sceneRoad.signals[i].x;
+        float   y     = 280.0f;
+        int32_t state = sceneRoad.signals[i].state;
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        CullBox box = {x - 12.0f, y, x + 12.0f, y + 85.0f};
+        if (!cullVisible(CULL_PROP, box)) continue;
 
-    float y = 330.0f;
+        glColor3f(0.2f, 0.2f, 0.2f);
+        glBegin(GL_QUADS);
+        glVertex2f(x - 4, y);
+        glVertex2f(x + 4, y);
+        glVertex2f(x + 4, y + 50);
+        glVertex2f(x - 4, y + 50);
+        glEnd();
 
-    for (int h = 0; h < 2; ++h) {
-        float startX = 110.0f + h * 200.0f;
-        float endX   = startX + 90.0f;
+        glBegin(GL_QUADS);
+        glVertex2f(x - 12, y + 50);
+        glVertex2f(x + 12, y + 50);
+        glVertex2f(x + 12, y + 85);
+        glVertex2f(x - 12, y + 85);
+        glEnd();
 
-        // ------------------ WIRE USING DDA ------------------
-        glColor4f(0.8f, 0.8f, 0.8f, 0.6f);
-        glPointSize(2.0f);
+        float redA    = (state == 0) ? 1.0f : 0.25f;
+        float yellowA = (state == 1) ? 1.0f : 0.25f;
+        float greenA  = (state == 2) ? 1.0f : 0.25f;
 
-        // create points along curve, then connect each segment with DDA
-        float prevX = startX;
-        float prevY = y + 6.0f * std::sin(0.0f * 3.1415f); // t=0
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        for (int i = 1; i <= 6; ++i) {
-            float t  = i / 6.0f;
-            float cx = startX + t * (endX - startX);
-            float cy = y + 6.0f * std::sin(t * 3.1415f);
+        glColor4f(1.0f, 0.2f, 0.2f, redA);
+        drawCircle(x, y + 79, 6);
+        glColor4f(1.0f, 0.9f, 0.3f, yellowA);
+        drawCircle(x, y + 67, 6);
+        glColor4f(0.2f, 1.0f, 0.2f, greenA);
+        drawCircle(x, y + 55, 6);
 
-            drawLineDDA((int)prevX, (int)prevY, (int)cx, (int)cy);
+        glDisable(GL_BLEND);
+    }
+}
 
-            prevX = cx;
-            prevY = cy;
-        }
+// ============================================================================
+// SCENE TIMERS (hierarchical timer wheel)
+// Traffic phases, swing reversal and the object wraps used to be checked
+// with a modulo / compare per object per tick. Now each one is an event
+// scheduled for the tick it can first happen, in a 4-level wheel of 64
+// slots (64^4 ticks ~ 74 h). A tick only touches the slot it lands on, and
+// a higher level is cascaded down once every 64^L ticks.
+// Estimates are conservative (top speed, max wind, never late): a firing
+// event re-runs the original check and reschedules, so the simulation is
+// bit-for-bit what the per-tick checks produced.
+// ============================================================================
 
-        // ------------------ BULBS (same as before) ------------------
-        for (int i = 0; i <= 6; ++i) {
-            float t  = i / 6.0f;
-            float x  = startX + t * (endX - startX);
-            float yy = y + 6.0f * std::sin(t * 3.1415f);
+enum SceneTimer {
+    TM_TRAFFIC, TM_SWING, TM_RAIN,
+    TM_CLOUD, TM_BOAT, TM_BIRD, TM_CAR, TM_BUS,
+    TM_PLANE, TM_TRAIN, TM_FISH, TM_BALLOON, TM_KITE,
+    TM_COUNT
+};
 
-            int colorIndex = (i + (int)(sunAngle * 4)) % 3;
-            if (colorIndex == 0)      glColor4f(1.0f, 0.3f, 0.3f, 0.9f);
-            else if (colorIndex == 1) glColor4f(0.3f, 1.0f, 0.3f, 0.9f);
-            else                      glColor4f(1.0f, 1.0f, 0.3f, 0.9f);
+#define TIMER_BIT(ev) (1u << (ev))
 
-            // drawCircle(x, yy, 3.0f);
-            glPointSize(2.0f);
-            drawCircleMidpoint((int)x, (int)yy, 3);
+const int      WHEEL_BITS      = 6;
+const int      WHEEL_SLOTS     = 1 << WHEEL_BITS;
+const int      WHEEL_LEVELS    = 4;
+const uint32_t WHEEL_MAX_DELAY = (1u << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+
+struct TimerWheel {
+    uint32_t now;
+    uint32_t due[TM_COUNT];
+    int8_t   next[TM_COUNT];                      // intrusive slot lists
+    int8_t   head[WHEEL_LEVELS][WHEEL_SLOTS];
+
+    void clear(uint32_t tick) {
+        now = tick;
+        std::memset(head, -1, sizeof(head));
+    }
+
+    void insert(int ev) {
+        uint32_t diff  = due[ev] - now;
+        int      level = 0;
+        while (level < WHEEL_LEVELS - 1 && diff >= (1u << (WHEEL_BITS * (level + 1))))
+            level++;
+        int slot = (due[ev] >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+        next[ev] = head[level][slot];
+        head[level][slot] = (int8_t)ev;
+    }
+
+    void schedule(int ev, uint32_t delay) {
+        if (delay < 1) delay = 1;
+        if (delay > WHEEL_MAX_DELAY) delay = WHEEL_MAX_DELAY;
+        due[ev] = now + delay;
+        insert(ev);
+    }
+
+    // moves to the next tick; returns the events due on it
+    uint32_t advance() {
+        now++;
+        for (int level = WHEEL_LEVELS - 1; level > 0; level--) {
+            if (now & ((1u << (WHEEL_BITS * level)) - 1)) continue;
+            int8_t& slot = head[level][(now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)];
+            int ev = slot;
+            slot = -1;
+            while (ev >= 0) {
+                int n = next[ev];
+                insert(ev);
+                ev = n;
+            }
+        }
 
+        uint32_t fired = 0;
+        int8_t& slot = head[0][now & (WHEEL_SLOTS - 1)];
+        int ev = slot;
+        slot = -1;
+        while (ev >= 0) {
+            int n = next[ev];
+            if (due[ev] == now) fired |= TIMER_BIT(ev);
+            else                insert(ev);   // a full lap ahead (clamped delay)
+            ev = n;
         }
+        return fired;
     }
+};
 
-    glDisable(GL_BLEND);
+TimerWheel sceneTimers;
+bool       sceneTimersDirty = true;   // keys, seeks and loads reschedule everything
+uint64_t   sceneTimerFires  = 0;      // for --bench
+
+// "pos > limit -> pos = reset" (or "<" for the train, which moves left)
+struct WrapRule {
+    float* pos;
+    float  step;      // per tick at speed 1 (before wind)
+    bool   windy;     // step is also scaled by windIntensity
+    float  limit;
+    float  reset;
+};
+
+const WrapRule WRAP_RULES[TM_COUNT] = {
+    {NULL, 0, false, 0, 0}, {NULL, 0, false, 0, 0}, {NULL, 0, false, 0, 0},
+    {&cloudOffset,     0.4f, true,  WIDTH + 300.0f, -300.0f},
+    {&boatPosition,    1.2f, false, WIDTH + 200.0f, -200.0f},
+    {&birdOffset,      1.8f, false, WIDTH + 150.0f, -150.0f},
+    {&carPosition,     1.8f, false, WIDTH + 250.0f, -250.0f},
+    {&busPosition,     1.5f, false, WIDTH + 400.0f, -400.0f},
+    {&planePosition,   2.2f, false, WIDTH + 350.0f, -350.0f},
+    {&trainPosition,  -1.6f, false, -800.0f,        WIDTH + 400.0f},   // limit: trainWrapX()
+    {&fishPosition,    1.3f, false, WIDTH + 300.0f, -300.0f},
+    {&balloonPosition, 0.5f, false, WIDTH + 600.0f, 0.0f},
+    {&kitePosition,    1.0f, true,  WIDTH + 400.0f, 0.0f},
+};
+
+// the train's wrap point depends on how many coaches it has
+static float wrapLimit(int ev) {
+    return ev == TM_TRAIN ? trainWrapX(trainBogieCount) : WRAP_RULES[ev].limit;
 }
 
+// whole ticks that certainly pass before `dist` is covered at `step` a tick,
+// starting from the value `from`. The value is a float, so each add can
+// round up by half an ulp of the largest magnitude on the way (0.5% at
+// speed 0.1 near the traffic timer's 10000).
+static uint32_t ticksBefore(float dist, float step, float from) {
+    float  reach = std::max(std::fabs(from) + std::fabs(dist), 1.0f);
+    double ulp   = std::ldexp(1.0, std::ilogb(reach) - 23);
+    double k = (double)dist / (step + 0.5 * ulp) * 0.999 - 1.0;
+    if (k < 1.0) return 1;
+    if (k > WHEEL_MAX_DELAY) return WHEEL_MAX_DELAY;
+    return (uint32_t)k;
+}
 
-// Electric poles + wires behind houses
-void drawElectricPolesAndWires() {
-    float yBase      = 360.0f;
-    float poleHeight = 70.0f;
-    float wireY      = yBase + poleHeight - 10.0f;
+static void scheduleSceneTimer(int ev) {
+    float speed   = speedFactor;
+    float maxWind = std::max(windIntensity, 1.2f * windUser);
+
+    switch (ev) {
+        case TM_TRAFFIC: {
+            // earliest signal that may change (see SIGNAL CONTROLLER) or the 10000 reset
+            uint32_t reset = ticksBefore(10000.0f - trafficTimer, speed, trafficTimer);
+            uint32_t due   = nextSignalDue(sceneRoad) - sceneTimers.now;
+            sceneTimers.schedule(ev, std::min(reset, due));
+            break;
+        }
+        case TM_SWING: {
+            float dist = swingForward ? 20.0f - swingAngle : swingAngle + 20.0f;
+            sceneTimers.schedule(ev, ticksBefore(dist, 0.4f * speed, swingAngle));
+            break;
+        }
+        case TM_RAIN:
+            if (isRaining)
+                sceneTimers.schedule(ev, ticksBefore(HEIGHT - rainOffset, 8.0f * speed, rainOffset));
+            break;
+        default: {
+            const WrapRule& w = WRAP_RULES[ev];
+            float step = std::fabs(w.step) * speed * (w.windy ? maxWind : 1.0f);
+            float limit = wrapLimit(ev);
+            float dist  = (w.step > 0.0f) ? limit - *w.pos : *w.pos - limit;
+            sceneTimers.schedule(ev, ticksBefore(dist, step, *w.pos));
+            break;
+        }
+    }
+}
 
-    float xs[] = {140.0f, 300.0f, 460.0f, 620.0f, 780.0f, 940.0f, 1100.0f, 1260.0f};
-    int count = sizeof(xs) / sizeof(xs[0]);
+// the check each event stands for (same code the tick used to run)
+static void fireSceneTimer(int ev) {
+    sceneTimerFires++;
+    switch (ev) {
+        case TM_TRAFFIC: {
+            if (trafficTimer > 10000.0f) {
+                trafficTimer = 0.0f;
+                resetSignals(sceneRoad, trafficTimer, speedFactor, sceneTimers.now);
+            } else {
+                fireSignals(sceneRoad, trafficTimer, speedFactor, sceneTimers.now);
+            }
+            trafficState = sceneRoad.signals[mainSignal].state;   // 0=red,1=yellow,2=green
+            break;
+        }
+        case TM_SWING:
+            if (swingAngle > 20.0f)  swingForward = false;
+            if (swingAngle < -20.0f) swingForward = true;
+            break;
+        case TM_RAIN:
+            if (rainOffset > HEIGHT) rainOffset = 0.0f;
+            break;
+        default: {
+            const WrapRule& w = WRAP_RULES[ev];
+            float limit = wrapLimit(ev);
+            if (w.step > 0.0f ? *w.pos > limit : *w.pos < limit) *w.pos = w.reset;
+            break;
+        }
+    }
+    scheduleSceneTimer(ev);
+}
 
-    glColor3f(0.35f, 0.35f, 0.35f);
-    for (int i = 0; i < count; ++i) {
-        float x = xs[i];
-        glBegin(GL_QUADS);
-            glVertex2f(x - 4, yBase);
-            glVertex2f(x + 4, yBase);
-            glVertex2f(x + 4, yBase + poleHeight);
-            glVertex2f(x - 4, yBase + poleHeight);
-        glEnd();
+// index of the lowest set bit (mask != 0)
+static inline int lowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return (int)i;
+#elif defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int i = 0;
+    while (!(mask & 1u)) { mask >>= 1; i++; }
+    return i;
+#endif
+}
 
-        glBegin(GL_QUADS);
-            glVertex2f(x - 12, yBase + poleHeight);
-            glVertex2f(x + 12, yBase + poleHeight);
-            glVertex2f(x + 12, yBase + poleHeight + 6);
-            glVertex2f(x - 12, yBase + poleHeight + 6);
-        glEnd();
+static void fireSceneTimers(uint32_t mask) {
+    while (mask) {
+        int ev = lowestBit(mask);
+        mask &= mask - 1;
+        fireSceneTimer(ev);
     }
+}
 
-    glColor3f(0.2f, 0.2f, 0.2f);
-    glLineWidth(2.0f);
-    glBegin(GL_LINE_STRIP);
-    for (int i = 0; i < count; ++i) {
-        float x = xs[i];
-        glVertex2f(x, wireY + std::sin(x * 0.01f) * 4.0f);
+// called right after scene.tick++; returns the events due this tick
+static uint32_t sceneTimersDue() {
+    if (sceneTimersDirty || sceneTimers.now + 1 != scene.tick) {
+        sceneTimers.clear(scene.tick - 1);
+        resetSignals(sceneRoad, trafficTimer, speedFactor, sceneTimers.now);
+        for (int ev = 0; ev < TM_COUNT; ev++) scheduleSceneTimer(ev);
+        sceneTimersDirty = false;
     }
-    glEnd();
+    return sceneTimers.advance();
 }
 
-// Simple playground with seesaw + 2 kids (uses swingAngle)
-void drawPlayground() {
-    float sx = 900.0f;
-    float sy = 70.0f;
+// ============================================================================
+// ANIMATION UPDATE
+// stepScene() is one tick of the simulation. It touches nothing but the
+// scene state, so a recording can be replayed headless (see --replay).
+// live = false is the timeline's forward sim: no agent sims (fish, crowd,
+// herd), no checkpoints, no console output.
+// ============================================================================
 
-    // ===================== SAND / GROUND PAD =====================
-    // shadow under pad
-    drawShadowEllipse(sx, sy - 24, 95, 12, 0.22f);
+// wall time of each agent sim per tick, smoothed (HUD readout, --bench)
+enum AgentSim { SIM_FISH, SIM_CROWD, SIM_HERD, SIM_COUNT };
+double simCostMs[SIM_COUNT];
 
-    // sand gradient
-    glBegin(GL_QUADS);
-        glColor3f(0.92f, 0.84f, 0.55f);
-        glVertex2f(sx - 105, sy - 28);
-        glVertex2f(sx + 105, sy - 28);
+static void noteSimCost(int sim, double ms) {
+    simCostMs[sim] += (ms - simCostMs[sim]) * 0.05;
+}
 
-        glColor3f(0.85f, 0.75f, 0.46f);
-        glVertex2f(sx + 105, sy + 14);
-        glVertex2f(sx - 105, sy + 14);
-    glEnd();
+void stepScene(bool live) {
+    if (!animationPaused) {
+        float speed = speedFactor;
 
-    // border frame
-    glColor3f(0.45f, 0.30f, 0.16f);
-    glLineWidth(2.5f);
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(sx - 105, sy - 28);
-        glVertex2f(sx + 105, sy - 28);
-        glVertex2f(sx + 105, sy + 14);
-        glVertex2f(sx - 105, sy + 14);
-    glEnd();
+        const float PI = 3.1415926f;
+
+        scene.tick++;
+        uint32_t due = sceneTimersDue();
+
+        // ✅ day-night angle (NO WRAP / NO AUTO RESET)
+        sunAngle += 0.008f * speed;
+
+        // ✅ use phase only for checking day/night (0..2PI)
+        float phase = std::fmod(sunAngle, 2.0f * PI);
+        if (phase < 0.0f) phase += 2.0f * PI;
+
+        cloudOffset     += 0.4f   * speed * windIntensity;
+        boatPosition    += 1.2f   * speed;
+        birdOffset      += 1.8f   * speed;
+        windmillAngle   += 2.5f   * speed * windIntensity;
+        planePosition   += 2.2f   * speed;
+        trainPosition   -= 1.6f   * speed;
+        personPosition  += 0.8f   * speed;
+        riverWave       += 0.5f   * speed;
+        fishPosition    += 1.3f   * speed;
+        smokeOffset     += 0.3f   * speed;
+        balloonPosition += 0.5f   * speed;
+        kitePosition    += 1.0f   * speed * windIntensity;
+
+        if (live) {
+            double t0 = nowMs();
+            updateFishSchool(speed);
+            double t1 = nowMs();
+            updateCrowd(speed);
+            double t2 = nowMs();
+            updateHerd(speed);
+            noteSimCost(SIM_FISH, t1 - t0);
+            noteSimCost(SIM_CROWD, t2 - t1);
+            noteSimCost(SIM_HERD, nowMs() - t2);
+        }
+
+        // ✅ day/night decision uses phase (NOT sunAngle)
+        bool prevIsDay = isDay;
+        isDay = (phase < PI);
+        if (isDay != prevIsDay && live && !replayMode) {
+            printf("Switched to %s\n", isDay ? "Day" : "Night");
+        }
+
+        // ✅ wind uses phase too (optional but better)
+        float baseWind = 0.8f + 0.4f * std::sin(phase * 0.3f);
+        windIntensity = baseWind * windUser;
 
-    // tiny sand dots
-    glPointSize(2.0f);
-    glBegin(GL_POINTS);
-    for (int i = 0; i < 110; i++) {
-        float x = (i * 29) % 190 - 95;   // -95..95
-        float y = (i * 17) % 34 - 24;    // -24..10
-        float c = 0.86f + (i % 3) * 0.03f;
-        glColor3f(c, c * 0.98f, c * 0.85f);
-        glVertex2f(sx + x, sy + y);
+        swingAngle += (swingForward ? 0.4f : -0.4f) * speed;
+
+        if (isRaining) rainOffset += 8.0f * speed;
+
+        // traffic light cycle (phase changes are timer events)
+        trafficTimer += 1.0f * speed;
+        if (due & TIMER_BIT(TM_TRAFFIC)) fireSceneTimer(TM_TRAFFIC);
+
+        // Car & bus stop on red near the next signal (queued ones sleep)
+        moveRoadVehicles(sceneRoad, speed);
+
+        // swing reversal + object wraps that are due (see WRAP_RULES)
+        fireSceneTimers(due & ~TIMER_BIT(TM_TRAFFIC));
     }
-    glEnd();
 
-    // ===================== SEESAW SUPPORT (TRIANGLE + METAL BAR) =====================
-    // support shadow
-    drawShadowEllipse(sx, sy - 12, 26, 7, 0.28f);
+    // day/night fade + sun glow (used to be done while drawing; runs even
+    // when paused, exactly like before)
+    if (isDay && dayNightBlend < 1.0f) dayNightBlend += 0.02f;
+    if (!isDay && dayNightBlend > 0.0f) dayNightBlend -= 0.02f;
 
-    // wooden triangle support
-    glColor3f(0.48f, 0.30f, 0.18f);
-    glBegin(GL_TRIANGLES);
-        glVertex2f(sx - 14, sy - 20);
-        glVertex2f(sx + 14, sy - 20);
-        glVertex2f(sx,      sy + 2);
-    glEnd();
+    float t = std::fmod(sunAngle, 2.0f * 3.1415926f);
+    if (t < 0.0f) t += 2.0f * 3.1415926f;
+    if (t < 3.1415926f) sunGlow = 0.3f + 0.2f * std::sin(t * 3.0f);
 
-    // highlight on support
-    glColor3f(0.62f, 0.42f, 0.25f);
-    glBegin(GL_TRIANGLES);
-        glVertex2f(sx - 6,  sy - 18);
-        glVertex2f(sx + 6,  sy - 18);
-        glVertex2f(sx,      sy - 2);
-    glEnd();
+    if (live && !animationPaused) recordCheckpoint();
+}
 
-    // center metal pivot bar
-    glColor3f(0.25f, 0.25f, 0.28f);
-    glBegin(GL_QUADS);
-        glVertex2f(sx - 18, sy + 2);
-        glVertex2f(sx + 18, sy + 2);
-        glVertex2f(sx + 18, sy + 6);
-        glVertex2f(sx - 18, sy + 6);
-    glEnd();
+void update(int value) {
+    stepScene();
+    recordTickHash();
+    inputTick++;
 
-    // pivot bolt
-    glColor3f(0.75f, 0.75f, 0.78f);
-    drawCircle(sx, sy + 4, 3.2f, 18);
-    glColor3f(0.25f, 0.25f, 0.25f);
-    drawCircle(sx, sy + 4, 1.2f, 14);
+    glutPostRedisplay();
+    glutTimerFunc(16, update, 0);
+}
 
-    // ===================== SEESAW PLANK (ROTATE WITH swingAngle) =====================
-    float angle = swingAngle * 0.85f;
+// ============================================================================
+// ANALYTIC TIME SEEK
+// stateAt(base, n) = the scene n ticks after `base` with no input, computed
+// directly instead of running stepScene() n times. stepScene() adds in
+// float, and so does this: inside one binade a float add of a fixed step
+// moves by a fixed amount (see floatRun()), so a run of ticks costs a few
+// adds per power of two and ends on the same float the tick loop reaches.
+//  - constant-speed objects: ticks to the first wrap, then whole laps
+//    with a modulo
+//  - swing: bounce to bounce until a bounce value repeats, then modulo
+//  - sun + day/night fade: one half-day at a time; once the fades settle,
+//    whole day/night pairs up to the next power of two are skipped
+//  - car + bus: event walk (free run -> next stop line -> wait for that
+//    light -> wrap); whole laps are cached per traffic-timer phase, so
+//    a seek replays at most one cycle of the lap orbit
+// All of that is bit-exact. The wind-driven accumulators (clouds, kite,
+// windmill) are not: they use the integral of the wind curve over the sun's
+// walk (midpoint rule), and each wrap drops an overshoot of up to one tick's
+// step that is only known on average. After 100k ticks clouds and kite are
+// within a few px at speed 1 but up to ~200 px at speed 8, so past a few
+// laps only the lap count is meaningful. The windmill angle never wraps:
+// expect about a degree per 1k ticks, plus whatever drift the tick loop's
+// own float sum picks up once the angle gets large.
+// The fish school, the pedestrian crowd and the cow herd are agent sims and
+// keep their current state.
+// ============================================================================
 
-    glPushMatrix();
-    glTranslatef(sx, sy + 6.0f, 0.0f);
-    glRotatef(angle, 0, 0, 1);
+const double TICKS_PER_SECOND = 1000.0 / 16.0;   // glutTimerFunc(16, ...)
+const double TWO_PI_D         = 6.283185307179586;
+const double PI_D             = 3.141592653589793;
+const float  SUN_PI           = 3.1415926f;       // stepScene()'s PI
 
-    // plank shadow (under it)
-    glColor3f(0.15f, 0.12f, 0.10f);
-    glLineWidth(8.0f);
-    glBegin(GL_LINES);
-        glVertex2f(-78, -6);
-        glVertex2f( 78, -6);
-    glEnd();
+// one straight piece of a float walk: ticks k0+1 .. k0+len hold x0 + i * step
+struct FloatPiece {
+    uint64_t k0, len;
+    float    x0;
+    double   step;
+};
 
-    // plank (wood) with shading
-    glBegin(GL_QUADS);
-        glColor3f(0.78f, 0.58f, 0.32f);
-        glVertex2f(-80,  4);
-        glVertex2f( 80,  4);
+// x += d in float (as stepScene() does), up to n times, stopping before
+// the first add that would leave `limit` behind (x > limit for d > 0,
+// x < limit for d < 0). Returns the adds done. All values in one binade
+// are multiples of the same ulp, so once the rounding of x + d has settled
+// (a tie to even can take one add) every add moves x by the same amount:
+// a few real adds per binade, one multiply for the rest.
+static uint64_t floatRun(float& x, float d, uint64_t n, double limit,
+                         std::vector<FloatPiece>* path = NULL) {
+    auto inside = [d, limit](float v) { return d > 0.0f ? v <= limit : v >= limit; };
+    uint64_t k = 0;
+    while (k < n) {
+        float x1 = x + d;
+        if (!inside(x1)) break;
+        if (path) path->push_back({k, 1, x, (double)x1 - x});
+        x = x1;
+        if (++k == n || x == 0.0f) continue;
+
+        float  x2   = x + d, x3 = x2 + d;
+        double step = (double)x2 - x;
+        if (step == 0.0) {                           // the add rounds away: x is stuck
+            if (path) path->push_back({k, n - k, x, 0.0});
+            return n;
+        }
+        if ((double)x3 - x2 != step) continue;       // rounding not settled yet
+
+        int e;
+        std::frexp(x, &e);                           // 2^(e-1) <= |x| < 2^e
+        bool   away  = (x > 0.0f) == (d > 0.0f);
+        double edge  = std::ldexp(1.0, away ? e : e - 1);
+        double room  = std::fabs(edge - std::fabs((double)x)) - 2.0 * (std::fabs((double)d) + std::fabs(step));
+        double steps = std::min(std::floor(room / std::fabs(step)),
+                                std::floor((limit - x) / step) - 1.0);
+        steps = std::min(steps, (double)(n - k));
+        if (steps < 1.0) continue;
+
+        if (path) path->push_back({k, (uint64_t)steps, x, step});
+        x  = (float)((double)x + steps * step);
+        k += (uint64_t)steps;
+    }
+    return k;
+}
 
-        glColor3f(0.62f, 0.44f, 0.22f);
-        glVertex2f( 80, -6);
-        glVertex2f(-80, -6);
-    glEnd();
+// largest float below x: for a float v, "v >= x" is "v > floatBelow(x)"
+static double floatBelow(double x) {
+    float f = (float)x;
+    if ((double)f >= x) f = std::nextafter(f, -INFINITY);
+    return f;
+}
 
-    // plank outline
-    glColor3f(0.20f, 0.15f, 0.10f);
-    glLineWidth(2.0f);
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(-80,  4);
-        glVertex2f( 80,  4);
-        glVertex2f( 80, -6);
-        glVertex2f(-80, -6);
-    glEnd();
+// value after n ticks of "x += d; past wrapAt -> x = wrapTo" (for d < 0
+// past means below: the train)
+static float wrapCounterAt(float x, float d, float wrapAt, float wrapTo, uint64_t n) {
+    uint64_t k = floatRun(x, d, n, wrapAt);
+    if (k == n) return x;
+    n -= k + 1;                                      // that tick wraps
+
+    float    q   = wrapTo;
+    uint64_t lap = floatRun(q, d, UINT64_MAX, wrapAt);
+    if (lap != UINT64_MAX) n %= lap + 1;
+    x = wrapTo;
+    floatRun(x, d, n, wrapAt);
+    return x;
+}
 
-    // seats (left & right)
-    auto seat = [&](float x) {
-        glColor3f(0.20f, 0.22f, 0.24f);
-        glBegin(GL_QUADS);
-            glVertex2f(x - 12,  5);
-            glVertex2f(x + 12,  5);
-            glVertex2f(x + 10,  11);
-            glVertex2f(x - 10,  11);
-        glEnd();
+// distance-based version for steps that vary (wind): D = total distance,
+// dMean = average step. On a wrap the overshoot is lost, on average dMean/2.
+static double wrapDistanceAt(double x0, double D, double dMean, double wrapAt, double wrapTo) {
+    if (x0 + D <= wrapAt) return x0 + D;
+    double rest = D - (wrapAt - x0) - dMean * 0.5;
+    double lap  = (wrapAt - wrapTo) + dMean * 0.5;
+    if (rest < 0.0) rest = 0.0;
+    double x = wrapTo + std::fmod(rest, lap);
+    return (x > wrapAt) ? wrapAt : x;
+}
 
-        // seat highlight
-        glColor3f(0.45f, 0.48f, 0.52f);
-        glBegin(GL_LINES);
-            glVertex2f(x - 9, 9);
-            glVertex2f(x + 9, 9);
-        glEnd();
-    };
-    seat(-65);
-    seat( 65);
+// primitive of the wind curve 0.8 + 0.4*sin(0.3 * (theta mod 2PI))
+static double windIntegral(double theta) {
+    double cycles = std::floor(theta / TWO_PI_D);
+    double r      = theta - cycles * TWO_PI_D;
+    double full   = (1.0 - std::cos(0.6 * PI_D)) / 0.3;
+    return 0.8 * theta + 0.4 * (cycles * full + (1.0 - std::cos(0.3 * r)) / 0.3);
+}
 
-    // handles
-    glColor3f(0.85f, 0.20f, 0.20f);
-    glLineWidth(3.5f);
-    glBegin(GL_LINES);
-        glVertex2f(-70, 12); glVertex2f(-58, 12);
-        glVertex2f( 58, 12); glVertex2f( 70, 12);
-    glEnd();
+// ---------------------------------------------------------------------------
+// traffic light clock: timer += s, reset to 0 once above 10000
+// ---------------------------------------------------------------------------
+struct TrafficClock {
+    float    t0, s;
+    uint64_t firstReset;   // tick at which the timer first resets to 0
+    uint64_t period;       // ticks per reset cycle after that
+    std::vector<FloatPiece> head, lap;   // the walks t0 -> reset, 0 -> reset
+
+    TrafficClock(float timer0, float speed) : t0(timer0), s(speed) {
+        float t = t0;
+        firstReset = floatRun(t, s, UINT64_MAX, 10000.0, &head) + 1;
+        t = 0.0f;
+        period = floatRun(t, s, UINT64_MAX, 10000.0, &lap) + 1;
+    }
 
-    // ===================== KIDS (MORE REALISTIC SIMPLE) =====================
-    auto kid = [&](float x, float headY, float shirtR, float shirtG, float shirtB) {
-        // head
-        glColor3f(1.0f, 0.9f, 0.8f);
-        drawCircle(x, headY, 5.2f, 18);
+    // timer value after tick k
+    float at(uint64_t k) const {
+        if (k >= firstReset) return walkAt(lap, 0.0f, (k - firstReset) % period);
+        return walkAt(head, t0, k);
+    }
 
-        // body (shirt)
-        glColor3f(shirtR, shirtG, shirtB);
-        glBegin(GL_QUADS);
-            glVertex2f(x - 4.5f, headY - 6);
-            glVertex2f(x + 4.5f, headY - 6);
-            glVertex2f(x + 6.0f, headY - 18);
-            glVertex2f(x - 6.0f, headY - 18);
-        glEnd();
+    static float walkAt(const std::vector<FloatPiece>& path, float x0, uint64_t k) {
+        if (k == 0 || path.empty()) return x0;
+        std::vector<FloatPiece>::const_iterator it = std::upper_bound(
+            path.begin(), path.end(), k - 1,
+            [](uint64_t t, const FloatPiece& p) { return t < p.k0; });
+        --it;
+        return (float)((double)it->x0 + (double)(k - it->k0) * it->step);
+    }
 
-        // arms
-        glColor3f(shirtR * 0.85f, shirtG * 0.85f, shirtB * 0.85f);
-        glLineWidth(2.5f);
-        glBegin(GL_LINES);
-            glVertex2f(x, headY - 10); glVertex2f(x - 9, headY - 14);
-            glVertex2f(x, headY - 10); glVertex2f(x + 9, headY - 14);
-        glEnd();
+    // a signal's phase after tick k (as signalPhase())
+    bool red(uint64_t k, const PhasePlan& p, int off) const {
+        return signalPhase(p, off, at(k)) == 0;
+    }
 
-        // legs
-        glColor3f(0.10f, 0.10f, 0.12f);
-        glLineWidth(3.0f);
-        glBegin(GL_LINES);
-            glVertex2f(x - 2, headY - 18); glVertex2f(x - 7, headY - 30);
-            glVertex2f(x + 2, headY - 18); glVertex2f(x + 7, headY - 30);
-        glEnd();
+    // first tick >= k at which that signal is not red
+    uint64_t nextNotRed(uint64_t k, const PhasePlan& p, int off) const {
+        float t = at(k);
+        while (signalPhase(p, off, t) == 0) {
+            int cycle = planCycle(p);
+            int ends  = cycle * (((int)t + off) / cycle) + p.red - off;   // (int)timer at green
+            // stay below that, and never run across a timer reset (a new red)
+            k += floatRun(t, s, UINT64_MAX, std::min(floatBelow(ends), 10000.0)) + 1;
+            t  = at(k);
+        }
+        return k;
+    }
+};
 
-        // shoes
-        glColor3f(0.05f, 0.05f, 0.05f);
-        drawCircle(x - 7, headY - 30, 2.2f, 14);
-        drawCircle(x + 7, headY - 30, 2.2f, 14);
-    };
+// one signal's stop line in a vehicle's position units
+struct StopZone {
+    double    lo, hi;         // stops while lo < pos < hi and red
+    PhasePlan plan;
+    int       offset;
+};
 
-    float kidBase = 24.0f;
-    kid(-65, kidBase, 0.20f, 0.65f, 0.95f);  // left kid (blue)
-    kid( 65, kidBase, 0.90f, 0.35f, 0.35f);  // right kid (red)
+// a vehicle that waits at the red lights (car or bus)
+struct StopMover {
+    float  step;                    // px per tick
+    std::vector<StopZone> zones;    // sorted along the road
+    float  wrapAt, wrapTo;
+
+    // the zone p is in or the next one ahead, NULL past the last
+    const StopZone* zoneFrom(double p) const {
+        for (size_t i = 0; i < zones.size(); i++)
+            if (p < zones[i].hi) return &zones[i];
+        return NULL;
+    }
+};
 
-    glPopMatrix();
+// moveRoadVehicles() compares fmod(pos, span) - back with the float stop
+// line; on the road that subtraction is exact, so pos > line + back is the
+// same test
+static StopMover stopMover(float step, float back, float wrapAt, float wrapTo) {
+    StopMover m = {step, {}, wrapAt, wrapTo};
+    for (size_t i = 0; i < sceneRoad.signals.size(); i++) {
+        const Signal& s = sceneRoad.signals[i];
+        StopZone z = {(double)(s.x - 80.0f) + back, (double)(s.x - 10.0f) + back,
+                      sceneRoad.plans[s.plan], s.offset};
+        m.zones.push_back(z);
+    }
+    return m;
 }
 
+// Advances from (p after tick k) towards tick n. Returns the tick reached;
+// with untilWrap it stops right after the next wrap.
+static uint64_t advanceMover(const StopMover& m, const TrafficClock& c,
+                             float& p, uint64_t k, uint64_t n, bool untilWrap) {
+    while (k < n) {
+        const StopZone* z = m.zoneFrom(p);
+        if (z && p > z->lo) {
+            if (c.red(k + 1, z->plan, z->offset)) {   // waiting at the line
+                uint64_t go = c.nextNotRed(k + 1, z->plan, z->offset);
+                if (go > n) return n;
+                k = go - 1;
+                continue;
+            }
+            p += m.step;
+            k++;
+            if (p > m.wrapAt) { p = m.wrapTo; if (untilWrap) return k; }
+            continue;
+        }
 
-// Kite in sky
-void drawKite() {
-    float tx = std::fmod(kitePosition, WIDTH + 200.0f) - 100.0f;
-    float ty = 520.0f + 15.0f * std::sin(kitePosition * 0.03f);
+        // free run up to the next event (reaching a stop zone, or the wrap)
+        k += floatRun(p, m.step, n - k, z ? z->lo : m.wrapAt);
+        if (k == n) return n;
+        p += m.step;
+        k++;
+        if (p > m.wrapAt) { p = m.wrapTo; if (untilWrap) return k; }
+    }
+    return k;
+}
 
-    // ✅ BIG values for clear demo
-    float sx  = useScaleT ? 1.8f : 1.0f;
-    float sy  = useScaleT ? 1.8f : 1.0f;
+// Lap lengths depend only on the light phase at the moment of the wrap, so
+// they are cached per phase (one table per mover / speed / timer origin /
+// signal layout).
+struct LapCache {
+    float    step, t0, s;
+    uint64_t firstReset;
+    uint32_t layout;
+    std::vector<uint32_t> lapTicks;   // 0 = not computed yet
+};
 
-    float rot = useRotateT ? (std::sin(kitePosition * 0.02f) * 60.0f) : 0.0f;
+static float moverAt(const StopMover& m, const TrafficClock& c, LapCache& cache,
+                     float p0, uint64_t n) {
+    if (cache.step != m.step || cache.t0 != c.t0 || cache.s != c.s ||
+        cache.firstReset != c.firstReset || cache.layout != signalLayout) {
+        cache.step = m.step; cache.t0 = c.t0; cache.s = c.s;
+        cache.firstReset = c.firstReset; cache.layout = signalLayout;
+        cache.lapTicks.assign((size_t)c.period, 0u);
+    }
 
-    // ✅ Reflection always ON when toggle is ON (no random flip)
-    bool refX = false;
-    bool refY = useReflectT;
+    float    p = p0;
+    uint64_t k = 0;
 
-    // ✅ BIG shear values so V is clearly visible
-    float shx = useShearT ? 0.90f : 0.0f;
-    float shy = useShearT ? 0.40f : 0.0f;
+    // until the light settles into its repeating cycle: plain event walk
+    while (k < n && (k < c.firstReset || p != m.wrapTo)) {
+        uint64_t stop = (k < c.firstReset) ? std::min<uint64_t>(n, c.firstReset) : n;
+        k = advanceMover(m, c, p, k, stop, k >= c.firstReset);
+    }
+    if (k >= n) return p;
+
+    // at a wrap, light phase known: jump whole laps, skipping repeated orbits
+    std::vector<uint64_t> seenAt(cache.lapTicks.size(), UINT64_MAX);
+    bool skipped = false;
+    for (;;) {
+        uint64_t phase = (k - c.firstReset) % c.period;
+        uint32_t& lap  = cache.lapTicks[phase];
+        if (lap == 0) {
+            float    q  = m.wrapTo;
+            uint64_t k0 = c.firstReset + phase;
+            lap = (uint32_t)(advanceMover(m, c, q, k0, UINT64_MAX, true) - k0);
+        }
 
-    // ✅ bigger diamond for better visibility
-    Vec2 top    = {  0,  28 };
-    Vec2 right  = { 22,   0 };
-    Vec2 bottom = {  0, -28 };
-    Vec2 left   = { -22,  0 };
+        if (!skipped) {
+            if (seenAt[phase] != UINT64_MAX) {
+                uint64_t orbit = k - seenAt[phase];
+                k += ((n - k) / orbit) * orbit;
+                skipped = true;
+                continue;
+            }
+            seenAt[phase] = k;
+        }
 
-    Vec2 T = applyAllTransforms(top,    sx, sy, rot, refX, refY, shx, shy, tx, ty);
-    Vec2 R = applyAllTransforms(right,  sx, sy, rot, refX, refY, shx, shy, tx, ty);
-    Vec2 B = applyAllTransforms(bottom, sx, sy, rot, refX, refY, shx, shy, tx, ty);
-    Vec2 L = applyAllTransforms(left,   sx, sy, rot, refX, refY, shx, shy, tx, ty);
+        if (k + lap > n) break;
+        k += lap;
+    }
 
-    // ✅ Two different colors (so Reflection C is obvious)
-    // Right half (red)
-    glColor3f(1.0f, 0.25f, 0.25f);
-    glBegin(GL_TRIANGLES);
-        glVertex2f(T.x, T.y);
-        glVertex2f(R.x, R.y);
-        glVertex2f(B.x, B.y);
-    glEnd();
+    p = m.wrapTo;
+    advanceMover(m, c, p, k, n, false);
+    return p;
+}
 
-    // Left half (blue)
-    glColor3f(0.25f, 0.65f, 1.0f);
-    glBegin(GL_TRIANGLES);
-        glVertex2f(T.x, T.y);
-        glVertex2f(B.x, B.y);
-        glVertex2f(L.x, L.y);
-    glEnd();
+// ping-pong swing: leg by leg; once the value at a top bounce repeats, the
+// rest is whole orbits
+static void swingAt(float v, bool fwd, float d, uint64_t n, float& vOut, bool& fwdOut) {
+    std::vector<std::pair<float, uint64_t> > tops;   // value after a top bounce, tick
+    bool     periodic = false;
+    uint64_t k = 0;
+    while (k < n) {
+        float step = fwd ? d : -d;
+        k += floatRun(v, step, n - k, fwd ? 20.0 : -20.0);
+        if (k == n) break;
+        v += step;                                   // goes past: turns this tick
+        k++;
+        fwd = !fwd;
+
+        if (!fwd && !periodic) {
+            for (size_t i = 0; i < tops.size() && !periodic; i++) {
+                if (tops[i].first != v) continue;
+                uint64_t orbit = k - tops[i].second;
+                k += ((n - k) / orbit) * orbit;
+                periodic = true;
+            }
+            tops.push_back(std::make_pair(v, k));
+        }
+    }
+    vOut   = v;
+    fwdOut = fwd;
+}
 
-    // Outline (black)
-    glColor3f(0.08f, 0.08f, 0.08f);
-    glLineWidth(2.0f);
-    glBegin(GL_LINE_LOOP);
-        glVertex2f(T.x, T.y);
-        glVertex2f(R.x, R.y);
-        glVertex2f(B.x, B.y);
-        glVertex2f(L.x, L.y);
-    glEnd();
+// dayNightBlend moves 0.02 a tick towards the current day/night target
+// (stepScene(): "if below 1, add"). Returns true when it got there with
+// ticks to spare.
+static bool fadeBy(float& v, bool toDay, uint64_t ticks) {
+    if (toDay ? v >= 1.0f : v <= 0.0f) return true;
+    uint64_t k = floatRun(v, toDay ? 0.02f : -0.02f, ticks,
+                          toDay ? floatBelow(1.0) : -floatBelow(0.0));
+    if (k == ticks) return false;
+    v += toDay ? 0.02f : -0.02f;
+    return k + 2 < ticks;
+}
 
-    // Cross stick (single line)
-    Vec2 stickL = { -20, 0 };
-    Vec2 stickR = {  20, 0 };
-    stickL = applyAllTransforms(stickL, sx, sy, rot, refX, refY, shx, shy, tx, ty);
-    stickR = applyAllTransforms(stickR, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+// the sun phase stepScene() tests (day while below SUN_PI)
+static float sunPhase(float th) {
+    float ph = std::fmod(th, 2.0f * SUN_PI);
+    if (ph < 0.0f) ph += 2.0f * SUN_PI;
+    return ph;
+}
 
-    glColor3f(0.95f, 0.85f, 0.25f);
-    glLineWidth(3.0f);
-    glBegin(GL_LINES);
-        glVertex2f(stickL.x, stickL.y);
-        glVertex2f(stickR.x, stickR.y);
-    glEnd();
+static float sunGlowAt(float th) {
+    return 0.3f + 0.2f * std::sin(sunPhase(th) * 3.0f);
+}
+
+SceneState stateAt(const SceneState& base, uint64_t n) {
+    SceneState st = base;
+    if (n == 0) return st;
+
+    if (base.animationPaused) {   // only the fade (and the glow) keep running
+        fadeBy(st.dayNightBlend, base.isDay, n);
+        if (sunPhase(base.sunAngle) < SUN_PI) st.sunGlow = sunGlowAt(base.sunAngle);
+        return st;
+    }
+
+    const float  sf = base.speedFactor;
+    const double dn = (double)n;
+    st.tick = base.tick + (uint32_t)n;
+
+    // ---- sun / day-night ----
+    const float dth = 0.008f * sf;
+    float thN = base.sunAngle;
+    std::vector<FloatPiece> sunPath;   // for the wind below
+    floatRun(thN, dth, n, INFINITY, &sunPath);
+    st.sunAngle = thN;
+    st.isDay    = sunPhase(thN) < SUN_PI;
+
+    // half-day segments: tick k is day while floor(theta_k / SUN_PI) is even
+    float    th    = base.sunAngle, blend = base.dayNightBlend;
+    uint64_t k     = 0;
+    bool     sawDay = false;
+    float    lastDay = 0.0f;
+    long long prevDaySeg = -1;      // the last day segment: index, start blend,
+    float     prevDayBlend = 0.0f;  // binade of theta and whether both fades
+    int       prevDayExp = 0;       // since then finished with ticks to spare
+    bool      settledSince = false;
+    while (k < n) {
+        float     t1 = th + dth;
+        long long j  = (long long)std::floor((double)t1 / SUN_PI);
+        if ((double)j * SUN_PI > t1)             j--;
+        else if ((double)(j + 1) * SUN_PI <= t1) j++;
+        bool day = (j % 2 == 0);
+
+        if (day) {
+            int e;
+            std::frexp(th, &e);
+            if (settledSince && j == prevDaySeg + 2 && blend == prevDayBlend && e == prevDayExp) {
+                // the fades repeat: jump to the last day segment that starts
+                // inside this binade and no later than tick n
+                double    cap = std::min(std::ldexp(1.0, e), (double)thN);
+                long long J   = (long long)std::floor(cap / SUN_PI);
+                if ((double)J * SUN_PI > cap) J--;
+                J -= (J - j) & 1;
+                if (J > j) {
+                    k += floatRun(th, dth, n - k, floatBelow((double)J * SUN_PI));
+                    j  = J;
+                }
+            }
+            prevDaySeg = j; prevDayBlend = blend; prevDayExp = e;
+            settledSince = true;
+        }
+
+        uint64_t m = floatRun(th, dth, n - k, floatBelow((double)(j + 1) * SUN_PI));
+        settledSince = fadeBy(blend, day, m) && settledSince;
+        if (day) { sawDay = true; lastDay = th; }
+        k += m;
+    }
+    st.dayNightBlend = blend;
+    if (sawDay) st.sunGlow = sunGlowAt(lastDay);
+
+    // ---- wind: each tick uses the wind of the previous tick ----
+    const double s = sf;
+    st.windIntensity = (0.8f + 0.4f * std::sin(sunPhase(thN) * 0.3f)) * base.windUser;
+    double windSum = base.windIntensity;                 // tick 1
+    for (size_t i = 0; i < sunPath.size(); i++) {       // ticks 2..n: the sun at 1..n-1
+        const FloatPiece& p = sunPath[i];
+        double len = (double)std::min<uint64_t>(p.len, n - 1 - std::min<uint64_t>(p.k0, n - 1));
+        if (len <= 0.0) break;
+        if (p.step == 0.0) {
+            windSum += len * (0.8 + 0.4 * std::sin(sunPhase(p.x0) * 0.3)) * base.windUser;
+            continue;
+        }
+        double a = p.x0 + p.step * 0.5;                  // midpoint rule over the piece
+        double b = p.x0 + p.step * (len + 0.5);
+        windSum += base.windUser * (windIntegral(b) - windIntegral(a)) / p.step;
+    }
+
+    double cloudD = 0.4 * s * windSum;
+    st.cloudOffset   = (float)wrapDistanceAt(base.cloudOffset, cloudD, cloudD / dn, WIDTH + 300, -300);
+    st.windmillAngle = (float)(base.windmillAngle + 2.5 * s * windSum);
+    double kiteD = 1.0 * s * windSum;
+    st.kitePosition  = (float)wrapDistanceAt(base.kitePosition, kiteD, kiteD / dn, WIDTH + 400, 0.0);
+
+    // ---- constant speed objects (the same float steps as stepScene()) ----
+    st.boatPosition    = wrapCounterAt(base.boatPosition,    1.2f * sf, WIDTH + 200.0f, -200.0f, n);
+    st.birdOffset      = wrapCounterAt(base.birdOffset,      1.8f * sf, WIDTH + 150.0f, -150.0f, n);
+    st.planePosition   = wrapCounterAt(base.planePosition,   2.2f * sf, WIDTH + 350.0f, -350.0f, n);
+    st.fishPosition    = wrapCounterAt(base.fishPosition,    1.3f * sf, WIDTH + 300.0f, -300.0f, n);
+    st.balloonPosition = wrapCounterAt(base.balloonPosition, 0.5f * sf, WIDTH + 600.0f, 0.0f,    n);
+    st.trainPosition   = wrapCounterAt(base.trainPosition, -(1.6f * sf),
+                                       trainWrapX(base.trainBogieCount), WIDTH + 400.0f, n);
+
+    floatRun(st.personPosition, 0.8f * sf, n, INFINITY);
+    floatRun(st.riverWave,      0.5f * sf, n, INFINITY);
+    floatRun(st.smokeOffset,    0.3f * sf, n, INFINITY);
+
+    swingAt(base.swingAngle, base.swingForward, 0.4f * sf, n, st.swingAngle, st.swingForward);
+
+    if (base.isRaining)
+        st.rainOffset = wrapCounterAt(base.rainOffset, 8.0f * sf, (float)HEIGHT, 0.0f, n);
+
+    // ---- traffic lights + the vehicles that stop for them ----
+    TrafficClock clock(base.trafficTimer, 1.0f * sf);
+    st.trafficTimer = clock.at(n);
+    const Signal& light = sceneRoad.signals[mainSignal];
+    st.trafficState = signalPhase(sceneRoad.plans[light.plan], light.offset, st.trafficTimer);
+
+    // carX = carPosition - 150, busX = busPosition - 200 (stop line x-80..x-10)
+    static LapCache carLaps = {0, 0, 0, 0, 0, {}}, busLaps = {0, 0, 0, 0, 0, {}};
+    StopMover car = stopMover(1.8f * sf, 150.0f, WIDTH + 250.0f, -250.0f);
+    StopMover bus = stopMover(1.5f * sf, 200.0f, WIDTH + 400.0f, -400.0f);
+    st.carPosition = moverAt(car, clock, carLaps, base.carPosition, n);
+    st.busPosition = moverAt(bus, clock, busLaps, base.busPosition, n);
+
+    return st;
+}
 
-    // ✅ Asymmetric sticker on RIGHT side (Reflection moves it to LEFT)
-    Vec2 s1 = {  8,  10 };
-    Vec2 s2 = { 16,  10 };
-    Vec2 s3 = { 16,   2 };
-    Vec2 s4 = {  8,   2 };
+// "123" ticks, or with a unit: "45s", "30m", "17h"
+uint64_t parseTicks(const char* text) {
+    char*  end = NULL;
+    double v   = strtod(text, &end);
+    if (v < 0.0) v = 0.0;
+    if (end && *end == 's') v *= TICKS_PER_SECOND;
+    if (end && *end == 'm') v *= TICKS_PER_SECOND * 60.0;
+    if (end && *end == 'h') v *= TICKS_PER_SECOND * 3600.0;
+    return (uint64_t)(v + 0.5);
+}
 
-    s1 = applyAllTransforms(s1, sx, sy, rot, refX, refY, shx, shy, tx, ty);
-    s2 = applyAllTransforms(s2, sx, sy, rot, refX, refY, shx, shy, tx, ty);
-    s3 = applyAllTransforms(s3, sx, sy, rot, refX, refY, shx, shy, tx, ty);
-    s4 = applyAllTransforms(s4, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+// ============================================================================
+// TIMELINE (checkpoints + HUD scrub bar)
+// The live loop drops a copy of the SceneState every `checkpointEvery`
+// ticks into a bounded ring (oldest dropped first, 128 bytes each), plus
+// one after every key or click that changes it - a seek simulates forward
+// without input, so that input would otherwise be lost. A seek
+// starts from the closest checkpoint at or before the target and runs the
+// scalar part of stepScene() forward - never more than SEEK_STEP_MAX ticks;
+// a longer gap goes through stateAt(), which costs the same at any distance.
+// Targets past the recorded end (the bar always shows one more day/night
+// cycle) come from stateAt(). The agent sims (fish, crowd, herd) are not rewound.
+// Resuming after a seek back starts a new branch: the old future is cut.
+// ============================================================================
 
-    glColor3f(0.10f, 0.95f, 0.30f); // green
-    glBegin(GL_QUADS);
-        glVertex2f(s1.x, s1.y);
-        glVertex2f(s2.x, s2.y);
-        glVertex2f(s3.x, s3.y);
-        glVertex2f(s4.x, s4.y);
-    glEnd();
+std::deque<SceneState> checkpoints;
+uint32_t checkpointEvery = 250;      // --checkpoint-every (<= SEEK_STEP_MAX: seeks just step)
+size_t   checkpointLimit = 16384;    // --checkpoints (16384 * 250 ticks ~ 18 h, 2 MB)
+uint32_t timelineEnd     = 0;        // newest tick on the current branch
+const uint32_t SEEK_STEP_MAX = 250;  // keeps the worst seek well under 1 ms
+
+bool timelineDragging  = false;
+bool dragResumePlaying = false;
+
+// scrub bar geometry (scene coords, inside the HUD bar)
+const float TIMELINE_X0 = 10.0f;
+const float TIMELINE_X1 = WIDTH - 250.0f;
+const float TIMELINE_Y  = HEIGHT - 71.0f;
+
+void resetTimeline() {
+    sceneTimersDirty = true;
+    checkpoints.clear();
+    checkpoints.push_back(scene);
+    timelineEnd = scene.tick;
+}
 
-    // ✅ Tail (offset) -> reflection very clear
-    Vec2 tailA = { 10, -28 };
-    Vec2 tailB = { 20, -75 };
+// running again (or changing anything) after a seek back: the recorded
+// future is gone
+static void cutTimelineFuture() {
+    if (timelineEnd > scene.tick) {
+        while (!checkpoints.empty() && checkpoints.back().tick > scene.tick)
+            checkpoints.pop_back();
+    }
+    timelineEnd = scene.tick;
+}
 
-    tailA = applyAllTransforms(tailA, sx, sy, rot, refX, refY, shx, shy, tx, ty);
-    tailB = applyAllTransforms(tailB, sx, sy, rot, refX, refY, shx, shy, tx, ty);
+// a later state at the same tick (input after the tick) replaces the old one
+static void pushCheckpoint() {
+    if (!checkpoints.empty() && checkpoints.back().tick == scene.tick)
+        checkpoints.pop_back();
+    checkpoints.push_back(scene);
+    while (checkpoints.size() > checkpointLimit && checkpoints.size() > 1)
+        checkpoints.pop_front();
+}
 
-    glColor3f(0.95f, 0.85f, 0.25f);
-    glLineWidth(2.5f);
-    glBegin(GL_LINES);
-        glVertex2f(tailA.x, tailA.y);
-        glVertex2f(tailB.x, tailB.y);
-    glEnd();
+void recordCheckpoint() {
+    cutTimelineFuture();
+    if (checkpointEvery == 0 || scene.tick % checkpointEvery != 0) return;
+    pushCheckpoint();
 }
 
+// handleKey() / the pause click changed the scene between two ticks
+void recordInputCheckpoint() {
+    cutTimelineFuture();
+    pushCheckpoint();
+}
 
+void seekTimeline(uint32_t target) {
+    if (checkpoints.empty()) resetTimeline();
 
+    // last checkpoint with tick <= target (ticks are increasing)
+    std::deque<SceneState>::const_iterator it = std::upper_bound(
+        checkpoints.begin(), checkpoints.end(), target,
+        [](uint32_t t, const SceneState& s) { return t < s.tick; });
+    if (it != checkpoints.begin()) --it;
 
-// // Welcome sign board
-// void drawWelcomeSign() {
-//     float x     = 80.0f;
-//     float baseY = 260.0f;
+    SceneState base = *it;
+    if (scene.tick <= target && scene.tick > base.tick) base = scene;
+    if (target < base.tick) target = base.tick;   // older than the ring
 
-//     glColor3f(0.4f, 0.25f, 0.12f);
-//     glBegin(GL_QUADS);
-//         glVertex2f(x - 4, baseY);
-//         glVertex2f(x + 4, baseY);
-//         glVertex2f(x + 4, baseY + 40);
-//         glVertex2f(x - 4, baseY + 40);
-//     glEnd();
+    bool paused = animationPaused;
+    base.animationPaused = false;
 
-//     glColor3f(0.9f, 0.8f, 0.2f);
-//     glBegin(GL_QUADS);
-//         glVertex2f(x - 70, baseY + 40);
-//         glVertex2f(x + 70, baseY + 40);
-//         glVertex2f(x + 70, baseY + 70);
-//         glVertex2f(x - 70, baseY + 70);
-//     glEnd();
+    uint32_t n = target - base.tick;
+    if (n > SEEK_STEP_MAX) {
+        scene = stateAt(base, n);
+    } else {
+        scene = base;
+        sceneTimersDirty = true;
+        while (scene.tick < target) stepScene(false);
+    }
+    animationPaused  = paused;
+    sceneTimersDirty = true;
+}
 
-//     glColor3f(0.0f, 0.0f, 0.0f);
-//     glRasterPos2f(x - 60, baseY + 55);
-//     const char* msg = "WELCOME TO VILLAGE";
-//     for (int i = 0; msg[i] != '\0'; ++i) {
-//         glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, msg[i]);
-//     }
-// }
+// ticks for one full day/night cycle at the current speed
+static uint32_t dayCycleTicks() {
+    return (uint32_t)(2.0 * PI_D / (0.008 * speedFactor) + 0.5);
+}
 
-// Well near a house
-void drawWell(float x, float y) {
-    glColor3f(0.6f, 0.6f, 0.6f);
+static void timelineRange(uint32_t& t0, uint32_t& t1) {
+    t0 = checkpoints.empty() ? 0 : checkpoints.front().tick;
+    t1 = std::max(timelineEnd, scene.tick) + dayCycleTicks();
+}
+
+static bool overTimeline(float sx, float sy) {
+    return sx >= TIMELINE_X0 - 6.0f && sx <= TIMELINE_X1 + 6.0f &&
+           sy >= TIMELINE_Y - 7.0f  && sy <= TIMELINE_Y + 7.0f;
+}
+
+static void scrubTo(float sx) {
+    uint32_t t0, t1;
+    timelineRange(t0, t1);
+    float f = (sx - TIMELINE_X0) / (TIMELINE_X1 - TIMELINE_X0);
+    if (f < 0.0f) f = 0.0f;
+    if (f > 1.0f) f = 1.0f;
+    seekTimeline(t0 + (uint32_t)((double)(t1 - t0) * f + 0.5));
+}
+
+static void formatTicks(uint32_t ticks, char* out, size_t size) {
+    unsigned sec = (unsigned)(ticks / TICKS_PER_SECOND);
+    snprintf(out, size, "%u:%02u:%02u", sec / 3600, (sec / 60) % 60, sec % 60);
+}
+
+void drawTimelineBar() {
+    uint32_t t0, t1;
+    timelineRange(t0, t1);
+    float w = TIMELINE_X1 - TIMELINE_X0;
+    auto xOf = [&](uint32_t t) {
+        return TIMELINE_X0 + w * (float)((double)(t - t0) / (double)(t1 - t0));
+    };
+
+    // track: recorded part brighter than the stateAt() look-ahead
+    float xEnd = xOf(timelineEnd);
     glBegin(GL_QUADS);
-        glVertex2f(x - 18, y);
-        glVertex2f(x + 18, y);
-        glVertex2f(x + 18, y + 25);
-        glVertex2f(x - 18, y + 25);
+        glColor3f(0.35f, 0.35f, 0.40f);
+        glVertex2f(TIMELINE_X0, TIMELINE_Y - 2); glVertex2f(xEnd, TIMELINE_Y - 2);
+        glVertex2f(xEnd, TIMELINE_Y + 2);        glVertex2f(TIMELINE_X0, TIMELINE_Y + 2);
+        glColor3f(0.20f, 0.20f, 0.25f);
+        glVertex2f(xEnd, TIMELINE_Y - 2);        glVertex2f(TIMELINE_X1, TIMELINE_Y - 2);
+        glVertex2f(TIMELINE_X1, TIMELINE_Y + 2); glVertex2f(xEnd, TIMELINE_Y + 2);
     glEnd();
 
-    glColor3f(0.4f, 0.4f, 0.4f);
-    drawEllipse(x, y + 25, 18.0f, 6.0f, 24);
-    glColor3f(0.2f, 0.2f, 0.2f);
-    drawEllipse(x, y + 22, 14.0f, 4.0f, 24);
-
-    glColor3f(0.35f, 0.25f, 0.15f);
+    // checkpoint ticks (thinned so the bar never gets more than ~200)
+    size_t stride = checkpoints.size() / 200 + 1;
+    glColor3f(0.55f, 0.55f, 0.60f);
     glBegin(GL_LINES);
-        glVertex2f(x - 16, y + 25);
-        glVertex2f(x - 16, y + 55);
-        glVertex2f(x + 16, y + 25);
-        glVertex2f(x + 16, y + 55);
-        glVertex2f(x - 16, y + 55);
-        glVertex2f(x + 16, y + 55);
+    for (size_t i = 0; i < checkpoints.size(); i += stride) {
+        float x = xOf(checkpoints[i].tick);
+        glVertex2f(x, TIMELINE_Y - 4);
+        glVertex2f(x, TIMELINE_Y + 4);
+    }
     glEnd();
 
-    glBegin(GL_LINES);
-        glVertex2f(x, y + 55);
-        glVertex2f(x, y + 35);
+    // knob
+    float x = xOf(scene.tick);
+    if (timelineDragging) glColor3f(1.0f, 0.85f, 0.3f);
+    else                  glColor3f(0.9f, 0.9f, 0.95f);
+    glBegin(GL_QUADS);
+        glVertex2f(x - 3, TIMELINE_Y - 6); glVertex2f(x + 3, TIMELINE_Y - 6);
+        glVertex2f(x + 3, TIMELINE_Y + 6); glVertex2f(x - 3, TIMELINE_Y + 6);
     glEnd();
 
-    drawCircle(x, y + 33, 2.0f);
+    char now[32], end[32], info[96];
+    formatTicks(scene.tick, now, sizeof(now));
+    formatTicks(timelineEnd, end, sizeof(end));
+    snprintf(info, sizeof(info), "%s / %s | %u checkpoints",
+             now, end, (unsigned)checkpoints.size());
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glRasterPos2f(TIMELINE_X1 + 12, TIMELINE_Y - 4);
+    for (int i = 0; info[i] != '\0'; i++)
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
 }
 
+
 // ============================================================================
-// WEATHER EFFECTS
+// DISPLAY AND INPUT HANDLING
 // ============================================================================
-void drawRain() {
-    if (!isRaining) return;
 
+void display() {
+    if (!treeAtlasReady) bakeTreeAtlas();   // needs a live window: first frame
+    if (!cloudAtlasReady) uploadCloudAtlas();
+    if (benchGL) {
+        runGLBenchmarks();
+        closeRecording();
+        exit(0);
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluOrtho2D(0, WIDTH, 0, HEIGHT);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    updateTimeOfDay();
+    resolveMaterials();
+    drawVillageScene();
+    compositeLights();
+    applyBloom();
+
+    // HUD bar (✅ make it taller because now 3 lines)
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(0.0f, 0.0f, 0.0f, 0.45f);
+    glBegin(GL_QUADS);
+        glVertex2f(0, HEIGHT - 80);      // ✅ was -60
+        glVertex2f(WIDTH, HEIGHT - 80);  // ✅ was -60
+        glVertex2f(WIDTH, HEIGHT);
+        glVertex2f(0, HEIGHT);
+    glEnd();
+    glDisable(GL_BLEND);
 
-    // wind slant
-    float slant = 10.0f * windIntensity;   // increase with wind
+    glColor3f(1.0f, 1.0f, 1.0f);
 
-    // -------- FAR LAYER (thin, faint) --------
-    glColor4f(0.80f, 0.85f, 1.0f, 0.22f);
-    glLineWidth(1.0f);
-    glBegin(GL_LINES);
-    for (int i = 0; i < 260; i++) {
-        float x = (i * 37) % WIDTH;
-        float y = std::fmod((float)(i * 61) - rainOffset * 0.7f + HEIGHT, (float)HEIGHT);
-        glVertex2f(x, y);
-        glVertex2f(x + slant * 0.6f, y - 14.0f);
+    char info[350];
+
+    // ---------- Line 1 ----------
+    glRasterPos2f(10, HEIGHT - 20);
+    if (animationPaused) {
+        sprintf(info,
+            "REALISTIC VILLAGE (PAUSED) | P: Play | D/N: Day/Night | "
+            "R: Rain | 1/2: Speed | E: Reset | W/S: Wind | F: Festival");
+    } else {
+        sprintf(info,
+            "REALISTIC VILLAGE (RUNNING) | P: Pause | D/N: Day/Night | "
+            "R: Rain | 1/2: Speed | E: Reset | W/S: Wind | F: Festival");
     }
-    glEnd();
+    for (int i = 0; info[i] != '\0'; i++)
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
 
-    // -------- MID LAYER --------
-    glColor4f(0.85f, 0.88f, 1.0f, 0.45f);
-    glLineWidth(1.5f);
-    glBegin(GL_LINES);
-    for (int i = 0; i < 320; i++) {
-        float x = (i * 29) % WIDTH;
-        float y = std::fmod((float)(i * 47) - rainOffset + HEIGHT, (float)HEIGHT);
+    // ---------- Line 2 ----------
+    glRasterPos2f(10, HEIGHT - 38);
+    sprintf(info,
+        "B: Birds %s | A: Plane %s | G: Train %s | L: Lights %s | H: Person %s | Festival: %s | ESC: Exit",
+        showBirds  ? "ON" : "OFF",
+        showPlane  ? "ON" : "OFF",
+        showTrain  ? "ON" : "OFF",
+        showLights ? "ON" : "OFF",
+        showPerson ? "ON" : "OFF",
+        festivalMode ? "ON" : "OFF");
+    for (int i = 0; info[i] != '\0'; i++)
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
 
-        float len = 18.0f + (i % 5) * 2.5f;     // different length
-        glVertex2f(x, y);
-        glVertex2f(x + slant * 0.8f, y - len);
+    // ---------- Line 3 (✅ NEW: Z/X/C/V) ----------
+    glRasterPos2f(10, HEIGHT - 56);
+    sprintf(info,
+        "Transforms: Z(Scale) %s | X(Rotate) %s | C(Reflect) %s | V(Shear) %s | K/O: Save/Load snapshot",
+        useScaleT   ? "ON" : "OFF",
+        useRotateT  ? "ON" : "OFF",
+        useReflectT ? "ON" : "OFF",
+        useShearT   ? "ON" : "OFF");
+    for (int i = 0; info[i] != '\0'; i++)
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
+
+    // ---------- Timeline scrub bar ----------
+    drawTimelineBar();
+
+    // ---------- Right side status ----------
+    glRasterPos2f(WIDTH - 420, HEIGHT - 20);
+    sprintf(info, "MODE: %s | Rain: %s | Speed: %.1fx | U: %s",
+        isDay ? "DAY" : "NIGHT",
+        isRaining ? "ON" : "OFF",
+        speedFactor,
+        shaderPathActive() ? "GLSL" : "Fixed");
+    for (int i = 0; info[i] != '\0'; i++)
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
+
+    glRasterPos2f(WIDTH - 420, HEIGHT - 38);
+    sprintf(info, "SIM ms/tick: fish %.3f | crowd %.3f | herd %.3f",
+        simCostMs[SIM_FISH], simCostMs[SIM_CROWD], simCostMs[SIM_HERD]);
+    for (int i = 0; info[i] != '\0'; i++)
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
+
+    // this frame's culling pass: total, then the kinds that lost anything
+    int tested = 0, skipped = 0;
+    for (int k = 0; k < CULL_KINDS; k++) { tested += cullTested[k]; skipped += cullSkipped[k]; }
+    glRasterPos2f(WIDTH - 420, HEIGHT - 56);
+    int len = sprintf(info, "CULLED: %d of %d", skipped, tested);
+    for (int k = 0; k < CULL_KINDS; k++)
+        if (cullSkipped[k] > 0)
+            len += sprintf(info + len, " | %s %d", CULL_NAMES[k], cullSkipped[k]);
+    for (int i = 0; info[i] != '\0'; i++)
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
+
+    glutSwapBuffers();
+}
+
+
+void keyboard(unsigned char key, int x, int y) {
+    recordInput('K', key, 0, x, y);
+
+    if (key == 27) {
+        printf("Exiting program\n");
+        closeRecording();
+        exit(0);
     }
-    glEnd();
+    handleKey(key);
+}
 
-    // -------- NEAR LAYER (bright, thick) --------
-    glColor4f(0.90f, 0.90f, 1.0f, 0.70f);
-    glLineWidth(2.2f);
-    glBegin(GL_LINES);
-    for (int i = 0; i < 180; i++) {
-        float x = (i * 53 + 120) % WIDTH;
-        float y = std::fmod((float)(i * 83) - rainOffset * 1.3f + HEIGHT, (float)HEIGHT);
+void handleKey(unsigned char key) {
+    SceneState before = scene;
+    sceneTimersDirty = true;   // speed, wind, rain and resets move the events
+
+    switch (key) {
+        case 'p': case 'P':
+            animationPaused = !animationPaused;
+            printf("Animation %s\n", animationPaused ? "Paused" : "Resumed");
+            break;
+
+        case 'd': case 'D':
+            sunAngle      = TOD_NOON_PHASE;
+            isDay         = true;
+            dayNightBlend = 1.0f;
+            printf("Switched to Day mode\n");
+            break;
+
+        case 'n': case 'N':
+            sunAngle      = TOD_MIDNIGHT_PHASE;
+            isDay         = false;
+            dayNightBlend = 0.0f;
+            printf("Switched to Night mode\n");
+            break;
+
+        // ❌ remove T rain toggle (now rain is R)
+        // case 't': case 'T':
+        //     isRaining = !isRaining;
+        //     printf("Rain %s\n", isRaining ? "ON" : "OFF");
+        //     break;
+
+        case '1':
+            speedFactor *= 1.3f;
+            if (speedFactor > 8.0f) speedFactor = 8.0f;
+            printf("Speed increased: %.2fx\n", speedFactor);
+            break;
+
+        case '2':
+            speedFactor *= 0.7f;
+            if (speedFactor < 0.1f) speedFactor = 0.1f;
+            printf("Speed decreased: %.2fx\n", speedFactor);
+            break;
+
+        case 'w': case 'W':
+            windUser += 0.2f;
+            if (windUser > 2.0f) windUser = 2.0f;
+            printf("Wind increased: %.1f\n", windUser);
+            break;
+
+        case 's': case 'S':
+            windUser -= 0.2f;
+            if (windUser < 0.2f) windUser = 0.2f;
+            printf("Wind decreased: %.1f\n", windUser);
+            break;
 
-        float len = 26.0f + (i % 4) * 4.0f;
-        glVertex2f(x, y);
-        glVertex2f(x + slant, y - len);
-    }
-    glEnd();
+        case 'b': case 'B':
+            showBirds = !showBirds;
+            printf("Birds %s\n", showBirds ? "ON" : "OFF");
+            break;
 
-    // -------- SPLASH (near ground & river line) --------
-    glPointSize(2.0f);
-    glBegin(GL_POINTS);
-    for (int i = 0; i < 120; i++) {
-        float x = (i * 41) % WIDTH;
+        case 'a': case 'A':
+            showPlane = !showPlane;
+            printf("Airplane %s\n", showPlane ? "ON" : "OFF");
+            break;
 
-        // splash on ground area (around y=200..260) and river edges (110..190)
-        float y;
-        if (i % 2 == 0) y = 200.0f + (i % 25);   // footpath/road zone
-        else           y = 118.0f + (i % 60);    // river zone
+        case 'g': case 'G':
+            showTrain = !showTrain;
+            printf("Train %s\n", showTrain ? "ON" : "OFF");
+            break;
 
-        glColor4f(0.90f, 0.95f, 1.0f, 0.45f);
-        glVertex2f(x, y);
-        glVertex2f(x + 2, y + 1);
-    }
-    glEnd();
+        case 'l': case 'L':
+            showLights = !showLights;
+            printf("Lights glow %s\n", showLights ? "ON" : "OFF");
+            break;
 
-    glDisable(GL_BLEND);
-}
+        case 'h': case 'H':
+            showPerson = !showPerson;
+            printf("Pedestrians %s\n", showPerson ? "ON" : "OFF");
+            break;
 
-// ============================================================================
-// PEOPLE - WALKING ON FOOTPATH
-// ============================================================================
+        case 'f': case 'F':
+            festivalMode = !festivalMode;
+            printf("Festival mode %s\n", festivalMode ? "ON" : "OFF");
+            break;
 
-void drawWalkingPerson() {
-    float px   = std::fmod(personPosition, WIDTH + 200.0f) - 100.0f;
-    float base = 225.0f;
-    float py   = base + 4.0f * std::sin(personPosition * 0.15f);
-    float step = std::sin(personPosition * 0.3f) * 6.0f;
+        // ✅ R = Rain toggle
+        case 'r': case 'R':
+            isRaining = !isRaining;
+            printf("Rain %s\n", isRaining ? "ON" : "OFF");
+            break;
 
-    drawShadowEllipse(px, base - 10.0f, 11.0f, 3.5f, 0.35f);
+        // ✅ NEW: transformation toggles (algorithm based)
+        case 'z': case 'Z':
+            useScaleT = !useScaleT;
+            printf("Algorithm Scale %s\n", useScaleT ? "ON" : "OFF");
+            break;
 
-    glColor3f(1.0f, 0.9f, 0.8f);
-    drawCircle(px, py + 22.0f, 7.0f);
+        case 'x': case 'X':
+            useRotateT = !useRotateT;
+            printf("Algorithm Rotate %s\n", useRotateT ? "ON" : "OFF");
+            break;
 
-    glColor3f(0.8f, 0.2f, 0.2f);
-    glLineWidth(3.0f);
-    glBegin(GL_LINES);
-    glVertex2f(px, py + 16.0f);
-    glVertex2f(px, py);
-    glEnd();
+        case 'c': case 'C':
+            useReflectT = !useReflectT;
+            printf("Algorithm Reflection %s\n", useReflectT ? "ON" : "OFF");
+            break;
 
-    glBegin(GL_LINES);
-    glVertex2f(px, py + 12.0f);
-    glVertex2f(px - 8.0f - step * 0.4f, py + 4.0f);
-    glVertex2f(px, py + 12.0f);
-    glVertex2f(px + 8.0f + step * 0.4f, py + 4.0f);
-    glEnd();
+        case 'v': case 'V':
+            useShearT = !useShearT;
+            printf("Algorithm Shear %s\n", useShearT ? "ON" : "OFF");
+            break;
 
-    glBegin(GL_LINES);
-    glVertex2f(px, py);
-    glVertex2f(px - 6.0f - step, py - 14.0f);
-    glVertex2f(px, py);
-    glVertex2f(px + 6.0f + step, py - 14.0f);
-    glEnd();
-}
+        // ✅ RESET moved to E (because R is rain now)
+        // back to the exact start-up state (pause state is kept)
+        case 'e': case 'E': {
+            bool paused = animationPaused;
+            scene = sceneDefaults();
+            animationPaused = paused;
+            initFishSchool((int)fishSchool.size());   // same size, start positions
+            initCrowd((int)crowd.size());
+            initHerd((int)herd.size());
+            resetTimeline();
 
-// void drawWalkingPerson() {
-//     float px   = std::fmod(personPosition, WIDTH + 200.0f) - 100.0f;
-//     float base = 225.0f;
-//     float py   = base + 3.0f * std::sin(personPosition * 0.15f);
+            printf("All animations & toggles reset (E)\n");
+            break;
+        }
 
-//     float phase = personPosition * 0.22f;
-//     float legA  = std::sin(phase) * 9.0f;
-//     float armA  = std::sin(phase + 3.14159f) * 7.0f;
+        case 'k': case 'K':
+            if (replayMode) saveReplaySnapshot();
+            else            saveSnapshot(snapshotPath);
+            break;
 
-//     // shadow
-//     drawShadowEllipse(px, base - 10.0f, 13.0f, 4.0f, 0.35f);
+        // train length: double / halve (1 .. MAX_TRAIN_COACHES)
+        case '+': case '=':
+            trainBogieCount = std::min(trainBogieCount * 2, MAX_TRAIN_COACHES);
+            printf("Train coaches: %d\n", trainBogieCount);
+            break;
 
-//     // ===================== HEAD + HAIR =====================
-//     glColor3f(1.0f, 0.90f, 0.80f);
-//     drawCircle(px, py + 26.0f, 7.2f, 22);
+        case '-': case '_':
+            trainBogieCount = std::max(trainBogieCount / 2, 1);
+            printf("Train coaches: %d\n", trainBogieCount);
+            break;
 
-//     glColor3f(0.12f, 0.10f, 0.08f); // hair
-//     drawCircle(px - 1.5f, py + 29.0f, 5.6f, 20);
+        case 'o': case 'O':
+            if (replayMode) loadReplaySnapshot();
+            else            loadSnapshot(snapshotPath);
+            break;
 
-//     // neck
-//     glColor3f(0.95f, 0.85f, 0.75f);
-//     glBegin(GL_QUADS);
-//         glVertex2f(px - 2.2f, py + 18.5f);
-//         glVertex2f(px + 2.2f, py + 18.5f);
-//         glVertex2f(px + 2.2f, py + 22.0f);
-//         glVertex2f(px - 2.2f, py + 22.0f);
-//     glEnd();
+        case 'j': case 'J':
+            bloomEnabled = !bloomEnabled;
+            printf("Bloom %s\n", bloomEnabled ? "ON" : "OFF");
+            break;
 
-//     // ===================== TORSO (SHIRT) =====================
-//     glColor3f(0.85f, 0.20f, 0.20f);
-//     glBegin(GL_QUADS);
-//         glVertex2f(px - 7.0f, py + 18.0f);
-//         glVertex2f(px + 7.0f, py + 18.0f);
-//         glVertex2f(px + 8.5f, py + 2.0f);
-//         glVertex2f(px - 8.5f, py + 2.0f);
-//     glEnd();
+        // sky + water: GLSL shaders <-> fixed-function (display setting only)
+        case 'u': case 'U':
+            useShaders = !useShaders;
+            printf("Shader path %s%s\n", useShaders ? "ON" : "OFF",
+                   useShaders && !shadersReady && !replayMode ? " (not available, staying fixed-function)" : "");
+            break;
 
-//     // shirt highlight
-//     glColor3f(0.95f, 0.35f, 0.35f);
-//     glBegin(GL_LINES);
-//         glVertex2f(px - 6.0f, py + 15.0f);
-//         glVertex2f(px + 5.0f, py + 10.0f);
-//     glEnd();
+    }
 
-//     // ===================== BELT / WAIST =====================
-//     glColor3f(0.15f, 0.15f, 0.18f);
-//     glBegin(GL_QUADS);
-//         glVertex2f(px - 9.0f, py + 2.0f);
-//         glVertex2f(px + 9.0f, py + 2.0f);
-//         glVertex2f(px + 9.0f, py - 1.0f);
-//         glVertex2f(px - 9.0f, py - 1.0f);
-//     glEnd();
+    // keep the input for seeks (display-only keys leave the scene alone)
+    if (std::memcmp(&before, &scene, sizeof(SceneState)) != 0) recordInputCheckpoint();
+}
 
-//     // ===================== ARMS (ANIMATED) =====================
-//     glLineWidth(3.0f);
-//     glColor3f(0.85f, 0.20f, 0.20f);
+void mouse(int button, int state, int x, int y) {
+    recordInput('M', (uint8_t)button, (uint8_t)state, x, y);
+    handleMouse(button, state, x, y);
+}
 
-//     // left arm
-//     glBegin(GL_LINES);
-//         glVertex2f(px - 6.0f, py + 14.0f);
-//         glVertex2f(px - 14.0f, py + 7.0f + armA * 0.25f);
-//     glEnd();
+void handleMouse(int button, int state, int x, int y) {
+    if (button != GLUT_LEFT_BUTTON) return;
 
-//     // right arm
-//     glBegin(GL_LINES);
-//         glVertex2f(px + 6.0f, py + 14.0f);
-//         glVertex2f(px + 14.0f, py + 7.0f - armA * 0.25f);
-//     glEnd();
+    float sx = x * (float)WIDTH / winW;
+    float sy = HEIGHT - y * (float)HEIGHT / winH;
 
-//     // hands
-//     glColor3f(1.0f, 0.90f, 0.80f);
-//     drawCircle(px - 14.0f, py + 7.0f + armA * 0.25f, 2.0f, 14);
-//     drawCircle(px + 14.0f, py + 7.0f - armA * 0.25f, 2.0f, 14);
+    // drag on the scrub bar: hold the sim while scrubbing
+    if (state == GLUT_DOWN && overTimeline(sx, sy)) {
+        timelineDragging  = true;
+        dragResumePlaying = !animationPaused;
+        animationPaused   = true;
+        scrubTo(sx);
+        return;
+    }
+    if (state == GLUT_UP && timelineDragging) {
+        timelineDragging = false;
+        if (dragResumePlaying) animationPaused = false;
+        return;
+    }
 
-//     // ===================== LEGS (ANIMATED) =====================
-//     glColor3f(0.08f, 0.08f, 0.10f);
-//     glLineWidth(4.0f);
+    if (state == GLUT_DOWN) {
+        printf("Mouse clicked at: (%d, %d)\n", x, HEIGHT - y);
+        animationPaused = !animationPaused;
+        recordInputCheckpoint();
+    }
+}
 
-//     // left leg
-//     glBegin(GL_LINES);
-//         glVertex2f(px - 4.0f, py - 1.0f);
-//         glVertex2f(px - 9.0f - legA * 0.20f, py - 18.0f);
-//     glEnd();
+void motion(int x, int y) {
+    recordInput('V', 0, 0, x, y);
+    handleMotion(x, y);
+}
 
-//     // right leg
-//     glBegin(GL_LINES);
-//         glVertex2f(px + 4.0f, py - 1.0f);
-//         glVertex2f(px + 9.0f + legA * 0.20f, py - 18.0f);
-//     glEnd();
+// the bar is horizontal: a drag only reads x
+void handleMotion(int x, int /*y*/) {
+    if (timelineDragging) scrubTo(x * (float)WIDTH / winW);
+}
 
-//     // shoes
-//     glColor3f(0.02f, 0.02f, 0.02f);
-//     drawEllipse(px - 9.0f - legA * 0.20f, py - 18.5f, 5.0f, 2.2f, 18);
-//     drawEllipse(px + 9.0f + legA * 0.20f, py - 18.5f, 5.0f, 2.2f, 18);
-// }
+void reshape(int w, int h) {
+    recordInput('R', 0, 0, w, h);
+    winW = w > 0 ? w : 1;
+    winH = h > 0 ? h : 1;
+    glViewport(0, 0, w, h);
+}
 
+// wall clock in ms (benchmarks, replay timing)
+static double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
 
 // ============================================================================
-// SCENE COMPOSITION - FIXED LAYER ORDER
+// SNAPSHOTS (binary save / restore of the complete scene)
+// File layout (native endianness):
+//   SnapshotHeader | SceneState | Fish[fishCount] | Pedestrian[pedCount] | Cow[cowCount]
+// The header also holds the road's signal layout (--signals, --signal-plan);
+// loading re-lays the road to match, so the light positions and phases
+// are the ones the state was saved with.
 // ============================================================================
 
-void drawVillageScene() {
-    drawSky();
-    drawStars();
-    drawSunMoon();
-    drawClouds();
-    drawHotAirBalloon();
-    drawKite();
+const uint32_t SNAPSHOT_MAGIC   = 0x504E5356u;   // "VSNP"
+const uint32_t SNAPSHOT_VERSION = 7u;
+
+struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t stateSize;     // sizeof(SceneState) when written
+    uint32_t fishCount;
+    uint32_t pedCount;
+    uint32_t cowCount;
+    uint32_t signalCount;   // lights on the road (after clamping)
+    PhasePlan signalPlan;
+};
 
-    drawDistantHills();
+static size_t snapshotImageSize(const SnapshotHeader& h) {
+    return sizeof(h) + sizeof(SceneState) + (size_t)h.fishCount * sizeof(Fish) +
+           (size_t)h.pedCount * sizeof(Pedestrian) + (size_t)h.cowCount * sizeof(Cow);
+}
 
-    drawGround();
-    drawFieldAndCow();
-    drawElectricPolesAndWires();
+// header + state + fish + walkers + cows, as one byte image
+static void snapshotImage(std::vector<unsigned char>& out) {
+    SnapshotHeader h;
+    h.magic     = SNAPSHOT_MAGIC;
+    h.version   = SNAPSHOT_VERSION;
+    h.stateSize = sizeof(SceneState);
+    h.fishCount = (uint32_t)fishSchool.size();
+    h.pedCount  = (uint32_t)crowd.size();
+    h.cowCount  = (uint32_t)herd.size();
+    h.signalCount = (uint32_t)sceneRoad.signals.size();
+    h.signalPlan  = signalPlan;
+
+    out.clear();
+    out.reserve(snapshotImageSize(h));
+    auto put = [&out](const void* p, size_t bytes) {
+        out.insert(out.end(), (const unsigned char*)p, (const unsigned char*)p + bytes);
+    };
+    put(&h, sizeof(h));
+    put(&scene, sizeof(SceneState));
+    if (h.fishCount > 0) put(fishSchool.data(), h.fishCount * sizeof(Fish));
+    if (h.pedCount > 0)  put(crowd.data(), h.pedCount * sizeof(Pedestrian));
+    if (h.cowCount > 0)  put(herd.data(), h.cowCount * sizeof(Cow));
+}
 
-    drawRiver();
-    drawFish();
+// Writes the snapshot image; also used at the start of input recordings.
+static bool writeSnapshotImage(FILE* fp) {
+    std::vector<unsigned char> image;
+    snapshotImage(image);
+    return fwrite(image.data(), 1, image.size(), fp) == image.size();
+}
 
-    drawRailTrack();
-    if (showTrain) drawMovingTrain();
+bool saveSnapshot(const char* path) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        printf("Snapshot: cannot write %s\n", path);
+        return false;
+    }
 
-    drawWindmill(950, 320);
-    for (int i = 0; i < 10; i++) {
-        drawTree(150 + i * 120, 320 + (i % 3) * 10, i);
+    bool ok = writeSnapshotImage(fp);
+    ok = (fclose(fp) == 0) && ok;
+
+    if (ok) printf("Snapshot saved: %s (tick %u, %u fish, %u walkers, %u cows)\n", path, scene.tick,
+                   (unsigned)fishSchool.size(), (unsigned)crowd.size(), (unsigned)herd.size());
+    else    printf("Snapshot: write failed for %s\n", path);
+    return ok;
+}
+
+// The payload is copied as raw bytes, so anything later used as an index
+// or a count is forced back into range (a hand-edited or foreign file must
+// not crash the scene). Valid snapshots pass through unchanged.
+static void clampSnapshotPayload() {
+    scene.trainBogieCount = std::max(1, std::min(scene.trainBogieCount, MAX_TRAIN_COACHES));
+    if (scene.trafficState < 0 || scene.trafficState > 2) scene.trafficState = 0;
+    // the +/- keys keep speed in 0.1..8 and the sun only counts up; stateAt()
+    // walks both, so a NaN or out-of-range value would make seeks meaningless
+    if (!(scene.speedFactor >= 0.1f)) scene.speedFactor = 0.1f;
+    if (scene.speedFactor > 8.0f)     scene.speedFactor = 8.0f;
+    if (!(scene.sunAngle >= 0.0f) || !std::isfinite(scene.sunAngle)) scene.sunAngle = 0.0f;
+
+    // bools as bytes: only 0 and 1 are valid bool values
+    unsigned char* flag = (unsigned char*)&scene + offsetof(SceneState, isDay);
+    unsigned char* end  = (unsigned char*)&scene + offsetof(SceneState, reserved);
+    for (; flag < end; flag++) *flag = (*flag != 0);
+    std::memset(scene.reserved, 0, sizeof(scene.reserved));
+
+    for (size_t i = 0; i < crowd.size(); i++) {
+        Pedestrian& p = crowd[i];
+        if (p.state > PED_RETURN)     p.state = PED_WALK;
+        if (p.dest >= NAV_DEST_COUNT) p.dest  = NAV_FOOTPATH;
+        p.dir = p.dir < 0 ? -1 : 1;
+    }
+    for (size_t i = 0; i < herd.size(); i++) {
+        Cow& c = herd[i];
+        if (c.state > COW_FLOCK) c.state = COW_GRAZE;
+        c.facing = c.facing < 0 ? -1 : 1;
+        c.pad[0] = c.pad[1] = 0;
     }
+}
 
-    // Houses row
-    float houseY = 285.0f;     // ✅ same base for all houses
-    float gap    = 210.0f;     // spacing
+// Validates a snapshot image in memory and applies it to the scene.
+static bool applySnapshot(const unsigned char* data, size_t size, const char* path) {
+    SnapshotHeader h;
+    if (size < sizeof(h)) {
+        printf("Snapshot: %s is too small\n", path);
+        return false;
+    }
+    std::memcpy(&h, data, sizeof(h));
 
-    drawModernHouse(  80, houseY);
-    drawTraditionalHouse( 80 + gap, houseY);
-    drawFarmHouse(  80 + 2*gap, houseY);
-    drawTraditionalHouse( 80 + 3*gap, houseY);
-    drawModernHouse(  80 + 4*gap, houseY);
-    drawFarmHouse(  80 + 5*gap, houseY);
+    if (h.magic != SNAPSHOT_MAGIC || h.version != SNAPSHOT_VERSION ||
+        h.stateSize != sizeof(SceneState)) {
+        printf("Snapshot: %s has an unsupported format (version %u)\n", path, h.version);
+        return false;
+    }
+    if (size < snapshotImageSize(h)) {
+        printf("Snapshot: %s is truncated\n", path);
+        return false;
+    }
+    const PhasePlan& plan = h.signalPlan;
+    if (h.signalCount < 1 || h.signalCount > (uint32_t)MAX_ROAD_SIGNALS ||
+        plan.red <= 0 || plan.yellow < 0 || plan.green <= 0) {
+        printf("Snapshot: %s has an invalid signal layout\n", path);
+        return false;
+    }
+    if (h.fishCount > (uint32_t)MAX_FISH || h.pedCount > (uint32_t)MAX_CROWD ||
+        h.cowCount > (uint32_t)MAX_HERD) {
+        printf("Snapshot: %s has too many agents\n", path);
+        return false;
+    }
 
+    std::memcpy(&scene, data + sizeof(h), sizeof(SceneState));
+    fishSchool.resize(h.fishCount);
+    if (h.fishCount > 0)
+        std::memcpy(fishSchool.data(), data + sizeof(h) + sizeof(SceneState),
+                    (size_t)h.fishCount * sizeof(Fish));
+    const unsigned char* agents = data + sizeof(h) + sizeof(SceneState) + (size_t)h.fishCount * sizeof(Fish);
+    crowd.resize(h.pedCount);
+    if (h.pedCount > 0)
+        std::memcpy(crowd.data(), agents, (size_t)h.pedCount * sizeof(Pedestrian));
+    agents += (size_t)h.pedCount * sizeof(Pedestrian);
+    herd.resize(h.cowCount);
+    if (h.cowCount > 0)
+        std::memcpy(herd.data(), agents, (size_t)h.cowCount * sizeof(Cow));
+    clampSnapshotPayload();
+
+    if (h.signalCount != sceneRoad.signals.size() || plan.red != signalPlan.red ||
+        plan.yellow != signalPlan.yellow || plan.green != signalPlan.green) {
+        signalCount = (int)h.signalCount;
+        signalPlan  = plan;
+        initRoadSignals(signalCount);
+        if (!replayMode)
+            printf("Snapshot: road re-laid to %d signals, plan %d:%d:%d\n",
+                   signalCount, plan.red, plan.yellow, plan.green);
+    }
 
-    // Well near second house
-    drawWell(230, 260);
+    resetTimeline();
 
-    drawFootpath();
-    drawRoad();
+    if (!replayMode)
+        printf("Snapshot loaded: %s (tick %u, %u fish, %u walkers, %u cows)\n", path, scene.tick,
+               h.fishCount, h.pedCount, h.cowCount);
+    return true;
+}
 
-    // drawWelcomeSign();
-    drawBusStop();
-    drawTrafficLight();
-    drawPlayground();
+// Whole file into memory (small files: snapshots, recordings)
+static bool readWholeFile(const char* path, std::vector<unsigned char>& data) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+    data.clear();
+    unsigned char buf[4096];
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), fp)) > 0)
+        data.insert(data.end(), buf, buf + got);
+    fclose(fp);
+    return true;
+}
 
-    for (int i = 0; i < 4; i++) {
-        float lx = 180 + i * 320;
-        drawStreetLight(lx, 280);
+#if defined(__unix__) || defined(__APPLE__)
+
+bool loadSnapshot(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Snapshot: cannot open %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        printf("Snapshot: cannot read %s\n", path);
+        return false;
     }
 
-    drawMovingCar();
-    drawMovingBus();
+    size_t size = (size_t)st.st_size;
+    void*  map  = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("Snapshot: mmap failed for %s\n", path);
+        return false;
+    }
 
-    drawDockAndFisherman();  // dock on river bank
-    drawMovingBoat();        // boat is top layer on water
+    bool ok = applySnapshot((const unsigned char*)map, size, path);
+    munmap(map, size);
+    return ok;
+}
 
-    if (showBirds)  drawBirds();
-    if (showPlane)  drawAirplane();
-    if (showPerson) drawWalkingPerson();
+#else
 
-    drawFestivalLights();
-    drawFireflies();
-    drawRain();
+bool loadSnapshot(const char* path) {
+    std::vector<unsigned char> data;
+    if (!readWholeFile(path, data)) {
+        printf("Snapshot: cannot open %s\n", path);
+        return false;
+    }
+    return applySnapshot(data.data(), data.size(), path);
 }
 
-// ============================================================================
-// ANIMATION UPDATE
-// ============================================================================
+#endif
 
-void update(int value) {
-    if (!animationPaused) {
-        float speed = speedFactor;
+// K / O under --replay use a slot in memory instead, so a replay never
+// overwrites the user's snapshot file. A load before any save in the replay
+// (the recording loaded a file saved earlier) reads the file once, read-only.
+std::vector<unsigned char> replaySnapshot;
 
-        const float PI = 3.1415926f;
+void saveReplaySnapshot() {
+    snapshotImage(replaySnapshot);
+}
 
-        // ✅ day-night angle (NO WRAP / NO AUTO RESET)
-        sunAngle += 0.008f * speed;
+bool loadReplaySnapshot() {
+    if (replaySnapshot.empty() && !readWholeFile(snapshotPath, replaySnapshot)) {
+        printf("Snapshot: cannot open %s\n", snapshotPath);
+        return false;
+    }
+    return applySnapshot(replaySnapshot.data(), replaySnapshot.size(), "replay snapshot");
+}
 
-        // ✅ use phase only for checking day/night (0..2PI)
-        float phase = std::fmod(sunAngle, 2.0f * PI);
-        if (phase < 0.0f) phase += 2.0f * PI;
+// ============================================================================
+// INPUT RECORDING + HEADLESS REPLAY
+// File layout:
+//   RecordingHeader | snapshot image (start state) | InputRecord...
+// The header carries the checkpoint settings, since scrubbing depends on
+// what the timeline holds; the road's signal layout comes with the
+// snapshot image.
+// Every keyboard/mouse event is stored with the inputTick it arrived at,
+// and after every tick an 'H' record holds a hash of the scene state.
+// Replaying applies the same events at the same ticks and compares hashes,
+// so the first diverging tick is reported exactly.
+// ============================================================================
 
-        cloudOffset     += 0.4f   * speed * windIntensity;
-        boatPosition    += 1.2f   * speed;
-        birdOffset      += 1.8f   * speed;
-        windmillAngle   += 2.5f   * speed * windIntensity;
-        planePosition   += 2.2f   * speed;
-        trainPosition   -= 1.6f   * speed;
-        personPosition  += 0.8f   * speed;
-        riverWave       += 0.5f   * speed;
-        fishPosition    += 1.3f   * speed;
-        smokeOffset     += 0.3f   * speed;
-        balloonPosition += 0.5f   * speed;
-        kitePosition    += 1.0f   * speed * windIntensity;
+const uint32_t RECORDING_MAGIC   = 0x43455256u;   // "VREC"
+const uint32_t RECORDING_VERSION = 2u;
 
-        // ✅ day/night decision uses phase (NOT sunAngle)
-        bool prevIsDay = isDay;
-        isDay = (phase < PI);
-        if (isDay != prevIsDay) {
-            printf("Switched to %s\n", isDay ? "Day" : "Night");
-        }
+struct RecordingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t checkpointEvery;
+    uint32_t checkpointLimit;
+};
 
-        // ✅ wind uses phase too (optional but better)
-        float baseWind = 0.8f + 0.4f * std::sin(phase * 0.3f);
-        windIntensity = baseWind * windUser;
+struct InputRecord {
+    uint32_t tick;
+    uint8_t  kind;      // 'K' key, 'M' mouse button, 'V' drag, 'R' reshape, 'H' hash
+    uint8_t  code;      // key or mouse button
+    uint8_t  state;     // mouse button state
+    uint8_t  pad;
+    uint32_t data;      // x | y << 16 (reshape: w | h << 16),  'H': FNV-1a hash
+};
 
-        swingAngle += (swingForward ? 0.4f : -0.4f) * speed;
-        if (swingAngle > 20.0f)  swingForward = false;
-        if (swingAngle < -20.0f) swingForward = true;
+static_assert(sizeof(InputRecord) == 12, "InputRecord must stay 12 bytes");
 
-        if (isRaining) {
-            rainOffset += 8.0f * speed;
-            if (rainOffset > HEIGHT) rainOffset = 0.0f;
-        }
+FILE* recordFile = NULL;
 
-        // traffic light cycle
-        trafficTimer += 1.0f * speed;
-        if (trafficTimer > 10000.0f) trafficTimer = 0.0f;
-        int cycle = (int)trafficTimer % 260;
-        if (cycle < 120)      trafficState = 0; // red
-        else if (cycle < 160) trafficState = 1; // yellow
-        else                  trafficState = 2; // green
-
-        // Car & bus stop on red near signal
-        float carX = std::fmod(carPosition, WIDTH + 300.0f) - 150.0f;
-        float busX = std::fmod(busPosition, WIDTH + 500.0f) - 200.0f;
-
-        bool red      = (trafficState == 0);
-        bool carNear  = red && (carX > 620.0f && carX < 690.0f);
-        bool busNear  = red && (busX > 620.0f && busX < 690.0f);
-
-        if (!carNear) carPosition += 1.8f * speed;
-        if (!busNear) busPosition += 1.5f * speed;
-
-        // Wrap positions (keep these, they are for objects only)
-        if (cloudOffset > WIDTH + 300) cloudOffset = -300;
-        if (boatPosition > WIDTH + 200) boatPosition = -200;
-        if (birdOffset > WIDTH + 150) birdOffset = -150;
-        if (carPosition > WIDTH + 250) carPosition = -250;
-        if (busPosition > WIDTH + 400) busPosition = -400;
-        if (planePosition > WIDTH + 350) planePosition = -350;
-        if (trainPosition < -800)       trainPosition = WIDTH + 400;
-        if (fishPosition > WIDTH + 300) fishPosition = -300;
-        if (balloonPosition > WIDTH + 600) balloonPosition = 0.0f;
-        if (kitePosition > WIDTH + 400)    kitePosition = 0.0f;
+static uint32_t fnv1a(uint32_t h, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 16777619u;
     }
+    return h;
+}
 
-    glutPostRedisplay();
-    glutTimerFunc(16, update, 0);
+uint32_t sceneHash() {
+    uint32_t h = 2166136261u;
+    h = fnv1a(h, &scene, sizeof(SceneState));
+    if (!fishSchool.empty())
+        h = fnv1a(h, fishSchool.data(), fishSchool.size() * sizeof(Fish));
+    if (!crowd.empty())
+        h = fnv1a(h, crowd.data(), crowd.size() * sizeof(Pedestrian));
+    if (!herd.empty())
+        h = fnv1a(h, herd.data(), herd.size() * sizeof(Cow));
+    return h;
 }
 
+bool startRecording(const char* path) {
+    recordFile = fopen(path, "wb");
+    if (!recordFile) {
+        printf("Recording: cannot write %s\n", path);
+        return false;
+    }
+    RecordingHeader h = { RECORDING_MAGIC, RECORDING_VERSION,
+                          checkpointEvery, (uint32_t)checkpointLimit };
+    if (fwrite(&h, sizeof(h), 1, recordFile) != 1 || !writeSnapshotImage(recordFile)) {
+        printf("Recording: write failed for %s\n", path);
+        fclose(recordFile);
+        recordFile = NULL;
+        return false;
+    }
+    printf("Recording input to %s\n", path);
+    return true;
+}
 
-// ============================================================================
-// DISPLAY AND INPUT HANDLING
-// ============================================================================
+static void writeRecord(const InputRecord& r) {
+    if (recordFile && fwrite(&r, sizeof(r), 1, recordFile) != 1) {
+        printf("Recording: write failed, recording stopped\n");
+        fclose(recordFile);
+        recordFile = NULL;
+    }
+}
 
-void display() {
-    glClear(GL_COLOR_BUFFER_BIT);
+void recordInput(char kind, uint8_t code, uint8_t state, int x, int y) {
+    if (!recordFile) return;
+    InputRecord r;
+    r.tick  = inputTick;
+    r.kind  = (uint8_t)kind;
+    r.code  = code;
+    r.state = state;
+    r.pad   = 0;
+    r.data  = ((uint32_t)x & 0xFFFFu) | (((uint32_t)y & 0xFFFFu) << 16);
+    writeRecord(r);
+}
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluOrtho2D(0, WIDTH, 0, HEIGHT);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+void recordTickHash() {
+    if (!recordFile) return;
+    InputRecord r;
+    r.tick  = inputTick;
+    r.kind  = 'H';
+    r.code  = 0;
+    r.state = 0;
+    r.pad   = 0;
+    r.data  = sceneHash();
+    writeRecord(r);
+}
 
-    drawVillageScene();
+void closeRecording() {
+    if (!recordFile) return;
+    fclose(recordFile);
+    recordFile = NULL;
+}
 
-    // HUD bar (✅ make it taller because now 3 lines)
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(0.0f, 0.0f, 0.0f, 0.45f);
-    glBegin(GL_QUADS);
-        glVertex2f(0, HEIGHT - 80);      // ✅ was -60
-        glVertex2f(WIDTH, HEIGHT - 80);  // ✅ was -60
-        glVertex2f(WIDTH, HEIGHT);
-        glVertex2f(0, HEIGHT);
-    glEnd();
-    glDisable(GL_BLEND);
+// Runs a recording headless at full speed. Returns the process exit code.
+int runReplay(const char* path) {
+    std::vector<unsigned char> data;
+    if (!readWholeFile(path, data)) {
+        printf("Replay: cannot open %s\n", path);
+        return 1;
+    }
 
-    glColor3f(1.0f, 1.0f, 1.0f);
+    RecordingHeader rh;
+    SnapshotHeader  sh;
+    if (data.size() < sizeof(rh) + sizeof(sh)) {
+        printf("Replay: %s is too small\n", path);
+        return 1;
+    }
+    std::memcpy(&rh, data.data(), sizeof(rh));
+    if (rh.magic != RECORDING_MAGIC || rh.version != RECORDING_VERSION) {
+        printf("Replay: %s is not a supported recording\n", path);
+        return 1;
+    }
 
-    char info[350];
+    replayMode      = true;
+    checkpointEvery = rh.checkpointEvery;
+    checkpointLimit = rh.checkpointLimit;
+    const unsigned char* image = data.data() + sizeof(rh);
+    if (!applySnapshot(image, data.size() - sizeof(rh), path)) return 1;
+    std::memcpy(&sh, image, sizeof(sh));
+
+    size_t offset  = sizeof(rh) + snapshotImageSize(sh);
+    size_t count   = (data.size() - offset) / sizeof(InputRecord);
+    const unsigned char* recs = data.data() + offset;
+
+    uint32_t tick = 0, events = 0, hashes = 0;
+    long     firstDiverged = -1;
+
+    double t0 = nowMs();
+    for (size_t i = 0; i < count; ) {
+        InputRecord r;
+
+        // all input that arrived before this tick
+        for (; i < count; i++) {
+            std::memcpy(&r, recs + i * sizeof(r), sizeof(r));
+            if (r.tick < tick) {
+                printf("Replay: %s is corrupt (record %lu is out of order)\n", path, (unsigned long)i);
+                return 1;
+            }
+            if (r.kind == 'H' || r.tick != tick) break;
+
+            int x = (int)(int16_t)(r.data & 0xFFFFu);
+            int y = (int)(int16_t)(r.data >> 16);
+            if (r.kind == 'K' && r.code != 27) handleKey(r.code);
+            if (r.kind == 'M') handleMouse(r.code, r.state, x, y);
+            if (r.kind == 'V') handleMotion(x, y);
+            if (r.kind == 'R') { winW = x > 0 ? x : 1; winH = y > 0 ? y : 1; }
+            events++;
+        }
 
-    // ---------- Line 1 ----------
-    glRasterPos2f(10, HEIGHT - 20);
-    if (animationPaused) {
-        sprintf(info,
-            "REALISTIC VILLAGE (PAUSED) | P: Play | D/N: Day/Night | "
-            "R: Rain | 1/2: Speed | E: Reset | W/S: Wind | F: Festival");
-    } else {
-        sprintf(info,
-            "REALISTIC VILLAGE (RUNNING) | P: Pause | D/N: Day/Night | "
-            "R: Rain | 1/2: Speed | E: Reset | W/S: Wind | F: Festival");
+        stepScene();
+
+        if (i < count) {
+            std::memcpy(&r, recs + i * sizeof(r), sizeof(r));
+            if (r.kind == 'H' && r.tick == tick) {
+                hashes++;
+                if (firstDiverged < 0 && r.data != sceneHash()) {
+                    firstDiverged = (long)tick;
+                    printf("Replay: DIVERGED at tick %u (recorded %08x, replayed %08x)\n",
+                           tick, r.data, sceneHash());
+                }
+                i++;
+            }
+        }
+        tick++;
     }
-    for (int i = 0; info[i] != '\0'; i++)
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
+    double ms = nowMs() - t0;
 
-    // ---------- Line 2 ----------
-    glRasterPos2f(10, HEIGHT - 38);
-    sprintf(info,
-        "B: Birds %s | A: Plane %s | G: Train %s | L: Lights %s | H: Person %s | Festival: %s | ESC: Exit",
-        showBirds  ? "ON" : "OFF",
-        showPlane  ? "ON" : "OFF",
-        showTrain  ? "ON" : "OFF",
-        showLights ? "ON" : "OFF",
-        showPerson ? "ON" : "OFF",
-        festivalMode ? "ON" : "OFF");
-    for (int i = 0; info[i] != '\0'; i++)
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
+    printf("Replay: %u ticks, %u input events, %u hashes checked in %.1f ms (%.0f ticks/s)\n",
+           tick, events, hashes, ms, ms > 0.0 ? tick * 1000.0 / ms : 0.0);
+    printf("Replay: final tick %u, state hash %08x -> %s\n", scene.tick, sceneHash(),
+           firstDiverged < 0 ? "MATCH" : "DIVERGED");
+    return firstDiverged < 0 ? 0 : 2;
+}
 
-    // ---------- Line 3 (✅ NEW: Z/X/C/V) ----------
-    glRasterPos2f(10, HEIGHT - 56);
-    sprintf(info,
-        "Transforms: Z(Scale) %s | X(Rotate) %s | C(Reflect) %s | V(Shear) %s",
-        useScaleT   ? "ON" : "OFF",
-        useRotateT  ? "ON" : "OFF",
-        useReflectT ? "ON" : "OFF",
-        useShearT   ? "ON" : "OFF");
-    for (int i = 0; info[i] != '\0'; i++)
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
+// ============================================================================
+// BENCHMARKS (headless, "--bench")
+// ============================================================================
 
-    // ---------- Right side status ----------
-    glRasterPos2f(WIDTH - 360, HEIGHT - 20);
-    sprintf(info, "MODE: %s | Rain: %s | Speed: %.1fx",
-        isDay ? "DAY" : "NIGHT",
-        isRaining ? "ON" : "OFF",
-        speedFactor);
-    for (int i = 0; info[i] != '\0'; i++)
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, info[i]);
+static void benchFishSchool() {
+    const int sizes[] = {100, 1000, 2000, 5000, 10000};
+    const int ticks   = 300;
+
+    printf("fish school (%d ticks each, 16.7 ms frame budget)\n", ticks);
+    for (int size : sizes) {
+        initFishSchool(size);
+        double t0 = nowMs();
+        for (int t = 0; t < ticks; t++) {
+            riverWave    += 0.5f;
+            boatPosition += 1.2f;
+            updateFishSchool(1.0f);
+        }
+        double perTick = (nowMs() - t0) / ticks;
+        printf("  %6d fish : %8.4f ms/tick\n", size, perTick);
+    }
+    initFishSchool(fishCount);
+}
 
-    glutSwapBuffers();
+// walkers on a red light (so trips can cross the road), then the CPU
+// figure expansion the fallback path does per frame vs the instance upload
+static void benchCrowd() {
+    const int sizes[] = {100, 1000, 10000, 50000};
+    const int ticks   = 200;
+    SceneState saved = scene;
+
+    printf("pedestrian crowd (%d ticks each)\n", ticks);
+    for (int size : sizes) {
+        initCrowd(size);
+        trafficState = 0;
+        double t0 = nowMs();
+        for (int t = 0; t < ticks; t++) updateCrowd(1.0f);
+        double simMs = (nowMs() - t0) / ticks;
+
+        int frames = size >= 10000 ? 10 : 100, verts = 0;
+        t0 = nowMs();
+        cullScene();
+        for (int f = 0; f < frames; f++) verts = expandCrowd();
+        double expandMs = (nowMs() - t0) / frames;
+
+        int stopTrips = 0;
+        for (size_t i = 0; i < crowd.size(); i++) stopTrips += crowd[i].state != PED_WALK;
+        printf("  %6d walkers: sim %8.4f ms/tick (%d on trips) | CPU figures %7.3f ms, "
+               "%u KB vs instanced %u KB/frame\n",
+               size, simMs, stopTrips, expandMs,
+               (unsigned)(verts * (2 * sizeof(float) + 4) / 1024),
+               (unsigned)(crowd.size() * sizeof(Pedestrian) / 1024));
+    }
+    scene = saved;
+    initCrowd(crowdCount);
 }
 
+// the herd sim, then the CPU cow expansion vs the instance upload
+static void benchHerd() {
+    const int sizes[] = {8, 100, 500, 2000, 5000};
+    const int ticks   = 300;
+
+    printf("cow herd (%d ticks each)\n", ticks);
+    for (int size : sizes) {
+        initHerd(size);
+        double t0 = nowMs();
+        for (int t = 0; t < ticks; t++) updateHerd(1.0f);
+        double simMs = (nowMs() - t0) / ticks;
+
+        int verts = 0;
+        t0 = nowMs();
+        cullScene();
+        for (int f = 0; f < 50; f++) verts = expandHerd();
+        double expandMs = (nowMs() - t0) / 50;
+
+        int state[3] = {0, 0, 0};
+        for (size_t i = 0; i < herd.size(); i++) state[herd[i].state]++;
+        printf("  %5d cows: sim %8.4f ms/tick (graze %d, wander %d, flock %d) | CPU cows %7.3f ms, "
+               "%u KB vs instanced %u KB/frame\n",
+               size, simMs, state[COW_GRAZE], state[COW_WANDER], state[COW_FLOCK], expandMs,
+               (unsigned)(verts * (2 * sizeof(float) + 4) / 1024),
+               (unsigned)(herd.size() * sizeof(Cow) / 1024));
+    }
+    initHerd(herdCount);
+}
 
-void keyboard(unsigned char key, int x, int y) {
-    switch (key) {
-        case 'p': case 'P':
-            animationPaused = !animationPaused;
-            printf("Animation %s\n", animationPaused ? "Paused" : "Resumed");
-            break;
+// A long corridor of lights: the event-driven controller against the old
+// way (every vehicle checks every light each tick). Same positions, but
+// the event cost only follows the vehicles and the lights that change.
+static void benchSignals() {
+    const int       counts[] = {10, 100, 1000, 10000};
+    const int       vehicles = 2000;
+    const int       ticks    = 400;
+    const PhasePlan plan     = {120, 40, 100};
+
+    printf("signal corridor (%d vehicles, %d ticks, lights 400 px apart, green wave)\n",
+           vehicles, ticks);
+    for (int count : counts) {
+        TrafficRoad road;
+        road.plans.assign(1, plan);
+        for (int k = 0; k < count; k++) {
+            float  x = 300.0f + 400.0f * k;
+            Signal s = {x, 0, waveOffset(x, 1.8f, plan), 0, -1};
+            road.signals.push_back(s);
+        }
+        float span = 400.0f * count + 400.0f;
+        std::vector<float> pos(vehicles), steps(vehicles);
+        for (int v = 0; v < vehicles; v++) {
+            pos[v]   = span * v / vehicles;
+            steps[v] = 1.2f + 0.2f * (v % 5);
+            RoadVehicle rv = {&pos[v], steps[v], span, 0.0f, 0, -1, false};
+            road.vehicles.push_back(rv);
+        }
+        std::vector<float> scan = pos;
+        road.changes = road.wakes = 0;
+
+        float    timer = 0.0f;
+        uint32_t tick  = 0;
+        resetSignals(road, timer, 1.0f, tick);
+        double t0 = nowMs();
+        for (int t = 0; t < ticks; t++) {
+            tick++;
+            timer += 1.0f;
+            if (nextSignalDue(road) == tick) fireSignals(road, timer, 1.0f, tick);
+            moveRoadVehicles(road, 1.0f);
+        }
+        double eventMs = (nowMs() - t0) / ticks;
+        int queued = 0;
+        for (int v = 0; v < vehicles; v++) queued += road.vehicles[v].queued;
+
+        printf("  %5d lights: events %8.4f ms/tick (%.2f changes, %.2f wakes, %d queued)",
+               count, eventMs, (double)road.changes / ticks, (double)road.wakes / ticks, queued);
+        if (count > 1000) { printf("\n"); continue; }
+
+        timer = 0.0f;
+        t0 = nowMs();
+        for (int t = 0; t < ticks; t++) {
+            timer += 1.0f;
+            for (int v = 0; v < vehicles; v++) {
+                float x    = std::fmod(scan[v], span);
+                bool  stop = false;
+                for (int k = 0; k < count; k++) {
+                    const Signal& s = road.signals[k];
+                    stop |= x > s.x - 80.0f && x < s.x - 10.0f &&
+                            signalPhase(plan, s.offset, timer) == 0;
+                }
+                if (!stop) scan[v] += steps[v];
+            }
+        }
+        double scanMs = (nowMs() - t0) / ticks;
+        printf(" | scan all %8.4f ms/tick, same positions: %s\n",
+               scanMs, scan == pos ? "yes" : "NO");
+    }
+}
 
-        case 'd': case 'D':
-            sunAngle      = 0.3f;
-            isDay         = true;
-            dayNightBlend = 1.0f;
-            printf("Switched to Day mode\n");
-            break;
+static void benchTimeSeek() {
+    const char* horizons[] = {"1m", "1h", "17h", "240h"};
+
+    printf("analytic seek (stateAt)\n");
+    SceneState base = sceneDefaults();
+    for (const char* h : horizons) {
+        uint64_t n = parseTicks(h);
+        double t0 = nowMs();
+        SceneState st = stateAt(base, n);
+        double ms = nowMs() - t0;
+        printf("  %5s (%10llu ticks) : %8.4f ms  car %.1f bus %.1f\n",
+               h, (unsigned long long)n, ms, st.carPosition, st.busPosition);
+    }
 
-        case 'n': case 'N':
-            sunAngle      = 3.4f;
-            isDay         = false;
-            dayNightBlend = 0.0f;
-            printf("Switched to Night mode\n");
-            break;
+    // cross-check against the real tick loop
+    SceneState saved = scene;
+    std::vector<Fish> savedFish;
+    std::vector<Pedestrian> savedCrowd;
+    std::vector<Cow> savedHerd;
+    savedFish.swap(fishSchool);
+    savedCrowd.swap(crowd);
+    savedHerd.swap(herd);
+
+    scene = base;
+    const uint64_t n = 100000;
+    uint64_t fires0 = sceneTimerFires;
+    double t0 = nowMs();
+    for (uint64_t i = 0; i < n; i++) stepScene();
+    double stepMs = nowMs() - t0;
+    uint64_t fires = sceneTimerFires - fires0;
+    SceneState st = stateAt(base, n);
+    // everything but the wind-driven fields has to match bit for bit
+    SceneState windless = st;
+    windless.cloudOffset   = scene.cloudOffset;
+    windless.kitePosition  = scene.kitePosition;
+    windless.windmillAngle = scene.windmillAngle;
+    bool exact = std::memcmp(&windless, &scene, sizeof(SceneState)) == 0;
+    printf("  stepping %llu ticks: %.1f ms | exact fields %s | cloud %+.2f kite %+.2f windmill %+.2f\n",
+           (unsigned long long)n, stepMs, exact ? "match" : "DIFFER",
+           st.cloudOffset - scene.cloudOffset, st.kitePosition - scene.kitePosition,
+           st.windmillAngle - scene.windmillAngle);
+    printf("  timer wheel: %llu events fired (%.3f per tick, %d scheduled)\n",
+           (unsigned long long)fires, (double)fires / n, (int)TM_COUNT);
+
+    scene = saved;
+    fishSchool.swap(savedFish);
+    crowd.swap(savedCrowd);
+    herd.swap(savedHerd);
+}
 
-        // ❌ remove T rain toggle (now rain is R)
-        // case 't': case 'T':
-        //     isRaining = !isRaining;
-        //     printf("Rain %s\n", isRaining ? "ON" : "OFF");
-        //     break;
+static void benchTimeline() {
+    SceneState saved = scene;
+    scene = sceneDefaults();
+    resetTimeline();
+
+    const uint32_t recorded = 200000;   // ~53 min of play
+    for (uint32_t i = 0; i < recorded; i++) stepScene();
+
+    const int seeks = 2000;
+    uint32_t t0, t1;
+    timelineRange(t0, t1);
+    std::vector<double> times;
+    double total = 0.0;
+    for (int i = 0; i < seeks; i++) {
+        uint32_t target = t0 + (uint32_t)(fishRand() * (t1 - t0));
+        double s0 = nowMs();
+        seekTimeline(target);
+        times.push_back(nowMs() - s0);
+        total += times.back();
+    }
+    std::sort(times.begin(), times.end());
+    int over = (int)(times.end() - std::upper_bound(times.begin(), times.end(), 1.0));
+
+    // the two slowest paths, best of 20 (no scheduler noise): the longest
+    // stepped gap between checkpoints, and stateAt() (past the recorded end)
+    const SceneState& midState = checkpoints[checkpoints.size() / 2];
+    uint32_t mid = midState.tick;
+    uint32_t longestStep = std::min(std::max(checkpointEvery, 1u) - 1, SEEK_STEP_MAX);
+    double worstPath[2] = {1e9, 1e9};
+    for (int r = 0; r < 20; r++) {
+        seekTimeline(mid - 1);   // behind the checkpoint, so the seek starts from it
+        double s0 = nowMs();
+        seekTimeline(mid + longestStep);
+        worstPath[0] = std::min(worstPath[0], nowMs() - s0);
+
+        s0 = nowMs();
+        scene = stateAt(midState, SEEK_STEP_MAX + 1);
+        worstPath[1] = std::min(worstPath[1], nowMs() - s0);
+    }
 
-        case '1':
-            speedFactor *= 1.3f;
-            if (speedFactor > 8.0f) speedFactor = 8.0f;
-            printf("Speed increased: %.2fx\n", speedFactor);
-            break;
+    printf("timeline scrub (%u ticks recorded, %u checkpoints = %u KB, every %u ticks)\n",
+           recorded, (unsigned)checkpoints.size(),
+           (unsigned)(checkpoints.size() * sizeof(SceneState) / 1024), checkpointEvery);
+    printf("  %d random seeks : avg %.4f ms, p99 %.4f ms, worst %.4f ms (%d over 1 ms)\n",
+           seeks, total / seeks, times[seeks * 99 / 100], times.back(), over);
+    printf("  worst paths    : %u ticks stepped %.4f ms, %u ticks via stateAt %.4f ms\n",
+           longestStep, worstPath[0], SEEK_STEP_MAX + 1, worstPath[1]);
 
-        case '2':
-            speedFactor *= 0.7f;
-            if (speedFactor < 0.1f) speedFactor = 0.1f;
-            printf("Speed decreased: %.2fx\n", speedFactor);
-            break;
+    scene = saved;
+    resetTimeline();
+}
 
-        case 'w': case 'W':
-            windUser += 0.2f;
-            if (windUser > 2.0f) windUser = 2.0f;
-            printf("Wind increased: %.1f\n", windUser);
-            break;
+static void benchTimeOfDay() {
+    double t0 = nowMs();
+    bakeTimeOfDay();
+    double bakeMs = nowMs() - t0;
+
+    // per frame: the old day/night lerp of every material vs one row fetch
+    const int frames = 1000000;
+    volatile float sink = 0.0f;
+    float saved = sunAngle;
+
+    t0 = nowMs();
+    for (int i = 0; i < frames; i++) {
+        float f = (i & 255) / 255.0f, acc = 0.0f;
+        for (int m = 0; m < TOD_COUNT; m++) {
+            const TodKeys& k = TOD_KEYS[m];
+            acc += k.noon.r * f + k.night.r * (1.0f - f);
+            acc += k.noon.g * f + k.night.g * (1.0f - f);
+            acc += k.noon.b * f + k.night.b * (1.0f - f);
+        }
+        sink = sink + acc;
+    }
+    double lerpNs = (nowMs() - t0) * 1e6 / frames;
+
+    t0 = nowMs();
+    for (int i = 0; i < frames; i++) {
+        sunAngle = i * 0.008f;
+        updateTimeOfDay();
+        float acc = 0.0f;
+        for (int m = 0; m < TOD_COUNT; m++)
+            acc += todNow[m].r + todNow[m].g + todNow[m].b;
+        sink = sink + acc;
+    }
+    double lutNs = (nowMs() - t0) * 1e6 / frames;
+
+    // the D / N phases must fetch the pure noon / night keyframes
+    int keyMiss = 0;
+    sunAngle = TOD_NOON_PHASE;
+    updateTimeOfDay();
+    for (int m = 0; m < TOD_COUNT; m++)
+        keyMiss += todNow[m].r != TOD_KEYS[m].noon.r || todNow[m].g != TOD_KEYS[m].noon.g ||
+                   todNow[m].b != TOD_KEYS[m].noon.b;
+    sunAngle = TOD_MIDNIGHT_PHASE;
+    updateTimeOfDay();
+    for (int m = 0; m < TOD_COUNT; m++)
+        keyMiss += todNow[m].r != TOD_KEYS[m].night.r || todNow[m].g != TOD_KEYS[m].night.g ||
+                   todNow[m].b != TOD_KEYS[m].night.b;
+    sunAngle = saved;
+    updateTimeOfDay();
+
+    printf("time-of-day table (%d rows x %d materials, %u KB)\n",
+           TOD_LUT_SIZE, (int)TOD_COUNT, (unsigned)(sizeof(todTable) / 1024));
+    printf("  bake %.3f ms | per frame: lerps %.1f ns, table %.1f ns\n", bakeMs, lerpNs, lutNs);
+    printf("  D/N keys: noon + midnight rows %s\n", keyMiss ? "MISMATCH" : "exact");
+
+    t0 = nowMs();
+    for (int i = 0; i < frames / 10; i++) resolveMaterials();
+    double palNs = (nowMs() - t0) * 1e6 / (frames / 10);
+    printf("  material palette: %d materials -> RGBA8 in %.1f ns/frame\n", (int)MAT_COUNT, palNs);
+}
 
-        case 's': case 'S':
-            windUser -= 0.2f;
-            if (windUser < 0.2f) windUser = 0.2f;
-            printf("Wind decreased: %.1f\n", windUser);
-            break;
+static void benchRiverSurface() {
+    // accuracy of the polynomial over a wide range of phases
+    float maxErr = 0.0f;
+    for (int i = -200000; i <= 200000; i++) {
+        float x = i * 0.0025f;
+        maxErr = std::max(maxErr, std::fabs(fastSin(x) - std::sin(x)));
+    }
+    printf("river surface (fastSin max error %.2e)\n", maxErr);
+
+    const TodColor water = {0.10f, 0.35f, 0.60f};
+    const int widths[2] = {1400, 7680};
+    for (int w = 0; w < 2; w++) {
+        int columns = riverColumnsFor(widths[w]);
+        int frames = 2000000 / columns + 100;
+        RiverSurface fast, ref;
+        volatile float sink = 0.0f;
+
+        double t0 = nowMs();
+        for (int f = 0; f < frames; f++) {
+            buildRiverSurface(fast, columns, f * 0.5f, 4.0f, water, true);
+            sink = sink + fast.pos[5];
+        }
+        double fastUs = (nowMs() - t0) * 1e3 / frames;
+
+        // reference: the same strip one column at a time with std::sin
+        ref.pos.resize(fast.pos.size());
+        ref.color.resize(fast.color.size());
+        const float dx = (float)WIDTH / (columns - 1);
+        t0 = nowMs();
+        for (int f = 0; f < frames; f++) {
+            float wave = f * 0.5f;
+            for (int i = 0; i < columns; i++) {
+                float x = i * dx;
+                float depth = 0.10f + 0.10f * std::sin(x * 0.02f + wave * 0.02f);
+                float s = (x > WIDTH * 0.70f && x < WIDTH * 0.92f)
+                        ? 0.10f + 0.10f * std::sin((x - WIDTH * 0.78f) * 0.06f + wave * 0.10f) : 0.0f;
+                float* p = &ref.pos[i * 4];
+                p[0] = x; p[1] = RIVER_TOP + 4.0f * std::sin(x * 0.03f + wave * 0.10f);
+                p[2] = x; p[3] = RIVER_BOTTOM + 4.0f * std::sin(x * 0.03f + wave * 0.10f + 0.55f);
+                float* c = &ref.color[i * 8];
+                c[0] = water.r + 0.10f + s; c[1] = water.g + 0.10f + s; c[2] = water.b + 0.12f + s; c[3] = 1.0f;
+                c[4] = water.r - depth; c[5] = water.g - depth * 0.9f; c[6] = water.b - depth * 0.6f; c[7] = 1.0f;
+            }
+            sink = sink + ref.pos[5];
+        }
+        double refUs = (nowMs() - t0) * 1e3 / frames;
 
-        case 'b': case 'B':
-            showBirds = !showBirds;
-            printf("Birds %s\n", showBirds ? "ON" : "OFF");
-            break;
+        float diff = 0.0f;
+        for (size_t i = 0; i < ref.pos.size(); i++)   diff = std::max(diff, std::fabs(ref.pos[i] - fast.pos[i]));
+        for (size_t i = 0; i < ref.color.size(); i++) diff = std::max(diff, std::fabs(ref.color[i] - fast.color[i]));
 
-        case 'a': case 'A':
-            showPlane = !showPlane;
-            printf("Airplane %s\n", showPlane ? "ON" : "OFF");
-            break;
+        printf("  %5d px, %4d columns: std::sin %.2f us, surface pass %.2f us (%.1fx), max diff %.1e\n",
+               widths[w], columns, refUs, fastUs, refUs / fastUs, diff);
+    }
+}
 
-        case 'g': case 'G':
-            showTrain = !showTrain;
-            printf("Train %s\n", showTrain ? "ON" : "OFF");
-            break;
+static void benchStarfield() {
+    const int counts[2] = {400, 100000};
+    volatile uint32_t sink = 0;
+    printf("starfield (fixed-function twinkle update; the shader path has none)\n");
+    for (int k = 0; k < 2; k++) {
+        double t0 = nowMs();
+        initStarfield(counts[k]);
+        double genMs = nowMs() - t0;
+
+        const int frames = 200;
+        t0 = nowMs();
+        for (int f = 0; f < frames; f++) {
+            scene.tick = f;
+            updateStarColors(1.0f);
+            sink = sink + starColors[f % starColors.size()];
+        }
+        double updUs = (nowMs() - t0) * 1e3 / frames;
+        printf("  %6d stars (%d bright): generate %.2f ms once, twinkle %.1f us/frame, %u KB static + %u KB/frame\n",
+               counts[k], brightStars, genMs, updUs,
+               (unsigned)(starfield.size() * sizeof(Star) / 1024),
+               (unsigned)(starColors.size() * sizeof(uint32_t) / 1024));
+    }
+    initStarfield(starCount);
+    scene = sceneDefaults();
+}
 
-        case 'l': case 'L':
-            showLights = !showLights;
-            printf("Lights glow %s\n", showLights ? "ON" : "OFF");
-            break;
+static void benchCloudBake() {
+    int threads = std::max(1, (int)std::thread::hardware_concurrency());
+    double t0 = nowMs();
+    startCloudBake(1);
+    finishCloudBake();
+    double oneMs = nowMs() - t0;
+
+    t0 = nowMs();
+    startCloudBake(threads);
+    finishCloudBake();
+    double allMs = nowMs() - t0;
+    std::vector<unsigned char>().swap(cloudPixels);
+
+    printf("cloud atlas (%d shapes, %dx%d): bake 1 thread %.1f ms, %d threads %.1f ms\n",
+           CLOUD_SHAPES, CLOUD_ATLAS_W, CLOUD_ATLAS_H, oneMs, std::min(threads, CLOUD_SHAPES), allMs);
+}
 
-        case 'h': case 'H':
-            showPerson = !showPerson;
-            printf("Person %s\n", showPerson ? "ON" : "OFF");
-            break;
+// flow-field bake, then crowds with everyone on a trip: steering is one
+// lookup per walker, so the cost per walker stays flat as the crowd grows
+static void benchNavigation() {
+    int threads = std::max(1, (int)std::thread::hardware_concurrency());
+    finishNavBake();   // don't race the start-up bake
+    double t0 = nowMs();
+    for (int d = 0; d < NAV_DEST_COUNT; d++) bakeFlowField(d);
+    double oneMs = nowMs() - t0;
+
+    t0 = nowMs();
+    navReady = false;
+    startNavBake(threads);
+    finishNavBake();
+    double allMs = nowMs() - t0;
+
+    int open = 0, reach = 0;
+    for (size_t c = 0; c < navGrid.size(); c++) {
+        open  += navGrid[c] != NAV_BLOCKED;
+        reach += navFlow[NAV_BUS_STOP][c] != NAV_NO_PATH;
+    }
+    printf("flow fields (%d destinations, %dx%d cells, %d walkable, %d reach the bus stop): "
+           "bake 1 thread %.1f ms, %d threads %.1f ms\n", (int)NAV_DEST_COUNT, NAV_COLS, NAV_ROWS,
+           open, reach, oneMs, std::min(threads, (int)NAV_DEST_COUNT), allMs);
+
+    SceneState saved = scene;
+    const int sizes[] = {1, 1000, 100000};
+    for (int size : sizes) {
+        initCrowd(size);
+        for (size_t i = 0; i < crowd.size(); i++) {
+            crowd[i].state = PED_TRIP;
+            crowd[i].dest  = (uint8_t)(NAV_BUS_STOP + i % (NAV_DEST_COUNT - 1));
+        }
+        trafficState = 0;
+        int ticks = size >= 100000 ? 20 : 200;
+        t0 = nowMs();
+        for (int t = 0; t < ticks; t++) updateCrowd(1.0f);
+        double ms = (nowMs() - t0) / ticks;
+        printf("  %6d walkers on trips: %8.4f ms/tick (%.1f ns per walker)\n", size, ms, ms * 1e6 / size);
+    }
+    scene = saved;
+    initCrowd(crowdCount);
+}
 
-        case 'f': case 'F':
-            festivalMode = !festivalMode;
-            printf("Festival mode %s\n", festivalMode ? "ON" : "OFF");
-            break;
+static void benchHills() {
+    // what the old drawDistantHills() computed every frame
+    const int frames = 20000;
+    volatile float sink = 0.0f;
+    double t0 = nowMs();
+    int perFrame = 0;
+    for (int f = 0; f < frames; f++) {
+        perFrame = 0;
+        for (int l = 0; l < 4; l++) {
+            const HillLayer& h = HILL_LAYERS[l];
+            for (float x = 0; x <= WIDTH; x += h.step) {
+                sink = sink + h.baseY + h.amp1 * std::sin(x * h.f1) + h.amp2 * std::sin(x * h.f2 + 1.7f);
+                perFrame++;
+            }
+        }
+    }
+    double oldUs = (nowMs() - t0) * 1e3 / frames;
+    printf("distant hills: old per-frame ridge %d vertices, %.2f us of sin; now built once:\n", perFrame, oldUs);
+
+    const int octaves[3] = {0, 3, 6};
+    for (int k = 0; k < 3; k++) {
+        t0 = nowMs();
+        buildHills(octaves[k]);
+        double buildUs = (nowMs() - t0) * 1e3;
+        printf("  %d octaves: %5d vertices, build %.1f us once, 4 draw calls per frame\n",
+               octaves[k], (int)hillVertices.size() / 2, buildUs);
+    }
+    buildHills(hillOctaves);
+}
 
-        // ✅ R = Rain toggle
-        case 'r': case 'R':
-            isRaining = !isRaining;
-            printf("Rain %s\n", isRaining ? "ON" : "OFF");
-            break;
+static void benchLightPass() {
+    printf("light pass (%dx%d grid, CPU side; upload + 2 quads on top)\n", LIGHT_GRID_W, LIGHT_GRID_H);
+    const int counts[4] = {10, 100, 1000, 10000};
+    for (int k = 0; k < 4; k++) {
+        uint32_t seed = 99u;
+        auto rnd = [&]() {
+            seed = seed * 1664525u + 1013904223u;
+            return (seed >> 8) * (1.0f / 16777216.0f);
+        };
+        std::vector<PointLight> lights;
+        for (int i = 0; i < counts[k]; i++) {
+            PointLight l = {rnd() * WIDTH, rnd() * HEIGHT, rnd(), rnd(), rnd(), i % LIGHT_SIZES};
+            lights.push_back(l);
+        }
 
-        // ✅ NEW: transformation toggles (algorithm based)
-        case 'z': case 'Z':
-            useScaleT = !useScaleT;
-            printf("Algorithm Scale %s\n", useScaleT ? "ON" : "OFF");
-            break;
+        const int frames = 200;
+        double t0 = nowMs();
+        for (int f = 0; f < frames; f++) {
+            frameLights = lights;
+            accumulateLights();
+        }
+        printf("  %5d lights: %.3f ms/frame\n", counts[k], (nowMs() - t0) / frames);
+    }
+    frameLights.clear();
+}
 
-        case 'x': case 'X':
-            useRotateT = !useRotateT;
-            printf("Algorithm Rotate %s\n", useRotateT ? "ON" : "OFF");
-            break;
+// random footprints over the ground band, for both shadow benches
+static void fillShadowCasters(int count) {
+    uint32_t seed = 7u;
+    auto rnd = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) * (1.0f / 16777216.0f);
+    };
+    frameShadows.clear();
+    for (int i = 0; i < count; i++) {
+        ShadowCaster c = {rnd() * WIDTH, rnd() * 380.0f, 8.0f + rnd() * 70.0f, 3.0f + rnd() * 9.0f, 0.2f + rnd() * 0.15f};
+        frameShadows.push_back(c);
+    }
+}
 
-        case 'c': case 'C':
-            useReflectT = !useReflectT;
-            printf("Algorithm Reflection %s\n", useReflectT ? "ON" : "OFF");
-            break;
+static void benchShadowPass() {
+    printf("shadow pass (CPU batch build; one glDrawArrays on top, see --bench-gl)\n");
+    const int counts[4] = {20, 200, 2000, 20000};
+    for (int k = 0; k < 4; k++) {
+        const int frames = 200;
+        double t0 = nowMs();
+        int n = 0;
+        for (int f = 0; f < frames; f++) {
+            fillShadowCasters(counts[k]);
+            setShadowLight(f * 0.015f, 1.0f);
+            n = buildShadowBatch();
+        }
+        printf("  %5d casters: %.3f ms/frame, %d vertices, %zu KB\n", counts[k],
+               (nowMs() - t0) / frames, n, (shadowXY.size() * 4 + shadowRGBA.size()) / 1024);
+    }
+    frameShadows.clear();
+}
 
-        case 'v': case 'V':
-            useShearT = !useShearT;
-            printf("Algorithm Shear %s\n", useShearT ? "ON" : "OFF");
-            break;
+static void benchCables() {
+    printf("cables (CPU: set anchors + re-tessellate changed spans + draw list)\n");
+    const int counts[2] = {100, 2000};
+    for (int k = 0; k < 2; k++) {
+        cables.clear();
+        cableXY.clear();
+        cableRGBA.clear();
+        std::vector<int> ids;
+        for (int i = 0; i < counts[k]; i++)
+            ids.push_back(addCable(i % 2, 16, 4.0f + (i % 7), 0.2f, 0.2f, 0.2f, 1.0f));
+
+        const int frames = 200;
+        for (int windy = 0; windy < 2; windy++) {
+            windIntensity = windy ? 1.5f : 0.0f;
+            cableTessellations = 0;
+            double t0 = nowMs();
+            for (int f = 0; f < frames; f++) {
+                riverWave = f * 0.5f;
+                for (int i = 0; i < counts[k]; i++) {
+                    float x = (float)((i * 37) % WIDTH);
+                    setCable(ids[i], x, 400.0f + (i % 5), x + 60.0f + (i % 90), 405.0f);
+                }
+                for (int layer = 0; layer < CABLE_LAYERS; layer++) {   // draw lists only
+                    cableIndex.clear();
+                    for (size_t c = 0; c < cables.size(); c++) {
+                        if (cables[c].layer != layer || !cables[c].shown) continue;
+                        cables[c].shown = false;
+                        for (int v = 0; v < cables[c].segments * 2; v++) cableIndex.push_back((GLuint)(cables[c].first + v));
+                    }
+                }
+            }
+            printf("  %4d spans, %-10s %.3f ms/frame (%.1f re-tessellated per frame)\n", counts[k],
+                   windy ? "windy:" : "still air:", (nowMs() - t0) / frames,
+                   (double)cableTessellations / frames);
+        }
+    }
+    scene = sceneDefaults();
+    initCables();
+}
 
-        // ✅ RESET moved to E (because R is rain now)
-        case 'e': case 'E':
-            sunAngle        = 0.0f;
-            cloudOffset     = 0.0f;
-            boatPosition    = 0.0f;
-            birdOffset      = 0.0f;
-            windmillAngle   = 0.0f;
-            carPosition     = 0.0f;
-            busPosition     = -300.0f;
-            swingAngle      = 0.0f;
-            swingForward    = true;
-            planePosition   = 0.0f;
-            rainOffset      = 0.0f;
-            speedFactor     = 1.0f;
-            trainPosition   = WIDTH + 400.0f;
-            personPosition  = 0.0f;
-            riverWave       = 0.0f;
-            fishPosition    = 0.0f;
-            smokeOffset     = 0.0f;
-            windIntensity   = 1.0f;
-            dayNightBlend   = isDay ? 1.0f : 0.0f;
-            balloonPosition = 0.0f;
-            trafficTimer    = 0.0f;
-            trafficState    = 0;
-            kitePosition    = 0.0f;
-
-            showBirds       = true;
-            showPlane       = true;
-            showTrain       = true;
-            showLights      = true;
-            showPerson      = true;
-            festivalMode    = false;
-
-            // also reset transform toggles
-            useScaleT   = true;
-            useRotateT  = true;
-            useReflectT = true;
-            useShearT   = true;
+// the culling pass on a busy scene, with the view where it is, half a
+// screen to the right and far away along the road
+static void benchCulling() {
+    SceneState saved = scene;
+    initFishSchool(1000);
+    initCrowd(10000);
+    initHerd(2000);
+    initForest(10000);
+    initClouds(1000);
+    trainBogieCount = MAX_TRAIN_COACHES;
+    trainPosition   = 0.0f;
+
+    const float pans[3] = {0.0f, WIDTH * 0.5f, WIDTH * 4.0f};
+    const int   frames  = 100;
+    printf("viewport culling (1000 fish, 10000 walkers, 2000 cows, 10000 sprite trees, %d clouds, %d coaches)\n",
+           (int)cloudImpostors.size(), trainBogieCount);
+    for (float pan : pans) {
+        cullView.x0 = pan;
+        cullView.x1 = pan + WIDTH;
+        double t0 = nowMs();
+        for (int f = 0; f < frames; f++) cullScene();
+        double ms = (nowMs() - t0) / frames;
+
+        int tested = 0, skipped = 0;
+        for (int k = 0; k < CULL_KINDS; k++) { tested += cullTested[k]; skipped += cullSkipped[k]; }
+        printf("  view x %6.0f..%-6.0f: %.3f ms/frame, %d of %d culled (", cullView.x0, cullView.x1, ms, skipped, tested);
+        for (int k = 0; k < CULL_KINDS; k++)
+            printf("%s%s %d/%d", k ? ", " : "", CULL_NAMES[k], cullSkipped[k], cullTested[k]);
+        printf(")\n");
+    }
+    cullView.x0 = 0.0f;
+    cullView.x1 = (float)WIDTH;
+
+    scene = saved;
+    initClouds(cloudCount);
+    initFishSchool(fishCount);
+    initCrowd(crowdCount);
+    initHerd(herdCount);
+    initForest(forestCount);
+}
 
-            printf("All animations & toggles reset (E)\n");
-            break;
+static void benchBloom() {
+    printf("bloom (CPU: downsample + threshold + 3 box passes + pack; read-back / upload in --bench-gl)\n");
+    const int sizes[2][2] = {{1400, 800}, {7680, 4320}};
+    for (int k = 0; k < 2; k++) {
+        int fw = sizes[k][0], fh = sizes[k][1];
+        bloom.frame.assign((size_t)fw * fh * 4, 40);
+        uint32_t seed = 5u;
+        for (int i = 0; i < 400; i++) {                  // some bright spots
+            seed = seed * 1664525u + 1013904223u;
+            int cx = (seed >> 8) % fw;
+            seed = seed * 1664525u + 1013904223u;
+            int cy = (seed >> 8) % fh;
+            for (int y = std::max(0, cy - 6); y < std::min(fh, cy + 6); y++)
+                memset(&bloom.frame[((size_t)y * fw + std::max(0, cx - 6)) * 4], 255,
+                       (size_t)(std::min(fw, cx + 6) - std::max(0, cx - 6)) * 4);
+        }
+        for (int div = 2; div <= 4; div += 2) {
+            int frames = k == 0 ? 50 : 5;
+            double t0 = nowMs();
+            for (int f = 0; f < frames; f++) bloomProcess(bloom.frame.data(), fw, fh, div, 0.6f);
+            printf("  %5dx%-4d at 1/%d (%4dx%-4d): %.2f ms/frame\n",
+                   fw, fh, div, bloom.w, bloom.h, (nowMs() - t0) / frames);
+        }
+    }
+    BloomBuffers empty = {};
+    bloom = empty;
+}
 
-        case 27:
-            printf("Exiting program\n");
-            exit(0);
-            break;
+// Fixed-function vs shader path, CPU side (no GL context needed): what the
+// CPU computes and streams to GL per frame for the sky + water body.
+static void benchShaderPath() {
+    const int widths[2] = {1400, 7680};
+    const int frames = 20000;
+    volatile float sink = 0.0f;
+    printf("sky + water body per frame: fixed-function vs GLSL (CPU side, --bench-gl times the GPU)\n");
+    for (int w = 0; w < 2; w++) {
+        int columns = riverColumnsFor(widths[w]);
+        double t0 = nowMs();
+        for (int f = 0; f < frames; f++) {
+            sunAngle = f * 0.01f;
+            updateTimeOfDay();
+            buildRiverSurface(riverSurface, columns, f * 0.5f, 4.0f, todNow[TOD_WATER], true);
+            sink = sink + riverSurface.pos[1];
+        }
+        double fixedUs = (nowMs() - t0) * 1e3 / frames;
+        size_t fixedBytes = 4 * 5 * sizeof(float)                 // sky quad, immediate mode
+                          + (size_t)columns * 2 * 6 * sizeof(float);  // strip xy + rgba
+        printf("  %5d px: fixed %.2f us + %u bytes of vertices | GLSL 2 x 5 uniforms (48 bytes)\n",
+               widths[w], fixedUs, (unsigned)fixedBytes);
     }
+    scene = sceneDefaults();
 }
 
-void mouse(int button, int state, int x, int y) {
-    if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN) {
-        printf("Mouse clicked at: (%d, %d)\n", x, HEIGHT - y);
-        animationPaused = !animationPaused;
+// --bench-gl: needs a live context, so display() runs it on the first frame.
+// Draws sky + river only, glFinish() per frame, both paths, two strip widths,
+// then the starfield, shadows, reflections, pedestrians, cows and bloom.
+void runGLBenchmarks() {
+    const int frames = 300;
+    SceneState saved = scene;
+    bool savedUse = useShaders;
+    int  savedW   = winW;
+
+    printf("sky + river, %d frames each (%s)\n", frames, (const char*)glGetString(GL_RENDERER));
+    const int widths[2] = {1400, 7680};
+    for (int w = 0; w < 2; w++) {
+        winW = widths[w];   // only drives the strip's column count here
+        for (int pass = 0; pass < 2; pass++) {
+            useShaders = pass == 1;
+            if (useShaders && !shadersReady) {
+                printf("  %5d px: GLSL path not available\n", widths[w]);
+                continue;
+            }
+
+            double t0 = 0.0, submit = 0.0;
+            for (int f = -20; f < frames; f++) {   // 20 warm-up frames
+                if (f == 0) { glFinish(); t0 = nowMs(); submit = 0.0; }
+                riverWave = f * 0.5f;
+                sunAngle  = f * 0.02f;
+
+                double s0 = nowMs();
+                glClear(GL_COLOR_BUFFER_BIT);
+                glMatrixMode(GL_PROJECTION);
+                glLoadIdentity();
+                gluOrtho2D(0, WIDTH, 0, HEIGHT);
+                glMatrixMode(GL_MODELVIEW);
+                glLoadIdentity();
+                updateTimeOfDay();
+                drawSky();
+                drawRiver();
+                submit += nowMs() - s0;
+                glFinish();
+            }
+            double total = nowMs() - t0;
+            printf("  %5d px %-14s %.3f ms/frame (CPU submit %.3f ms)\n", widths[w],
+                   useShaders ? "GLSL:" : "fixed-function:", total / frames, submit / frames);
+        }
+    }
+
+    // night sky, run with --stars 100000 for the full field
+    isDay = false;
+    dayNightBlend = 0.0f;
+    for (int pass = 0; pass < 2; pass++) {
+        useShaders = pass == 1;
+        if (useShaders && !shadersReady) continue;
+
+        double t0 = 0.0;
+        for (int f = -20; f < frames; f++) {
+            if (f == 0) { glFinish(); t0 = nowMs(); }
+            scene.tick = (uint32_t)(f + 20);
+            sunAngle   = 3.4f + f * 0.002f;
+            glClear(GL_COLOR_BUFFER_BIT);
+            drawStars();
+            glFinish();
+        }
+        printf("  %d stars %-14s %.3f ms/frame\n", (int)starfield.size(),
+               useShaders ? "GLSL:" : "fixed-function:", (nowMs() - t0) / frames);
+    }
+
+    // shadows: one immediate fan per caster vs the batched stencil pass
+    const int casters[2] = {200, 2000};
+    for (int k = 0; k < 2; k++) {
+        for (int pass = 0; pass < 2; pass++) {
+            if (pass == 1 && !shadowStencil) {
+                printf("  %d shadows: no stencil buffer, batched pass off\n", casters[k]);
+                continue;
+            }
+            double t0 = 0.0;
+            for (int f = -5; f < frames / 3; f++) {
+                if (f == 0) { glFinish(); t0 = nowMs(); }
+                glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+                fillShadowCasters(casters[k]);
+                if (pass == 0) {
+                    for (size_t i = 0; i < frameShadows.size(); i++) {
+                        const ShadowCaster& c = frameShadows[i];
+                        drawShadowEllipse(c.cx, c.cy, c.rx, c.ry, c.alpha);
+                    }
+                    frameShadows.clear();
+                } else {
+                    beginShadowMask();
+                    drawShadowPass();
+                }
+                glFinish();
+            }
+            printf("  %d shadows %-14s %.3f ms/frame\n", casters[k],
+                   pass == 0 ? "per caster:" : "batched:", (nowMs() - t0) / (frames / 3));
+        }
+    }
+
+    // river reflections of whatever is in the frame (far bank + the boat)
+    if (shadowStencil) {
+        double t0 = 0.0;
+        for (int f = -5; f < frames / 3; f++) {
+            if (f == 0) { glFinish(); t0 = nowMs(); }
+            glClear(GL_STENCIL_BUFFER_BIT);
+            beginShadowMask();
+            glStencilFunc(GL_ALWAYS, MASK_WATER, 0xFF);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glRectf(0.0f, RIVER_BOTTOM, (float)WIDTH, RIVER_TOP);   // mark the band as water
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            addMirror(500.0f, 640.0f, 113.0f, 151.0f, 0.6f, 0.45f);
+            drawReflections();
+            glDisable(GL_STENCIL_TEST);
+            glFinish();
+        }
+        printf("  river reflection: %.3f ms/frame (copy + %d quads)\n",
+               (nowMs() - t0) / (frames / 3), (int)(mirrorXY.size() / 8));
+    }
+
+    // pedestrians: CPU-expanded triangle array vs one instanced draw, each
+    // with the walkers' own shadow pass (one footprint per walker)
+    const int crowdSizes[2] = {1000, 50000};
+    for (int k = 0; k < 2; k++) {
+        initCrowd(crowdSizes[k]);
+        for (int pass = 0; pass < 2; pass++) {
+            useShaders = pass == 1;
+            if (useShaders && !(shadersReady && crowdShaderReady)) {
+                printf("  %d walkers: instanced path not available\n", crowdSizes[k]);
+                continue;
+            }
+            double t0 = 0.0, shadowMs = 0.0;
+            for (int f = -5; f < frames / 3; f++) {
+                if (f == 0) { glFinish(); t0 = nowMs(); shadowMs = 0.0; }
+                glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+                updateCrowd(1.0f);
+                cullScene();
+                beginShadowMask();
+                drawCrowd();
+                glFinish();   // so the split below is the shadow pass alone
+                double s0 = nowMs();
+                drawShadowPass();
+                glFinish();
+                shadowMs += nowMs() - s0;
+            }
+            printf("  %d walkers %-14s %.3f ms/frame (sim + shadows included, shadow pass %.3f ms)\n",
+                   crowdSizes[k], useShaders ? "instanced:" : "CPU figures:", (nowMs() - t0) / (frames / 3),
+                   shadowMs / (frames / 3));
+        }
+    }
+    initCrowd(crowdCount);
+
+    // cows: CPU-expanded triangle array vs one instanced draw
+    const int herdSizes[2] = {100, 5000};
+    for (int k = 0; k < 2; k++) {
+        initHerd(herdSizes[k]);
+        for (int pass = 0; pass < 2; pass++) {
+            useShaders = pass == 1;
+            if (useShaders && !(shadersReady && herdShaderReady)) {
+                printf("  %d cows: instanced path not available\n", herdSizes[k]);
+                continue;
+            }
+            double t0 = 0.0, shadowMs = 0.0;
+            for (int f = -5; f < frames / 3; f++) {
+                if (f == 0) { glFinish(); t0 = nowMs(); shadowMs = 0.0; }
+                glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+                updateHerd(1.0f);
+                cullScene();
+                beginShadowMask();
+                drawHerd();
+                glFinish();   // so the split below is the shadow pass alone
+                double s0 = nowMs();
+                drawShadowPass();
+                glFinish();
+                shadowMs += nowMs() - s0;
+            }
+            printf("  %d cows %-14s %.3f ms/frame (sim + shadows included, shadow pass %.3f ms)\n",
+                   herdSizes[k], useShaders ? "instanced:" : "CPU cows:", (nowMs() - t0) / (frames / 3),
+                   shadowMs / (frames / 3));
+        }
+    }
+    initHerd(herdCount);
+
+    // bloom on whatever is in the frame, at both sizes
+    bool savedBloom = bloomEnabled;
+    int  savedDiv   = bloomDivisor;
+    bloomEnabled = true;
+    for (int div = 2; div <= 4; div += 2) {
+        bloomDivisor = div;
+        winW = savedW;
+        double t0 = 0.0;
+        for (int f = -5; f < frames / 3; f++) {
+            if (f == 0) { glFinish(); t0 = nowMs(); }
+            applyBloom();
+            glFinish();
+        }
+        printf("  bloom %dx%d at 1/%d: %.3f ms/frame (%s read-back + CPU + upload)\n",
+               winW, winH, div, (nowMs() - t0) / (frames / 3), shadersReady ? "PBO" : "sync");
     }
+    bloomEnabled = savedBloom;
+    bloomDivisor = savedDiv;
+
+    scene      = saved;
+    useShaders = savedUse;
+    winW       = savedW;
 }
 
-void reshape(int w, int h) {
-    glViewport(0, 0, w, h);
+void runBenchmarks() {
+    printf("==================================================================\n");
+    printf("VILLAGE BENCHMARKS\n");
+    printf("==================================================================\n");
+    replayMode = true;   // keep the day/night console messages quiet
+    benchFishSchool();
+    benchCrowd();
+    benchHerd();
+    benchTimeSeek();
+    benchSignals();
+    benchTimeline();
+    benchTimeOfDay();
+    benchRiverSurface();
+    benchShaderPath();
+    benchStarfield();
+    benchCloudBake();
+    benchNavigation();
+    benchHills();
+    benchLightPass();
+    benchShadowPass();
+    benchCables();
+    benchCulling();
+    benchBloom();
 }
 
 // ============================================================================
@@ -4220,8 +10336,95 @@ void reshape(int w, int h) {
 // ============================================================================
 
 int main(int argc, char** argv) {
+    bool benchOnly = false;
+    bool warmStart = false;
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    uint64_t    seekTicks  = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--bench")) benchOnly = true;
+        else if (!strcmp(argv[i], "--bench-gl")) benchGL = true;
+        else if (!strcmp(argv[i], "--fixed-function")) useShaders = false;
+        else if (!strcmp(argv[i], "--no-bloom")) bloomEnabled = false;
+        else if (!strcmp(argv[i], "--bloom-scale") && i + 1 < argc) {
+            bloomDivisor = atoi(argv[++i]) <= 2 ? 2 : 4;
+        }
+        else if (!strcmp(argv[i], "--fish") && i + 1 < argc) fishCount = std::max(0, std::min(MAX_FISH, atoi(argv[++i])));
+        else if (!strcmp(argv[i], "--crowd") && i + 1 < argc) crowdCount = std::max(0, std::min(MAX_CROWD, atoi(argv[++i])));
+        else if (!strcmp(argv[i], "--cows") && i + 1 < argc) herdCount = std::max(0, std::min(MAX_HERD, atoi(argv[++i])));
+        else if (!strcmp(argv[i], "--signals") && i + 1 < argc) signalCount = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--signal-plan") && i + 1 < argc) {
+            PhasePlan p = {0, 0, 0};
+            if (sscanf(argv[++i], "%d:%d:%d", &p.red, &p.yellow, &p.green) == 3 &&
+                p.red > 0 && p.yellow >= 0 && p.green > 0)
+                signalPlan = p;
+        }
+        else if (!strcmp(argv[i], "--snapshot") && i + 1 < argc) snapshotPath = argv[++i];
+        else if (!strcmp(argv[i], "--seek") && i + 1 < argc) seekTicks = parseTicks(argv[++i]);
+        else if (!strcmp(argv[i], "--record") && i + 1 < argc) recordPath = argv[++i];
+        else if (!strcmp(argv[i], "--replay") && i + 1 < argc) replayPath = argv[++i];
+        else if (!strcmp(argv[i], "--forest") && i + 1 < argc) forestCount = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--hill-octaves") && i + 1 < argc) {
+            hillOctaves = std::max(0, std::min(atoi(argv[++i]), 8));
+        }
+        else if (!strcmp(argv[i], "--clouds") && i + 1 < argc) {
+            cloudCount = std::max(0, std::min(atoi(argv[++i]), MAX_CLOUDS));
+        }
+        else if (!strcmp(argv[i], "--stars") && i + 1 < argc) {
+            starCount = std::max(0, std::min(atoi(argv[++i]), MAX_STARS));
+        }
+        else if (!strcmp(argv[i], "--coaches") && i + 1 < argc) {
+            startCoaches = std::max(1, std::min(atoi(argv[++i]), MAX_TRAIN_COACHES));
+            scene = sceneDefaults();
+        }
+        else if (!strcmp(argv[i], "--checkpoints") && i + 1 < argc) {
+            checkpointLimit = (size_t)std::max(1, atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "--checkpoint-every") && i + 1 < argc) {
+            checkpointEvery = (uint32_t)std::max<uint64_t>(1, parseTicks(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "--load-snapshot") && i + 1 < argc) {
+            snapshotPath = argv[++i];
+            warmStart    = true;
+        }
+    }
+
+    bakeTimeOfDay();
+    registerMaterials();
+    initForest(forestCount);
+    initStarfield(starCount);
+    initClouds(cloudCount);
+    buildHills(hillOctaves);
+    initCables();
+    buildCoachMeshes();
+    initFishSchool(fishCount);
+    initCrowd(crowdCount);
+    initHerd(herdCount);
+    initRoadSignals(signalCount);
+    if (warmStart && !loadSnapshot(snapshotPath)) return 1;
+    if (seekTicks > 0) {
+        scene = stateAt(scene, seekTicks);
+        printf("Seeked %llu ticks ahead (tick %u)\n", (unsigned long long)seekTicks, scene.tick);
+    }
+    resetTimeline();
+
+    if (replayPath) return runReplay(replayPath);
+
+    if (benchOnly) {
+        runBenchmarks();
+        return 0;
+    }
+
+    if (recordPath && !startRecording(recordPath)) return 1;
+
+    // cloud textures bake in the background while the window opens
+    startCloudBake((int)std::thread::hardware_concurrency());
+    atexit(finishCloudBake);
+    startNavBake((int)std::thread::hardware_concurrency());
+    atexit(joinNavWorkers);
+
     glutInit(&argc, argv);
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_STENCIL);
     glutInitWindowSize(WIDTH, HEIGHT);
     glutInitWindowPosition(50, 50);
     glutCreateWindow("Advanced Realistic Village with River Boat - Final Version v4");
@@ -4237,15 +10440,21 @@ int main(int argc, char** argv) {
     printf("  1/2: Speed +/-  W/S: Wind +/-   F: Festival lights\n");
     printf("  B: Birds   A: Airplane   G: Train   L: Light glow\n");
     printf("  H: Person  E: Reset   ESC: Exit\n");
+    printf("  U: GLSL / fixed-function sky + water   J: Bloom\n");
+    printf("  K/O: Save/Load snapshot (%s)   +/-: Train coaches (%d)\n", snapshotPath, trainBogieCount);
+    printf("  Drag the HUD timeline to scrub (checkpoint every %u ticks, max %u)\n",
+           checkpointEvery, (unsigned)checkpointLimit);
     printf("==================================================================\n");
 
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
     glutKeyboardFunc(keyboard);
     glutMouseFunc(mouse);
+    glutMotionFunc(motion);
     glutTimerFunc(0, update, 0);
 
     initRendering();
+    initShaders();
 
     glutMainLoop();
     return 0;